@@ -0,0 +1,274 @@
+
+/*!
+ * \file ask.cpp
+ *
+ * \brief Main program for sending requests to a solver daemon
+ *
+ * \author Stewart L. Palmer
+ */
+
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <limits.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/time.h>
+#include "daemon_client.h"
+
+using namespace ::std;
+
+/*!
+ * \brief Print the command line usage
+ */
+static void usage(
+  const char   *program)           /*!< Name of the program                 */
+{
+  cerr << "usage: " << program << " [-n count] socket request\n"
+          "  -n count     send the request count times and report the rate\n"
+          "  socket       the socket given to assign -d\n"
+          "  request is one of:\n"
+          "    locate J123                   where the juggler is assigned\n"
+          "    roster C1970                  the jugglers assigned to the circuit\n"
+          "    cutoff C5                     the score needed to get into the circuit\n"
+          "    add J12000 H:3 E:4 P:5 C1,C2  add a juggler\n"
+          "    withdraw J123                 withdraw a juggler\n"
+          "    shutdown                      stop the daemon" << endl;
+}
+
+
+/*!
+ * \brief Parse the number of a juggler or circuit name such as J123
+ *
+ * \return Zero if the name has the letter and a number, non-zero otherwise
+ */
+static int parse_name(
+  const string    &name,           /*!< The name                            */
+  const char       letter,         /*!< J or C                              */
+  uint32_t        &id)             /*!< Returned number                     */
+{
+  if ( (name.size() < 2) || (name[0] != letter) )
+    return 1;
+  char *end = 0;
+  const unsigned long n = strtoul(name.c_str() + 1, &end, 10);
+  if (*end != '\0')
+    return 1;
+  id = n;
+
+  return 0;
+}
+
+
+/*!
+ * \brief Parse a talent such as H:3
+ *
+ * \return Zero if the talent has the letter and a number, non-zero otherwise
+ */
+static int parse_talent(
+  const string    &text,           /*!< The talent                          */
+  const char       letter,         /*!< H, E or P                           */
+  int32_t         &value)          /*!< Returned value                      */
+{
+  if ( (text.size() < 3) || (text[0] != letter) || (text[1] != ':') )
+    return 1;
+  value = atoi(text.c_str() + 2);
+
+  return 0;
+}
+
+
+/*!
+ * \brief Build the request from the command line
+ *
+ * \return Zero if the request is understood, non-zero otherwise
+ */
+static int parse_request(
+  const int          argc,         /*!< Number of words                     */
+  char              *argv[],       /*!< The words of the request            */
+  daemon_request    &request,      /*!< Returned request                    */
+  vector<uint32_t>  &preferences)  /*!< Returned circuit numbers            */
+{
+  memset(&request, 0, sizeof(request));
+  if (argc < 1)
+    return 1;
+  const string what(argv[0]);
+  if (what == "shutdown")
+    {
+      request.operation = shutdown_operation;
+      return (argc == 1) ? 0 : 1;
+    }
+  if (argc < 2)
+    return 1;
+  const string name(argv[1]);
+  if ( (what == "locate") && (argc == 2) )
+    {
+      request.operation = locate_operation;
+      return parse_name(name, 'J', request.id);
+    }
+  if ( (what == "roster") && (argc == 2) )
+    {
+      request.operation = roster_operation;
+      return parse_name(name, 'C', request.id);
+    }
+  if ( (what == "cutoff") && (argc == 2) )
+    {
+      request.operation = cutoff_operation;
+      return parse_name(name, 'C', request.id);
+    }
+  if ( (what == "withdraw") && (argc == 2) )
+    {
+      request.operation = withdraw_operation;
+      return parse_name(name, 'J', request.id);
+    }
+  if ( (what == "add") && (argc == 6) )
+    {
+      request.operation = add_operation;
+      if ( (parse_name(name, 'J', request.id) != 0) ||
+           (parse_talent(argv[2], 'H', request.hand) != 0) ||
+           (parse_talent(argv[3], 'E', request.endurance) != 0) ||
+           (parse_talent(argv[4], 'P', request.pizzazz) != 0) )
+        return 1;
+      istringstream is(argv[5]);
+      string circuit_name;
+      while (getline(is, circuit_name, ','))
+      {
+        uint32_t id = 0;
+        if (parse_name(circuit_name, 'C', id) != 0)
+          return 1;
+        preferences.push_back(id);
+      }
+      request.preference_count = preferences.size();
+      return 0;
+    }
+
+  return 1;
+}
+
+
+/*!
+ * \brief Print a reply
+ */
+static void show_reply(
+  const daemon_request              &request,/*!< The request               */
+  const daemon_reply                &reply,/*!< The reply                   */
+  const vector<daemon_entry>        &entries)/*!< Its entries               */
+{
+  if (reply.status == not_found_status)
+    {
+      cout << "No such " << ( ((request.operation == roster_operation) ||
+                               (request.operation == cutoff_operation)) ?
+                              "circuit" : "juggler" ) << "." << endl;
+      return;
+    }
+  if (reply.status == rejected_status)
+    {
+      cout << "Rejected." << endl;
+      return;
+    }
+  if (reply.status != ok_status)
+    {
+      cout << "The daemon did not understand the request." << endl;
+      return;
+    }
+
+  switch (request.operation)
+  {
+    case locate_operation:
+    case add_operation:
+      for (unsigned int e = 0; e < entries.size(); e++)
+        {
+          const daemon_entry &entry = entries[e];
+          if (entry.circuit < 0)
+            cout << "J" << entry.juggler << " is not assigned." << endl;
+          else
+            cout << "J" << entry.juggler << " is assigned to C" << entry.circuit <<
+                    ", score " << entry.score << ", preference " << entry.preference << endl;
+        }
+      break;
+    case roster_operation:
+      cout << "C" << request.id;
+      for (unsigned int e = 0; e < entries.size(); e++)
+        cout << (e == 0 ? " " : ", ") << "J" << entries[e].juggler << ":" << entries[e].score;
+      cout << endl;
+      cout << "Juggler sum for C" << request.id << " is " << reply.value << endl;
+      break;
+    case cutoff_operation:
+      if (reply.value == INT_MIN)
+        cout << "C" << request.id << " is not full." << endl;
+      else
+        cout << "Cutoff for C" << request.id << " is " << reply.value << endl;
+      break;
+    default:
+      cout << "Done." << endl;
+      break;
+  }
+}
+
+
+int main(
+  int     argc,
+  char   *argv[])
+{
+  int count = 1;
+  int opt = getopt(argc, argv, "n:");
+  while (opt != -1)
+  {
+    switch (opt)
+    {
+      case 'n':
+        count = atoi(optarg);
+        if (count <= 0)
+          {
+            usage(argv[0]);
+            return 2;
+          }
+        break;
+      default:
+        usage(argv[0]);
+        return 2;
+    }
+    opt = getopt(argc, argv, "n:");
+  }
+
+  daemon_request request;
+  vector<uint32_t> preferences;
+  if ( ((argc - optind) < 2) ||
+       (parse_request(argc - optind - 1, argv + optind + 1, request, preferences) != 0) )
+    {
+      usage(argv[0]);
+      return 2;
+    }
+
+  daemon_client client;
+  if (client.connect(argv[optind]) != 0)
+    {
+      cerr << "Cannot connect to " << argv[optind] << endl;
+      return 2;
+    }
+
+  // Return 0 if done, 1 if not found or rejected and 2 for trouble
+  daemon_reply reply;
+  vector<daemon_entry> entries;
+  timeval start;
+  gettimeofday(&start, 0);
+  for (int i = 0; i < count; i++)
+    if (client.call(request, preferences, reply, entries) != 0)
+      {
+        cerr << "The daemon did not reply." << endl;
+        return 2;
+      }
+  timeval end;
+  gettimeofday(&end, 0);
+  show_reply(request, reply, entries);
+  if (count > 1)
+    {
+      const double seconds = (end.tv_sec - start.tv_sec) + (end.tv_usec - start.tv_usec) / 1e6;
+      cerr << count << " requests in " << seconds << " seconds, " <<
+              (seconds > 0.0 ? count / seconds : 0.0) << " per second, " <<
+              (1e6 * seconds / count) << " microseconds each" << endl;
+    }
+
+  return ( (reply.status == ok_status) ? 0 : ((reply.status == malformed_status) ? 2 : 1) );
+}
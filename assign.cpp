@@ -1,3 +1,4 @@
+
 /*!
  * \file assign.cpp
  *
@@ -6,46 +7,399 @@
  * \author Stewart L. Palmer
  */
 
+#include <fstream>
 #include <iostream>
+#include <string>
+#include <vector>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
 #include "scheduler.h"
+#include "solver_daemon.h"
 
 using namespace ::std;
 
-int main()
+//! Spans kept per thread for -l
+static const unsigned int timeline_spans = 1 << 16;
+
+//! Waitlist size of each circuit for -d when -w does not give one
+static const unsigned int daemon_waitlist_size = 4;
+
+//! Juggler sum for C1970 of the stable assignment of the input.txt shipped
+static const int shipped_c1970_sum = 28762;
+
+//! file_hash() of the input.txt shipped
+static const uint64_t shipped_input_hash = ((uint64_t) 0x6c21ebcf << 32) | 0x3c1795a5;
+
+
+/*!
+ * \brief Print the command line usage
+ */
+static void usage(
+  const char   *program)           /*!< Name of the program                 */
+{
+  cerr << "usage: " << program << " [-a | -e | -r] [-t threads] [-b seconds] [-p seconds]\n"
+          "              [-o format:file ...] [-q query ...] [-s file] [-c] [-m file]\n"
+          "              [-l file] [-d socket [-w size]]\n"
+          "  -a          assign for the highest total score instead of stability\n"
+          "  -e          use the egalitarian stable assignment\n"
+          "  -r          use the minimum regret stable assignment\n"
+          "  -t threads  number of worker threads\n"
+          "  -b seconds  time allowed for the stable assignment\n"
+          "  -p seconds  time between progress samples of the stable assignment\n"
+          "  -o format:file  also write the assignments to file as text, csv,\n"
+          "              json (JSON Lines) or binary\n"
+          "  -q query    write only the answer to the query instead of all of the\n"
+          "              assignments; a query is a circuit name, a juggler name,\n"
+          "              or sum:circuit for the sum of its juggler IDs\n"
+          "  -s file     write the time of each phase and the proposal counters to\n"
+          "              file as JSON\n"
+          "  -c          also count cycles, instructions and cache, branch and TLB\n"
+          "              misses of each phase and worker thread for -s\n"
+          "  -m file     write the bytes held by each kind of data structure, the\n"
+          "              bytes per juggler and the resident set to file as JSON\n"
+          "  -l file     write a timeline of parsing, proposals, validation and\n"
+          "              output on each thread to file as Chrome trace events\n"
+          "  -d socket   instead of writing the assignments to stdout, keep them and\n"
+          "              answer requests on the socket until asked to shut down;\n"
+          "              each change is validated if the assignments were\n"
+          "  -w size     number of jugglers each circuit keeps on its waitlist to\n"
+          "              refill the places of jugglers withdrawn through -d, 4 by\n"
+          "              default, 0 to leave the places open" << endl;
+}
+
+
+/*!
+ * \brief Return the 64 bit FNV-1a hash of the bytes of a file
+ *
+ * This tells the input.txt that comes with assign from any other festival.
+ */
+static uint64_t file_hash(
+  const char   *path)              /*!< The file                            */
 {
+  static const uint64_t basis = ((uint64_t) 0xcbf29ce4 << 32) | 0x84222325;
+  static const uint64_t prime = ((uint64_t) 0x00000100 << 32) | 0x000001b3;
+  ifstream file(path, ios::binary);
+  uint64_t hash = basis;
+  char buffer[65536];
+  while (file.read(buffer, sizeof(buffer)) || (file.gcount() > 0))
+    for (streamsize b = 0; b < file.gcount(); b++)
+      {
+        hash ^= (unsigned char) buffer[b];
+        hash *= prime;
+      }
+
+  return hash;
+}
+
+
+/*!
+ * \brief Parse a -o argument and open its file
+ *
+ * \return Zero if the format is known and the file was opened
+ */
+static int add_output(
+  const char                          *arg,/*!< The format:file argument   */
+  vector<scheduler::output_format>    &formats,/*!< Formats to write       */
+  vector<int>                         &fds)/*!< Descriptor of each format  */
+{
+  const char *const colon = strchr(arg, ':');
+  if (colon == 0)
+    return 1;
+  const string format(arg, colon - arg);
+  scheduler::output_format f = scheduler::text_output;
+  if (format == "text")
+    f = scheduler::text_output;
+  else if (format == "csv")
+    f = scheduler::csv_output;
+  else if (format == "json")
+    f = scheduler::json_lines_output;
+  else if (format == "binary")
+    f = scheduler::binary_output;
+  else
+    return 1;
+
+  const int fd = open(colon + 1, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+  if (fd < 0)
+    {
+      cerr << "Cannot create " << (colon + 1) << endl;
+      return 1;
+    }
+  formats.push_back(f);
+  fds.push_back(fd);
+
+  return 0;
+}
+
+
+int main(
+  int     argc,
+  char   *argv[])
+{
+  bool max_score = false;
+  bool lattice = false;
+  stable_lattice::choice which = stable_lattice::juggler_optimal;
+  int workers = 0;
+  double budget = 0.0;
+  double interval = 0.0;
+  vector<scheduler::output_format> formats;
+  vector<int> fds;
+  vector<string> queries;
+  const char *socket_path = 0;
+  int waitlist = -1;
+  const char *stats_path = 0;
+  const char *memory_path = 0;
+  const char *timeline_path = 0;
+  int opt = getopt(argc, argv, "aert:b:p:o:q:s:cm:l:d:w:");
+  while (opt != -1)
+  {
+    switch (opt)
+    {
+      case 'a':
+        max_score = true;
+        break;
+      case 'e':
+        lattice = true;
+        which = stable_lattice::egalitarian;
+        break;
+      case 'r':
+        lattice = true;
+        which = stable_lattice::minimum_regret;
+        break;
+      case 't':
+        workers = atoi(optarg);
+        if (workers <= 0)
+          {
+            usage(argv[0]);
+            return 1;
+          }
+        break;
+      case 'b':
+        budget = atof(optarg);
+        if (budget <= 0.0)
+          {
+            usage(argv[0]);
+            return 1;
+          }
+        break;
+      case 'p':
+        interval = atof(optarg);
+        if (interval <= 0.0)
+          {
+            usage(argv[0]);
+            return 1;
+          }
+        break;
+      case 'o':
+        if (add_output(optarg, formats, fds) != 0)
+          {
+            usage(argv[0]);
+            return 1;
+          }
+        break;
+      case 'q':
+        queries.push_back(optarg);
+        break;
+      case 's':
+        stats_path = optarg;
+        break;
+      case 'c':
+        scheduler_stats::set_hardware_counting(true);
+        break;
+      case 'm':
+        memory_path = optarg;
+        break;
+      case 'l':
+        timeline_path = optarg;
+        break;
+      case 'd':
+        socket_path = optarg;
+        break;
+      case 'w':
+        waitlist = atoi(optarg);
+        if (waitlist < 0)
+          {
+            usage(argv[0]);
+            return 1;
+          }
+        break;
+      default:
+        usage(argv[0]);
+        return 1;
+    }
+    opt = getopt(argc, argv, "aert:b:p:o:q:s:cm:l:d:w:");
+  }
+
+  // Without queries or a daemon, all of the assignments go to stdout as text
+  if ( queries.empty() && (socket_path == 0) )
+    {
+      formats.insert(formats.begin(), scheduler::text_output);
+      fds.insert(fds.begin(), STDOUT_FILENO);
+    }
+
+  // The timeline lives as long as the scheduler that records in it
+  span_trace *timeline = 0;
+  if (timeline_path != 0)
+    {
+      timeline = new span_trace(timeline_spans);
+      scheduler_stats::set_span_trace(timeline);
+    }
+
   // Read and parse the input file, creating all of the jugglers and circuits
   scheduler sched("input.txt");
+  if (workers != 0)
+    sched.set_worker_count(workers);
+  if (budget != 0.0)
+    sched.set_time_budget(budget);
+  if (interval != 0.0)
+    sched.set_progress(&cerr, interval);
+
+  // The daemon refills withdrawals from waitlists, which assign() fills
+  if (socket_path != 0)
+    sched.set_waitlist_size((waitlist >= 0) ? waitlist : daemon_waitlist_size);
 
   cerr << "circuit count = "          << sched.circuit_count() <<
           ", juggler count = "        << sched.juggler_count() <<
           ", jugglers per circuit = " << sched.jugglers_per_circuit() << endl;
 
-  // Assign all the jugglers to their best fit circuits
-  sched.assign();
-  cerr << "All jugglers assigned." << endl;
+  // Only assignments that validated are validated again after each change
+  bool validated = false;
+  if (max_score)
+    {
+      // Assign the jugglers for the highest total score, ignoring stability
+      sched.assign_max_score();
+      cerr << "All jugglers assigned for highest total score." << endl;
+    }
+  else if (lattice)
+    {
+      // Assign the jugglers to another point of the stable lattice
+      sched.assign_stable(which, cerr);
+      cerr << "All jugglers assigned." << endl;
+
+      const int arc = sched.validate_assignments(cerr);
+      if (arc == 0)
+        {
+          cerr << "Assignments validated." << endl;
+          validated = true;
+        }
+    }
+  else
+    {
+      // Assign all the jugglers to their best fit circuits
+      sched.assign();
+      cerr << "All jugglers assigned." << endl;
 
-  // Compare the assignments to the original problem statement
-  const int arc = sched.validate_assignments(cerr);
-  if (arc == 0)
-    cerr << "Assignments validated." << endl;
+      if (sched.out_of_time())
+        {
+          cerr << "Time budget ran out after " << sched.proposal_count() <<
+                  " proposals, " << sched.blocking_pair_count() <<
+                  " blocking pairs remain." << endl;
+        }
+      else
+        {
+          // Compare the assignments to the original problem statement
+          const int arc = sched.validate_assignments(cerr);
+          if (arc == 0)
+            {
+              cerr << "Assignments validated." << endl;
+              validated = true;
+            }
+        }
+    }
+  cerr << "Total score = " << sched.total_score() << endl;
 
-  // Write out the completed assignments
-  sched.show_assignments(cout);
+  // Answer the queries, or write out the completed assignments
+  int qrc = 0;
+  for (unsigned int q = 0; q < queries.size(); q++)
+    if (sched.answer_query(queries[q], cout) != 0)
+      qrc = 1;
+  cout.flush();
+  if ( !formats.empty() )
+    {
+      // Every format asked for is written at once
+      const int wrc = sched.write_assignments(formats, fds);
+      for (unsigned int f = 0; f < fds.size(); f++)
+        if (fds[f] != STDOUT_FILENO)
+          close(fds[f]);
+      if (wrc != 0)
+        {
+          cerr << "Cannot write the assignments." << endl;
+          return 1;
+        }
+    }
 
   // Get the sum of all jugglers assigned to circuit C1970
   int csum = -1;
   const circuit *const c = sched.get_circuit("C1970");
-  if (c == 0)
-    cout << "Circuit C1970 does not exist." << endl;
-  else
+  if (c != 0)
     {
       const circuit &circ = *c;
       csum = circ.juggler_sum();
       cerr << "Juggler sum for C1970 is " << csum << endl;
     }
 
-  // This constitutes a regression test
-  assert(csum == 28762);
+  // This constitutes a regression test of the stable assignment, which only
+  // holds for the input.txt that comes with assign, before any daemon changes
+  int rrc = 0;
+  if ( !max_score && !lattice && !sched.out_of_time() && (socket_path == 0) &&
+       (csum != shipped_c1970_sum) && (file_hash("input.txt") == shipped_input_hash) )
+    {
+      cerr << "Regression: the juggler sum for C1970 should be " << shipped_c1970_sum <<
+              "." << endl;
+      rrc = 1;
+    }
 
-  return 0;
+  // Report where the time went and what the proposals did
+  if (stats_path != 0)
+    {
+      ofstream report(stats_path);
+      sched.write_stats_report(report, 10);
+      if ( !report )
+        {
+          cerr << "Cannot write " << stats_path << endl;
+          return 1;
+        }
+    }
+
+  // Report what each kind of data structure holds
+  if (memory_path != 0)
+    {
+      ofstream report(memory_path);
+      sched.write_memory_report(report);
+      if ( !report )
+        {
+          cerr << "Cannot write " << memory_path << endl;
+          return 1;
+        }
+    }
+
+  // Show what each thread did when
+  if (timeline != 0)
+    {
+      ofstream trace(timeline_path);
+      timeline->write_chrome_json(trace);
+      if ( !trace )
+        {
+          cerr << "Cannot write " << timeline_path << endl;
+          return 1;
+        }
+    }
+
+  // Serve the assignments until asked to stop
+  if (socket_path != 0)
+    {
+      solver_daemon daemon(sched, socket_path);
+      if (validated)
+        daemon.set_validation(&cerr);
+      cerr << "Serving requests on " << socket_path << endl;
+      if (daemon.serve(cerr) != 0)
+        return 1;
+      cerr << "Answered " << daemon.request_count() << " requests." << endl;
+      if (daemon.invalid_change_count() != 0)
+        cerr << daemon.invalid_change_count() << " changes did not validate." << endl;
+    }
+
+  return (qrc != 0) ? qrc : rrc;
 }
@@ -0,0 +1,424 @@
+
+/*!
+ * \file assignment_diff.cpp
+ *
+ * \brief Contains the implementation of assignment_diff
+ *
+ * \author Stewart L. Palmer
+ */
+
+#include <climits>
+#include <string>
+#include <assert.h>
+#include "parallel_phase.h"
+#include "assignment_diff.h"
+
+using namespace ::std;
+
+
+/*!
+ * \brief Return a rank that orders a circuit the juggler did not list after
+ *        all of those it did
+ */
+static int choice_order(
+  const int    rank)               /*!< entry_rank(), -1 if not listed      */
+{
+  return (rank < 0) ? INT_MAX : rank;
+}
+
+
+/*                                                                          */
+/****************************************************************************/
+/*     C O N S T R U C T O R                                                */
+/****************************************************************************/
+/*                                                                          */
+assignment_diff::assignment_diff(
+  const assignment_file   &before, /*!< The earlier assignment              */
+  const assignment_file   &after)  /*!< The later assignment                */
+  :
+  _before(before),
+  _after(after),
+  _before_jugglers(before.entry_names()),
+  _after_jugglers(after.entry_names()),
+  _before_circuits(before.line_names()),
+  _after_circuits(after.line_names()),
+  _workers(1),
+  _details(true),
+  _common_count(0),
+  _moved_count(0),
+  _better_count(0),
+  _worse_count(0),
+  _rescored_count(0),
+  _removed_count(0),
+  _added_count(0),
+  _changed_circuit_count(0),
+  _duplicate_count(0),
+  _before_score(0),
+  _after_score(0)
+{ }
+
+
+/*                                                                          */
+/****************************************************************************/
+/*     C O M P A R E                                                        */
+/****************************************************************************/
+/*                                                                          */
+int assignment_diff::compare(
+  const unsigned int    workers,   /*!< Maximum number of worker threads    */
+  const bool            details,   /*!< Report each difference              */
+  ostream              &os)        /*!< Stream for the differences          */
+{
+  assert(workers > 0);
+  _workers = workers;
+  _details = details;
+  _duplicate_count = 0;
+
+  fill_table(_before_jugglers, _before.entry_names(), "Juggler", _before, os);
+  fill_table(_after_jugglers, _after.entry_names(), "Juggler", _after, os);
+  fill_table(_before_circuits, _before.line_names(), "Circuit", _before, os);
+  fill_table(_after_circuits, _after.line_names(), "Circuit", _after, os);
+
+  // Matching fills _after_match and _before_match, which the rosters need
+  _line_match.assign(_after.line_count(), -1);
+  _after_match.assign(_after.entry_count(), -1);
+  _before_match.assign(_before.entry_count(), -1);
+  run_phase(&assignment_diff::match_circuits, _after.line_count(), os);
+  run_phase(&assignment_diff::compare_jugglers, _after.entry_count(), os);
+  _removed_count = run_phase(&assignment_diff::find_removed_jugglers,
+                             _before.entry_count(), os);
+  _changed_circuit_count =
+    run_phase(&assignment_diff::compare_circuits, _after.line_count(), os);
+  _changed_circuit_count +=
+    run_phase(&assignment_diff::find_removed_circuits, _before.line_count(), os);
+  count_changes();
+
+  const bool same = ( (_moved_count == 0) && (_rescored_count == 0) &&
+                      (_removed_count == 0) && (_added_count == 0) &&
+                      (_changed_circuit_count == 0) && (_duplicate_count == 0) );
+
+  return (same ? 0 : 1);
+}
+
+
+/*                                                                          */
+/****************************************************************************/
+/*     R U N _ P H A S E                                                    */
+/****************************************************************************/
+/*                                                                          */
+uint64_t assignment_diff::run_phase(
+  const phase_function   function, /*!< The work of the phase               */
+  const unsigned int     count,    /*!< Number of items                     */
+  ostream               &os)       /*!< Stream for the differences          */
+{
+  parallel_phase<assignment_diff>  phase(*this, function);
+
+  return phase.run_in_order(count, _workers, os);
+}
+
+
+/*                                                                          */
+/****************************************************************************/
+/*     F I L L _ T A B L E                                                  */
+/****************************************************************************/
+/*                                                                          */
+void assignment_diff::fill_table(
+  name_table            &table,    /*!< The table to fill                   */
+  const vector<span>    &names,    /*!< Names of the indexes                */
+  const char            *kind,     /*!< What the names are                  */
+  const assignment_file &file,     /*!< Where the names are from            */
+  ostream               &os)       /*!< Stream for the differences          */
+{
+  table.reset();
+  for (unsigned int i = 0; i < names.size(); i++)
+    {
+      if (table.insert(i) >= 0)
+        {
+          if (_details)
+            os << kind << " " << string(names[i].text, names[i].size) <<
+                  " is listed more than once in " << file.name() << endl;
+          _duplicate_count++;
+        }
+    }
+}
+
+
+/*                                                                          */
+/****************************************************************************/
+/*     M A T C H _ C I R C U I T S                                          */
+/****************************************************************************/
+/*                                                                          */
+uint64_t assignment_diff::match_circuits(
+  ostream               &os,
+  const unsigned int     first,
+  const unsigned int     last)
+{
+  (void) os;
+  for (unsigned int l = first; l < last; l++)
+    {
+      const span &circ = _after.line_name(l);
+      if (_after_circuits.find(circ) == (int) l)
+        _line_match[l] = _before_circuits.find(circ);
+    }
+
+  return 0;
+}
+
+
+/*                                                                          */
+/****************************************************************************/
+/*     C O M P A R E _ J U G G L E R S                                      */
+/****************************************************************************/
+/*                                                                          */
+uint64_t assignment_diff::compare_jugglers(
+  ostream               &os,
+  const unsigned int     first,
+  const unsigned int     last)
+{
+  uint64_t reported = 0;
+  for (unsigned int e = first; e < last; e++)
+    {
+      const span &jug = _after.entry_name(e);
+      if (_after_jugglers.find(jug) != (int) e)
+        continue;                  /* Only the first listing is compared    */
+      const unsigned int line = _after.entry_line(e);
+      const span &circ = _after.line_name(line);
+      const int b = _before_jugglers.find(jug);
+      _after_match[e] = b;
+      if (b < 0)
+        {
+          if (_details)
+            os << string(jug.text, jug.size) << " is only in " << _after.name() <<
+                  ", in " << string(circ.text, circ.size) << " (Pref " <<
+                  _after.entry_rank(e) << ", Score " << _after.entry_score(e) << ")" << endl;
+          reported++;
+          continue;
+        }
+
+      const span &old_circ = _before.line_name(_before.entry_line(b));
+      const bool moved = (_line_match[line] != (int) _before.entry_line(b));
+      const bool rescored = ( (_before.entry_rank(b) != _after.entry_rank(e)) ||
+                              (_before.entry_score(b) != _after.entry_score(e)) );
+      if ( !moved && !rescored )
+        continue;
+      if (_details)
+        {
+          os << string(jug.text, jug.size);
+          if (moved)
+            os << " moved from " << string(old_circ.text, old_circ.size) << " (Pref " <<
+                  _before.entry_rank(b) << ", Score " << _before.entry_score(b) << ") to " <<
+                  string(circ.text, circ.size);
+          else
+            os << " stayed in " << string(circ.text, circ.size) << " but changed from (Pref " <<
+                  _before.entry_rank(b) << ", Score " << _before.entry_score(b) << ") to";
+          os << " (Pref " << _after.entry_rank(e) << ", Score " << _after.entry_score(e) <<
+                ")" << endl;
+        }
+      reported++;
+    }
+
+  return reported;
+}
+
+
+/*                                                                          */
+/****************************************************************************/
+/*     F I N D _ R E M O V E D _ J U G G L E R S                            */
+/****************************************************************************/
+/*                                                                          */
+uint64_t assignment_diff::find_removed_jugglers(
+  ostream               &os,
+  const unsigned int     first,
+  const unsigned int     last)
+{
+  uint64_t removed = 0;
+  for (unsigned int e = first; e < last; e++)
+    {
+      const span &jug = _before.entry_name(e);
+      if (_before_jugglers.find(jug) != (int) e)
+        continue;                  /* Only the first listing is compared    */
+      const int a = _after_jugglers.find(jug);
+      _before_match[e] = a;
+      if (a >= 0)
+        continue;
+      if (_details)
+        {
+          const span &circ = _before.line_name(_before.entry_line(e));
+          os << string(jug.text, jug.size) << " is only in " << _before.name() <<
+                ", in " << string(circ.text, circ.size) << " (Pref " <<
+                _before.entry_rank(e) << ", Score " << _before.entry_score(e) << ")" << endl;
+        }
+      removed++;
+    }
+
+  return removed;
+}
+
+
+/*                                                                          */
+/****************************************************************************/
+/*     C O M P A R E _ C I R C U I T S                                      */
+/****************************************************************************/
+/*                                                                          */
+uint64_t assignment_diff::compare_circuits(
+  ostream               &os,
+  const unsigned int     first,
+  const unsigned int     last)
+{
+  uint64_t changed = 0;
+  for (unsigned int l = first; l < last; l++)
+    {
+      const span &circ = _after.line_name(l);
+      if (_after_circuits.find(circ) != (int) l)
+        continue;                  /* Only the first listing is compared    */
+      const int b = _line_match[l];
+      if (b < 0)
+        {
+          if (_details)
+            os << string(circ.text, circ.size) << " is only in " << _after.name() << endl;
+          changed++;
+          continue;
+        }
+
+      // A juggler was gained if it was elsewhere before, and lost if it is
+      // elsewhere after
+      vector<unsigned int>  gained;
+      for (unsigned int e = _after.line_first(l); e < _after.line_first(l + 1); e++)
+        {
+          const int m = _after_match[e];
+          if (m >= 0)
+            {
+              if (_before.entry_line(m) != (unsigned int) b)
+                gained.push_back(e);
+            }
+          else if (_after_jugglers.find(_after.entry_name(e)) == (int) e)
+            gained.push_back(e);
+        }
+      vector<unsigned int>  lost;
+      for (unsigned int e = _before.line_first(b); e < _before.line_first(b + 1); e++)
+        {
+          const int m = _before_match[e];
+          if (m >= 0)
+            {
+              if (_after.entry_line(m) != l)
+                lost.push_back(e);
+            }
+          else if (_before_jugglers.find(_before.entry_name(e)) == (int) e)
+            lost.push_back(e);
+        }
+      if ( gained.empty() && lost.empty() )
+        continue;
+      if (_details)
+        {
+          os << string(circ.text, circ.size) << " lost";
+          for (unsigned int i = 0; i < lost.size(); i++)
+            os << " " << string(_before.entry_name(lost[i]).text, _before.entry_name(lost[i]).size);
+          if (lost.empty())
+            os << " nothing";
+          os << ", gained";
+          for (unsigned int i = 0; i < gained.size(); i++)
+            os << " " << string(_after.entry_name(gained[i]).text, _after.entry_name(gained[i]).size);
+          if (gained.empty())
+            os << " nothing";
+          os << endl;
+        }
+      changed++;
+    }
+
+  return changed;
+}
+
+
+/*                                                                          */
+/****************************************************************************/
+/*     F I N D _ R E M O V E D _ C I R C U I T S                            */
+/****************************************************************************/
+/*                                                                          */
+uint64_t assignment_diff::find_removed_circuits(
+  ostream               &os,
+  const unsigned int     first,
+  const unsigned int     last)
+{
+  uint64_t removed = 0;
+  for (unsigned int l = first; l < last; l++)
+    {
+      const span &circ = _before.line_name(l);
+      if ( (_before_circuits.find(circ) != (int) l) || (_after_circuits.find(circ) >= 0) )
+        continue;
+      if (_details)
+        os << string(circ.text, circ.size) << " is only in " << _before.name() << endl;
+      removed++;
+    }
+
+  return removed;
+}
+
+
+/*                                                                          */
+/****************************************************************************/
+/*     C O U N T _ C H A N G E S                                            */
+/****************************************************************************/
+/*                                                                          */
+void assignment_diff::count_changes()
+{
+  _common_count = 0;
+  _moved_count = 0;
+  _better_count = 0;
+  _worse_count = 0;
+  _rescored_count = 0;
+  _added_count = 0;
+  _before_score = 0;
+  _after_score = 0;
+  for (unsigned int e = 0; e < _before.entry_count(); e++)
+    _before_score += _before.entry_score(e);
+  for (unsigned int e = 0; e < _after.entry_count(); e++)
+    {
+      _after_score += _after.entry_score(e);
+      const int b = _after_match[e];
+      if (b < 0)
+        {
+          if (_after_jugglers.find(_after.entry_name(e)) == (int) e)
+            _added_count++;
+          continue;
+        }
+      _common_count++;
+
+      if (_line_match[_after.entry_line(e)] != (int) _before.entry_line(b))
+        {
+          _moved_count++;
+          const int before_order = choice_order(_before.entry_rank(b));
+          const int after_order = choice_order(_after.entry_rank(e));
+          if (after_order < before_order)
+            _better_count++;
+          else if (after_order > before_order)
+            _worse_count++;
+        }
+      else if ( (_before.entry_rank(b) != _after.entry_rank(e)) ||
+                (_before.entry_score(b) != _after.entry_score(e)) )
+        _rescored_count++;
+    }
+}
+
+
+/*                                                                          */
+/****************************************************************************/
+/*     P R I N T _ S E L F                                                  */
+/****************************************************************************/
+/*                                                                          */
+ostream &assignment_diff::print_self(
+  ostream    &os)                  /*!< The stream into which we stream     */
+const
+{
+  os << "jugglers in both = "      << _common_count <<
+        ", moved = "               << _moved_count <<
+        " (better = "              << _better_count <<
+        ", worse = "               << _worse_count <<
+        "), rescored = "           << _rescored_count <<
+        ", removed = "             << _removed_count <<
+        ", added = "               << _added_count <<
+        ", circuits changed = "    << _changed_circuit_count <<
+        ", total score = "         << _before_score << " -> " << _after_score;
+  if (_duplicate_count != 0)
+    os << ", listed more than once = " << _duplicate_count;
+
+  return os;
+}
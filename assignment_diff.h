@@ -0,0 +1,342 @@
+#ifndef assignment_diff_h_included
+#define assignment_diff_h_included 1
+
+/*!
+ * \file assignment_diff.h
+ *
+ * \brief Contains the definition of assignment_diff
+ *
+ * \author Stewart L. Palmer
+ */
+
+#include <iostream>
+#include <vector>
+#include <stdint.h>
+#include "assignment_file.h"
+#include "line_scanner.h"
+#include "name_table.h"
+
+
+/*!
+ * \brief Compares two assignments of the same jugglers
+ *
+ * Jugglers are matched by name through hash tables rather than by sorting
+ * either file, and every phase runs on many threads through parallel_phase, so
+ * the differences always come out in the order of the files.  The differences
+ * reported are:
+ *
+ * <ul>
+ * <li> jugglers that moved to another circuit, with their rank and score in
+ *      both;
+ * <li> jugglers that stayed in their circuit but whose rank or score changed,
+ *      as happens when the instance is edited;
+ * <li> jugglers and circuits found in only one of the assignments;
+ * <li> circuits whose rosters differ, with the jugglers each lost and gained.
+ * </ul>
+ *
+ * A juggler's rank in a circuit is where the circuit comes in the circuits it
+ * lists, so a lower rank is a better choice, and a circuit it does not list is
+ * worse than any it does.  Both assignments must already be
+ * parsed; they may come from files or from show_assignments() captured in
+ * memory.
+ */
+class assignment_diff
+{
+public:
+
+  /*!
+   * \brief Standard constructor
+   */
+  explicit assignment_diff(
+    const assignment_file   &before,/*!< The earlier assignment             */
+    const assignment_file   &after /*!< The later assignment                */
+                          );
+
+
+  /*!
+   * \brief Compare the assignments
+   *
+   * \return Zero if they are the same, non-zero otherwise
+   */
+  int compare(
+    const unsigned int    workers, /*!< Maximum number of worker threads    */
+    const bool            details, /*!< Report each difference, not just
+                                        the summary                         */
+    std::ostream         &os       /*!< Stream for the differences          */
+             );
+
+
+  /*!
+   * \brief Return the number of jugglers in both assignments
+   */
+  unsigned int common_count() const
+  { return _common_count; }
+
+
+  /*!
+   * \brief Return the number of jugglers that moved to another circuit
+   */
+  unsigned int moved_count() const
+  { return _moved_count; }
+
+
+  /*!
+   * \brief Return the number of moved jugglers that got a better rank
+   */
+  unsigned int better_count() const
+  { return _better_count; }
+
+
+  /*!
+   * \brief Return the number of moved jugglers that got a worse rank
+   */
+  unsigned int worse_count() const
+  { return _worse_count; }
+
+
+  /*!
+   * \brief Return the number of jugglers whose rank or score changed in the
+   *        same circuit
+   */
+  unsigned int rescored_count() const
+  { return _rescored_count; }
+
+
+  /*!
+   * \brief Return the number of jugglers only in the earlier assignment
+   */
+  unsigned int removed_count() const
+  { return _removed_count; }
+
+
+  /*!
+   * \brief Return the number of jugglers only in the later assignment
+   */
+  unsigned int added_count() const
+  { return _added_count; }
+
+
+  /*!
+   * \brief Return the number of circuits whose rosters differ, or that are in
+   *        only one of the assignments
+   */
+  unsigned int changed_circuit_count() const
+  { return _changed_circuit_count; }
+
+
+  /*!
+   * \brief Return the number of jugglers or circuits listed more than once in
+   *        one of the assignments; only the first listing is compared
+   */
+  unsigned int duplicate_count() const
+  { return _duplicate_count; }
+
+
+  /*!
+   *  \brief Stream object out to a stream
+   *
+   * The summary of the comparison.
+   *
+   * \return The same stream as the input to allow for chained operators.
+   */
+  friend std::ostream &operator<<(
+    std::ostream            &os,   /*!< The stream into which we stream     */
+    const assignment_diff   &cn)   /*!< The object to be streamed           */
+  {
+    return cn.print_self(os);
+  }
+
+private:
+
+  typedef line_scanner::span span;
+
+  //! Function run over a range of items by one worker of a phase
+  typedef uint64_t (assignment_diff::*phase_function)(
+    std::ostream          &os,
+    const unsigned int     first,
+    const unsigned int     last);
+
+
+  /*!
+   * \brief The copy constructor is deliberately private and unimplemented.
+   *
+   * \param rhs the object from which we are to be constructed
+   */
+  assignment_diff(
+    const assignment_diff   &rhs);
+
+  /*!
+   * \brief operator=() is deliberately private and unimplemented.
+   *
+   * \param rhs the object from which we are to be assigned
+   *
+   * \return reference to self to allow for chained operators
+   */
+  assignment_diff &operator=(
+    const assignment_diff   &rhs);
+
+  /*!
+   * \brief This is the implementation function for operator<<()
+   *
+   * \return The same stream as the input to allow for chained operators.
+   */
+  std::ostream &print_self(
+    std::ostream    &os)           /*!< The stream into which we stream     */
+  const;
+
+
+  /*!
+   * \brief Run one phase over count items
+   *
+   * \return The sum of what the workers returned
+   */
+  uint64_t run_phase(
+    const phase_function   function,/*!< The work of the phase              */
+    const unsigned int     count,  /*!< Number of items                     */
+    std::ostream          &os      /*!< Stream for the differences          */
+                );
+
+
+  /*!
+   * \brief Fill a name table, reporting names listed more than once
+   */
+  void fill_table(
+    name_table                &table,/*!< The table to fill                 */
+    const std::vector<span>   &names,/*!< Names of the indexes              */
+    const char                *kind, /*!< What the names are                */
+    const assignment_file     &file, /*!< Where the names are from          */
+    std::ostream              &os    /*!< Stream for the differences        */
+                 );
+
+
+  /*!
+   * \brief Match a range of circuits of the later assignment to the lines of
+   *        the earlier one
+   */
+  uint64_t match_circuits(
+    std::ostream          &os,
+    const unsigned int     first,
+    const unsigned int     last);
+
+
+  /*!
+   * \brief Match a range of jugglers of the later assignment, and report
+   *        those that moved, changed, or are new
+   *
+   * \return The number of jugglers reported
+   */
+  uint64_t compare_jugglers(
+    std::ostream          &os,
+    const unsigned int     first,
+    const unsigned int     last);
+
+
+  /*!
+   * \brief Match a range of jugglers of the earlier assignment, and report
+   *        those that are gone
+   *
+   * \return The number of jugglers that are gone
+   */
+  uint64_t find_removed_jugglers(
+    std::ostream          &os,
+    const unsigned int     first,
+    const unsigned int     last);
+
+
+  /*!
+   * \brief Compare the rosters of a range of circuits of the later assignment
+   *
+   * \return The number of circuits that differ
+   */
+  uint64_t compare_circuits(
+    std::ostream          &os,
+    const unsigned int     first,
+    const unsigned int     last);
+
+
+  /*!
+   * \brief Report a range of circuits found only in the earlier assignment
+   *
+   * \return The number of those circuits
+   */
+  uint64_t find_removed_circuits(
+    std::ostream          &os,
+    const unsigned int     first,
+    const unsigned int     last);
+
+
+  /*!
+   * \brief Gather the counts from the matched jugglers
+   */
+  void count_changes();
+
+
+  //! The earlier assignment
+  const assignment_file      &_before;
+
+  //! The later assignment
+  const assignment_file      &_after;
+
+  //! Entries of the earlier assignment by juggler name
+  name_table                  _before_jugglers;
+
+  //! Entries of the later assignment by juggler name
+  name_table                  _after_jugglers;
+
+  //! Lines of the earlier assignment by circuit name
+  name_table                  _before_circuits;
+
+  //! Lines of the later assignment by circuit name
+  name_table                  _after_circuits;
+
+  //! Matching earlier line of each later line, or -1
+  std::vector<int>            _line_match;
+
+  //! Matching earlier entry of each later entry, or -1
+  std::vector<int>            _after_match;
+
+  //! Matching later entry of each earlier entry, or -1
+  std::vector<int>            _before_match;
+
+  //! Maximum number of worker threads
+  unsigned int                _workers;
+
+  //! Report each difference, not just the summary
+  bool                        _details;
+
+  //! Number of jugglers in both assignments
+  unsigned int                _common_count;
+
+  //! Number of jugglers that moved to another circuit
+  unsigned int                _moved_count;
+
+  //! Number of moved jugglers that got a better rank
+  unsigned int                _better_count;
+
+  //! Number of moved jugglers that got a worse rank
+  unsigned int                _worse_count;
+
+  //! Number of jugglers whose rank or score changed in the same circuit
+  unsigned int                _rescored_count;
+
+  //! Number of jugglers only in the earlier assignment
+  unsigned int                _removed_count;
+
+  //! Number of jugglers only in the later assignment
+  unsigned int                _added_count;
+
+  //! Number of circuits whose rosters differ
+  unsigned int                _changed_circuit_count;
+
+  //! Number of names listed more than once
+  unsigned int                _duplicate_count;
+
+  //! Total score of the earlier assignment
+  int64_t                     _before_score;
+
+  //! Total score of the later assignment
+  int64_t                     _after_score;
+
+};
+
+#endif                             /* assignment_diff_h_included            */
@@ -0,0 +1,246 @@
+
+/*!
+ * \file assignment_file.cpp
+ *
+ * \brief Contains the implementation of assignment_file
+ *
+ * \author Stewart L. Palmer
+ */
+
+#include <string.h>
+#include <assert.h>
+#include "parallel_phase.h"
+#include "assignment_file.h"
+
+using namespace ::std;
+
+
+/*                                                                          */
+/****************************************************************************/
+/*     C O N S T R U C T O R                                                */
+/****************************************************************************/
+/*                                                                          */
+assignment_file::assignment_file(
+  const string         &name,      /*!< Name used in diagnostics            */
+  const char           *data,      /*!< The text                            */
+  const size_t          size)      /*!< Number of characters                */
+  :
+  _name(name),
+  _data(data),
+  _size(size)
+{ }
+
+
+/*                                                                          */
+/****************************************************************************/
+/*     P A R S E                                                            */
+/****************************************************************************/
+/*                                                                          */
+uint64_t assignment_file::parse(
+  const unsigned int    workers,   /*!< Maximum number of worker threads    */
+  ostream              &os)        /*!< Stream for problem reports          */
+{
+  assert(workers > 0);
+
+  // Several chunks per worker evens out lines of different lengths
+  vector<const char *>  starts;
+  line_scanner::split(_data, _size, 4 * workers, starts);
+  _chunks.assign(starts.size() - 1, chunk());
+  for (unsigned int i = 0; i < _chunks.size(); i++)
+    {
+      _chunks[i].first = starts[i];
+      _chunks[i].last = starts[i + 1];
+      _chunks[i].line = 0;
+    }
+
+  parallel_phase<assignment_file> counter(*this, &assignment_file::count_lines);
+  counter.run_in_order(_chunks.size(), workers, os);
+  unsigned int line = 1;
+  for (unsigned int i = 0; i < _chunks.size(); i++)
+    {
+      const unsigned int lines = _chunks[i].line;
+      _chunks[i].line = line;
+      line += lines;
+    }
+
+  parallel_phase<assignment_file> parser(*this, &assignment_file::parse_chunks);
+  const uint64_t problems = parser.run_in_order(_chunks.size(), workers, os);
+  join();
+
+  return problems;
+}
+
+
+/*                                                                          */
+/****************************************************************************/
+/*     C O U N T _ L I N E S                                                */
+/****************************************************************************/
+/*                                                                          */
+uint64_t assignment_file::count_lines(
+  ostream               &os,
+  const unsigned int     first,
+  const unsigned int     last)
+{
+  (void) os;
+  for (unsigned int i = first; i < last; i++)
+    _chunks[i].line = line_scanner::count_lines(_chunks[i].first, _chunks[i].last);
+
+  return 0;
+}
+
+
+/*                                                                          */
+/****************************************************************************/
+/*     P A R S E _ C H U N K S                                              */
+/****************************************************************************/
+/*                                                                          */
+uint64_t assignment_file::parse_chunks(
+  ostream               &os,
+  const unsigned int     first,
+  const unsigned int     last)
+{
+  uint64_t problems = 0;
+  for (unsigned int i = first; i < last; i++)
+    {
+      chunk &c = _chunks[i];
+      unsigned int line = c.line;
+      const char *p = c.first;
+      while (p != c.last)
+      {
+        const char *end = static_cast<const char *>(memchr(p, '\n', c.last - p));
+        const char *const next = (end == 0) ? c.last : (end + 1);
+        if (end == 0)
+          end = c.last;
+        const char *const line_start = p;
+
+        // A line is a circuit followed by its jugglers, each followed by the
+        // circuits it listed with their scores, separated by commas
+        span name;
+        name.size = line_scanner::next_token(p, end, name.text);
+        bool understood = true;
+        if (name.size != 0)
+          {
+            understood = (memchr(name.text, ':', name.size) == 0);
+            const unsigned int listed_before = c.listed_name.size();
+            unsigned int entries = 0;
+            const char *token = 0;
+            unsigned int size = line_scanner::next_token(p, end, token);
+            while ( understood && (size != 0) )
+            {
+              if (token[size - 1] == ',')
+                size--;
+              const char *const colon = static_cast<const char *>(memchr(token, ':', size));
+              if (colon == 0)      /* A juggler                             */
+                {
+                  span jug;
+                  jug.text = token;
+                  jug.size = size;
+                  c.entry_name.push_back(jug);
+                  c.entry_rank.push_back(-1);
+                  c.entry_score.push_back(0);
+                  c.entry_listed.push_back(0);
+                  entries++;
+                }
+              else                 /* A circuit and score of that juggler   */
+                {
+                  span circ;
+                  circ.text = token;
+                  circ.size = colon - token;
+                  int score = 0;
+                  if ( (entries == 0) || (circ.size == 0) ||
+                       (line_scanner::parse_number(colon + 1, token + size, score) != 0) )
+                    understood = false;
+                  else
+                    {
+                      if ( (c.entry_rank.back() < 0) && (circ.size == name.size) &&
+                           (memcmp(circ.text, name.text, name.size) == 0) )
+                        {
+                          c.entry_rank.back() = c.entry_listed.back();
+                          c.entry_score.back() = score;
+                        }
+                      c.listed_name.push_back(circ);
+                      c.listed_score.push_back(score);
+                      c.entry_listed.back()++;
+                    }
+                }
+              size = line_scanner::next_token(p, end, token);
+            }
+            if (understood)
+              {
+                c.line_name.push_back(name);
+                c.line_number.push_back(line);
+                c.line_entries.push_back(entries);
+              }
+            else                   /* Drop what was taken from this line    */
+              {
+                const unsigned int kept = c.entry_name.size() - entries;
+                c.entry_name.resize(kept);
+                c.entry_rank.resize(kept);
+                c.entry_score.resize(kept);
+                c.entry_listed.resize(kept);
+                c.listed_name.resize(listed_before);
+                c.listed_score.resize(listed_before);
+              }
+          }
+        if ( !understood )
+          {
+            os << _name << ":" << line << ": Do not understand <" <<
+                  string(line_start, end - line_start) << ">" << endl;
+            problems++;
+          }
+        line++;
+        p = next;
+      }
+    }
+
+  return problems;
+}
+
+
+/*                                                                          */
+/****************************************************************************/
+/*     J O I N                                                              */
+/****************************************************************************/
+/*                                                                          */
+void assignment_file::join()
+{
+  _line_first.push_back(0);
+  _entry_first.push_back(0);
+  for (unsigned int i = 0; i < _chunks.size(); i++)
+    {
+      chunk &c = _chunks[i];
+      _line_name.insert(_line_name.end(), c.line_name.begin(), c.line_name.end());
+      _line_number.insert(_line_number.end(), c.line_number.begin(), c.line_number.end());
+      for (unsigned int j = 0; j < c.line_entries.size(); j++)
+        {
+          _line_first.push_back(_line_first.back() + c.line_entries[j]);
+          _entry_line.insert(_entry_line.end(),
+                             (vector<unsigned int>::size_type) c.line_entries[j],
+                             (unsigned int) (_line_first.size() - 2));
+        }
+      _entry_name.insert(_entry_name.end(), c.entry_name.begin(), c.entry_name.end());
+      _entry_rank.insert(_entry_rank.end(), c.entry_rank.begin(), c.entry_rank.end());
+      _entry_score.insert(_entry_score.end(), c.entry_score.begin(), c.entry_score.end());
+      for (unsigned int j = 0; j < c.entry_listed.size(); j++)
+        _entry_first.push_back(_entry_first.back() + c.entry_listed[j]);
+      _listed_name.insert(_listed_name.end(), c.listed_name.begin(), c.listed_name.end());
+      _listed_score.insert(_listed_score.end(), c.listed_score.begin(), c.listed_score.end());
+    }
+  vector<chunk>().swap(_chunks);
+}
+
+
+/*                                                                          */
+/****************************************************************************/
+/*     P R I N T _ S E L F                                                  */
+/****************************************************************************/
+/*                                                                          */
+ostream &assignment_file::print_self(
+  ostream    &os)                  /*!< The stream into which we stream     */
+const
+{
+  os << "assignment_file " << _name << ": " << line_count() << " lines, " <<
+        entry_count() << " jugglers";
+
+  return os;
+}
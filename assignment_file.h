@@ -0,0 +1,351 @@
+#ifndef assignment_file_h_included
+#define assignment_file_h_included 1
+
+/*!
+ * \file assignment_file.h
+ *
+ * \brief Contains the definition of assignment_file
+ *
+ * \author Stewart L. Palmer
+ */
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <stddef.h>
+#include <stdint.h>
+#include "line_scanner.h"
+
+
+/*!
+ * \brief The parsed text of an assignment file
+ *
+ * An assignment file is what scheduler::show_assignments() writes: a line per
+ * circuit holding the circuit's name and its jugglers, each of which is
+ * followed by the circuits it listed and its score in each.  The text is
+ * parsed on several threads into three levels, each numbered in file order:
+ *
+ * <ul>
+ * <li> lines, one per circuit;
+ * <li> entries, one per juggler, with the entries of line l in
+ *      [line_first(l), line_first(l+1));
+ * <li> listed circuits, with those of entry e in
+ *      [entry_first(e), entry_first(e+1)).
+ * </ul>
+ *
+ * Names point into the text, which must outlive the object.  The text may be a
+ * mapped file or the output of show_assignments() captured in memory.
+ */
+class assignment_file
+{
+public:
+
+  typedef line_scanner::span span;
+
+  /*!
+   * \brief Standard constructor
+   */
+  explicit assignment_file(
+    const std::string    &name,    /*!< Name used in diagnostics            */
+    const char           *data,    /*!< The text                            */
+    const size_t          size     /*!< Number of characters                */
+                          );
+
+
+  /*!
+   * \brief Parse the text, reporting the lines that cannot be understood
+   *
+   * \return The number of lines that could not be understood
+   */
+  uint64_t parse(
+    const unsigned int    workers, /*!< Maximum number of worker threads    */
+    std::ostream         &os       /*!< Stream for problem reports          */
+                );
+
+
+  /*!
+   * \brief Return the name used in diagnostics
+   */
+  const std::string &name() const
+  { return _name; }
+
+
+  /*!
+   * \brief Return the number of circuit lines
+   */
+  unsigned int line_count() const
+  { return _line_name.size(); }
+
+
+  /*!
+   * \brief Return the circuit name of a line
+   */
+  const span &line_name(
+    const unsigned int    l)       /*!< Line index                          */
+  const
+  { return _line_name[l]; }
+
+
+  /*!
+   * \brief Return the circuit names of all of the lines, to build a name_table
+   */
+  const std::vector<span> &line_names() const
+  { return _line_name; }
+
+
+  /*!
+   * \brief Return the line number of a line in the file
+   */
+  unsigned int line_number(
+    const unsigned int    l)       /*!< Line index                          */
+  const
+  { return _line_number[l]; }
+
+
+  /*!
+   * \brief Return the first entry of a line; line_first(line_count()) is the
+   *        number of entries
+   */
+  unsigned int line_first(
+    const unsigned int    l)       /*!< Line index                          */
+  const
+  { return _line_first[l]; }
+
+
+  /*!
+   * \brief Return the number of juggler entries
+   */
+  unsigned int entry_count() const
+  { return _entry_name.size(); }
+
+
+  /*!
+   * \brief Return the juggler name of an entry
+   */
+  const span &entry_name(
+    const unsigned int    e)       /*!< Entry index                         */
+  const
+  { return _entry_name[e]; }
+
+
+  /*!
+   * \brief Return the juggler names of all of the entries, to build a
+   *        name_table
+   */
+  const std::vector<span> &entry_names() const
+  { return _entry_name; }
+
+
+  /*!
+   * \brief Return the line holding an entry
+   */
+  unsigned int entry_line(
+    const unsigned int    e)       /*!< Entry index                         */
+  const
+  { return _entry_line[e]; }
+
+
+  /*!
+   * \brief Return where the circuit of its line comes in an entry's listed
+   *        circuits, or -1 if the entry does not list it
+   */
+  int entry_rank(
+    const unsigned int    e)       /*!< Entry index                         */
+  const
+  { return _entry_rank[e]; }
+
+
+  /*!
+   * \brief Return the score listed for the circuit of an entry's line, or zero
+   *        if the entry does not list it
+   */
+  int entry_score(
+    const unsigned int    e)       /*!< Entry index                         */
+  const
+  { return _entry_score[e]; }
+
+
+  /*!
+   * \brief Return the first listed circuit of an entry; entry_first(
+   *        entry_count()) is the number of listed circuits
+   */
+  unsigned int entry_first(
+    const unsigned int    e)       /*!< Entry index                         */
+  const
+  { return _entry_first[e]; }
+
+
+  /*!
+   * \brief Return the name of a listed circuit
+   */
+  const span &listed_name(
+    const unsigned int    p)       /*!< Listed circuit index                */
+  const
+  { return _listed_name[p]; }
+
+
+  /*!
+   * \brief Return the score of a listed circuit
+   */
+  int listed_score(
+    const unsigned int    p)       /*!< Listed circuit index                */
+  const
+  { return _listed_score[p]; }
+
+
+  /*!
+   *  \brief Stream object out to a stream
+   *
+   * \return The same stream as the input to allow for chained operators.
+   */
+  friend std::ostream &operator<<(
+    std::ostream            &os,   /*!< The stream into which we stream     */
+    const assignment_file   &cn)   /*!< The object to be streamed           */
+  {
+    return cn.print_self(os);
+  }
+
+private:
+
+  /*!
+   * \brief What one chunk of the text holds once parsed
+   *
+   * Chunks are parsed in parallel and then joined in file order.
+   */
+  struct chunk
+  {
+    //! First character of the chunk, which starts a line
+    const char                *first;
+
+    //! Just past the last character of the chunk
+    const char                *last;
+
+    //! Line number of the first line of the chunk
+    unsigned int               line;
+
+    //! Circuit names of the lines
+    std::vector<span>          line_name;
+
+    //! Line number of each line
+    std::vector<unsigned int>  line_number;
+
+    //! Number of entries of each line
+    std::vector<unsigned int>  line_entries;
+
+    //! Juggler names of the entries
+    std::vector<span>          entry_name;
+
+    //! Rank of the circuit of the line in each entry
+    std::vector<int>           entry_rank;
+
+    //! Score of the circuit of the line in each entry
+    std::vector<int>           entry_score;
+
+    //! Number of listed circuits of each entry
+    std::vector<unsigned int>  entry_listed;
+
+    //! Names of the listed circuits
+    std::vector<span>          listed_name;
+
+    //! Scores of the listed circuits
+    std::vector<int>           listed_score;
+  };
+
+
+  /*!
+   * \brief The copy constructor is deliberately private and unimplemented.
+   *
+   * \param rhs the object from which we are to be constructed
+   */
+  assignment_file(
+    const assignment_file   &rhs);
+
+  /*!
+   * \brief operator=() is deliberately private and unimplemented.
+   *
+   * \param rhs the object from which we are to be assigned
+   *
+   * \return reference to self to allow for chained operators
+   */
+  assignment_file &operator=(
+    const assignment_file   &rhs);
+
+  /*!
+   * \brief This is the implementation function for operator<<()
+   *
+   * \return The same stream as the input to allow for chained operators.
+   */
+  std::ostream &print_self(
+    std::ostream    &os)           /*!< The stream into which we stream     */
+  const;
+
+
+  /*!
+   * \brief Count the lines of a range of chunks
+   */
+  uint64_t count_lines(
+    std::ostream          &os,
+    const unsigned int     first,
+    const unsigned int     last);
+
+
+  /*!
+   * \brief Parse a range of chunks
+   */
+  uint64_t parse_chunks(
+    std::ostream          &os,
+    const unsigned int     first,
+    const unsigned int     last);
+
+
+  /*!
+   * \brief Join the parsed chunks in file order
+   */
+  void join();
+
+
+  //! Name used in diagnostics
+  std::string                 _name;
+
+  //! The text
+  const char                 *_data;
+
+  //! Number of characters
+  size_t                      _size;
+
+  //! Chunks of the text
+  std::vector<chunk>          _chunks;
+
+  //! Circuit name of each line
+  std::vector<span>           _line_name;
+
+  //! Line number of each line
+  std::vector<unsigned int>   _line_number;
+
+  //! Start of each line's entries; one extra at end
+  std::vector<unsigned int>   _line_first;
+
+  //! Juggler name of each entry
+  std::vector<span>           _entry_name;
+
+  //! Line of each entry
+  std::vector<unsigned int>   _entry_line;
+
+  //! Rank of the circuit of its line in each entry, or -1
+  std::vector<int>            _entry_rank;
+
+  //! Score of the circuit of its line in each entry
+  std::vector<int>            _entry_score;
+
+  //! Start of each entry's listed circuits; one extra at end
+  std::vector<unsigned int>   _entry_first;
+
+  //! Name of each listed circuit
+  std::vector<span>           _listed_name;
+
+  //! Score of each listed circuit
+  std::vector<int>            _listed_score;
+
+};
+
+#endif                             /* assignment_file_h_included            */
@@ -0,0 +1,61 @@
+#ifndef assignment_record_h_included
+#define assignment_record_h_included 1
+
+/*!
+ * \file assignment_record.h
+ *
+ * \brief Contains the layout of the binary assignment file
+ *
+ * \author Stewart L. Palmer
+ */
+
+#include <stdint.h>
+
+
+/*!
+ * \brief The start of a binary assignment file
+ *
+ * A binary assignment file, as written by scheduler::write_assignments(), is
+ * this header followed by one assignment_record per juggler, indexed by the
+ * juggler's position in the input file.  Everything is in the byte order of
+ * the machine that wrote it and every field is four byte aligned, so a reader
+ * can map the file and use the records in place.
+ */
+struct assignment_header
+{
+  //! "JUGGLEFA", not terminated
+  char           magic[8];
+
+  //! Version of the layout, which is 1
+  uint32_t       version;
+
+  //! Size of an assignment_record in bytes
+  uint32_t       record_size;
+
+  //! Number of jugglers, and of records
+  uint32_t       juggler_count;
+
+  //! Number of circuits
+  uint32_t       circuit_count;
+};
+
+
+/*!
+ * \brief The assignment of one juggler in a binary assignment file
+ */
+struct assignment_record
+{
+  //! Position in the input file of the circuit assigned, or -1 for none
+  int32_t        circuit;
+
+  //! Score of the juggler in that circuit
+  int32_t        score;
+
+  /*!
+   * Preference of the juggler for that circuit, zero for its first choice.  A
+   * circuit the juggler did not list ranks after every circuit it did.
+   */
+  int32_t        preference;
+};
+
+#endif                             /* assignment_record_h_included          */
@@ -0,0 +1,210 @@
+#ifndef assignment_snapshot_h_included
+#define assignment_snapshot_h_included 1
+
+/*!
+ * \file assignment_snapshot.h
+ *
+ * \brief Contains the definition of assignment_snapshot
+ *
+ * \author Stewart L. Palmer
+ */
+
+#include <iostream>
+#include <vector>
+#include <stdint.h>
+#include "daemon_protocol.h"
+
+
+/*!
+ * \brief The assignments as they were at one moment, never to change
+ *
+ * A snapshot_store publishes a new snapshot after every change to the
+ * scheduler, so a reader that holds a snapshot sees either all of an eviction
+ * chain or none of it, and never has to lock anything.
+ *
+ * Copying every assignment for every change would cost too much, so a snapshot
+ * is made of parts that are shared with the snapshot before it.  The jugglers
+ * are kept in pages of page_size entries, indexed by juggler number, and each
+ * circuit has a roster, indexed by circuit number.  The pointers to the pages
+ * and to the rosters are kept in blocks of block_size, and only the tables of
+ * pointers to the blocks belong to one snapshot.  A change copies the pages and
+ * rosters it touches, the blocks that point to them, and the two short tables.
+ */
+class assignment_snapshot
+{
+public:
+
+  //! Number of jugglers in a page
+  static const unsigned int page_size = 1024;
+
+  //! Number of pointers to pages or rosters in a block
+  static const unsigned int block_size = 1024;
+
+
+  /*!
+   * \brief The entries of page_size jugglers, by juggler number
+   *
+   * The juggler of an entry is -1 where no juggler has that number.
+   */
+  struct page
+  {
+    //! Entry of each juggler
+    daemon_entry   entries[page_size];
+  };
+
+
+  /*!
+   * \brief The jugglers assigned to one circuit
+   */
+  struct roster
+  {
+    //! The jugglers, best score first
+    std::vector<daemon_entry>   entries;
+
+    //! Sum of the numbers of the jugglers
+    int32_t                     sum;
+
+    //! Score a juggler must beat to get in, or INT_MIN if not full
+    int32_t                     cutoff;
+  };
+
+
+  /*!
+   * \brief block_size pointers to pages or rosters, shared by snapshots until
+   *        one of the pages or rosters changes
+   */
+  template <class T>
+  struct block
+  {
+    //! Each page or roster, or zero where there is none
+    const T        *items[block_size];
+  };
+
+  typedef block<page>     page_block;
+  typedef block<roster>   roster_block;
+
+
+  /*!
+   * \brief Standard constructor
+   */
+  explicit assignment_snapshot(
+    const uint64_t   version)      /*!< Number of the publication           */
+  :
+  _version(version)
+  { }
+
+
+  /*!
+   * \brief Return the number of the publication, counting from one
+   */
+  uint64_t version() const
+  { return _version; }
+
+
+  /*!
+   * \brief Return the entry of a juggler, or zero if there is none
+   */
+  const daemon_entry *locate(
+    const uint32_t   juggler)      /*!< Number of the juggler               */
+  const
+  {
+    const page *const pg = find(_page_blocks, juggler / page_size);
+    if (pg == 0)
+      return 0;
+    const daemon_entry *const e = &pg->entries[juggler % page_size];
+
+    return (e->juggler < 0) ? 0 : e;
+  }
+
+
+  /*!
+   * \brief Return the roster of a circuit, or zero if there is none
+   */
+  const roster *find_roster(
+    const uint32_t   circuit)      /*!< Number of the circuit               */
+  const
+  { return find(_roster_blocks, circuit); }
+
+
+  /*!
+   *  \brief Stream object out to a stream
+   *
+   * \return The same stream as the input to allow for chained operators.
+   */
+  friend std::ostream &operator<<(
+    std::ostream                &os,/*!< The stream into which we stream    */
+    const assignment_snapshot   &cn)/*!< The object to be streamed          */
+  {
+    return cn.print_self(os);
+  }
+
+private:
+
+  friend class snapshot_store;
+
+
+  /*!
+   * \brief The copy constructor is deliberately private and unimplemented.
+   *
+   * \param rhs the object from which we are to be constructed
+   */
+  assignment_snapshot(
+    const assignment_snapshot   &rhs);
+
+  /*!
+   * \brief operator=() is deliberately private and unimplemented.
+   *
+   * \param rhs the object from which we are to be assigned
+   *
+   * \return reference to self to allow for chained operators
+   */
+  assignment_snapshot &operator=(
+    const assignment_snapshot   &rhs);
+
+  /*!
+   * \brief This is the implementation function for operator<<()
+   *
+   * \return The same stream as the input to allow for chained operators.
+   */
+  std::ostream &print_self(
+    std::ostream    &os)           /*!< The stream into which we stream     */
+  const
+  {
+    os << "assignment_snapshot: version " << _version << ", " <<
+          _page_blocks.size() << " page blocks, " << _roster_blocks.size() <<
+          " roster blocks";
+
+    return os;
+  }
+
+
+  /*!
+   * \brief Return the page or roster of a number from a table of blocks, or
+   *        zero if there is none
+   */
+  template <class T>
+  static const T *find(
+    const std::vector<const block<T> *> &blocks,/*!< The table of blocks    */
+    const uint32_t                       number)/*!< Number of the page or
+                                                     roster                 */
+  {
+    const uint32_t b = number / block_size;
+    if ( (b >= blocks.size()) || (blocks[b] == 0) )
+      return 0;
+
+    return blocks[b]->items[number % block_size];
+  }
+
+
+  //! Number of the publication
+  const uint64_t                       _version;
+
+  //! Blocks of pages of juggler entries, zero where no juggler is numbered
+  std::vector<const page_block *>      _page_blocks;
+
+  //! Blocks of rosters of circuits, zero where no circuit is numbered
+  std::vector<const roster_block *>    _roster_blocks;
+
+};
+
+#endif                             /* assignment_snapshot_h_included        */
@@ -0,0 +1,637 @@
+
+/*!
+ * \file assignment_verifier.cpp
+ *
+ * \brief Contains the implementation of assignment_verifier
+ *
+ * \author Stewart L. Palmer
+ */
+
+#include <climits>
+#include <string.h>
+#include <ctype.h>
+#include <assert.h>
+#include "mapped_file.h"
+#include "parallel_phase.h"
+#include "assignment_verifier.h"
+
+using namespace ::std;
+
+
+namespace
+{
+
+/*!
+ * \brief Parse the three talents of a circuit or juggler definition
+ *
+ * \return Zero if all three talents are there, non-zero otherwise
+ */
+int parse_talents(
+  const char    *&p,
+  const char    *const end,
+  int           *talents)
+{
+  bool found[3] = { false, false, false };
+  for (unsigned int i = 0; i < 3; i++)
+    {
+      const char *token = 0;
+      const unsigned int size = line_scanner::next_token(p, end, token);
+      const char *const colon = static_cast<const char *>(memchr(token, ':', size));
+      if ( (size < 3) || (colon == 0) )
+        return 1;
+      int t = -1;
+      switch (toupper(token[0]))
+      {
+        case 'H':
+          t = 0;
+          break;
+        case 'E':
+          t = 1;
+          break;
+        case 'P':
+          t = 2;
+          break;
+        default:
+          return 1;
+      }
+      if (line_scanner::parse_number(colon + 1, token + size, talents[t]) != 0)
+        return 1;
+      found[t] = true;
+    }
+
+  return ( (found[0] && found[1] && found[2]) ? 0 : 1 );
+}
+
+
+/*!
+ * \brief Write the score needed to get into a circuit, or "open" if it has a
+ *        vacancy, as the scheduler's validation does
+ */
+void show_low(
+  ostream            &os,          /*!< Stream for the score                */
+  const int           low)         /*!< The score, or INT_MIN               */
+{
+  if (low == INT_MIN)
+    os << "open";
+  else
+    os << low;
+}
+
+
+}
+
+
+/*                                                                          */
+/****************************************************************************/
+/*     C O N S T R U C T O R                                                */
+/****************************************************************************/
+/*                                                                          */
+assignment_verifier::assignment_verifier(
+  const mapped_file    &instance,  /*!< The circuit and juggler definitions */
+  const mapped_file    &assignments)/*!< The assignments to verify          */
+  :
+  _instance(instance),
+  _file(assignments.name(), assignments.data(), assignments.size()),
+  _circuit_table(_circuit_name),
+  _juggler_table(_juggler_name),
+  _capacity(0),
+  _problem_count(0),
+  _blocking_pair_count(0),
+  _workers(1)
+{ }
+
+
+/*                                                                          */
+/****************************************************************************/
+/*     V E R I F Y                                                          */
+/****************************************************************************/
+/*                                                                          */
+int assignment_verifier::verify(
+  const unsigned int    workers,   /*!< Maximum number of worker threads    */
+  ostream              &os)        /*!< Stream for problem reports          */
+{
+  assert(workers > 0);
+  _workers = workers;
+  _problem_count = 0;
+  _blocking_pair_count = 0;
+
+  // Several chunks per worker evens out lines of different lengths
+  vector<const char *>  starts;
+  line_scanner::split(_instance.data(), _instance.size(), 4 * workers, starts);
+  _instance_chunks.assign(starts.size() - 1, chunk());
+  for (unsigned int i = 0; i < _instance_chunks.size(); i++)
+    {
+      _instance_chunks[i].first = starts[i];
+      _instance_chunks[i].last = starts[i + 1];
+      _instance_chunks[i].line = 0;
+    }
+  run_phase(&assignment_verifier::count_lines, _instance_chunks.size(), os);
+  unsigned int line = 1;
+  for (unsigned int i = 0; i < _instance_chunks.size(); i++)
+    {
+      const unsigned int lines = _instance_chunks[i].line;
+      _instance_chunks[i].line = line;
+      line += lines;
+    }
+
+  run_phase(&assignment_verifier::parse_instance, _instance_chunks.size(), os);
+  _problem_count += _file.parse(_workers, os);
+  _problem_count += join_instance(os);
+  _line_circuit.assign(_file.line_count(), -1);
+  _entry_juggler.assign(_file.entry_count(), -1);
+  _listed_circuit.assign(_file.entry_first(_file.entry_count()), -1);
+  run_phase(&assignment_verifier::resolve_preferences, juggler_count(), os);
+  run_phase(&assignment_verifier::resolve_assignments, _file.line_count(), os);
+  _problem_count += place_jugglers(os);
+  run_phase(&assignment_verifier::check_lines, _file.line_count(), os);
+  const uint64_t before = _problem_count;
+  run_phase(&assignment_verifier::check_jugglers, juggler_count(), os);
+  _blocking_pair_count = _problem_count - before;
+
+  return ( (_problem_count == 0) ? 0 : 1 );
+}
+
+
+/*                                                                          */
+/****************************************************************************/
+/*     R U N _ P H A S E                                                    */
+/****************************************************************************/
+/*                                                                          */
+void assignment_verifier::run_phase(
+  const phase_function   function, /*!< The work of the phase               */
+  const unsigned int     count,    /*!< Number of items                     */
+  ostream               &os)       /*!< Stream for problem reports          */
+{
+  parallel_phase<assignment_verifier>  phase(*this, function);
+  _problem_count += phase.run_in_order(count, _workers, os);
+}
+
+
+/*                                                                          */
+/****************************************************************************/
+/*     C O U N T _ L I N E S                                                */
+/****************************************************************************/
+/*                                                                          */
+uint64_t assignment_verifier::count_lines(
+  ostream               &os,
+  const unsigned int     first,
+  const unsigned int     last)
+{
+  (void) os;
+  for (unsigned int i = first; i < last; i++)
+    {
+      chunk &c = _instance_chunks[i];
+      c.line = line_scanner::count_lines(c.first, c.last);
+    }
+
+  return 0;
+}
+
+
+/*                                                                          */
+/****************************************************************************/
+/*     P A R S E _ I N S T A N C E                                          */
+/****************************************************************************/
+/*                                                                          */
+uint64_t assignment_verifier::parse_instance(
+  ostream               &os,
+  const unsigned int     first,
+  const unsigned int     last)
+{
+  uint64_t problems = 0;
+  for (unsigned int i = first; i < last; i++)
+    {
+      chunk &c = _instance_chunks[i];
+      unsigned int line = c.line;
+      const char *p = c.first;
+      while (p != c.last)
+      {
+        const char *end = static_cast<const char *>(memchr(p, '\n', c.last - p));
+        const char *const next = (end == 0) ? c.last : (end + 1);
+        if (end == 0)
+          end = c.last;
+
+        const char *token = 0;
+        const unsigned int size = line_scanner::next_token(p, end, token);
+        const char type = (size == 1) ? toupper(token[0]) : 0;
+        span name;
+        name.size = line_scanner::next_token(p, end, name.text);
+        int talents[3];
+        bool understood = false;
+        if ( (size == 0) && (name.size == 0) )
+          understood = true;         /* Blank line                            */
+        else if ( ((type == 'C') || (type == 'J')) && (name.size != 0) &&
+                  (parse_talents(p, end, talents) == 0) )
+          {
+            understood = true;
+            if (type == 'C')
+              {
+                c.circuit_name.push_back(name);
+                c.circuit_talent.insert(c.circuit_talent.end(), talents, talents + 3);
+              }
+            else
+              {
+                c.juggler_name.push_back(name);
+                c.juggler_talent.insert(c.juggler_talent.end(), talents, talents + 3);
+                const char *list = 0;
+                const unsigned int list_size = line_scanner::next_token(p, end, list);
+                const char *const list_end = list + list_size;
+                unsigned int count = 0;
+                while (list != list_end)
+                {
+                  const char *comma = static_cast<const char *>(memchr(list, ',', list_end - list));
+                  if (comma == 0)
+                    comma = list_end;
+                  span circ;
+                  circ.text = list;
+                  circ.size = comma - list;
+                  c.listed_name.push_back(circ);
+                  count++;
+                  list = (comma == list_end) ? list_end : (comma + 1);
+                }
+                c.juggler_circuits.push_back(count);
+              }
+          }
+        if ( !understood )
+          {
+            os << _instance.name() << ":" << line << ": Do not understand <" <<
+                  string(token, end - token) << ">" << endl;
+            problems++;
+          }
+        line++;
+        p = next;
+      }
+    }
+
+  return problems;
+}
+
+
+/*                                                                          */
+/****************************************************************************/
+/*     J O I N _ I N S T A N C E                                            */
+/****************************************************************************/
+/*                                                                          */
+uint64_t assignment_verifier::join_instance(
+  ostream               &os)
+{
+  uint64_t problems = 0;
+  _pref_first.push_back(0);
+  for (unsigned int i = 0; i < _instance_chunks.size(); i++)
+    {
+      chunk &c = _instance_chunks[i];
+      _circuit_name.insert(_circuit_name.end(), c.circuit_name.begin(), c.circuit_name.end());
+      _circuit_talent.insert(_circuit_talent.end(), c.circuit_talent.begin(), c.circuit_talent.end());
+      _juggler_name.insert(_juggler_name.end(), c.juggler_name.begin(), c.juggler_name.end());
+      _juggler_talent.insert(_juggler_talent.end(), c.juggler_talent.begin(), c.juggler_talent.end());
+      _pref_name.insert(_pref_name.end(), c.listed_name.begin(), c.listed_name.end());
+      for (unsigned int j = 0; j < c.juggler_circuits.size(); j++)
+        _pref_first.push_back(_pref_first.back() + c.juggler_circuits[j]);
+      vector<span>().swap(c.circuit_name);
+      vector<int>().swap(c.circuit_talent);
+      vector<span>().swap(c.juggler_name);
+      vector<int>().swap(c.juggler_talent);
+      vector<span>().swap(c.listed_name);
+      vector<unsigned int>().swap(c.juggler_circuits);
+    }
+
+  // Number the circuits and jugglers in the order they were defined
+  _circuit_table.reset();
+  for (unsigned int i = 0; i < _circuit_name.size(); i++)
+    {
+      if (_circuit_table.insert(i) >= 0)
+        {
+          os << "Circuit " << string(_circuit_name[i].text, _circuit_name[i].size) <<
+                " is defined more than once" << endl;
+          problems++;
+        }
+    }
+  _juggler_table.reset();
+  for (unsigned int i = 0; i < _juggler_name.size(); i++)
+    {
+      if (_juggler_table.insert(i) >= 0)
+        {
+          os << "Juggler " << string(_juggler_name[i].text, _juggler_name[i].size) <<
+                " is defined more than once" << endl;
+          problems++;
+        }
+    }
+
+  if ( (circuit_count() == 0) || ((juggler_count() % circuit_count()) != 0) )
+    {
+      os << "There are " << juggler_count() << " jugglers for " <<
+            circuit_count() << " circuits" << endl;
+      problems++;
+    }
+  else
+    _capacity = juggler_count() / circuit_count();
+  _pref_circuit.assign(_pref_name.size(), -1);
+
+  return problems;
+}
+
+
+/*                                                                          */
+/****************************************************************************/
+/*     R E S O L V E _ P R E F E R E N C E S                                */
+/****************************************************************************/
+/*                                                                          */
+uint64_t assignment_verifier::resolve_preferences(
+  ostream               &os,
+  const unsigned int     first,
+  const unsigned int     last)
+{
+  uint64_t problems = 0;
+  for (unsigned int j = first; j < last; j++)
+    {
+      for (unsigned int p = _pref_first[j]; p < _pref_first[j + 1]; p++)
+        {
+          const int c = _circuit_table.find(_pref_name[p]);
+          _pref_circuit[p] = c;
+          if (c < 0)
+            {
+              os << "Juggler " << string(_juggler_name[j].text, _juggler_name[j].size) <<
+                    " asks for circuit " << string(_pref_name[p].text, _pref_name[p].size) <<
+                    ", which is not defined" << endl;
+              problems++;
+            }
+        }
+    }
+
+  return problems;
+}
+
+
+/*                                                                          */
+/****************************************************************************/
+/*     R E S O L V E _ A S S I G N M E N T S                                */
+/****************************************************************************/
+/*                                                                          */
+uint64_t assignment_verifier::resolve_assignments(
+  ostream               &os,
+  const unsigned int     first,
+  const unsigned int     last)
+{
+  uint64_t problems = 0;
+  for (unsigned int l = first; l < last; l++)
+    {
+      const unsigned int line = _file.line_number(l);
+      const span &name = _file.line_name(l);
+      _line_circuit[l] = _circuit_table.find(name);
+      if (_line_circuit[l] < 0)
+        {
+          os << _file.name() << ":" << line << ": Circuit " <<
+                string(name.text, name.size) << " is not defined" << endl;
+          problems++;
+        }
+      for (unsigned int e = _file.line_first(l); e < _file.line_first(l + 1); e++)
+        {
+          const span &jug = _file.entry_name(e);
+          _entry_juggler[e] = _juggler_table.find(jug);
+          if (_entry_juggler[e] < 0)
+            {
+              os << _file.name() << ":" << line << ": Juggler " <<
+                    string(jug.text, jug.size) << " is not defined" << endl;
+              problems++;
+            }
+          for (unsigned int p = _file.entry_first(e); p < _file.entry_first(e + 1); p++)
+            {
+              const span &circ = _file.listed_name(p);
+              _listed_circuit[p] = _circuit_table.find(circ);
+              if (_listed_circuit[p] < 0)
+                {
+                  os << _file.name() << ":" << line << ": Circuit " <<
+                        string(circ.text, circ.size) << " is not defined" << endl;
+                  problems++;
+                }
+            }
+        }
+    }
+
+  return problems;
+}
+
+
+/*                                                                          */
+/****************************************************************************/
+/*     P L A C E _ J U G G L E R S                                          */
+/****************************************************************************/
+/*                                                                          */
+uint64_t assignment_verifier::place_jugglers(
+  ostream               &os)
+{
+  uint64_t problems = 0;
+  vector<unsigned int>  line_of(circuit_count(), 0);
+  _assigned.assign(juggler_count(), -1);
+  for (unsigned int l = 0; l < _file.line_count(); l++)
+    {
+      const int c = _line_circuit[l];
+      if (c < 0)
+        continue;
+      if (line_of[c] != 0)
+        {
+          const span &name = _file.line_name(l);
+          os << _file.name() << ":" << _file.line_number(l) << ": Circuit " <<
+                string(name.text, name.size) << " is already listed on line " << line_of[c] << endl;
+          problems++;
+          _line_circuit[l] = -1;   /* Only the first listing counts         */
+          continue;
+        }
+      line_of[c] = _file.line_number(l);
+      for (unsigned int e = _file.line_first(l); e < _file.line_first(l + 1); e++)
+        {
+          const int j = _entry_juggler[e];
+          if (j < 0)
+            continue;
+          if (_assigned[j] >= 0)
+            {
+              const span &jug = _file.entry_name(e);
+              os << _file.name() << ":" << _file.line_number(l) << ": Juggler " <<
+                    string(jug.text, jug.size) << " is already assigned to circuit " <<
+                    string(_circuit_name[_assigned[j]].text, _circuit_name[_assigned[j]].size) << endl;
+              problems++;
+              _entry_juggler[e] = -1;
+              continue;
+            }
+          _assigned[j] = c;
+        }
+    }
+
+  for (unsigned int c = 0; c < circuit_count(); c++)
+    {
+      if (line_of[c] == 0)
+        {
+          os << "Circuit " << string(_circuit_name[c].text, _circuit_name[c].size) <<
+                " is not listed" << endl;
+          problems++;
+        }
+    }
+  for (unsigned int j = 0; j < juggler_count(); j++)
+    {
+      if (_assigned[j] < 0)
+        {
+          os << "Juggler " << string(_juggler_name[j].text, _juggler_name[j].size) <<
+                " is not assigned!" << endl;
+          problems++;
+        }
+    }
+  _lowest.assign(circuit_count(), INT_MIN);
+
+  return problems;
+}
+
+
+/*                                                                          */
+/****************************************************************************/
+/*     C H E C K _ L I N E S                                                */
+/****************************************************************************/
+/*                                                                          */
+uint64_t assignment_verifier::check_lines(
+  ostream               &os,
+  const unsigned int     first,
+  const unsigned int     last)
+{
+  uint64_t problems = 0;
+  for (unsigned int l = first; l < last; l++)
+    {
+      const int c = _line_circuit[l];
+      if (c < 0)
+        continue;
+      const unsigned int line = _file.line_number(l);
+      const unsigned int count = _file.line_first(l + 1) - _file.line_first(l);
+      if (count != _capacity)
+        {
+          os << "Circuit " << string(_circuit_name[c].text, _circuit_name[c].size) <<
+                " is assigned " << count << " jugglers instead of the required " <<
+                _capacity << endl;
+          problems++;
+        }
+
+      bool have_low = false;
+      int low = INT_MIN;
+      for (unsigned int e = _file.line_first(l); e < _file.line_first(l + 1); e++)
+        {
+          const int j = _entry_juggler[e];
+          if (j < 0)
+            continue;
+          const span &jug = _file.entry_name(e);
+          const int s = score(j, c);
+          if ( !have_low || (s < low) )
+            low = s;
+          have_low = true;
+
+          // The circuits listed must be the juggler's own, in order, followed
+          // by this circuit if the juggler did not ask for it
+          const unsigned int pref_count = _pref_first[j + 1] - _pref_first[j];
+          const unsigned int listed_count = _file.entry_first(e + 1) - _file.entry_first(e);
+          bool asked = false;
+          for (unsigned int p = _pref_first[j]; p < _pref_first[j + 1]; p++)
+            if (_pref_circuit[p] == c)
+              asked = true;
+          bool same = (listed_count == (pref_count + (asked ? 0 : 1)));
+          for (unsigned int i = 0; same && (i < listed_count); i++)
+            {
+              const int expected = (i < pref_count) ? _pref_circuit[_pref_first[j] + i] : c;
+              if (_listed_circuit[_file.entry_first(e) + i] != expected)
+                same = false;
+            }
+          if ( !same )
+            {
+              os << _file.name() << ":" << line << ": Juggler " <<
+                    string(jug.text, jug.size) << " does not list the circuits it asked for" << endl;
+              problems++;
+            }
+
+          for (unsigned int p = _file.entry_first(e); p < _file.entry_first(e + 1); p++)
+            {
+              const int lc = _listed_circuit[p];
+              if ( (lc >= 0) && (_file.listed_score(p) != score(j, lc)) )
+                {
+                  const span &circ = _file.listed_name(p);
+                  os << _file.name() << ":" << line << ": Juggler " <<
+                        string(jug.text, jug.size) << " lists " <<
+                        string(circ.text, circ.size) << ":" <<
+                        _file.listed_score(p) << " but the score is " << score(j, lc) << endl;
+                  problems++;
+                }
+            }
+        }
+      _lowest[c] = (count < _capacity) ? INT_MIN : low;/* Open to anyone  */
+    }
+
+  return problems;
+}
+
+
+/*                                                                          */
+/****************************************************************************/
+/*     C H E C K _ J U G G L E R S                                          */
+/****************************************************************************/
+/*                                                                          */
+uint64_t assignment_verifier::check_jugglers(
+  ostream               &os,
+  const unsigned int     first,
+  const unsigned int     last)
+{
+  uint64_t problems = 0;
+  for (unsigned int j = first; j < last; j++)
+    {
+      const int c = _assigned[j];
+      if (c < 0)                   /* Reported by place_jugglers()          */
+        continue;
+
+      // A juggler outside its preferences checks all of them, and is shown with
+      // the preference scheduler::distribute_orphans() gives it
+      const unsigned int pref_count = _pref_first[j + 1] - _pref_first[j];
+      unsigned int assigned_pref = pref_count + 1;
+      unsigned int checked = pref_count;
+      for (unsigned int p = _pref_first[j]; p < _pref_first[j + 1]; p++)
+        if (_pref_circuit[p] == c)
+          {
+            assigned_pref = p - _pref_first[j];
+            checked = assigned_pref;
+            break;
+          }
+
+      for (unsigned int i = 0; i < checked; i++)
+        {
+          const int pc = _pref_circuit[_pref_first[j] + i];
+          if (pc < 0)
+            continue;
+          const int s = score(j, pc);
+          if (s > _lowest[pc])
+            {
+              os << string(_juggler_name[j].text, _juggler_name[j].size) <<
+                    " is assigned to " <<
+                    string(_circuit_name[c].text, _circuit_name[c].size) <<
+                    " (Pref " << assigned_pref << ", Score " << score(j, c) << ", Low = ";
+              show_low(os, _lowest[c]);
+              os << ").  Better fit in " <<
+                    string(_circuit_name[pc].text, _circuit_name[pc].size) <<
+                    " (Pref " << i << ", Score " << s << ", Low = ";
+              show_low(os, _lowest[pc]);
+              os << ")." << endl;
+              problems++;
+            }
+        }
+    }
+
+  return problems;
+}
+
+
+/*                                                                          */
+/****************************************************************************/
+/*     P R I N T _ S E L F                                                  */
+/****************************************************************************/
+/*                                                                          */
+ostream &assignment_verifier::print_self(
+  ostream    &os)                  /*!< The stream into which we stream     */
+const
+{
+  os << "assignment_verifier: " << circuit_count() << " circuits, " <<
+        juggler_count() << " jugglers, " << _problem_count << " problems, " <<
+        _blocking_pair_count << " blocking pairs";
+
+  return os;
+}
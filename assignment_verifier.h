@@ -0,0 +1,347 @@
+#ifndef assignment_verifier_h_included
+#define assignment_verifier_h_included 1
+
+/*!
+ * \file assignment_verifier.h
+ *
+ * \brief Contains the definition of assignment_verifier
+ *
+ * \author Stewart L. Palmer
+ */
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <stdint.h>
+#include "assignment_file.h"
+#include "line_scanner.h"
+#include "name_table.h"
+
+class mapped_file;
+
+
+/*!
+ * \brief Verifies an assignment file against the instance it claims to solve
+ *
+ * This does not use scheduler, so it can check the output of any program that
+ * writes the format of scheduler::show_assignments().  Both files are mapped
+ * into memory and parsed by a small hand written scanner rather than regular
+ * expressions.  The checks are:
+ *
+ * <ul>
+ * <li> Every line of both files can be understood, and every name refers to a
+ *      circuit or juggler of the instance.
+ * <li> Every circuit is listed once and holds exactly jugglers per circuit
+ *      jugglers.
+ * <li> Every juggler is listed once.
+ * <li> Every juggler lists the circuits of its definition in order, followed by
+ *      the circuit it was given if that is not one of them, and every listed
+ *      score is the dot product of the juggler and the circuit.
+ * <li> No juggler would be a better fit than the lowest scoring juggler of a
+ *      circuit that it prefers to its own.
+ * </ul>
+ *
+ * The work is split into phases.  Each phase runs on many threads through
+ * parallel_phase, so the diagnostics always come out in file order.  Only the
+ * steps that number the circuits and jugglers run on one thread.
+ */
+class assignment_verifier
+{
+public:
+
+  /*!
+   * \brief Standard constructor
+   *
+   * The files must stay mapped until the verifier is destroyed.
+   */
+  explicit assignment_verifier(
+    const mapped_file    &instance,/*!< The circuit and juggler definitions */
+    const mapped_file    &assignments/*!< The assignments to verify         */
+                              );
+
+
+  /*!
+   * \brief Verify the assignments
+   *
+   * \return Zero if no problems are found, non-zero otherwise
+   */
+  int verify(
+    const unsigned int    workers, /*!< Maximum number of worker threads    */
+    std::ostream         &os       /*!< Stream for problem reports          */
+            );
+
+
+  /*!
+   * \brief Return the number of circuits in the instance
+   */
+  unsigned int circuit_count() const
+  { return _circuit_name.size(); }
+
+
+  /*!
+   * \brief Return the number of jugglers in the instance
+   */
+  unsigned int juggler_count() const
+  { return _juggler_name.size(); }
+
+
+  /*!
+   * \brief Return the number of problems found, including blocking pairs
+   */
+  uint64_t problem_count() const
+  { return _problem_count; }
+
+
+  /*!
+   * \brief Return the number of blocking pairs found
+   */
+  uint64_t blocking_pair_count() const
+  { return _blocking_pair_count; }
+
+
+  /*!
+   *  \brief Stream object out to a stream
+   *
+   * \return The same stream as the input to allow for chained operators.
+   */
+  friend std::ostream &operator<<(
+    std::ostream                &os,/*!< The stream into which we stream    */
+    const assignment_verifier   &cn)/*!< The object to be streamed          */
+  {
+    return cn.print_self(os);
+  }
+
+private:
+
+  typedef line_scanner::span span;
+
+  /*!
+   * \brief What one chunk of the instance holds once parsed
+   *
+   * Chunks are parsed in parallel and then joined in file order.
+   */
+  struct chunk
+  {
+    //! First character of the chunk, which starts a line
+    const char                *first;
+
+    //! Just past the last character of the chunk
+    const char                *last;
+
+    //! Line number of the first line of the chunk
+    unsigned int               line;
+
+    //! Names of the circuits
+    std::vector<span>          circuit_name;
+
+    //! Talents of each circuit, three to a circuit
+    std::vector<int>           circuit_talent;
+
+    //! Names of the jugglers
+    std::vector<span>          juggler_name;
+
+    //! Talents of each juggler, three to a juggler
+    std::vector<int>           juggler_talent;
+
+    //! Number of circuits listed by each juggler
+    std::vector<unsigned int>  juggler_circuits;
+
+    //! Names of the circuits listed by the jugglers
+    std::vector<span>          listed_name;
+  };
+
+  //! Function run over a range of items by one worker of a phase
+  typedef uint64_t (assignment_verifier::*phase_function)(
+    std::ostream          &os,
+    const unsigned int     first,
+    const unsigned int     last);
+
+
+  /*!
+   * \brief The copy constructor is deliberately private and unimplemented.
+   *
+   * \param rhs the object from which we are to be constructed
+   */
+  assignment_verifier(
+    const assignment_verifier   &rhs);
+
+  /*!
+   * \brief operator=() is deliberately private and unimplemented.
+   *
+   * \param rhs the object from which we are to be assigned
+   *
+   * \return reference to self to allow for chained operators
+   */
+  assignment_verifier &operator=(
+    const assignment_verifier   &rhs);
+
+  /*!
+   * \brief This is the implementation function for operator<<()
+   *
+   * \return The same stream as the input to allow for chained operators.
+   */
+  std::ostream &print_self(
+    std::ostream    &os)           /*!< The stream into which we stream     */
+  const;
+
+
+  /*!
+   * \brief Run one phase over count items, and write its reports in order
+   */
+  void run_phase(
+    const phase_function   function,/*!< The work of the phase              */
+    const unsigned int     count,  /*!< Number of items                     */
+    std::ostream          &os      /*!< Stream for problem reports          */
+                );
+
+
+  /*!
+   * \brief Count the lines of a range of chunks of the instance
+   */
+  uint64_t count_lines(
+    std::ostream          &os,
+    const unsigned int     first,
+    const unsigned int     last);
+
+
+  /*!
+   * \brief Parse a range of chunks of the instance
+   */
+  uint64_t parse_instance(
+    std::ostream          &os,
+    const unsigned int     first,
+    const unsigned int     last);
+
+
+  /*!
+   * \brief Join the parsed chunks and number the circuits and jugglers
+   */
+  uint64_t join_instance(
+    std::ostream          &os);
+
+
+  /*!
+   * \brief Find the circuits listed by a range of jugglers of the instance
+   */
+  uint64_t resolve_preferences(
+    std::ostream          &os,
+    const unsigned int     first,
+    const unsigned int     last);
+
+
+  /*!
+   * \brief Find the circuits and jugglers of a range of assignment lines
+   */
+  uint64_t resolve_assignments(
+    std::ostream          &os,
+    const unsigned int     first,
+    const unsigned int     last);
+
+
+  /*!
+   * \brief Record which circuit holds each juggler, reporting duplicates
+   */
+  uint64_t place_jugglers(
+    std::ostream          &os);
+
+
+  /*!
+   * \brief Check the listed circuits and scores of a range of assignment lines,
+   *        and find the lowest score of each of their circuits
+   */
+  uint64_t check_lines(
+    std::ostream          &os,
+    const unsigned int     first,
+    const unsigned int     last);
+
+
+  /*!
+   * \brief Check a range of jugglers for blocking pairs
+   */
+  uint64_t check_jugglers(
+    std::ostream          &os,
+    const unsigned int     first,
+    const unsigned int     last);
+
+
+  /*!
+   * \brief Return the score of a juggler in a circuit
+   */
+  int score(
+    const int              jug,    /*!< Index of the juggler                */
+    const int              circ)   /*!< Index of the circuit                */
+  const
+  {
+    const int *const j = &_juggler_talent[3 * jug];
+    const int *const c = &_circuit_talent[3 * circ];
+
+    return (j[0] * c[0] + j[1] * c[1] + j[2] * c[2]);
+  }
+
+
+  //! The circuit and juggler definitions
+  const mapped_file          &_instance;
+
+  //! The parsed assignments
+  assignment_file             _file;
+
+  //! Chunks of the instance
+  std::vector<chunk>          _instance_chunks;
+
+  //! Name of each circuit, by circuit index
+  std::vector<span>           _circuit_name;
+
+  //! Talents of each circuit, three to a circuit
+  std::vector<int>            _circuit_talent;
+
+  //! Circuit indexes by name
+  name_table                  _circuit_table;
+
+  //! Name of each juggler, by juggler index
+  std::vector<span>           _juggler_name;
+
+  //! Talents of each juggler, three to a juggler
+  std::vector<int>            _juggler_talent;
+
+  //! Juggler indexes by name
+  name_table                  _juggler_table;
+
+  //! Start of each juggler's preferences in the _pref arrays; one extra at end
+  std::vector<unsigned int>   _pref_first;
+
+  //! Name of each preferred circuit
+  std::vector<span>           _pref_name;
+
+  //! Index of each preferred circuit, or -1 if it does not exist
+  std::vector<int>            _pref_circuit;
+
+  //! Circuit index of each assignment line, or -1
+  std::vector<int>            _line_circuit;
+
+  //! Juggler index of each entry, or -1
+  std::vector<int>            _entry_juggler;
+
+  //! Index of each listed circuit, or -1
+  std::vector<int>            _listed_circuit;
+
+  //! Circuit holding each juggler, or -1
+  std::vector<int>            _assigned;
+
+  //! Lowest score of the jugglers held by each full circuit, INT_MIN if open
+  std::vector<int>            _lowest;
+
+  //! Jugglers per circuit
+  unsigned int                _capacity;
+
+  //! Number of problems found
+  uint64_t                    _problem_count;
+
+  //! Number of blocking pairs found
+  uint64_t                    _blocking_pair_count;
+
+  //! Maximum number of worker threads
+  unsigned int                _workers;
+
+};
+
+#endif                             /* assignment_verifier_h_included        */
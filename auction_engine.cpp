@@ -0,0 +1,435 @@
+
+/*!
+ * \file auction_engine.cpp
+ *
+ * \brief Contains the implementation of auction_engine
+ *
+ * \author Stewart L. Palmer
+ */
+
+#include <assert.h>
+#include "juggler_circuit.h"
+#include "circuit.h"
+#include "parallel_task.h"
+#include "auction_engine.h"
+
+using namespace ::std;
+
+//! Entries in the heap of cheap slots for each slot, stale ones included,
+//! beyond which the heap is rebuilt from the prices
+static const unsigned int cheap_entries_per_slot = 2;
+
+
+/*!
+ * \brief Computes the bids of a range of unassigned jugglers
+ *
+ * Bids only read the prices, so the jugglers can bid in parallel.  Each juggler
+ * writes only its own entries in the bid arrays.
+ */
+class auction_bidder : public parallel_task
+{
+public:
+
+  /*!
+   * \brief Standard constructor
+   */
+  explicit auction_bidder(
+    auction_engine   &engine,      /*!< The auction                         */
+    const int64_t     eps)         /*!< Minimum bid increment               */
+  :
+  _engine(engine),
+  _eps(eps)
+  { }
+
+protected:
+
+  /*!
+   * \brief Make the bids of the unassigned jugglers [first, last)
+   */
+  virtual void do_range(
+    const unsigned int   worker,
+    const unsigned int   first,
+    const unsigned int   last)
+  {
+    (void) worker;
+    for (unsigned int i = first; i < last; i++)
+      _engine.make_bid(_engine._unassigned[i], _eps);
+  }
+
+private:
+
+  //! The auction
+  auction_engine   &_engine;
+
+  //! Minimum bid increment
+  const int64_t     _eps;
+
+};
+
+
+/*                                                                          */
+/****************************************************************************/
+/*     C O N S T R U C T O R                                                */
+/****************************************************************************/
+/*                                                                          */
+auction_engine::auction_engine(
+  const vector<juggler *>  &jugglers,/*!< All jugglers by index             */
+  const vector<circuit *>  &circuits,/*!< All circuits by index             */
+  const unsigned int        capacity)/*!< Jugglers per circuit              */
+  :
+  _jugglers(jugglers),
+  _circuits(circuits),
+  _capacity(capacity),
+  _cheapest(-1),
+  _next_cheapest(-1),
+  _max_value(0),
+  _phase_count(0),
+  _round_count(0),
+  _bid_count(0)
+{
+  const unsigned int n = _jugglers.size();
+  assert(n == (_circuits.size() * _capacity));
+
+  // Flatten the preferences, scaling the scores so that epsilon of one at the
+  // end of the auction leaves the assignment exactly optimal
+  const int64_t scale = (int64_t) n + 1;
+  _pref_first.reserve(n + 1);
+  for (unsigned int j = 0; j < n; j++)
+    {
+      _pref_first.push_back(_pref_circuit.size());
+      const juggler &jug = *_jugglers[j];
+      assert(jug.index() == (int) j);
+      for (unsigned int i = 0; i < jug.request_count(); i++)
+        {
+          const juggler_circuit &jc = jug.request(i);
+          const int64_t value = scale * jc.score();
+          _pref_circuit.push_back(jc.circ().index());
+          _pref_value.push_back(value);
+          _pref_jc.push_back(&jc);
+          if (value > _max_value)
+            _max_value = value;
+        }
+    }
+  _pref_first.push_back(_pref_circuit.size());
+
+  const unsigned int m = n;        /* One slot for every juggler            */
+  _price.assign(m, 0);
+  _owner.assign(m, -1);
+  _slot_of.assign(n, -1);
+  _bid_slot.assign(n, -1);
+  _bid_amount.assign(n, 0);
+  _round_bid.assign(m, 0);
+  _round_bidder.assign(m, -1);
+  _round_stamp.assign(m, 0);
+  rebuild_cheap_slots();
+}
+
+
+/*                                                                          */
+/****************************************************************************/
+/*     S O L V E                                                            */
+/****************************************************************************/
+/*                                                                          */
+void auction_engine::solve(
+  const unsigned int   workers)    /*!< Number of threads used for bidding  */
+{
+  int64_t eps = _max_value / 2;
+  if (eps < 1)
+    eps = 1;
+  for (;;)
+  {
+    run_phase(eps, workers);
+    if (eps == 1)
+      break;
+    eps /= 5;
+    if (eps < 1)
+      eps = 1;
+  }
+}
+
+
+/*                                                                          */
+/****************************************************************************/
+/*     R U N _ P H A S E                                                    */
+/****************************************************************************/
+/*                                                                          */
+void auction_engine::run_phase(
+  const int64_t        eps,        /*!< Minimum bid increment               */
+  const unsigned int   workers)    /*!< Number of threads used for bidding  */
+{
+  // Every phase starts with nobody assigned but keeps the prices
+  _phase_count++;
+  _owner.assign(_owner.size(), -1);
+  _slot_of.assign(_slot_of.size(), -1);
+  _unassigned.clear();
+  for (unsigned int j = 0; j < _jugglers.size(); j++)
+    _unassigned.push_back(j);
+
+  vector<unsigned int>  still_unassigned;
+  while (_unassigned.size() != 0)
+  {
+    _round_count++;
+    _bid_count += _unassigned.size();
+    find_cheapest_slots();
+    auction_bidder  bidder(*this, eps);
+    bidder.set_pool(&_pool);
+    bidder.run(_unassigned.size(), workers);
+
+    // Find the highest bid for each slot; earlier jugglers win ties
+    const unsigned int stamp = _round_count;
+    for (unsigned int i = 0; i < _unassigned.size(); i++)
+      {
+        const unsigned int j = _unassigned[i];
+        const int s = _bid_slot[j];
+        if ( (_round_stamp[s] != stamp) || (_bid_amount[j] > _round_bid[s]) )
+          {
+            _round_stamp[s] = stamp;
+            _round_bid[s] = _bid_amount[j];
+            _round_bidder[s] = j;
+          }
+      }
+
+    // Hand each slot to its highest bidder, which displaces the previous holder
+    still_unassigned.clear();
+    for (unsigned int i = 0; i < _unassigned.size(); i++)
+      {
+        const unsigned int j = _unassigned[i];
+        const int s = _bid_slot[j];
+        if (_round_bidder[s] != (int) j)
+          {
+            still_unassigned.push_back(j);
+            continue;
+          }
+        const int previous = _owner[s];
+        if (previous >= 0)
+          {
+            _slot_of[previous] = -1;
+            still_unassigned.push_back(previous);
+          }
+        _owner[s] = j;
+        _slot_of[j] = s;
+        _price[s] = _round_bid[s];
+        _cheap.push(priced_slot(_price[s], s));
+      }
+    _unassigned.swap(still_unassigned);
+
+    // Every assignment leaves a stale entry behind, so the heap would grow
+    // with the bids rather than with the slots
+    if (_cheap.size() > cheap_entries_per_slot * _price.size())
+      rebuild_cheap_slots();
+  }
+}
+
+
+/*                                                                          */
+/****************************************************************************/
+/*     F I N D _ C H E A P E S T _ S L O T S                                */
+/****************************************************************************/
+/*                                                                          */
+void auction_engine::find_cheapest_slots()
+{
+  // Prices only go up, so an entry whose price is not current is stale
+  while (_cheap.top().first != _price[_cheap.top().second])
+    _cheap.pop();
+  const priced_slot cheapest = _cheap.top();
+  _cheapest = cheapest.second;
+  _cheap.pop();
+
+  _next_cheapest = -1;
+  while ( (_cheap.size() != 0) &&
+          (_cheap.top().first != _price[_cheap.top().second]) )
+    _cheap.pop();
+  if (_cheap.size() != 0)
+    _next_cheapest = _cheap.top().second;
+  _cheap.push(cheapest);
+}
+
+
+/*                                                                          */
+/****************************************************************************/
+/*     R E B U I L D _ C H E A P _ S L O T S                                */
+/****************************************************************************/
+/*                                                                          */
+void auction_engine::rebuild_cheap_slots()
+{
+  vector<priced_slot> slots;
+  slots.reserve(_price.size());
+  for (unsigned int s = 0; s < _price.size(); s++)
+    slots.push_back(priced_slot(_price[s], s));
+  _cheap = priority_queue<priced_slot, vector<priced_slot>, greater<priced_slot> >(
+             greater<priced_slot>(), slots);
+}
+
+
+/*                                                                          */
+/****************************************************************************/
+/*     M A K E _ B I D                                                      */
+/****************************************************************************/
+/*                                                                          */
+void auction_engine::make_bid(
+  const unsigned int   jug_index,  /*!< Index of the juggler                */
+  const int64_t        eps)        /*!< Minimum bid increment               */
+{
+  // Find the best and second best net values over distinct slots.  Options for
+  // the same slot can only overstate the second best value, which makes the
+  // bid smaller but never breaks epsilon complementary slackness.
+  bool     have_best = false;
+  bool     have_second = false;
+  int64_t  best = 0;
+  int64_t  second = 0;
+  int      best_slot = -1;
+
+  int64_t  values[4];
+  int      slots[4];
+  unsigned int option_count = 0;
+
+  // Any slot at all is worth zero to the juggler
+  values[option_count] = -_price[_cheapest];
+  slots[option_count++] = _cheapest;
+  if (_next_cheapest >= 0)
+    {
+      values[option_count] = -_price[_next_cheapest];
+      slots[option_count++] = _next_cheapest;
+    }
+
+  const unsigned int last = _pref_first[jug_index + 1];
+  unsigned int p = _pref_first[jug_index];
+  for (;;)
+  {
+    for (unsigned int o = 0; o < option_count; o++)
+      {
+        const int64_t v = values[o];
+        const int s = slots[o];
+        if (have_best && (s == best_slot))
+          {
+            if (v > best)
+              best = v;
+          }
+        else if ( !have_best || (v > best) )
+          {
+            if (have_best && ( !have_second || (best > second) ))
+              {
+                second = best;
+                have_second = true;
+              }
+            best = v;
+            best_slot = s;
+            have_best = true;
+          }
+        else if ( !have_second || (v > second) )
+          {
+            second = v;
+            have_second = true;
+          }
+      }
+    if (p == last)
+      break;
+
+    // The two cheapest slots of the next preferred circuit
+    const unsigned int first_slot = _pref_circuit[p] * _capacity;
+    int low = -1;
+    int next_low = -1;
+    for (unsigned int s = first_slot; s < (first_slot + _capacity); s++)
+      {
+        if ( (low < 0) || (_price[s] < _price[low]) )
+          {
+            next_low = low;
+            low = s;
+          }
+        else if ( (next_low < 0) || (_price[s] < _price[next_low]) )
+          next_low = s;
+      }
+    option_count = 0;
+    values[option_count] = _pref_value[p] - _price[low];
+    slots[option_count++] = low;
+    if (next_low >= 0)
+      {
+        values[option_count] = _pref_value[p] - _price[next_low];
+        slots[option_count++] = next_low;
+      }
+    p++;
+  }
+
+  assert(have_best);
+  if ( !have_second )              /* Only one slot exists at all           */
+    second = best;
+  _bid_slot[jug_index] = best_slot;
+  _bid_amount[jug_index] = _price[best_slot] + (best - second) + eps;
+}
+
+
+/*                                                                          */
+/****************************************************************************/
+/*     A S S I G N M E N T                                                  */
+/****************************************************************************/
+/*                                                                          */
+const juggler_circuit *auction_engine::assignment(
+  const unsigned int   jug_index)  /*!< Index of the juggler                */
+const
+{
+  const int s = _slot_of[jug_index];
+  assert(s >= 0);
+  const int c = s / _capacity;
+  const juggler_circuit *jc = 0;
+  for (unsigned int p = _pref_first[jug_index]; p < _pref_first[jug_index + 1]; p++)
+    {
+      if (_pref_circuit[p] == c)
+        {
+          jc = _pref_jc[p];
+          break;
+        }
+    }
+
+  return jc;
+}
+
+
+/*                                                                          */
+/****************************************************************************/
+/*     A S S I G N E D _ C I R C U I T                                      */
+/****************************************************************************/
+/*                                                                          */
+circuit *auction_engine::assigned_circuit(
+  const unsigned int   jug_index)  /*!< Index of the juggler                */
+const
+{
+  const int s = _slot_of[jug_index];
+  assert(s >= 0);
+
+  return _circuits[s / _capacity];
+}
+
+
+/*                                                                          */
+/****************************************************************************/
+/*     T O T A L _ S C O R E                                                */
+/****************************************************************************/
+/*                                                                          */
+int64_t auction_engine::total_score() const
+{
+  int64_t total = 0;
+  for (unsigned int j = 0; j < _jugglers.size(); j++)
+    {
+      const juggler_circuit *const jc = assignment(j);
+      if (jc != 0)
+        total += jc->score();
+    }
+
+  return total;
+}
+
+
+/*                                                                          */
+/****************************************************************************/
+/*     P R I N T _ S E L F                                                  */
+/****************************************************************************/
+/*                                                                          */
+ostream &auction_engine::print_self(
+  ostream    &os)                  /*!< The stream into which we stream     */
+const
+{
+  os << "auction_engine: " << _phase_count << " phases, " << _round_count <<
+        " rounds, " << _bid_count << " bids";
+
+  return os;
+}
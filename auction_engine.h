@@ -0,0 +1,279 @@
+#ifndef auction_engine_h_included
+#define auction_engine_h_included 1
+
+/*!
+ * \file auction_engine.h
+ *
+ * \brief Contains the definition of auction_engine
+ *
+ * \author Stewart L. Palmer
+ */
+
+#include <iostream>
+#include <vector>
+#include <queue>
+#include <functional>
+#include <stdint.h>
+#include "worker_pool.h"
+
+class circuit;
+class juggler;
+class juggler_circuit;
+class auction_bidder;
+
+
+/*!
+ * \brief Finds the assignment of jugglers to circuits with the highest total
+ *        score, using the auction algorithm of Bertsekas with epsilon scaling
+ *
+ * Unlike scheduler::assign(), this ignores stability.  It maximizes the sum of
+ * the scores of all jugglers placed in one of their preferred circuits, subject
+ * to every circuit holding exactly jugglers_per_circuit() jugglers.
+ *
+ * Each circuit is split into jugglers_per_circuit() identical slots, and each
+ * slot has a price.  A juggler values a slot in one of its preferred circuits at
+ * its score for that circuit, and any other slot at zero.  Since there are as
+ * many slots as jugglers this is a square assignment problem, and every juggler
+ * always has a slot to bid for.  Jugglers that end up in a slot outside their
+ * preferences are the orphans of this assignment.
+ *
+ * The auction runs in rounds.  In each round every unassigned juggler bids for
+ * the slot that gives it the most value net of price, raising the price by the
+ * margin over its second best choice plus epsilon.  Bids are computed in
+ * parallel, since they only read the prices, and each slot then goes to its
+ * highest bidder.  Scores are multiplied by one more than the number of jugglers
+ * so that the final pass with epsilon of one is exactly optimal.  Earlier passes
+ * with larger epsilon quickly bring the prices close to their final values.
+ */
+class auction_engine
+{
+public:
+
+  /*!
+   * \brief Standard constructor
+   *
+   * The vectors are indexed by the dense index of each juggler and circuit, and
+   * must outlive the engine.  The number of jugglers must equal the number of
+   * circuits times the capacity.
+   */
+  explicit auction_engine(
+    const std::vector<juggler *>  &jugglers,/*!< All jugglers by index      */
+    const std::vector<circuit *>  &circuits,/*!< All circuits by index      */
+    const unsigned int             capacity /*!< Jugglers per circuit       */
+                          );
+
+
+  /*!
+   * \brief Run the auction
+   */
+  void solve(
+    const unsigned int   workers   /*!< Number of threads used for bidding  */
+            );
+
+
+  /*!
+   * \brief Return the preferred circuit won by a juggler
+   *
+   * \return The juggler_circuit for the juggler's slot, or zero if the juggler
+   *         ended up in a circuit it did not ask for
+   */
+  const juggler_circuit *assignment(
+    const unsigned int   jug_index /*!< Index of the juggler                */
+                                   )
+  const;
+
+
+  /*!
+   * \brief Return the circuit of the slot won by a juggler
+   */
+  circuit *assigned_circuit(
+    const unsigned int   jug_index /*!< Index of the juggler                */
+                           )
+  const;
+
+
+  /*!
+   * \brief Return the total score of all jugglers placed in preferred circuits
+   */
+  int64_t total_score() const;
+
+
+  /*!
+   * \brief Return the number of epsilon scaling phases run
+   */
+  unsigned int phase_count() const
+  { return _phase_count; }
+
+
+  /*!
+   * \brief Return the number of bidding rounds run over all phases
+   */
+  unsigned int round_count() const
+  { return _round_count; }
+
+
+  /*!
+   * \brief Return the number of bids made over all phases
+   */
+  uint64_t bid_count() const
+  { return _bid_count; }
+
+
+  /*!
+   *  \brief Stream object out to a stream
+   *
+   * \return The same stream as the input to allow for chained operators.
+   */
+  friend std::ostream &operator<<(
+    std::ostream           &os,    /*!< The stream into which we stream     */
+    const auction_engine   &cn)    /*!< The object to be streamed           */
+  {
+    return cn.print_self(os);
+  }
+
+private:
+
+  friend class auction_bidder;
+
+  //! A slot price and slot index, as kept in the heap of cheap slots
+  typedef std::pair<int64_t, int>     priced_slot;
+
+
+  /*!
+   * \brief The copy constructor is deliberately private and unimplemented.
+   *
+   * \param rhs the object from which we are to be constructed
+   */
+  auction_engine(
+    const auction_engine   &rhs);
+
+  /*!
+   * \brief operator=() is deliberately private and unimplemented.
+   *
+   * \param rhs the object from which we are to be assigned
+   *
+   * \return reference to self to allow for chained operators
+   */
+  auction_engine &operator=(
+    const auction_engine   &rhs);
+
+  /*!
+   * \brief This is the implementation function for operator<<()
+   *
+   * \return The same stream as the input to allow for chained operators.
+   */
+  std::ostream &print_self(
+    std::ostream    &os)           /*!< The stream into which we stream     */
+  const;
+
+
+  /*!
+   * \brief Run one phase of the auction with a given epsilon
+   */
+  void run_phase(
+    const int64_t        eps,      /*!< Minimum bid increment               */
+    const unsigned int   workers   /*!< Number of threads used for bidding  */
+                );
+
+
+  /*!
+   * \brief Compute the bid of one juggler from the current prices
+   */
+  void make_bid(
+    const unsigned int   jug_index,/*!< Index of the juggler                */
+    const int64_t        eps       /*!< Minimum bid increment               */
+               );
+
+
+  /*!
+   * \brief Find the two cheapest slots of all
+   *
+   * Stale heap entries, left behind when a price went up, are discarded here.
+   */
+  void find_cheapest_slots();
+
+
+  /*!
+   * \brief Rebuild the heap of cheap slots with one entry for each slot
+   *
+   * This runs in O(s), where s is the number of slots.
+   */
+  void rebuild_cheap_slots();
+
+
+  //! All jugglers by index
+  const std::vector<juggler *>    &_jugglers;
+
+  //! All circuits by index
+  const std::vector<circuit *>    &_circuits;
+
+  //! Number of slots in each circuit
+  const unsigned int               _capacity;
+
+  //! Start of each juggler's preferences in the _pref arrays; one extra at end
+  std::vector<unsigned int>        _pref_first;
+
+  //! Circuit index of each preference
+  std::vector<int>                 _pref_circuit;
+
+  //! Scaled score of each preference
+  std::vector<int64_t>             _pref_value;
+
+  //! The juggler_circuit of each preference
+  std::vector<const juggler_circuit *> _pref_jc;
+
+  //! Current price of each slot
+  std::vector<int64_t>             _price;
+
+  //! Juggler holding each slot, or -1
+  std::vector<int>                 _owner;
+
+  //! Slot held by each juggler, or -1
+  std::vector<int>                 _slot_of;
+
+  //! Slot each juggler bids for in the current round
+  std::vector<int>                 _bid_slot;
+
+  //! Amount each juggler bids in the current round
+  std::vector<int64_t>             _bid_amount;
+
+  //! Highest bid for each slot in the round given by _round_stamp
+  std::vector<int64_t>             _round_bid;
+
+  //! Juggler with the highest bid for each slot in the round of _round_stamp
+  std::vector<int>                 _round_bidder;
+
+  //! The round in which _round_bid and _round_bidder were last set
+  std::vector<unsigned int>        _round_stamp;
+
+  //! Jugglers without a slot in the current round
+  std::vector<unsigned int>        _unassigned;
+
+  //! Heap of slots by price; may hold stale entries
+  std::priority_queue<priced_slot, std::vector<priced_slot>,
+                      std::greater<priced_slot> >  _cheap;
+
+  //! The cheapest slot of all in the current round
+  int                              _cheapest;
+
+  //! The second cheapest slot of all in the current round
+  int                              _next_cheapest;
+
+  //! Largest scaled score of any preference
+  int64_t                          _max_value;
+
+  //! Number of epsilon scaling phases run
+  unsigned int                     _phase_count;
+
+  //! Number of bidding rounds run
+  unsigned int                     _round_count;
+
+  //! Number of bids made
+  uint64_t                         _bid_count;
+
+  //! Threads that make the bids of every round
+  worker_pool                      _pool;
+
+};
+
+#endif                             /* auction_engine_h_included             */
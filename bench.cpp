@@ -0,0 +1,821 @@
+
+/*!
+ * \file bench.cpp
+ *
+ * \brief Main program for benchmarking the solvers over a range of festivals
+ *
+ * \author Stewart L. Palmer
+ */
+
+#include <algorithm>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <sys/time.h>
+#include <sys/wait.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "festival_definition.h"
+#include "festival_generator.h"
+#include "festival_instance.h"
+#include "festival_solution.h"
+#include "memory_usage.h"
+#include "parallel_task.h"
+#include "scheduler.h"
+
+using namespace ::std;
+
+
+/*!
+ * \brief What to run and over what
+ */
+struct bench_options
+{
+  //! Numbers of jugglers
+  vector<unsigned int>   sizes;
+
+  //! Numbers of preferences of each juggler
+  vector<unsigned int>   lengths;
+
+  //! Numbers of worker threads
+  vector<unsigned int>   threads;
+
+  //! Popularities, as given to festival_generator::set_popularity()
+  vector<string>         popularities;
+
+  //! Number of withdrawals, and of additions, timed after each assignment
+  unsigned int           operations;
+
+  //! Seed of the festivals
+  unsigned int           seed;
+};
+
+
+/*!
+ * \brief How a metric of the regression gate is compared with its baseline
+ */
+enum gate_kind
+{
+  gate_throughput,                 /*!< Timed; higher is better             */
+  gate_memory,                     /*!< Measured; lower is better           */
+  gate_count                       /*!< Exact; lower is better              */
+};
+
+
+/*!
+ * \brief A metric of the regression gate, as named in the results of a case
+ */
+struct gate_metric
+{
+  //! Name of the number in the results
+  const char    *name;
+
+  //! How it is compared
+  gate_kind      kind;
+
+  //! True if it is a result of the scheduler, false of festival_solution
+  bool           pipeline;
+
+  //! True if it depends on the machine, and so is only compared with -x
+  bool           machine;
+};
+
+
+//! The metrics of the regression gate; festival_solution solves the gate's
+//! festivals too quickly for its throughput to be timed
+static const gate_metric gate_metrics[] =
+{
+  { "proposals",           gate_count,      true,  false },
+  { "evictions",           gate_count,      true,  false },
+  { "bytes_per_juggler",   gate_memory,     true,  false },
+  { "jugglers_per_second", gate_throughput, true,  true  },
+  { "peak_rss_kb",         gate_memory,     true,  true  },
+  { "proposals",           gate_count,      false, false },
+  { "peak_rss_kb",         gate_memory,     false, true  }
+};
+
+//! Number of metrics of the regression gate
+static const unsigned int gate_metric_count = sizeof(gate_metrics) / sizeof(gate_metrics[0]);
+
+//! Times the regression gate runs each case for the metrics of the machine,
+//! keeping the best of each
+static const unsigned int gate_runs = 3;
+
+
+/*!
+ * \brief A small, fast generator of pseudo-random numbers for the jugglers
+ *        added and withdrawn, the same on every machine for the same seed
+ */
+class bench_random
+{
+public:
+
+  /*!
+   * \brief Standard constructor
+   */
+  explicit bench_random(
+    const uint64_t   seed)         /*!< The seed                            */
+  :
+  _state(seed * 2 + 1)
+  { }
+
+
+  /*!
+   * \brief Return a number from zero up to but not including limit
+   */
+  unsigned int below(
+    const unsigned int   limit)    /*!< One more than the largest result    */
+  {
+    static const uint64_t multiplier = ((uint64_t) 0x5851f42d << 32) | 0x4c957f2d;
+    static const uint64_t increment = ((uint64_t) 0x14057b7e << 32) | 0xf767814f;
+    _state = _state * multiplier + increment;
+    return (unsigned int) ((_state >> 32) % limit);
+  }
+
+private:
+
+  //! The state of the generator
+  uint64_t   _state;
+
+};
+
+
+/*!
+ * \brief Print the command line usage
+ */
+static void usage(
+  const char   *program)           /*!< Name of the program                 */
+{
+  cerr << "usage: " << program << " [-n jugglers] [-l preferences] [-t threads] [-m popularities]\n"
+          "       [-i operations] [-r seed] [-p] [-o file]\n"
+          "       " << program << " -g baseline [-w] [-x] [-e tolerance] [-o file]\n"
+          "  -n jugglers     numbers of jugglers, comma separated, 12000,120000 by default\n"
+          "  -l preferences  numbers of preferences of each juggler, 10 by default\n"
+          "  -t threads      numbers of worker threads, 1 by default\n"
+          "  -m popularities popularities of the circuits, as for generate, comma\n"
+          "                  separated, uniform by default\n"
+          "  -i operations   withdrawals and additions timed after each assignment,\n"
+          "                  1000 by default\n"
+          "  -r seed         seed of the festivals, 1 by default\n"
+          "  -p              also count cycles, instructions and cache, branch and\n"
+          "                  TLB misses of each phase of the scheduler\n"
+          "  -g baseline     instead, run the fixed regression set and compare it with\n"
+          "                  the baseline file; exit non-zero if anything regressed\n"
+          "  -w              with -g, write the baseline file from this run instead\n"
+          "  -x              with -g, also compare throughput and the peak resident\n"
+          "                  set, which only holds on the machine that wrote the\n"
+          "                  baseline\n"
+          "  -e tolerance    with -g, fraction by which throughput and memory may be\n"
+          "                  worse than the baseline, 0.25 by default; proposals and\n"
+          "                  evictions may not grow at all\n"
+          "  -o file         write the results to file instead of stdout" << endl;
+}
+
+
+/*!
+ * \brief Parse a comma separated list of positive numbers
+ *
+ * \return Zero if the list was parsed, non-zero otherwise
+ */
+static int parse_list(
+  const char             *text,    /*!< The list                            */
+  vector<unsigned int>   &values)  /*!< Returned numbers                    */
+{
+  values.clear();
+  const char *p = text;
+  while (*p != '\0')
+  {
+    char *end = 0;
+    const unsigned long value = strtoul(p, &end, 10);
+    if ( (end == p) || (value == 0) || ((*end != ',') && (*end != '\0')) )
+      return 1;
+    values.push_back((unsigned int) value);
+    p = (*end == ',') ? end + 1 : end;
+  }
+
+  return values.empty() ? 1 : 0;
+}
+
+
+/*!
+ * \brief Return the time of day in seconds
+ */
+static double now()
+{
+  struct timeval tv;
+  gettimeofday(&tv, 0);
+
+  return (tv.tv_sec + tv.tv_usec / 1000000.0);
+}
+
+
+/*!
+ * \brief Write latencies in microseconds as a JSON object of percentiles
+ */
+static void write_latencies(
+  ostream          &os,            /*!< The stream for the object           */
+  vector<double>   &seconds)       /*!< The latencies, which are sorted     */
+{
+  sort(seconds.begin(), seconds.end());
+  os << "{\"count\":" << seconds.size();
+  if ( !seconds.empty() )
+    {
+      static const double percentiles[] = { 0.5, 0.9, 0.99 };
+      static const char *const names[] = { "p50", "p90", "p99" };
+      for (unsigned int p = 0; p < 3; p++)
+        os << ",\"" << names[p] << "_us\":" <<
+              seconds[(size_t) (percentiles[p] * (seconds.size() - 1))] * 1e6;
+      os << ",\"max_us\":" << seconds.back() * 1e6;
+    }
+  os << "}";
+}
+
+
+/*!
+ * \brief Run the whole pipeline of the scheduler on one festival, then time
+ *        withdrawals and additions one at a time
+ *
+ * \return Zero if the assignments validated, non-zero otherwise
+ */
+static int bench_scheduler(
+  const festival_definition   &definition,/*!< The festival                 */
+  const unsigned int           threads,/*!< Number of worker threads        */
+  const bench_options         &options,/*!< What else to run                */
+  ostream                     &os) /*!< Stream for the results              */
+{
+  const double start = now();
+  scheduler *created = 0;
+  if (scheduler::create(definition, cerr, created) != 0)
+    return 1;
+  scheduler &sched = *created;
+  sched.set_worker_count(threads);
+  sched.set_waitlist_size(4);
+  sched.assign();
+  ostringstream errors;
+  const int vrc = sched.validate_assignments(errors);
+  const int null_fd = open("/dev/null", O_WRONLY);
+  const int wrc = sched.write_assignments(null_fd);
+  close(null_fd);
+  const double seconds = now() - start;
+
+  const scheduler_stats &stats = sched.stats();
+  os << ",\"seconds\":" << seconds << ",\"phases\":{";
+  for (unsigned int p = scheduler_stats::parse_phase; p < scheduler_stats::phase_count; p++)
+    os << (p == scheduler_stats::parse_phase ? "" : ",") << "\"" <<
+          scheduler_stats::phase_name((scheduler_stats::phase) p) << "\":" <<
+          stats.phase_seconds((scheduler_stats::phase) p);
+  const double propose = stats.phase_seconds(scheduler_stats::propose_phase);
+  os << "},\"proposals\":" << stats.proposal_count() <<
+        ",\"evictions\":" << stats.eviction_count() <<
+        ",\"longest_chain\":" << stats.longest_chain() <<
+        ",\"jugglers_per_second\":" << sched.juggler_count() / seconds <<
+        ",\"proposals_per_second\":" << ((propose > 0.0) ? stats.proposal_count() / propose : 0.0);
+  if (stats.counting_hardware())
+    {
+      os << ",\"counters\":";
+      stats.write_counters(os);
+    }
+  memory_usage usage;
+  sched.account_memory(usage);
+  os << ",\"memory\":";
+  usage.write_report(os, sched.juggler_count());
+
+  // Withdraw distinct jugglers, then add as many new ones
+  bench_random random(options.seed + 1);
+  const unsigned int jugglers = sched.juggler_count();
+  const unsigned int circuits = sched.circuit_count();
+  const unsigned int length = definition.preference_counts[0];
+  vector<char> withdrawn(jugglers, 0);
+  vector<double> withdrawals, additions;
+  for (unsigned int i = 0; (i < options.operations) && (i < jugglers); i++)
+    {
+      unsigned int j = random.below(jugglers);
+      while (withdrawn[j])
+        j = (j + 1) % jugglers;
+      withdrawn[j] = 1;
+      ostringstream name;
+      name << "J" << j;
+      const double t = now();
+      sched.withdraw_juggler(name.str());
+      withdrawals.push_back(now() - t);
+    }
+  for (unsigned int i = 0; i < options.operations; i++)
+    {
+      ostringstream name;
+      name << "J" << (jugglers + i);
+      talent_definition talents;
+      talents.hand = random.below(11);
+      talents.endurance = random.below(11);
+      talents.pizzazz = random.below(11);
+      vector<unsigned int> chosen;
+      vector<string> preferences;
+      while (chosen.size() < length)
+      {
+        const unsigned int c = random.below(circuits);
+        if (find(chosen.begin(), chosen.end(), c) != chosen.end())
+          continue;
+        chosen.push_back(c);
+        ostringstream circuit_name;
+        circuit_name << "C" << c;
+        preferences.push_back(circuit_name.str());
+      }
+      const double t = now();
+      sched.add_juggler(name.str(), talents, preferences);
+      additions.push_back(now() - t);
+    }
+  os << ",\"withdraw\":";
+  write_latencies(os, withdrawals);
+  os << ",\"add\":";
+  write_latencies(os, additions);
+  delete created;
+
+  return ( (vrc != 0) || (wrc != 0) ) ? 1 : 0;
+}
+
+
+/*!
+ * \brief Build a festival_instance and solve it, then solve one solution per
+ *        thread at once with growing capacities
+ *
+ * \return Zero if the festival could be built, non-zero otherwise
+ */
+static int bench_solution(
+  const festival_definition   &definition,/*!< The festival                 */
+  const unsigned int           threads,/*!< Number of worker threads        */
+  ostream                     &os) /*!< Stream for the results              */
+{
+  double t = now();
+  festival_instance *created = 0;
+  if (festival_instance::create(definition, cerr, created) != 0)
+    return 1;
+  const festival_instance &instance = *created;
+  const double build = now() - t;
+
+  festival_solution *const solution = new festival_solution(instance);
+  t = now();
+  solution->solve();
+  const double solve = now() - t;
+  const uint64_t proposals = solution->proposal_count();
+
+  vector<festival_solution *> solutions;
+  for (unsigned int s = 0; s < threads; s++)
+    {
+      solutions.push_back(new festival_solution(instance));
+      solutions.back()->set_capacity(instance.jugglers_per_circuit() + s);
+    }
+  t = now();
+  festival_solution::solve_all(solutions, threads);
+  const double all = now() - t;
+  for (unsigned int s = 0; s < solutions.size(); s++)
+    delete solutions[s];
+  delete solution;
+
+  os << ",\"seconds\":" << (build + solve) <<
+        ",\"phases\":{\"build\":" << build << ",\"solve\":" << solve <<
+        ",\"solve_all\":" << all << "}" <<
+        ",\"proposals\":" << proposals <<
+        ",\"jugglers_per_second\":" << instance.juggler_count() / (build + solve) <<
+        ",\"proposals_per_second\":" << ((solve > 0.0) ? proposals / solve : 0.0) <<
+        ",\"solutions_per_second\":" << ((all > 0.0) ? threads / all : 0.0);
+  delete created;
+
+  return 0;
+}
+
+
+/*!
+ * \brief Run one case in a child process, so that its peak memory is its own,
+ *        and write its results as one JSON object
+ *
+ * \return Zero if the case ran, non-zero otherwise
+ */
+static int run_case(
+  const bool             pipeline, /*!< The scheduler, else festival_solution */
+  const unsigned int     jugglers, /*!< Number of jugglers                  */
+  const unsigned int     length,   /*!< Preferences of each juggler         */
+  const unsigned int     threads,  /*!< Number of worker threads            */
+  const string          &popularity,/*!< Popularity of the circuits         */
+  const bench_options   &options,  /*!< What else to run                    */
+  ostream               &os)       /*!< Stream for the object               */
+{
+  int fds[2];
+  if (pipe(fds) != 0)
+    return 1;
+  cout.flush();
+  const pid_t child = fork();
+  if (child < 0)
+    {
+      close(fds[0]);
+      close(fds[1]);
+      return 1;
+    }
+  if (child == 0)
+    {
+      close(fds[0]);
+      // Six jugglers for each circuit, as in input.txt
+      const unsigned int circuits = max(jugglers / 6, length);
+      festival_generator generator(circuits, circuits * 6, length, options.seed);
+      festival_definition definition;
+      if ( (generator.set_popularity(popularity) != 0) ||
+           (generator.generate(definition) != 0) )
+        _exit(1);
+      ostringstream result;
+      result << "{\"kind\":\"" << (pipeline ? "scheduler" : "festival_solution") <<
+                "\",\"jugglers\":" << definition.jugglers.size() <<
+                ",\"circuits\":" << definition.circuits.size() <<
+                ",\"preferences\":" << length <<
+                ",\"popularity\":\"" << popularity <<
+                "\",\"threads\":" << threads;
+      const int rc = pipeline ? bench_scheduler(definition, threads, options, result)
+                              : bench_solution(definition, threads, result);
+      result << ",\"peak_rss_kb\":" << memory_usage::peak_rss_kb() << "}";
+      const string text = result.str();
+      size_t done = 0;
+      while (done < text.size())
+      {
+        const ssize_t n = write(fds[1], text.data() + done, text.size() - done);
+        if ( (n < 0) && (errno != EINTR) )
+          _exit(1);
+        if (n > 0)
+          done += n;
+      }
+      _exit(rc);
+    }
+
+  close(fds[1]);
+  string text;
+  char buffer[4096];
+  for (;;)
+  {
+    const ssize_t n = read(fds[0], buffer, sizeof(buffer));
+    if ( (n < 0) && (errno == EINTR) )
+      continue;
+    if (n <= 0)
+      break;
+    text.append(buffer, n);
+  }
+  close(fds[0]);
+  int status = 0;
+  while ( (waitpid(child, &status, 0) < 0) && (errno == EINTR) )
+    ;
+
+  const bool ok = WIFEXITED(status) && (WEXITSTATUS(status) == 0);
+  if ( ok || !text.empty() )
+    os << text;
+  else
+    os << "{\"kind\":\"" << (pipeline ? "scheduler" : "festival_solution") <<
+          "\",\"jugglers\":" << jugglers << ",\"preferences\":" << length <<
+          ",\"popularity\":\"" << popularity << "\",\"threads\":" << threads <<
+          ",\"failed\":true}";
+
+  return ok ? 0 : 1;
+}
+
+
+/*!
+ * \brief Find the number after the last "key": in the results of a case
+ *
+ * \return Zero if the key was found
+ */
+static int result_number(
+  const string          &text,     /*!< The results of the case             */
+  const char            *key,      /*!< Name of the number                  */
+  double                &value)    /*!< Returned number                     */
+{
+  const string quoted = string("\"") + key + "\":";
+  const size_t at = text.rfind(quoted);
+  if (at == string::npos)
+    return 1;
+  value = strtod(text.c_str() + at + quoted.size(), 0);
+
+  return 0;
+}
+
+
+/*!
+ * \brief Read a baseline file of "case metric value" lines, skipping blank
+ *        lines and those starting with #
+ *
+ * \return Zero if the file was read
+ */
+static int read_baseline(
+  const char            *path,     /*!< The baseline file                   */
+  map<string, double>   &baseline) /*!< Returned value of each case metric  */
+{
+  ifstream file(path);
+  if ( !file )
+    return 1;
+
+  string line;
+  while (getline(file, line))
+  {
+    if ( line.empty() || (line[0] == '#') )
+      continue;
+    istringstream fields(line);
+    string name, metric;
+    double value = 0.0;
+    if ( !(fields >> name >> metric >> value) )
+      return 1;
+    baseline[name + " " + metric] = value;
+  }
+
+  return 0;
+}
+
+
+/*!
+ * \brief Run the fixed regression set, then either write it as the baseline
+ *        or compare it with the baseline and report each metric
+ *
+ * The numbers of proposals and evictions and the bytes per juggler come out
+ * the same on any machine, so they are always compared.  Throughput and the
+ * peak resident set are only compared with the baseline when machine is true,
+ * since they mean nothing on a machine other than the one that wrote it; each
+ * case then runs gate_runs times and keeps its best throughput and least
+ * memory, which takes out most of the noise of a shared machine.  The baseline
+ * always holds every metric, so the set compared never depends on the run.
+ *
+ * \return Zero if the baseline was written or nothing regressed
+ */
+static int run_gate(
+  const char            *baseline_path,/*!< The baseline file               */
+  const bool             write_baseline,/*!< Write it instead of comparing  */
+  const bool             machine,  /*!< Also compare throughput and the
+                                        peak resident set                   */
+  const double           tolerance,/*!< Fraction throughput and memory may
+                                        be worse                            */
+  ostream               &os)       /*!< Stream for the report               */
+{
+  static const unsigned int sizes[] = { 120000, 480000 };
+  static const char *const popularities[] = { "uniform", "zipf:1" };
+  static const unsigned int length = 10;
+  static const unsigned int threads = 1;
+
+  map<string, double> baseline;
+  if ( !write_baseline && (read_baseline(baseline_path, baseline) != 0) )
+    {
+      cerr << "Cannot read " << baseline_path << endl;
+      return 1;
+    }
+
+  bench_options options;
+  options.operations = 100;
+  options.seed = 1;
+
+  const unsigned int runs = (write_baseline || machine) ? gate_runs : 1;
+  vector<string>        names;
+  vector<gate_kind>     kinds;
+  map<string, double>   measured;
+  for (unsigned int n = 0; n < sizeof(sizes) / sizeof(sizes[0]); n++)
+    for (unsigned int m = 0; m < sizeof(popularities) / sizeof(popularities[0]); m++)
+      for (unsigned int k = 0; k < 2; k++)
+        {
+          const bool pipeline = (k == 0);
+          ostringstream name;
+          name << (pipeline ? "scheduler" : "festival_solution") << "/" << sizes[n] << "/" <<
+                  length << "/" << popularities[m] << "/" << threads;
+          for (unsigned int r = 0; r < runs; r++)
+            {
+              ostringstream result;
+              if (run_case(pipeline, sizes[n], length, threads, popularities[m], options,
+                           result) != 0)
+                {
+                  cerr << name.str() << " failed" << endl;
+                  return 1;
+                }
+              for (unsigned int g = 0; g < gate_metric_count; g++)
+                {
+                  const gate_metric &metric = gate_metrics[g];
+                  if ( (metric.pipeline != pipeline) ||
+                       (metric.machine && !machine && !write_baseline) )
+                    continue;
+                  double value = 0.0;
+                  if (result_number(result.str(), metric.name, value) != 0)
+                    {
+                      cerr << name.str() << " has no " << metric.name << endl;
+                      return 1;
+                    }
+                  const string key = name.str() + " " + metric.name;
+                  if (r == 0)
+                    {
+                      names.push_back(key);
+                      kinds.push_back(metric.kind);
+                      measured[key] = value;
+                    }
+                  else if (metric.kind == gate_throughput)
+                    measured[key] = max(measured[key], value);
+                  else
+                    measured[key] = min(measured[key], value);
+                }
+            }
+          cerr << name.str() << " done" << endl;
+        }
+
+  if (write_baseline)
+    {
+      ofstream file(baseline_path);
+      file << "# Written by bench -g " << baseline_path << " -w; case metric value\n" <<
+              setprecision(10);
+      for (unsigned int i = 0; i < names.size(); i++)
+        file << names[i] << " " << measured[names[i]] << "\n";
+      if ( !file )
+        {
+          cerr << "Cannot write " << baseline_path << endl;
+          return 1;
+        }
+      return 0;
+    }
+
+  // A metric missing from the baseline fails, since the set never changes
+  // unless the gate does, and then the baseline must be written again
+  unsigned int regressed = 0;
+  os << left << setw(56) << "case metric" << right << setw(14) << "baseline" <<
+        setw(14) << "measured" << setw(10) << "change" << "  result\n";
+  for (unsigned int i = 0; i < names.size(); i++)
+    {
+      const double value = measured[names[i]];
+      os << left << setw(56) << names[i] << right << fixed << setprecision(1);
+      const map<string, double>::const_iterator it = baseline.find(names[i]);
+      if (it == baseline.end())
+        {
+          regressed++;
+          os << setw(14) << "-" << setw(14) << value << setw(10) << "-" << "  MISSING\n";
+          continue;
+        }
+      const double base = it->second;
+      const double change = (base != 0.0) ? (value - base) / base : 0.0;
+      bool worse = false;
+      bool better = false;
+      if (kinds[i] == gate_throughput)
+        {
+          worse = (value < base * (1.0 - tolerance));
+          better = (value > base * (1.0 + tolerance));
+        }
+      else if (kinds[i] == gate_memory)
+        {
+          worse = (value > base * (1.0 + tolerance));
+          better = (value < base * (1.0 - tolerance));
+        }
+      else
+        {
+          worse = (value > base);
+          better = (value < base);
+        }
+      if (worse)
+        regressed++;
+      os << setw(14) << base << setw(14) << value << setw(9) << (change * 100.0) << "%" <<
+            (worse ? "  REGRESSED\n" : better ? "  improved\n" : "  ok\n");
+    }
+  os << regressed << " of " << names.size() << " metrics regressed or missing, beyond " <<
+        (tolerance * 100.0) << "% for " << (machine ? "throughput and " : "") <<
+        "memory and beyond 0% for proposals and evictions" << endl;
+
+  return (regressed == 0) ? 0 : 1;
+}
+
+
+int main(
+  int     argc,
+  char   *argv[])
+{
+  bench_options options;
+  options.sizes.push_back(12000);
+  options.sizes.push_back(120000);
+  options.lengths.push_back(10);
+  options.threads.push_back(1);
+  options.popularities.push_back("uniform");
+  options.operations = 1000;
+  options.seed = 1;
+  const char *output = 0;
+  const char *baseline = 0;
+  bool write_baseline = false;
+  bool machine = false;
+  double tolerance = 0.25;
+
+  int opt = getopt(argc, argv, "n:l:t:m:i:r:pg:wxe:o:");
+  while (opt != -1)
+  {
+    switch (opt)
+    {
+      case 'n':
+      case 'l':
+      case 't':
+        if (parse_list(optarg, (opt == 'n') ? options.sizes :
+                               (opt == 'l') ? options.lengths : options.threads) != 0)
+          {
+            usage(argv[0]);
+            return 1;
+          }
+        break;
+      case 'm':
+        options.popularities.clear();
+        for (const char *p = optarg; ; p++)
+          {
+            const char *const comma = strchr(p, ',');
+            options.popularities.push_back((comma == 0) ? string(p) : string(p, comma));
+            if (comma == 0)
+              break;
+            p = comma;
+          }
+        break;
+      case 'i':
+        options.operations = atoi(optarg);
+        break;
+      case 'r':
+        options.seed = atoi(optarg);
+        break;
+      case 'p':
+        scheduler_stats::set_hardware_counting(true);
+        break;
+      case 'g':
+        baseline = optarg;
+        break;
+      case 'w':
+        write_baseline = true;
+        break;
+      case 'x':
+        machine = true;
+        break;
+      case 'e':
+        tolerance = atof(optarg);
+        if ( (tolerance < 0.0) || (tolerance >= 1.0) )
+          {
+            usage(argv[0]);
+            return 1;
+          }
+        break;
+      case 'o':
+        output = optarg;
+        break;
+      default:
+        usage(argv[0]);
+        return 1;
+    }
+    opt = getopt(argc, argv, "n:l:t:m:i:r:pg:wxe:o:");
+  }
+  if ( (optind != argc) || ((write_baseline || machine) && (baseline == 0)) )
+    {
+      usage(argv[0]);
+      return 1;
+    }
+
+  ostringstream os;
+  if (baseline != 0)
+    {
+      // The gate's report goes where the results would have
+      const int rc = run_gate(baseline, write_baseline, machine, tolerance, os);
+      if (output == 0)
+        cout << os.str();
+      else
+        {
+          ofstream file(output);
+          file << os.str();
+        }
+      return rc;
+    }
+
+  os << "{\"seed\":" << options.seed << ",\"operations\":" << options.operations <<
+        ",\"cpus\":" << parallel_task::available_workers() << ",\"cases\":[";
+  int rc = 0;
+  bool first = true;
+  for (unsigned int n = 0; n < options.sizes.size(); n++)
+    for (unsigned int l = 0; l < options.lengths.size(); l++)
+      for (unsigned int m = 0; m < options.popularities.size(); m++)
+        for (unsigned int t = 0; t < options.threads.size(); t++)
+          for (unsigned int k = 0; k < 2; k++)
+            {
+              os << (first ? "\n" : ",\n");
+              first = false;
+              if (run_case(k == 0, options.sizes[n], options.lengths[l], options.threads[t],
+                           options.popularities[m], options, os) != 0)
+                rc = 1;
+              cerr << options.sizes[n] << " jugglers, " << options.lengths[l] <<
+                      " preferences, " << options.popularities[m] << ", " <<
+                      options.threads[t] << " threads, " <<
+                      ((k == 0) ? "scheduler" : "festival_solution") << " done" << endl;
+            }
+  os << "\n]}\n";
+
+  if (output == 0)
+    cout << os.str();
+  else
+    {
+      ofstream file(output);
+      file << os.str();
+      if ( !file )
+        {
+          cerr << "Cannot write " << output << endl;
+          return 1;
+        }
+    }
+
+  return rc;
+}
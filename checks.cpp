@@ -0,0 +1,791 @@
+
+/*!
+ * \file checks.cpp
+ *
+ * \brief Main program for checking the scheduler after changes to a festival
+ *
+ * Each check builds a small festival whose stable assignment is known, makes
+ * changes to it as the daemon does, and checks the assignments and what the
+ * validation reports.  Other checks hold the solvers and tools to results that
+ * can be worked out by hand on festivals as small.  The program writes one
+ * line for each check and exits non-zero if any failed.
+ *
+ * \author Stewart L. Palmer
+ */
+
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <pthread.h>
+#include <stdio.h>
+#include <unistd.h>
+#include "assignment_diff.h"
+#include "assignment_file.h"
+#include "assignment_verifier.h"
+#include "daemon_client.h"
+#include "festival_checkpoint.h"
+#include "festival_instance.h"
+#include "festival_solution.h"
+#include "mapped_file.h"
+#include "scheduler.h"
+#include "solver_daemon.h"
+
+using namespace ::std;
+
+
+/*!
+ * \brief Make the festival of the checks
+ *
+ * C0 wants hand-eye coordination and C1 endurance, two jugglers each.  J0 and
+ * J1 are good at hand-eye coordination and J2 and J3 at endurance, and each
+ * lists the circuit that suits it first, so J0 and J1 go to C0 and J2 and J3
+ * to C1.
+ *
+ * \return The scheduler, which the caller deletes, or zero
+ */
+static scheduler *make_festival()
+{
+  festival_definition   definition;
+  const talent_definition circuits[2] = { { 1, 0, 0 }, { 0, 1, 0 } };
+  const talent_definition jugglers[4] = { { 5, 0, 0 }, { 4, 0, 0 },
+                                          { 0, 5, 0 }, { 0, 4, 0 } };
+  definition.circuits.assign(circuits, circuits + 2);
+  definition.jugglers.assign(jugglers, jugglers + 4);
+  for (unsigned int j = 0; j < 4; j++)
+    {
+      const unsigned int first = (j < 2) ? 0 : 1;
+      definition.preference_counts.push_back(2);
+      definition.preferences.push_back(first);
+      definition.preferences.push_back(1 - first);
+    }
+
+  scheduler *sched = 0;
+  if (scheduler::create(definition, cerr, sched) != 0)
+    return 0;
+
+  return sched;
+}
+
+
+/*!
+ * \brief Return the circuit a juggler is assigned to, or "none"
+ */
+static string circuit_of(
+  scheduler            &sched,     /*!< The scheduler                       */
+  const string         &name)      /*!< Name of the juggler                 */
+{
+  const juggler *const j = sched.get_juggler(name);
+  if ( (j == 0) || !j->is_assigned() )
+    return "none";
+
+  return j->assignment().circ().name();
+}
+
+
+/*!
+ * \brief Report the result of one check
+ *
+ * \return Zero if the check passed, one otherwise
+ */
+static int report(
+  const char           *name,      /*!< Name of the check                   */
+  const bool            passed,    /*!< True if the check passed            */
+  const string         &details)   /*!< What the validation said            */
+{
+  cout << name << ": " << (passed ? "ok" : "FAILED") << endl;
+  if ( !passed )
+    cout << details;
+
+  return passed ? 0 : 1;
+}
+
+
+/*!
+ * \brief A definition with a negative talent is turned away
+ *
+ * The festival of make_festival(), but with a negative talent for C1 and for
+ * J3, neither of which the circuit index can search.  Both are reported, and
+ * neither a scheduler nor an instance is made.
+ */
+static int check_negative_definition()
+{
+  festival_definition   definition;
+  const talent_definition circuits[2] = { { 1, 0, 0 }, { 0, -1, 0 } };
+  const talent_definition jugglers[4] = { { 5, 0, 0 }, { 4, 0, 0 },
+                                          { 0, 5, 0 }, { 0, 4, -2 } };
+  definition.circuits.assign(circuits, circuits + 2);
+  definition.jugglers.assign(jugglers, jugglers + 4);
+  for (unsigned int j = 0; j < 4; j++)
+    {
+      const unsigned int first = (j < 2) ? 0 : 1;
+      definition.preference_counts.push_back(2);
+      definition.preferences.push_back(first);
+      definition.preferences.push_back(1 - first);
+    }
+
+  ostringstream errors;
+  scheduler *sched = 0;
+  festival_instance *instance = 0;
+  const int src = scheduler::create(definition, errors, sched);
+  const int irc = festival_instance::create(definition, errors, instance);
+  const string expected = "Circuit C1 has a negative talent.\n"
+                          "Juggler J3 has a negative talent.\n";
+  const bool passed = (src != 0) && (sched == 0) && (irc != 0) && (instance == 0) &&
+                      (errors.str() == expected + expected);
+  delete sched;
+  delete instance;
+
+  return report("negative_definition", passed, errors.str());
+}
+
+
+/*!
+ * \brief An added juggler does not change the number of jugglers per circuit
+ *
+ * J4 is better at hand-eye coordination than J1 and takes its place in C0.
+ * J1 is not good enough for C1, and with two jugglers per circuit there is no
+ * place left for it.
+ */
+static int check_capacity_after_add()
+{
+  scheduler *const s = make_festival();
+  if (s == 0)
+    return report("capacity_after_add", false, "");
+  scheduler &sched = *s;
+  sched.assign();
+
+  const talent_definition talents = { 6, 0, 0 };
+  vector<string> preferences;
+  preferences.push_back("C0");
+  preferences.push_back("C1");
+  const int rc = sched.add_juggler("J4", talents, preferences);
+  const bool passed = (rc == 0) && (sched.jugglers_per_circuit() == 2) &&
+                      (sched.get_circuit("C0")->assigned_count() == 2) &&
+                      (sched.get_circuit("C1")->assigned_count() == 2) &&
+                      (circuit_of(sched, "J4") == "C0") &&
+                      (circuit_of(sched, "J1") == "none");
+  delete s;
+
+  return report("capacity_after_add", passed, "");
+}
+
+
+/*!
+ * \brief Validate the changes made by adding a juggler after a full validation
+ *
+ * The added juggler has no entry in what the full validation set up, so this
+ * is where validate_changes() once read past the end of it.  The validation
+ * must find that J1 has lost its place.
+ */
+static int check_validate_after_add()
+{
+  scheduler *const s = make_festival();
+  if (s == 0)
+    return report("validate_after_add", false, "");
+  scheduler &sched = *s;
+  sched.assign();
+  ostringstream full;
+  const int frc = sched.validate_assignments(full);
+
+  const talent_definition talents = { 6, 0, 0 };
+  vector<string> preferences;
+  preferences.push_back("C0");
+  preferences.push_back("C1");
+  sched.add_juggler("J4", talents, preferences);
+  ostringstream changes;
+  const int crc = sched.validate_changes(changes);
+  const bool passed = (frc == 0) && (crc != 0) &&
+                      (changes.str() == "Juggler J1 is not assigned!\n");
+  delete s;
+
+  return report("validate_after_add", passed, full.str() + changes.str());
+}
+
+
+/*!
+ * \brief Refill the place of a withdrawn juggler from a waitlist
+ *
+ * J4 takes the place of J1 in C0, which keeps J1 on its waitlist.  When J4
+ * withdraws, J1 gets its place back, and the festival is stable again.
+ */
+static int check_withdraw_refills()
+{
+  scheduler *const s = make_festival();
+  if (s == 0)
+    return report("withdraw_refills", false, "");
+  scheduler &sched = *s;
+  sched.set_waitlist_size(4);
+  sched.assign();
+  ostringstream full;
+  const int frc = sched.validate_assignments(full);
+
+  const talent_definition talents = { 6, 0, 0 };
+  vector<string> preferences;
+  preferences.push_back("C0");
+  preferences.push_back("C1");
+  const int arc = sched.add_juggler("J4", talents, preferences);
+  const int wrc = sched.withdraw_juggler("J4");
+  ostringstream changes;
+  const int crc = sched.validate_changes(changes);
+  const bool passed = (frc == 0) && (arc == 0) && (wrc == 0) && (crc == 0) &&
+                      (circuit_of(sched, "J1") == "C0") &&
+                      (sched.get_circuit("C0")->assigned_count() == 2);
+  delete s;
+
+  return report("withdraw_refills", passed, full.str() + changes.str());
+}
+
+
+/*!
+ * \brief The place of a withdrawn juggler may stay open without waitlists
+ *
+ * Nobody is left who would rather be in C0 than where they are, so the
+ * validation must not count the open place against C0.
+ */
+static int check_withdraw_leaves_place()
+{
+  scheduler *const s = make_festival();
+  if (s == 0)
+    return report("withdraw_leaves_place", false, "");
+  scheduler &sched = *s;
+  sched.assign();
+  ostringstream full;
+  const int frc = sched.validate_assignments(full);
+
+  const int wrc = sched.withdraw_juggler("J0");
+  ostringstream changes;
+  const int crc = sched.validate_changes(changes);
+  const bool passed = (frc == 0) && (wrc == 0) && (crc == 0) &&
+                      (sched.get_circuit("C0")->assigned_count() == 1);
+  delete s;
+
+  return report("withdraw_leaves_place", passed, full.str() + changes.str());
+}
+
+
+/*!
+ * \brief An orphan takes the place of a withdrawn juggler
+ *
+ * Adding J4 leaves J1 without a place.  There are no waitlists, so when J2
+ * withdraws from C1, J1 must be given its place as an orphan would be.
+ */
+static int check_withdraw_places_orphan()
+{
+  scheduler *const s = make_festival();
+  if (s == 0)
+    return report("withdraw_places_orphan", false, "");
+  scheduler &sched = *s;
+  sched.assign();
+  ostringstream full;
+  const int frc = sched.validate_assignments(full);
+
+  const talent_definition talents = { 6, 0, 0 };
+  vector<string> preferences;
+  preferences.push_back("C0");
+  preferences.push_back("C1");
+  const int arc = sched.add_juggler("J4", talents, preferences);
+  const int wrc = sched.withdraw_juggler("J2");
+  ostringstream changes;
+  const int crc = sched.validate_changes(changes);
+  const bool passed = (frc == 0) && (arc == 0) && (wrc == 0) && (crc == 0) &&
+                      (circuit_of(sched, "J1") == "C1") &&
+                      (sched.orphan_juggler_count() == 0);
+  delete s;
+
+  return report("withdraw_places_orphan", passed, full.str() + changes.str());
+}
+
+
+/*!
+ * \brief A daemon and the stream for what its serve() reports
+ */
+struct serving_daemon
+{
+  //! The daemon
+  solver_daemon    *daemon;
+
+  //! What serve() reports
+  ostringstream     errors;
+
+  //! What serve() returns
+  int               rc;
+};
+
+
+/*!
+ * \brief Thread entry point; serves requests until a shutdown
+ */
+static void *serve_main(
+  void           *arg)             /*!< The serving_daemon                  */
+{
+  serving_daemon &sd = *static_cast<serving_daemon *>(arg);
+  sd.rc = sd.daemon->serve(sd.errors);
+
+  return 0;
+}
+
+
+/*!
+ * \brief Send one request to the daemon
+ *
+ * \return The status of the reply, or -1 if no reply came back
+ */
+static int call(
+  daemon_client            &client,/*!< Connected client                    */
+  const uint32_t            operation,/*!< A daemon_operation               */
+  const uint32_t            id,    /*!< Number of the juggler               */
+  const int32_t             hand,  /*!< Hand-eye coordination of an add     */
+  const vector<uint32_t>   &preferences)/*!< Circuit numbers of an add      */
+{
+  daemon_request request;
+  request.operation = operation;
+  request.id = id;
+  request.hand = hand;
+  request.endurance = 0;
+  request.pizzazz = 0;
+  request.preference_count = preferences.size();
+  daemon_reply reply;
+  vector<daemon_entry> entries;
+  if (client.call(request, preferences, reply, entries) != 0)
+    return -1;
+
+  return reply.status;
+}
+
+
+/*!
+ * \brief The daemon validates each change it makes
+ *
+ * As in check_withdraw_refills(), but through a daemon: adding J4 leaves J1
+ * without a place, which the validation of that change must report, and
+ * withdrawing J4 gives it back, which must validate.  A juggler numbered far
+ * past the others, or with a negative talent, is turned away before it changes
+ * anything.
+ */
+static int check_daemon_validates()
+{
+  scheduler *const s = make_festival();
+  if (s == 0)
+    return report("daemon_validates", false, "");
+  scheduler &sched = *s;
+  sched.set_waitlist_size(4);
+  sched.assign();
+  ostringstream full;
+  const int frc = sched.validate_assignments(full);
+
+  char path[64];
+  sprintf(path, "/tmp/checks.%d.sock", (int) getpid());
+  ostringstream changes;
+  solver_daemon *const daemon = new solver_daemon(sched, path);
+  daemon->set_validation(&changes);
+  serving_daemon sd;
+  sd.daemon = daemon;
+  sd.rc = 1;
+  pthread_t thread;
+  if (pthread_create(&thread, 0, serve_main, &sd) != 0)
+    {
+      delete daemon;
+      delete s;
+      return report("daemon_validates", false, "");
+    }
+
+  // The daemon is ready once it has bound the socket
+  daemon_client client;
+  int connected = 1;
+  for (unsigned int tries = 0; (connected != 0) && (tries < 100); tries++)
+    {
+      connected = client.connect(path);
+      if (connected != 0)
+        usleep(50000);
+    }
+  vector<uint32_t> preferences;
+  preferences.push_back(0);
+  preferences.push_back(1);
+  const vector<uint32_t> none;
+  int arc = -1;
+  int wrc = -1;
+  int far_rc = -1;
+  int negative_rc = -1;
+  if (connected == 0)
+    {
+      far_rc = call(client, add_operation, 1 << 30, 6, preferences);
+      negative_rc = call(client, add_operation, 5, -5, preferences);
+      arc = call(client, add_operation, 4, 6, preferences);
+      wrc = call(client, withdraw_operation, 4, 0, none);
+      call(client, shutdown_operation, 0, 0, none);
+    }
+  else                             /* Stop the daemon from another client   */
+    {
+      daemon_client stopper;
+      if (stopper.connect(path) == 0)
+        call(stopper, shutdown_operation, 0, 0, none);
+    }
+  pthread_join(thread, 0);
+
+  const bool passed = (frc == 0) && (sd.rc == 0) &&
+                      (far_rc == rejected_status) && (negative_rc == rejected_status) &&
+                      (arc == ok_status) && (wrc == ok_status) &&
+                      (changes.str() == "Juggler J1 is not assigned!\n") &&
+                      (daemon->invalid_change_count() == 1) &&
+                      (circuit_of(sched, "J1") == "C0");
+  delete daemon;
+  delete s;
+
+  return report("daemon_validates", passed, full.str() + sd.errors.str() + changes.str());
+}
+
+
+/*!
+ * \brief Compare classifies each move by the ranks of the two circuits
+ *
+ * J1 moves from its first choice to its second, which is worse, and J4 from
+ * its second to its first, which is better.  J3 lists only C1 and moves to
+ * C0, which it did not list at all; that is worse than any listed choice, not
+ * better than its first.
+ */
+static int check_compare_ranks()
+{
+  const string before_text = "C0 J0 C0:5 C1:0, J1 C0:4 C1:0, J4 C1:3 C0:3\n"
+                             "C1 J2 C1:5 C0:0, J3 C1:4\n";
+  const string after_text = "C0 J0 C0:5 C1:0, J3 C1:4\n"
+                            "C1 J2 C1:5 C0:0, J1 C0:4 C1:0, J4 C1:3 C0:3\n";
+  ostringstream errors;
+  assignment_file before("before", before_text.data(), before_text.size());
+  assignment_file after("after", after_text.data(), after_text.size());
+  const uint64_t problems = before.parse(1, errors) + after.parse(1, errors);
+  assignment_diff diff(before, after);
+  ostringstream differences;
+  const int rc = diff.compare(1, true, differences);
+  const bool passed = (problems == 0) && (rc != 0) && (diff.common_count() == 5) &&
+                      (diff.moved_count() == 3) && (diff.better_count() == 1) &&
+                      (diff.worse_count() == 2) && (diff.rescored_count() == 0);
+  differences << diff << endl;
+
+  return report("compare_ranks", passed, errors.str() + differences.str());
+}
+
+
+/*!
+ * \brief Compare tells moves from changes of score, and from comings and goings
+ *
+ * J3 moves from C0, which it did not list, to its only choice, which is
+ * better, and J1 from its second choice to its first.  J0 stays where it is
+ * with a new score, J4 leaves and J5 arrives.
+ */
+static int check_compare_changes()
+{
+  const string before_text = "C0 J0 C0:5 C1:0, J3 C1:4\n"
+                             "C1 J2 C1:5 C0:0, J1 C0:4 C1:0, J4 C0:1\n";
+  const string after_text = "C0 J0 C0:6 C1:0, J1 C0:4 C1:0\n"
+                            "C1 J2 C1:5 C0:0, J3 C1:4, J5 C1:2\n";
+  ostringstream errors;
+  assignment_file before("before", before_text.data(), before_text.size());
+  assignment_file after("after", after_text.data(), after_text.size());
+  const uint64_t problems = before.parse(1, errors) + after.parse(1, errors);
+  assignment_diff diff(before, after);
+  ostringstream differences;
+  const int rc = diff.compare(1, true, differences);
+  const bool passed = (problems == 0) && (rc != 0) && (diff.common_count() == 4) &&
+                      (diff.moved_count() == 2) && (diff.better_count() == 2) &&
+                      (diff.worse_count() == 0) && (diff.rescored_count() == 1) &&
+                      (diff.removed_count() == 1) && (diff.added_count() == 1);
+  differences << diff << endl;
+
+  return report("compare_changes", passed, errors.str() + differences.str());
+}
+
+
+/*!
+ * \brief The auction finds the highest total score there is
+ *
+ * Three circuits of two jugglers each, and six jugglers that list every circuit
+ * but not in the order of their scores, so the stable assignment gives away
+ * some score.  Every way of placing the jugglers is tried to find the highest
+ * total, and assign_max_score() must reach it.
+ */
+static int check_auction_optimum()
+{
+  festival_definition   definition;
+  const talent_definition circuits[3] = { { 3, 1, 0 }, { 0, 3, 1 }, { 1, 0, 3 } };
+  const talent_definition jugglers[6] = { { 5, 2, 1 }, { 4, 4, 0 }, { 1, 5, 2 },
+                                          { 2, 1, 5 }, { 3, 3, 3 }, { 0, 2, 4 } };
+  const unsigned int preferences[6][3] = { { 1, 0, 2 }, { 0, 1, 2 }, { 2, 1, 0 },
+                                           { 0, 2, 1 }, { 2, 0, 1 }, { 1, 2, 0 } };
+  definition.circuits.assign(circuits, circuits + 3);
+  definition.jugglers.assign(jugglers, jugglers + 6);
+  for (unsigned int j = 0; j < 6; j++)
+    {
+      definition.preference_counts.push_back(3);
+      definition.preferences.insert(definition.preferences.end(),
+                                    preferences[j], preferences[j] + 3);
+    }
+
+  int score[6][3];
+  for (unsigned int j = 0; j < 6; j++)
+    for (unsigned int c = 0; c < 3; c++)
+      score[j][c] = (jugglers[j].hand * circuits[c].hand) +
+                    (jugglers[j].endurance * circuits[c].endurance) +
+                    (jugglers[j].pizzazz * circuits[c].pizzazz);
+  int64_t best = 0;
+  for (unsigned int placing = 0; placing < 729; placing++)
+    {
+      unsigned int counts[3] = { 0, 0, 0 };
+      int64_t total = 0;
+      unsigned int rest = placing;
+      for (unsigned int j = 0; j < 6; j++, rest /= 3)
+        {
+          counts[rest % 3]++;
+          total += score[j][rest % 3];
+        }
+      if ( (counts[0] == 2) && (counts[1] == 2) && (total > best) )
+        best = total;
+    }
+
+  scheduler *sched = 0;
+  if (scheduler::create(definition, cerr, sched) != 0)
+    return report("auction_optimum", false, "");
+  sched->assign_max_score();
+  const int64_t total = sched->total_score();
+  const bool passed = (total == best) && (sched->orphan_juggler_count() == 0);
+  delete sched;
+  ostringstream details;
+  details << "Total " << total << ", best " << best << endl;
+
+  return report("auction_optimum", passed, details.str());
+}
+
+
+/*!
+ * \brief Make a festival with three stable assignments
+ *
+ * Four circuits of one juggler each.  C0, C1 and C2 each want one talent and
+ * C3 all three.  The jugglers list every circuit, and their first choices
+ * J0 C2, J1 C1, J2 C0 and J3 C3 are stable.  So are C1, C0, C2 and C3, which
+ * is best for the circuits, and C0, C1, C2 and C3 between the two.
+ *
+ * \return The scheduler, which the caller deletes, or zero
+ */
+static scheduler *make_lattice_festival()
+{
+  festival_definition   definition;
+  const talent_definition circuits[4] = { { 1, 0, 0 }, { 0, 1, 0 },
+                                          { 0, 0, 1 }, { 1, 1, 1 } };
+  const talent_definition jugglers[4] = { { 3, 2, 1 }, { 5, 0, 5 },
+                                          { 1, 4, 2 }, { 2, 5, 4 } };
+  const unsigned int preferences[4][4] = { { 2, 0, 1, 3 }, { 1, 3, 0, 2 },
+                                           { 0, 2, 1, 3 }, { 3, 2, 0, 1 } };
+  definition.circuits.assign(circuits, circuits + 4);
+  definition.jugglers.assign(jugglers, jugglers + 4);
+  for (unsigned int j = 0; j < 4; j++)
+    {
+      definition.preference_counts.push_back(4);
+      definition.preferences.insert(definition.preferences.end(),
+                                    preferences[j], preferences[j] + 4);
+    }
+
+  scheduler *sched = 0;
+  if (scheduler::create(definition, cerr, sched) != 0)
+    return 0;
+
+  return sched;
+}
+
+
+/*!
+ * \brief Assign the festival of make_lattice_festival() to one stable assignment
+ *
+ * \return The circuit of each juggler in turn, separated by spaces
+ */
+static string stable_circuits(
+  const stable_lattice::choice   which,/*!< The stable assignment wanted    */
+  ostream                       &os)/*!< Stream for the summary             */
+{
+  scheduler *const s = make_lattice_festival();
+  if (s == 0)
+    return "";
+  scheduler &sched = *s;
+  sched.assign_stable(which, os);
+  const string circuits = circuit_of(sched, "J0") + " " + circuit_of(sched, "J1") + " " +
+                          circuit_of(sched, "J2") + " " + circuit_of(sched, "J3");
+  delete s;
+
+  return circuits;
+}
+
+
+/*!
+ * \brief The egalitarian and minimum regret assignments are the right ones
+ *
+ * Of the three stable assignments of make_lattice_festival(), the one between
+ * the two extremes has the lowest sum of ranks, 8 against 9 for both of the
+ * others.  The one best for the circuits has the lowest regret, 2 against 3.
+ */
+static int check_stable_choices()
+{
+  ostringstream summary;
+  const string egalitarian = stable_circuits(stable_lattice::egalitarian, summary);
+  const string minimum_regret = stable_circuits(stable_lattice::minimum_regret, summary);
+  const string juggler_optimal = stable_circuits(stable_lattice::juggler_optimal, summary);
+  const bool passed = (egalitarian == "C0 C1 C2 C3") &&
+                      (minimum_regret == "C1 C0 C2 C3") &&
+                      (juggler_optimal == "C2 C1 C0 C3");
+  summary << egalitarian << endl << minimum_regret << endl << juggler_optimal << endl;
+
+  return report("stable_choices", passed, summary.str());
+}
+
+
+/*!
+ * \brief Verify assignments held in a string against the festival of the checks
+ *
+ * The verifier reads mapped files, so the instance and the assignments are
+ * written to files of their own under /tmp and removed again.
+ *
+ * \return What verify() returned, or -1 if the files could not be made
+ */
+static int verify_text(
+  const string         &text,      /*!< The assignments, as assign writes   */
+  ostream              &os)        /*!< Stream for problem reports          */
+{
+  char instance_path[64];
+  char assignments_path[64];
+  sprintf(instance_path, "/tmp/checks.%d.input", (int) getpid());
+  sprintf(assignments_path, "/tmp/checks.%d.output", (int) getpid());
+  {
+    ofstream instance_file(instance_path);
+    instance_file << "C C0 H:1 E:0 P:0\n"
+                     "C C1 H:0 E:1 P:0\n"
+                     "\n"
+                     "J J0 H:5 E:0 P:0 C0,C1\n"
+                     "J J1 H:4 E:0 P:0 C0,C1\n"
+                     "J J2 H:0 E:5 P:0 C1,C0\n"
+                     "J J3 H:0 E:4 P:0 C1,C0\n";
+    ofstream assignments_file(assignments_path);
+    assignments_file << text;
+  }
+
+  int rc = -1;
+  mapped_file instance;
+  mapped_file assignments;
+  if ( (instance.map(instance_path) == 0) && (assignments.map(assignments_path) == 0) )
+    {
+      assignment_verifier verifier(instance, assignments);
+      rc = verifier.verify(1, os);
+    }
+  unlink(instance_path);
+  unlink(assignments_path);
+
+  return rc;
+}
+
+
+/*!
+ * \brief The verifier accepts the stable assignment and nothing less
+ *
+ * The assignment of make_festival() is verified as assign writes it.  With J1
+ * and J2 swapped, each would rather be in the other's circuit, and with the
+ * file cut off in the middle of its last line, C0 and its jugglers are
+ * missing; both must be rejected.
+ */
+static int check_verify_rejects()
+{
+  const string good = "C1 J3 C1:4 C0:0, J2 C1:5 C0:0\n"
+                      "C0 J1 C0:4 C1:0, J0 C0:5 C1:0\n";
+  const string swapped = "C1 J3 C1:4 C0:0, J1 C0:4 C1:0\n"
+                         "C0 J2 C1:5 C0:0, J0 C0:5 C1:0\n";
+  const string truncated = good.substr(0, good.size() - 6);
+  ostringstream problems;
+  const int grc = verify_text(good, problems);
+  const int src = verify_text(swapped, problems);
+  const int trc = verify_text(truncated, problems);
+  const bool passed = (grc == 0) && (src > 0) && (trc > 0);
+
+  return report("verify_rejects", passed, problems.str());
+}
+
+
+/*!
+ * \brief A solve restored from a checkpoint taken part way ends as solve() does
+ *
+ * Six jugglers all ask for C0 first, and three of them fit it best.  The
+ * checkpoint is taken once J0, J1 and J2 have been placed in C0, before the
+ * others come to push out all but J2.  The restored solve is advanced to the
+ * end, and every juggler must be where a solve from the start puts it.
+ */
+static int check_checkpoint_resumes()
+{
+  festival_definition   definition;
+  const talent_definition circuits[2] = { { 1, 0, 0 }, { 0, 1, 0 } };
+  const talent_definition jugglers[6] = { { 2, 1, 0 }, { 1, 5, 0 }, { 4, 2, 0 },
+                                          { 3, 4, 0 }, { 6, 3, 0 }, { 5, 6, 0 } };
+  definition.circuits.assign(circuits, circuits + 2);
+  definition.jugglers.assign(jugglers, jugglers + 6);
+  for (unsigned int j = 0; j < 6; j++)
+    {
+      definition.preference_counts.push_back(2);
+      definition.preferences.push_back(0);
+      definition.preferences.push_back(1);
+    }
+
+  festival_instance *instance = 0;
+  ostringstream errors;
+  if (festival_instance::create(definition, errors, instance) != 0)
+    return report("checkpoint_resumes", false, errors.str());
+  festival_solution whole(*instance);
+  whole.solve();
+  festival_solution part(*instance);
+  part.start();
+  const bool paused = !part.advance(3);
+
+  char path[64];
+  sprintf(path, "/tmp/checks.%d.checkpoint", (int) getpid());
+  festival_checkpoint checkpoint;
+  const int wrc = festival_checkpoint::write(part, path);
+  const int rrc = (wrc == 0) ? checkpoint.restore(path) : 1;
+  unlink(path);
+  bool same = false;
+  if (rrc == 0)
+    {
+      festival_solution &resumed = checkpoint.solution();
+      same = (resumed.placed_count() == 3) && resumed.advance(6) &&
+             (resumed.proposal_count() == whole.proposal_count());
+      for (unsigned int j = 0; j < 6; j++)
+        {
+          const assignment_record &w = whole.assignment(j);
+          const assignment_record &r = resumed.assignment(j);
+          same = same && (r.circuit == w.circuit) && (r.score == w.score) &&
+                 (r.preference == w.preference);
+        }
+    }
+  const bool passed = paused && (wrc == 0) && (rrc == 0) && same &&
+                      (whole.assignment(1).circuit == 1) &&
+                      (whole.assignment(2).circuit == 0);
+  delete instance;
+
+  return report("checkpoint_resumes", passed, errors.str());
+}
+
+
+int main()
+{
+  int failed = 0;
+  failed += check_negative_definition();
+  failed += check_capacity_after_add();
+  failed += check_validate_after_add();
+  failed += check_withdraw_refills();
+  failed += check_withdraw_leaves_place();
+  failed += check_withdraw_places_orphan();
+  failed += check_daemon_validates();
+  failed += check_compare_ranks();
+  failed += check_compare_changes();
+  failed += check_auction_optimum();
+  failed += check_stable_choices();
+  failed += check_verify_rejects();
+  failed += check_checkpoint_resumes();
+  if (failed != 0)
+    cout << failed << " checks failed" << endl;
+
+  return (failed == 0) ? 0 : 1;
+}
@@ -10,6 +10,8 @@
 #include <regex>
 #include <assert.h>
 #include "juggler_circuit_set_const_iterator.h"
+#include "juggler_circuit_set_iterator.h"
+#include "output_buffer.h"
 #include "scheduler.h"
 #include "circuit.h"
 
@@ -33,7 +35,9 @@ circuit::circuit(
   scheduler          &sched,       /*!< Reference to the scheduler          */
   const string       &definition)  /*!< String that defines the circuit     */
   :
-  talent(sched)
+  talent(sched),
+  _changed(false),
+  _unpublished(false)
 {
   smatch    matches;
   regex scan_rx(_scan_exp);
@@ -46,6 +50,27 @@ circuit::circuit(
 }
 
 
+/*                                                                          */
+/****************************************************************************/
+/*     C O N S T R U C T O R                                                */
+/****************************************************************************/
+/*                                                                          */
+circuit::circuit(
+  scheduler          &sched,       /*!< Reference to the scheduler          */
+  const string       &name,        /*!< Name of the circuit                 */
+  const int           hand,        /*!< Value for hand-eye coordination     */
+  const int           endurance,   /*!< Value for endurance                 */
+  const int           pizzazz)     /*!< Value for pizzazz                   */
+  :
+  talent(sched),
+  _changed(false),
+  _unpublished(false)
+{
+  set_name(name);
+  set_talents(hand, endurance, pizzazz);
+}
+
+
 /*                                                                          */
 /****************************************************************************/
 /*     R E A S S I G N _ J U G G L E R                                      */
@@ -54,9 +79,22 @@ circuit::circuit(
 void circuit::reassign_juggler(
   const juggler_circuit   &jc)     /*!< juggler_circuit to reassign         */
 {
+  if ( !sched().allow_proposal() )  /* Out of time                          */
+    {                              /* Leave it for the orphan placement     */
+      sched().add_orphaned_juggler(jc.jug());
+      return;
+    }
+  bool displaces = false;          /* Better fit than the lowest assigned   */
+  if (is_full())                   /* Contended, whatever happens next      */
+    {                              /* One lookup of the lowest score        */
+      trace(container_trace::roster_min, 0);
+      const int lowest = lowest_score();
+      displaces = (jc.score() > lowest);
+      sched().stats().count_contention(index(), displaces);
+    }
   const juggler_circuit *waiter = &jc;
   if ( is_not_full()  ||           /* If there is room for more or          */
-       (jc.score() > lowest_score()) )/* This is a better fit than any      */
+       displaces )                 /* This is a better fit than any         */
     {                              /* Will assign this juggler              */
       waiter = 0;                  /* This one will fit here                */
       if (is_full())               /* If no more room                       */
@@ -66,10 +104,12 @@ void circuit::reassign_juggler(
           waiting.clear_assignment();/* Mark no longer assigned             */
         }
       assign_juggler(jc);          /* Assign this one to ourself            */
+      sched().update_circuit_index(*this);/* In case that filled it         */
     }
   if (waiter != 0)                 /* This one won't fit here               */
     {                              /* Put it elsewhere                      */
       const juggler_circuit &wjc = *waiter;
+      waitlist_juggler(wjc);       /* Remember it in case of a vacancy      */
       juggler &jug = wjc.jug();     /* Get its next preferred circuit        */
       const juggler_circuit *const n = jug.get_next_preference(wjc.preference());
       if (n == 0)                  /* Has no more preferred circuits        */
@@ -85,6 +125,151 @@ void circuit::reassign_juggler(
     }
 }
 
+/*                                                                          */
+/****************************************************************************/
+/*     W A I T L I S T _ J U G G L E R                                      */
+/****************************************************************************/
+/*                                                                          */
+void circuit::waitlist_juggler(
+  const juggler_circuit   &jc)     /*!< The rejected juggler                */
+{
+  assert(&jc.circ() == this);
+  const unsigned int limit = sched().waitlist_size();
+  _waitlist.add(jc, limit);
+}
+
+
+/*                                                                          */
+/****************************************************************************/
+/*     R E F I L L _ V A C A N C Y                                          */
+/****************************************************************************/
+/*                                                                          */
+unsigned int circuit::refill_vacancy()
+{
+  unsigned int moved = 0;
+  circuit *vacant = this;
+  while (vacant != 0)
+  {
+    circuit &vc = *vacant;
+    if (vc.is_full())
+      break;
+    const unsigned int before = vc.assigned_count();
+    vacant = vc.fill_from_waitlist();
+    sched().update_circuit_index(vc);/* Filled, or the chain ends open here */
+    if (vc.assigned_count() != before)
+      moved++;
+  }
+
+  return moved;
+}
+
+
+/*                                                                          */
+/****************************************************************************/
+/*     F I L L _ F R O M _ W A I T L I S T                                  */
+/****************************************************************************/
+/*                                                                          */
+circuit *circuit::fill_from_waitlist()
+{
+  circuit *vacated = 0;
+  juggler_circuit_set_iterator  wit(_waitlist.waiting());
+  const juggler_circuit *w = wit.last();
+  while (w != 0)
+  {
+    const juggler_circuit &wjc = *w;
+    juggler &jug = wjc.jug();
+    if (jug.is_withdrawn())        /* Never coming back                     */
+      {
+        wit.remove_current();
+      }
+    else if ( !jug.is_assigned() ) /* An orphan, it only gains by moving    */
+      {
+        wit.remove_current();
+        sched().remove_orphaned_juggler(jug);
+        assign_juggler(wjc);
+        break;
+      }
+    else if (jug.assignment().preference() > wjc.preference())
+      {                            /* Prefers us to where it is now         */
+        const juggler_circuit &old = jug.assignment();
+        circuit &old_circ = old.circ();
+        wit.remove_current();
+        old_circ.remove_juggler(old);
+        assign_juggler(wjc);
+        vacated = &old_circ;       /* The vacancy moves to the old circuit  */
+        break;
+      }
+    w = wit.previous();            /* Content where it is, try the next one */
+  }
+
+  return vacated;
+}
+
+
+/*                                                                          */
+/****************************************************************************/
+/*     N O T E _ C H A N G E                                                */
+/****************************************************************************/
+/*                                                                          */
+void circuit::note_change()
+{
+  if ( !_changed )
+    {
+      _changed = true;
+      sched().circuit_changed(*this);
+    }
+  if ( !_unpublished )
+    {
+      _unpublished = true;
+      sched().circuit_unpublished(*this);
+    }
+}
+
+
+/*                                                                          */
+/****************************************************************************/
+/*     T R A C E                                                            */
+/****************************************************************************/
+/*                                                                          */
+void circuit::trace(
+  const container_trace::operation  op,/*!< The operation                   */
+  const juggler_circuit            *jc)/*!< The juggler_circuit, if any     */
+const
+{
+  container_trace *const t = sched().trace();
+  if (t != 0)
+    t->record_roster(op, index(), jc);
+}
+
+
+/*                                                                          */
+/****************************************************************************/
+/*     D E P E N D E N T _ J U G G L E R S                                  */
+/****************************************************************************/
+/*                                                                          */
+void circuit::dependent_jugglers(
+  vector<const juggler *>  &jugglers)/*!< Jugglers added to                 */
+const
+{
+  juggler_circuit_set_const_iterator  asg(assigned());
+  const juggler_circuit *j = asg.first();
+  while (j != 0)
+  {
+    jugglers.push_back(&j->jug());
+    j = asg.next();
+  }
+
+  for (unsigned int i = 0; i < _interested.size(); i++)
+    {
+      const juggler_circuit &jc = *_interested[i];
+      const juggler &jug = jc.jug();
+      if ( !jug.is_assigned() ||
+           (jc.preference() < jug.assignment().preference()) )
+        jugglers.push_back(&jug);
+    }
+}
+
+
 /*                                                                          */
 /****************************************************************************/
 /*     J U G G L E R _ S U M                                                */
@@ -137,6 +322,54 @@ const
 }
 
 
+/*                                                                          */
+/****************************************************************************/
+/*     S H O W _ A S S I G N M E N T S                                      */
+/****************************************************************************/
+/*                                                                          */
+void circuit::show_assignments(
+  output_buffer   &ob)             /*!< Buffer for the assignments          */
+const
+{
+  ob.append(name());
+  int n = 0;
+  juggler_circuit_set_const_iterator  assigned_iterator(assigned());
+  const juggler_circuit *j = assigned_iterator.last();
+  while(j != 0)
+  {
+    const juggler &jug = j->jug();
+    if (n == 0)
+      ob.append(' ');
+    else
+      ob.append(", ", 2);
+    ob.append(jug.name());
+    ob.append(' ');
+    jug.show_requests(ob);
+    n++;
+    j = assigned_iterator.previous();
+  }
+}
+
+
+/*                                                                          */
+/****************************************************************************/
+/*     A S S I G N E D _ J U G G L E R S                                    */
+/****************************************************************************/
+/*                                                                          */
+void circuit::assigned_jugglers(
+  vector<const juggler_circuit *> &jugglers)/*!< Jugglers added to          */
+const
+{
+  juggler_circuit_set_const_iterator  assigned_iterator(assigned());
+  const juggler_circuit *j = assigned_iterator.last();
+  while(j != 0)
+  {
+    jugglers.push_back(j);
+    j = assigned_iterator.previous();
+  }
+}
+
+
 /*                                                                          */
 /****************************************************************************/
 /*     V A L I D A T E _ A S S I G N M E N T                                */
@@ -148,7 +381,9 @@ int circuit::validate_assignments(
 {
   int rc = 0;
 
-  if (assigned_count() != jugglers_per_circuit())
+  // A circuit may be short only of the places left by withdrawals
+  if ( (assigned_count() > jugglers_per_circuit()) ||
+       ((assigned_count() < jugglers_per_circuit()) && !sched().has_vacancies()) )
     {
       os << "Circuit " << name() << " is assigned " << assigned_count() <<
             " jugglers instead of the required " << jugglers_per_circuit() << endl;
@@ -175,6 +410,22 @@ int circuit::validate_assignments(
 }
 
 
+/*                                                                          */
+/****************************************************************************/
+/*     A C C O U N T _ M E M O R Y                                          */
+/****************************************************************************/
+/*                                                                          */
+void circuit::account_memory(
+  memory_usage   &usage)           /*!< Where to charge them                */
+const
+{
+  usage.add_object(memory_usage::circuit_objects, sizeof(circuit));
+  _assigned.account_memory(usage);
+  _waitlist.account_memory(usage);
+  usage.add_vector(memory_usage::preference_vectors, _interested);
+  usage.add_string(memory_usage::talent_names, name());
+}
+
 /*                                                                          */
 /****************************************************************************/
 /*     P R I N T _ S E L F                                                  */
@@ -187,6 +438,8 @@ const
   os << "C:";
   talent::print_self(os);
   os << " " << assigned().size()  << " jugglers assigned:\n"  << assigned();
+  if (waitlist_count() != 0)
+    os << _waitlist;
 
   return os;
 }
@@ -17,6 +17,10 @@
 #include "juggler_circuit_set.h"
 #include "juggler_circuit_set_iterator.h"
 #include "juggler_circuit_set_const_iterator.h"
+#include "circuit_waitlist.h"
+#include "container_trace.h"
+
+class output_buffer;
 
 
 /*!
@@ -38,6 +42,18 @@ public:
     const std::string  &definition);
 
 
+  /*!
+   * \brief Constructor from values rather than from an input record
+   */
+  explicit circuit(
+    scheduler          &sched,     /*!< Reference to the scheduler          */
+    const std::string  &name,      /*!< Name of the circuit                 */
+    const int           hand,      /*!< Value for hand-eye coordination     */
+    const int           endurance, /*!< Value for endurance                 */
+    const int           pizzazz    /*!< Value for pizzazz                   */
+                  );
+
+
   /*!
    * \brief Return a count of jugglers assigned to this circuit
    */
@@ -114,6 +130,8 @@ public:
     if (j != 0)
       {
         assigned_iterator.remove_current();
+        trace(container_trace::roster_evict_min, j);
+        note_change();
       }
 
     return j;
@@ -131,10 +149,119 @@ public:
     assert(is_not_full());
     assert(&jc.circ() == this);
     assigned().add(jc);
+    trace(container_trace::roster_insert, &jc);
     jc.set_assignment();
+    note_change();
   }
 
 
+  /*!
+   * \brief Remove an assigned juggler from this circuit
+   *
+   * This is an unconditional removal.  It leaves a vacancy in the circuit.
+   */
+  void remove_juggler(
+    const juggler_circuit   &jc)   /*!< The juggler to remove               */
+  {
+    assert(&jc.circ() == this);
+    assigned().remove(jc);
+    trace(container_trace::roster_remove, &jc);
+    jc.clear_assignment();
+    note_change();
+  }
+
+
+  /*!
+   * \brief Record a juggler that has listed this circuit
+   */
+  void add_interest(
+    const juggler_circuit   &jc)   /*!< The juggler and its preference      */
+  {
+    assert(&jc.circ() == this);
+    _interested.push_back(&jc);
+  }
+
+
+  /*!
+   * \brief Return true if the jugglers assigned to this circuit have changed
+   *        since clear_changed() was last called
+   */
+  bool is_changed() const
+  { return _changed; }
+
+
+  /*!
+   * \brief Forget the changes to this circuit, once they have been validated
+   */
+  void clear_changed()
+  { _changed = false; }
+
+
+  /*!
+   * \brief Forget the changes to this circuit, once they have been published
+   *        to a snapshot_store
+   */
+  void clear_unpublished()
+  { _unpublished = false; }
+
+
+  /*!
+   * \brief Add the jugglers whose validity depends on this circuit
+   *
+   * These are the jugglers assigned to the circuit, and the jugglers that list
+   * the circuit ahead of their assignment or have no assignment.  A juggler may
+   * be added more than once.
+   */
+  void dependent_jugglers(
+    std::vector<const juggler *> &jugglers/*!< Jugglers added to            */
+                         )
+  const;
+
+
+  /*!
+   * \brief Add the jugglers assigned to this circuit, best score first
+   *
+   * This is the order in which show_assignments() lists them.
+   */
+  void assigned_jugglers(
+    std::vector<const juggler_circuit *> &jugglers/*!< Jugglers added to    */
+                        )
+  const;
+
+
+  /*!
+   * \brief Remember a juggler that this circuit has turned away
+   *
+   * The juggler goes on the waitlist if the scheduler keeps waitlists.
+   */
+  void waitlist_juggler(
+    const juggler_circuit   &jc);  /*!< The rejected juggler                */
+
+
+  /*!
+   * \brief Refill a vacancy in this circuit from the waitlists
+   *
+   * The best scoring juggler on our waitlist that still prefers this circuit to
+   * its current assignment (or that has no assignment) fills the vacancy.  If
+   * that juggler leaves another circuit, the vacancy moves to that circuit and
+   * is refilled from its waitlist in turn.  This continues until a vacancy
+   * cannot be refilled or it is refilled by an unassigned juggler, so the cost
+   * is proportional to the length of the chain rather than to the number of
+   * jugglers.  Each circuit along the chain is updated in the circuit index, so
+   * the orphans placed after it find the circuit left open.
+   *
+   * \return The number of jugglers moved to refill vacancies
+   */
+  unsigned int refill_vacancy();
+
+
+  /*!
+   * \brief Return a count of jugglers on this circuit's waitlist
+   */
+  unsigned int waitlist_count() const
+  { return _waitlist.size(); }
+
+
   /*!
    * \brief Try to find a home for a juggler
    *
@@ -148,6 +275,9 @@ public:
    * next preference.  Continue until the juggler is assigned somewhere or
    * or finally added to the set of orphaned jugglers.  These are jugglers
    * that cannot fit in any of their preferred circuits.
+   *
+   * If the scheduler has run out of time, no proposal is made and the juggler
+   * goes straight to the set of orphaned jugglers.
    */
   void reassign_juggler(
     const juggler_circuit   &jc    /*!< juggler_circuit to reassign         */
@@ -162,6 +292,16 @@ public:
   const;
 
 
+  /*!
+   * \brief Show all of the juggler assignments for this circuit
+   *
+   * The same text as show_assignments(std::ostream &), appended to a buffer.
+   */
+  void show_assignments(
+    output_buffer   &ob)           /*!< Buffer for the assignments          */
+  const;
+
+
   /*!
    * \brief Validate the assignments to this circuit
    *
@@ -175,6 +315,15 @@ public:
                                );
 
 
+  /*!
+   * \brief Charge the circuit, its roster, its waitlist, the list of
+   *        jugglers interested in it and its name to their subsystems
+   */
+  void account_memory(
+    memory_usage   &usage          /*!< Where to charge them                */
+                     ) const;
+
+
 
   /*!
    *  \brief Stream object out to a stream
@@ -232,6 +381,35 @@ private:
   { return _assigned; }
 
 
+  /*!
+   * \brief Fill a vacancy in this circuit from our own waitlist only
+   *
+   * \return The circuit that was vacated by the juggler that filled our
+   *         vacancy, or zero if the vacancy chain ends here
+   */
+  circuit *fill_from_waitlist();
+
+
+  /*!
+   * \brief Record that the jugglers assigned to this circuit have changed
+   *
+   * The scheduler is told the first time, so that it can validate only the
+   * circuits that changed, and the first time since the last snapshot was
+   * published, so that only they are copied into the next one.
+   */
+  void note_change();
+
+
+  /*!
+   * \brief Record an operation on the roster, if the scheduler is recording
+   *        a container_trace
+   */
+  void trace(
+    const container_trace::operation  op,/*!< The operation                 */
+    const juggler_circuit            *jc/*!< The juggler_circuit, if any    */
+            ) const;
+
+
   /*!
    * \brief Regular expression to scan a circuit string and extract the name of
    *        the circuit as well as its preferred talent (hand-eye coordination,
@@ -245,6 +423,26 @@ private:
     */
   juggler_circuit_set       _assigned;
 
+   /*!
+    * \brief The best of the jugglers that have been turned away by this circuit
+    */
+  circuit_waitlist          _waitlist;
+
+   /*!
+    * \brief Every juggler that listed this circuit, with its preference
+    */
+  std::vector<const juggler_circuit *> _interested;
+
+   /*!
+    * \brief True if the assigned jugglers changed since the last validation
+    */
+  bool                      _changed;
+
+   /*!
+    * \brief True if the assigned jugglers changed since the last snapshot
+    */
+  bool                      _unpublished;
+
 
 };
 
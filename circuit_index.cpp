@@ -0,0 +1,533 @@
+
+/*!
+ * \file circuit_index.cpp
+ *
+ * \brief Contains the implementation of circuit_index
+ *
+ * \author Stewart L. Palmer
+ */
+
+#include <algorithm>
+#include <climits>
+#include <assert.h>
+#include "circuit_set.h"
+#include "circuit_set_iterator.h"
+#include "festival_instance.h"
+#include "circuit_index.h"
+
+using namespace ::std;
+
+
+namespace
+{
+
+/*!
+ * \brief Orders bucket indexes by the value of one talent
+ */
+struct talent_less
+{
+  //! The value of the talent for each bucket
+  const vector<int>   *values;
+
+  bool operator()(
+    const int     a,
+    const int     b)
+  const
+  {
+    const int va = (*values)[a];
+    const int vb = (*values)[b];
+
+    return ( (va < vb) || ((va == vb) && (a < b)) );
+  }
+};
+
+
+/*!
+ * \brief Return the dot product of two talent vectors
+ */
+int dot3(
+  const int     a[3],
+  const int     b[3])
+{
+  return (a[0] * b[0] + a[1] * b[1] + a[2] * b[2]);
+}
+
+}
+
+
+/*                                                                          */
+/****************************************************************************/
+/*     B U I L D                                                            */
+/****************************************************************************/
+/*                                                                          */
+void circuit_index::build(
+  circuit_set     &circuits)       /*!< The set of all circuits             */
+{
+  _buckets.clear();
+  _order.clear();
+  _nodes.clear();
+  _bucket_of.assign(circuits.size(), -1);
+  _is_open.assign(circuits.size(), false);
+
+  // Gather circuits with identical talents into buckets
+  map<pair<int, pair<int, int> >, int>   bucket_key;
+  circuit_set_iterator   cit(circuits);
+  circuit *c = cit.next();
+  while (c != 0)
+  {
+    circuit &circ = *c;
+    const int talents[3] = { circ.hand(), circ.endurance(), circ.pizzazz() };
+    add_circuit(talents, circ.id(), circ.index(), c, circ.is_not_full(), bucket_key);
+    c = cit.next();
+  }
+
+  build_tree();
+}
+
+
+/*                                                                          */
+/****************************************************************************/
+/*     B U I L D                                                            */
+/****************************************************************************/
+/*                                                                          */
+void circuit_index::build(
+  const festival_instance   &inst) /*!< The festival                        */
+{
+  _buckets.clear();
+  _order.clear();
+  _nodes.clear();
+  _bucket_of.assign(inst.circuit_count(), -1);
+  _is_open.assign(inst.circuit_count(), false);
+
+  map<pair<int, pair<int, int> >, int>   bucket_key;
+  for (unsigned int c = 0; c < inst.circuit_count(); c++)
+    {
+      const talent_definition &tal = inst.circuit_talents(c);
+      const int talents[3] = { tal.hand, tal.endurance, tal.pizzazz };
+      add_circuit(talents, c, c, 0, true, bucket_key);
+    }
+
+  build_tree();
+}
+
+
+/*                                                                          */
+/****************************************************************************/
+/*     A D D _ C I R C U I T                                                */
+/****************************************************************************/
+/*                                                                          */
+void circuit_index::add_circuit(
+  const int            talents[3], /*!< Talents of the circuit              */
+  const int            id,         /*!< ID of the circuit                   */
+  const int            index,      /*!< Index of the circuit                */
+  circuit             *circ,       /*!< The circuit, if there is one        */
+  const bool           open,       /*!< True if the circuit is not full     */
+  map<pair<int, pair<int, int> >, int>  &bucket_key)
+                                   /*!< Bucket of each set of talents       */
+{
+  assert( (talents[0] >= 0) && (talents[1] >= 0) && (talents[2] >= 0) );
+  assert( (index >= 0) && (index < (int) _bucket_of.size()) );
+  const pair<int, pair<int, int> > key(talents[0],
+                                       pair<int, int>(talents[1], talents[2]));
+  map<pair<int, pair<int, int> >, int>::iterator  it = bucket_key.find(key);
+  int b = 0;
+  if (it != bucket_key.end())
+    b = it->second;
+  else
+    {
+      b = _buckets.size();
+      bucket_key.insert(pair<pair<int, pair<int, int> >, int>(key, b));
+      _buckets.push_back(bucket());
+      bucket &nb = _buckets[b];
+      for (int d = 0; d < 3; d++)
+        nb.talents[d] = talents[d];
+      nb.node = -1;
+    }
+  bucket &bk = _buckets[b];
+  bk.all.insert(pair<int, circuit *>(id, circ));
+  if (open)
+    {
+      bk.open.insert(pair<int, circuit *>(id, circ));
+      _is_open[index] = true;
+    }
+  _bucket_of[index] = b;
+}
+
+
+/*                                                                          */
+/****************************************************************************/
+/*     B U I L D _ T R E E                                                  */
+/****************************************************************************/
+/*                                                                          */
+void circuit_index::build_tree()
+{
+  for (unsigned int b = 0; b < _buckets.size(); b++)
+    _order.push_back(b);
+
+  if (_buckets.size() != 0)
+    build_node(0, _buckets.size(), -1);
+}
+
+
+/*                                                                          */
+/****************************************************************************/
+/*     B U I L D _ N O D E                                                  */
+/****************************************************************************/
+/*                                                                          */
+int circuit_index::build_node(
+  const unsigned int   first,      /*!< First bucket in _order              */
+  const unsigned int   last,       /*!< Just past last bucket in _order     */
+  const int            parent)     /*!< Index of the parent node            */
+{
+  assert(first < last);
+  const int n = _nodes.size();
+  _nodes.push_back(node());
+  int low[3]  = { INT_MAX, INT_MAX, INT_MAX };
+  int high[3] = { INT_MIN, INT_MIN, INT_MIN };
+  for (unsigned int i = first; i < last; i++)
+    {
+      const bucket &bk = _buckets[_order[i]];
+      for (int d = 0; d < 3; d++)
+        {
+          low[d]  = min(low[d],  bk.talents[d]);
+          high[d] = max(high[d], bk.talents[d]);
+        }
+    }
+  {
+    node &nd = _nodes[n];
+    for (int d = 0; d < 3; d++)
+      nd.high[d] = high[d];
+    nd.parent = parent;
+    nd.left = -1;
+    nd.right = -1;
+    nd.first = first;
+    nd.last = last;
+    nd.all_count = 0;
+    nd.open_count = 0;
+  }
+
+  if ((last - first) == 1)         /* A leaf holds exactly one bucket       */
+    {
+      bucket &bk = _buckets[_order[first]];
+      bk.node = n;
+      node &nd = _nodes[n];
+      nd.all_count = bk.all.size();
+      nd.open_count = bk.open.size();
+      return n;
+    }
+
+  // Split at the median of the talent with the widest spread
+  int split = 0;
+  for (int d = 1; d < 3; d++)
+    if ((high[d] - low[d]) > (high[split] - low[split]))
+      split = d;
+  vector<int>  values(_buckets.size());
+  for (unsigned int b = 0; b < _buckets.size(); b++)
+    values[b] = _buckets[b].talents[split];
+  talent_less  less;
+  less.values = &values;
+  const unsigned int middle = first + (last - first) / 2;
+  nth_element(_order.begin() + first, _order.begin() + middle, _order.begin() + last, less);
+
+  const int left  = build_node(first, middle, n);
+  const int right = build_node(middle, last, n);
+  node &nd = _nodes[n];
+  nd.left = left;
+  nd.right = right;
+  nd.all_count  = _nodes[left].all_count  + _nodes[right].all_count;
+  nd.open_count = _nodes[left].open_count + _nodes[right].open_count;
+
+  return n;
+}
+
+
+/*                                                                          */
+/****************************************************************************/
+/*     R E F R E S H                                                        */
+/****************************************************************************/
+/*                                                                          */
+void circuit_index::refresh()
+{
+  for (unsigned int b = 0; b < _buckets.size(); b++)
+    {
+      const bucket &bk = _buckets[b];
+      map<int, circuit *>::const_iterator  it;
+      for (it = bk.all.begin(); it != bk.all.end(); ++it)
+        update(*it->second);
+    }
+}
+
+
+/*                                                                          */
+/****************************************************************************/
+/*     U P D A T E                                                          */
+/****************************************************************************/
+/*                                                                          */
+void circuit_index::update(
+  const circuit   &circ)           /*!< The circuit that changed            */
+{
+  set_open(circ.id(), circ.index(), circ.is_not_full());
+}
+
+
+/*                                                                          */
+/****************************************************************************/
+/*     C L O S E                                                            */
+/****************************************************************************/
+/*                                                                          */
+void circuit_index::close(
+  const unsigned int   index)      /*!< Index of the circuit                */
+{
+  set_open(index, index, false);
+}
+
+
+/*                                                                          */
+/****************************************************************************/
+/*     S E T _ O P E N                                                      */
+/****************************************************************************/
+/*                                                                          */
+void circuit_index::set_open(
+  const int            id,         /*!< ID of the circuit                   */
+  const int            index,      /*!< Index of the circuit                */
+  const bool           open)       /*!< True if the circuit is not full     */
+{
+  assert( (index >= 0) && (index < (int) _is_open.size()) );
+  if (open == _is_open[index])
+    return;
+
+  _is_open[index] = open;
+  bucket &bk = _buckets[_bucket_of[index]];
+  if (open)
+    {
+      bk.open.insert(pair<int, circuit *>(id, bk.all[id]));
+      adjust_counts(bk.node, 0, 1);
+    }
+  else
+    {
+      bk.open.erase(id);
+      adjust_counts(bk.node, 0, -1);
+    }
+}
+
+
+/*                                                                          */
+/****************************************************************************/
+/*     A D J U S T _ C O U N T S                                            */
+/****************************************************************************/
+/*                                                                          */
+void circuit_index::adjust_counts(
+  const int            node_index, /*!< The leaf node of the bucket         */
+  const int            all_delta,  /*!< Change in all circuits              */
+  const int            open_delta) /*!< Change in open circuits             */
+{
+  int n = node_index;
+  while (n >= 0)
+  {
+    node &nd = _nodes[n];
+    nd.all_count  += all_delta;
+    nd.open_count += open_delta;
+    n = nd.parent;
+  }
+}
+
+
+/*                                                                          */
+/****************************************************************************/
+/*     B E S T                                                              */
+/****************************************************************************/
+/*                                                                          */
+circuit *circuit_index::best(
+  const talent    &tal,            /*!< Talent of the juggler               */
+  const bool       open_only)      /*!< Only consider circuits not yet full */
+const
+{
+  vector<circuit *>  result;
+  top(tal, 1, open_only, result);
+  circuit *c = 0;
+  if (result.size() != 0)
+    c = result[0];
+
+  return c;
+}
+
+
+/*                                                                          */
+/****************************************************************************/
+/*     B E S T _ I D                                                        */
+/****************************************************************************/
+/*                                                                          */
+int circuit_index::best_id(
+  const talent_definition   &tal,  /*!< Talents of the juggler              */
+  const bool                 open_only)/*!< Only consider open circuits     */
+const
+{
+  if (_nodes.size() == 0)
+    return -1;
+
+  assert( (tal.hand >= 0) && (tal.endurance >= 0) && (tal.pizzazz >= 0) );
+  const int talents[3] = { tal.hand, tal.endurance, tal.pizzazz };
+  vector<candidate>  found;
+  search(0, talents, 1, open_only, found);
+  int id = -1;
+  if (found.size() != 0)
+    id = found[0].id;
+
+  return id;
+}
+
+
+/*                                                                          */
+/****************************************************************************/
+/*     T O P                                                                */
+/****************************************************************************/
+/*                                                                          */
+void circuit_index::top(
+  const talent             &tal,   /*!< Talent of the juggler               */
+  const unsigned int        k,     /*!< Number of circuits wanted           */
+  const bool                open_only,/*!< Only consider open circuits      */
+  vector<circuit *>        &result)/*!< Returned circuits                   */
+const
+{
+  result.clear();
+  if ((k == 0) || (_nodes.size() == 0))
+    return;
+
+  assert( (tal.hand() >= 0) && (tal.endurance() >= 0) && (tal.pizzazz() >= 0) );
+  const int talents[3] = { tal.hand(), tal.endurance(), tal.pizzazz() };
+  vector<candidate>  found;
+  search(0, talents, k, open_only, found);
+  for (unsigned int i = 0; i < found.size(); i++)
+    result.push_back(found[i].circ);
+}
+
+
+/*                                                                          */
+/****************************************************************************/
+/*     S E A R C H                                                          */
+/****************************************************************************/
+/*                                                                          */
+void circuit_index::search(
+  const int                 node_index,/*!< The subtree to search           */
+  const int                 tal[3],    /*!< Talents of the juggler          */
+  const unsigned int        k,         /*!< Number of circuits wanted       */
+  const bool                open_only, /*!< Only consider open circuits     */
+  vector<candidate>        &found)     /*!< Best circuits so far            */
+const
+{
+  const node &nd = _nodes[node_index];
+  const unsigned int count = open_only ? nd.open_count : nd.all_count;
+  if (count == 0)
+    return;
+
+  const int bound = dot3(tal, nd.high);
+  if ((found.size() == k) && (bound < found.back().score))
+    return;                        /* Nothing here can make the list        */
+
+  if (nd.left < 0)                 /* A leaf, score its bucket              */
+    {
+      const bucket &bk = _buckets[_order[nd.first]];
+      const map<int, circuit *> &circuits = open_only ? bk.open : bk.all;
+      const int score = dot3(tal, bk.talents);
+      map<int, circuit *>::const_iterator  it;
+      for (it = circuits.begin(); it != circuits.end(); ++it)
+        {
+          candidate  cand;
+          cand.score = score;
+          cand.id = it->first;
+          cand.circ = it->second;
+          if ( !offer(cand, k, found) )
+            break;                 /* The rest have higher IDs              */
+        }
+      return;
+    }
+
+  // Search the more promising child first to tighten the bound early
+  const int left_bound  = dot3(tal, _nodes[nd.left].high);
+  const int right_bound = dot3(tal, _nodes[nd.right].high);
+  if (left_bound >= right_bound)
+    {
+      search(nd.left,  tal, k, open_only, found);
+      search(nd.right, tal, k, open_only, found);
+    }
+  else
+    {
+      search(nd.right, tal, k, open_only, found);
+      search(nd.left,  tal, k, open_only, found);
+    }
+}
+
+
+/*                                                                          */
+/****************************************************************************/
+/*     O F F E R                                                            */
+/****************************************************************************/
+/*                                                                          */
+bool circuit_index::offer(
+  const candidate          &cand,  /*!< The candidate circuit               */
+  const unsigned int        k,     /*!< Number of circuits wanted           */
+  vector<candidate>        &found) /*!< Best circuits so far                */
+{
+  // Find where the candidate belongs; higher scores first, then lower IDs
+  unsigned int pos = found.size();
+  while (pos > 0)
+  {
+    const candidate &prev = found[pos - 1];
+    if ( (prev.score > cand.score) ||
+         ((prev.score == cand.score) && (prev.id < cand.id)) )
+      break;
+    pos--;
+  }
+  if (pos >= k)
+    return false;
+
+  found.insert(found.begin() + pos, cand);
+  if (found.size() > k)
+    found.pop_back();
+
+  return true;
+}
+
+
+/*                                                                          */
+/****************************************************************************/
+/*     A C C O U N T _ M E M O R Y                                          */
+/****************************************************************************/
+/*                                                                          */
+void circuit_index::account_memory(
+  memory_usage   &usage)           /*!< Where to charge them                */
+const
+{
+  usage.add_vector(memory_usage::index_tables, _buckets);
+  for (unsigned int b = 0; b < _buckets.size(); b++)
+    {
+      usage.add_tree(memory_usage::index_tables, _buckets[b].all);
+      usage.add_tree(memory_usage::index_tables, _buckets[b].open);
+    }
+  usage.add_vector(memory_usage::index_tables, _bucket_of);
+  usage.add_vector(memory_usage::index_tables, _is_open);
+  usage.add_vector(memory_usage::index_tables, _order);
+  usage.add_vector(memory_usage::index_tables, _nodes);
+}
+
+/*                                                                          */
+/****************************************************************************/
+/*     P R I N T _ S E L F                                                  */
+/****************************************************************************/
+/*                                                                          */
+ostream &circuit_index::print_self(
+  ostream    &os)                  /*!< The stream into which we stream     */
+const
+{
+  unsigned int all = 0;
+  unsigned int open = 0;
+  if (_nodes.size() != 0)
+    {
+      all = _nodes[0].all_count;
+      open = _nodes[0].open_count;
+    }
+  os << "circuit_index: " << all << " circuits (" << open << " open) in " <<
+        bucket_count() << " buckets";
+
+  return os;
+}
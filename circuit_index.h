@@ -0,0 +1,372 @@
+#ifndef circuit_index_h_included
+#define circuit_index_h_included 1
+
+/*!
+ * \file circuit_index.h
+ *
+ * \brief Contains the definition of circuit_index
+ *
+ * \author Stewart L. Palmer
+ */
+
+#include <iostream>
+#include <vector>
+#include <map>
+#include "memory_usage.h"
+
+class circuit;
+class circuit_set;
+class festival_instance;
+class talent;
+struct talent_definition;
+
+
+/*!
+ * \brief A maximum inner product index over the talents of the circuits
+ *
+ * This answers the question "which circuit gives this juggler the highest
+ * score" without scoring the juggler against every circuit.
+ *
+ * Talents are small non-negative integers, so many circuits share exactly the
+ * same hand-eye coordination, endurance, and pizzazz.  Circuits with the same
+ * talents are gathered into one bucket, since they all give a juggler the same
+ * score.  The buckets are then arranged in a kd-tree.  Each node of the tree
+ * records the largest value of each talent found beneath it.  Since talents
+ * are never negative, the dot product of a juggler with that corner is an
+ * upper bound on the score of any circuit beneath the node, which lets a search
+ * skip every subtree that cannot beat the best circuit found so far.
+ *
+ * Each node also counts the open (not full) circuits beneath it, so that the
+ * search for the best open circuit can skip subtrees where everything is full.
+ * update() must be called when a circuit fills or empties to keep the counts
+ * correct.
+ *
+ * Among circuits with equal scores the circuit with the lowest ID wins, which
+ * makes every answer deterministic.
+ *
+ * An index may also be built over the circuits of a festival_instance, which
+ * has no circuit objects.  Circuit i then has ID i, is found with best_id(),
+ * and is marked full with close().
+ */
+class circuit_index
+{
+public:
+
+  /*!
+   * \brief Standard constructor
+   *
+   * The index is empty until build() is called.
+   */
+  explicit circuit_index()
+  { }
+
+
+  /*!
+   * \brief Build the index over a set of circuits
+   *
+   * This runs in O(c log c), where c is the number of circuits.
+   */
+  void build(
+    circuit_set     &circuits      /*!< The set of all circuits             */
+            );
+
+
+  /*!
+   * \brief Build the index over the circuits of a festival_instance
+   *
+   * Every circuit starts open.  This runs in O(c log c), where c is the number
+   * of circuits.
+   */
+  void build(
+    const festival_instance   &inst/*!< The festival                        */
+            );
+
+
+  /*!
+   * \brief Recount the open circuits
+   *
+   * Used after many circuits have changed without update() being called, as
+   * happens when an assignment is made in bulk.  This runs in O(c).
+   */
+  void refresh();
+
+
+  /*!
+   * \brief Update the index after a circuit has filled or emptied
+   *
+   * This runs in O(log c).
+   */
+  void update(
+    const circuit   &circ          /*!< The circuit that changed            */
+             );
+
+
+  /*!
+   * \brief Mark a circuit of a festival_instance full
+   *
+   * This runs in O(log c).
+   */
+  void close(
+    const unsigned int   index     /*!< Index of the circuit                */
+            );
+
+
+  /*!
+   * \brief Return the highest scoring circuit for a juggler
+   *
+   * \return A pointer to the circuit or zero if there is no such circuit
+   */
+  circuit *best(
+    const talent    &tal,          /*!< Talent of the juggler               */
+    const bool       open_only     /*!< Only consider circuits not yet full */
+               )
+  const;
+
+
+  /*!
+   * \brief Return the ID of the highest scoring circuit for talents
+   *
+   * \return The ID of the circuit or -1 if there is no such circuit
+   */
+  int best_id(
+    const talent_definition   &tal,/*!< Talents of the juggler              */
+    const bool                 open_only/*!< Only consider open circuits    */
+             )
+  const;
+
+
+  /*!
+   * \brief Return the k highest scoring circuits for a juggler
+   *
+   * The circuits are returned from the highest score to the lowest.  Fewer than
+   * k circuits are returned if fewer exist.
+   */
+  void top(
+    const talent             &tal,  /*!< Talent of the juggler              */
+    const unsigned int        k,    /*!< Number of circuits wanted          */
+    const bool                open_only,/*!< Only consider open circuits    */
+    std::vector<circuit *>   &result/*!< Returned circuits                  */
+          )
+  const;
+
+
+  /*!
+   * \brief Return the number of distinct talent buckets
+   */
+  unsigned int bucket_count() const
+  { return _buckets.size(); }
+
+
+  /*!
+   * \brief Charge the buckets, their maps and the kd-tree to the index
+   */
+  void account_memory(
+    memory_usage   &usage          /*!< Where to charge them                */
+                     ) const;
+
+
+  /*!
+   *  \brief Stream object out to a stream
+   *
+   * \return The same stream as the input to allow for chained operators.
+   */
+  friend std::ostream &operator<<(
+    std::ostream           &os,    /*!< The stream into which we stream     */
+    const circuit_index    &cn)    /*!< The object to be streamed           */
+  {
+    return cn.print_self(os);
+  }
+
+private:
+
+  /*!
+   * \brief All the circuits that share the same talents
+   */
+  struct bucket
+  {
+    //! Hand-eye coordination, endurance, and pizzazz of these circuits
+    int                          talents[3];
+
+    //! The leaf node that holds this bucket
+    int                          node;
+
+    //! Every circuit in this bucket by ID, to its object or zero if none
+    std::map<int, circuit *>     all;
+
+    //! The circuits in this bucket that are not full ordered by ID
+    std::map<int, circuit *>     open;
+  };
+
+
+  /*!
+   * \brief A node of the kd-tree
+   */
+  struct node
+  {
+    //! The largest value of each talent in any bucket beneath this node
+    int                          high[3];
+
+    //! Index of the parent node or -1 for the root
+    int                          parent;
+
+    //! Index of the left child or -1 for a leaf
+    int                          left;
+
+    //! Index of the right child or -1 for a leaf
+    int                          right;
+
+    //! Index into _order of the first bucket beneath this node
+    unsigned int                 first;
+
+    //! Index into _order just past the last bucket beneath this node
+    unsigned int                 last;
+
+    //! Number of circuits beneath this node
+    unsigned int                 all_count;
+
+    //! Number of open circuits beneath this node
+    unsigned int                 open_count;
+  };
+
+
+  /*!
+   * \brief A candidate circuit found by a search
+   */
+  struct candidate
+  {
+    //! Score of the juggler in the circuit
+    int                          score;
+
+    //! ID of the circuit, used to break ties
+    int                          id;
+
+    //! The circuit, or zero in an index over a festival_instance
+    circuit                     *circ;
+  };
+
+
+  /*!
+   * \brief The copy constructor is deliberately private and unimplemented.
+   *
+   * \param rhs the object from which we are to be constructed
+   */
+  circuit_index(
+    const circuit_index   &rhs);
+
+  /*!
+   * \brief operator=() is deliberately private and unimplemented.
+   *
+   * \param rhs the object from which we are to be assigned
+   *
+   * \return reference to self to allow for chained operators
+   */
+  circuit_index &operator=(
+    const circuit_index   &rhs);
+
+  /*!
+   * \brief This is the implementation function for operator<<()
+   *
+   * \return The same stream as the input to allow for chained operators.
+   */
+  std::ostream &print_self(
+    std::ostream    &os)           /*!< The stream into which we stream     */
+  const;
+
+
+  /*!
+   * \brief Add a circuit to the bucket of its talents while building
+   */
+  void add_circuit(
+    const int            talents[3],/*!< Talents of the circuit             */
+    const int            id,       /*!< ID of the circuit                   */
+    const int            index,    /*!< Index of the circuit                */
+    circuit             *circ,     /*!< The circuit, if there is one        */
+    const bool           open,     /*!< True if the circuit is not full     */
+    std::map<std::pair<int, std::pair<int, int> >, int>  &bucket_key
+                                   /*!< Bucket of each set of talents       */
+                  );
+
+
+  /*!
+   * \brief Build the kd-tree once every circuit is in a bucket
+   */
+  void build_tree();
+
+
+  /*!
+   * \brief Mark a circuit open or full, updating its bucket and the counts
+   */
+  void set_open(
+    const int            id,       /*!< ID of the circuit                   */
+    const int            index,    /*!< Index of the circuit                */
+    const bool           open      /*!< True if the circuit is not full     */
+               );
+
+
+  /*!
+   * \brief Build the subtree over _order[first, last)
+   *
+   * \return Index of the new node
+   */
+  int build_node(
+    const unsigned int   first,    /*!< First bucket in _order              */
+    const unsigned int   last,     /*!< Just past last bucket in _order     */
+    const int            parent    /*!< Index of the parent node            */
+                );
+
+
+  /*!
+   * \brief Add the change in a bucket's counts to its node and all ancestors
+   */
+  void adjust_counts(
+    const int            node_index,/*!< The leaf node of the bucket        */
+    const int            all_delta, /*!< Change in all circuits             */
+    const int            open_delta /*!< Change in open circuits            */
+                    );
+
+
+  /*!
+   * \brief Search a subtree for the k best circuits
+   *
+   * found is kept ordered from best to worst and never holds more than k.
+   */
+  void search(
+    const int                 node_index,/*!< The subtree to search         */
+    const int                 tal[3],    /*!< Talents of the juggler        */
+    const unsigned int        k,         /*!< Number of circuits wanted     */
+    const bool                open_only, /*!< Only consider open circuits   */
+    std::vector<candidate>   &found      /*!< Best circuits so far          */
+             )
+  const;
+
+
+  /*!
+   * \brief Offer a candidate to the list of best circuits found so far
+   *
+   * \return false if the candidate was not good enough to be kept
+   */
+  static bool offer(
+    const candidate          &cand,      /*!< The candidate circuit         */
+    const unsigned int        k,         /*!< Number of circuits wanted     */
+    std::vector<candidate>   &found      /*!< Best circuits so far          */
+                   );
+
+
+  //! The buckets of circuits with identical talents
+  std::vector<bucket>        _buckets;
+
+  //! The bucket of each circuit, indexed by the circuit index
+  std::vector<int>           _bucket_of;
+
+  //! True for each circuit, by circuit index, that was last seen open
+  std::vector<bool>          _is_open;
+
+  //! Bucket indexes ordered so that each node covers a contiguous range
+  std::vector<int>           _order;
+
+  //! The nodes of the kd-tree; the root is node zero
+  std::vector<node>          _nodes;
+
+};
+
+#endif                             /* circuit_index_h_included              */
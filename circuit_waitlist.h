@@ -0,0 +1,140 @@
+#ifndef circuit_waitlist_h_included
+#define circuit_waitlist_h_included 1
+
+/*!
+ * \file circuit_waitlist.h
+ *
+ * \brief Contains the definition of circuit_waitlist
+ *
+ * \author Stewart L. Palmer
+ */
+
+#include <iostream>
+#include <assert.h>
+#include "juggler_circuit_set.h"
+#include "juggler_circuit_set_iterator.h"
+
+/*!
+ * \brief A bounded, score ordered set of jugglers that a circuit has rejected
+ *
+ * Whenever a circuit turns a juggler away, either because the juggler is not a
+ * good enough fit or because a better fitting juggler evicted it, the circuit may
+ * remember the juggler here.  If an assigned juggler later withdraws, the circuit
+ * walks its waitlist from the highest score down to find a replacement without
+ * rerunning the assignment.
+ *
+ * Only the best scoring jugglers are kept.  When the waitlist grows beyond its
+ * limit the lowest scoring juggler is forgotten.
+ */
+class circuit_waitlist
+{
+public:
+
+  /*!
+   * \brief Standard constructor
+   */
+  explicit circuit_waitlist()
+  { }
+
+
+  /*!
+   * \brief Add a rejected juggler to the waitlist
+   *
+   * If this takes the waitlist over its limit, the lowest scoring juggler is
+   * dropped.  A limit of zero means that no waitlist is kept.
+   */
+  void add(
+    const juggler_circuit  &jc,    /*!< The rejected juggler                */
+    const unsigned int      limit) /*!< Maximum size of the waitlist        */
+  {
+    if (limit == 0)
+      return;
+
+    _waiting.add(jc);
+    if (size() > limit)
+      {
+        juggler_circuit_set_iterator  wit(_waiting);
+        const juggler_circuit *const lowest = wit.first();
+        assert(lowest != 0);
+        wit.remove_current();
+      }
+  }
+
+
+  /*!
+   * \brief Return the number of jugglers on the waitlist
+   */
+  unsigned int size() const
+  { return _waiting.size(); }
+
+
+  /*!
+   * \brief Charge the waiting jugglers to the rosters
+   */
+  void account_memory(
+    memory_usage   &usage)         /*!< Where to charge them                */
+  const
+  { _waiting.account_memory(usage); }
+
+
+  /*!
+   * \brief Return a reference to the waiting jugglers
+   *
+   * The set is ordered from the lowest score to the highest score.
+   */
+  juggler_circuit_set &waiting()
+  { return _waiting; }
+
+
+  /*!
+   *  \brief Stream object out to a stream
+   *
+   * \return The same stream as the input to allow for chained operators.
+   */
+  friend std::ostream &operator<<(
+    std::ostream              &os, /*!< The stream into which we stream     */
+    const circuit_waitlist    &cn) /*!< The object to be streamed           */
+  {
+    return cn.print_self(os);
+  }
+
+private:
+
+  /*!
+   * \brief The copy constructor is deliberately private and unimplemented.
+   *
+   * \param rhs the object from which we are to be constructed
+   */
+  circuit_waitlist(
+    const circuit_waitlist   &rhs);
+
+  /*!
+   * \brief operator=() is deliberately private and unimplemented.
+   *
+   * \param rhs the object from which we are to be assigned
+   *
+   * \return reference to self to allow for chained operators
+   */
+  circuit_waitlist &operator=(
+    const circuit_waitlist   &rhs);
+
+  /*!
+   * \brief This is the implementation function for operator<<()
+   *
+   * \return The same stream as the input to allow for chained operators.
+   */
+  std::ostream &print_self(
+    std::ostream    &os)           /*!< The stream into which we stream     */
+  const
+  {
+    os << size() << " jugglers waiting:\n" << _waiting;
+
+    return os;
+  }
+
+  //! The rejected jugglers ordered by score
+  juggler_circuit_set     _waiting;
+
+};
+
+#endif                             /* circuit_waitlist_h_included           */
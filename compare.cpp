@@ -0,0 +1,91 @@
+
+/*!
+ * \file compare.cpp
+ *
+ * \brief Main program for comparing two assignment files
+ *
+ * \author Stewart L. Palmer
+ */
+
+#include <iostream>
+#include <stdlib.h>
+#include <unistd.h>
+#include "mapped_file.h"
+#include "parallel_task.h"
+#include "assignment_file.h"
+#include "assignment_diff.h"
+
+using namespace ::std;
+
+/*!
+ * \brief Print the command line usage
+ */
+static void usage(
+  const char   *program)           /*!< Name of the program                 */
+{
+  cerr << "usage: " << program << " [-s] [-t threads] before after\n"
+          "  -s           show only the summary\n"
+          "  -t threads   number of worker threads\n"
+          "  before       the earlier assignments\n"
+          "  after        the later assignments" << endl;
+}
+
+
+int main(
+  int     argc,
+  char   *argv[])
+{
+  int workers = parallel_task::available_workers();
+  bool details = true;
+  int opt = getopt(argc, argv, "st:");
+  while (opt != -1)
+  {
+    switch (opt)
+    {
+      case 's':
+        details = false;
+        break;
+      case 't':
+        workers = atoi(optarg);
+        if (workers <= 0)
+          {
+            usage(argv[0]);
+            return 2;
+          }
+        break;
+      default:
+        usage(argv[0]);
+        return 2;
+    }
+    opt = getopt(argc, argv, "st:");
+  }
+  if ((argc - optind) != 2)
+    {
+      usage(argv[0]);
+      return 2;
+    }
+
+  mapped_file before_text;
+  if (before_text.map(argv[optind]) != 0)
+    {
+      cerr << "Cannot read " << argv[optind] << endl;
+      return 2;
+    }
+  mapped_file after_text;
+  if (after_text.map(argv[optind + 1]) != 0)
+    {
+      cerr << "Cannot read " << argv[optind + 1] << endl;
+      return 2;
+    }
+
+  // Like diff, return 0 if the same, 1 if different and 2 for trouble
+  assignment_file before(before_text.name(), before_text.data(), before_text.size());
+  assignment_file after(after_text.name(), after_text.data(), after_text.size());
+  uint64_t problems = before.parse(workers, cerr);
+  problems += after.parse(workers, cerr);
+  assignment_diff diff(before, after);
+  const int rc = diff.compare(workers, details, cout);
+  cout << diff << endl;
+
+  return ( (problems != 0) ? 2 : rc );
+}
@@ -0,0 +1,65 @@
+
+/*!
+ * \file container_trace.cpp
+ *
+ * \brief Contains the implementation of container_trace
+ *
+ * \author Stewart L. Palmer
+ */
+
+#include "container_trace.h"
+
+using namespace ::std;
+
+
+/*                                                                          */
+/****************************************************************************/
+/*     O P E R A T I O N _ N A M E                                          */
+/****************************************************************************/
+/*                                                                          */
+const char *container_trace::operation_name(
+  const operation      op)         /*!< The operation                       */
+{
+  static const char *const names[operation_count] =
+  {
+    "insert", "remove", "evict_min", "min", "iterate",
+    "orphan_insert", "orphan_remove", "orphan_take"
+  };
+
+  return names[op];
+}
+
+
+/*                                                                          */
+/****************************************************************************/
+/*     C O U N T                                                            */
+/****************************************************************************/
+/*                                                                          */
+uint64_t container_trace::count(
+  const operation      op)         /*!< The operation                       */
+const
+{
+  uint64_t n = 0;
+  for (size_t i = 0; i < _events.size(); i++)
+    if (_events[i].op == op)
+      n++;
+
+  return n;
+}
+
+
+/*                                                                          */
+/****************************************************************************/
+/*     P R I N T _ S E L F                                                  */
+/****************************************************************************/
+/*                                                                          */
+ostream &container_trace::print_self(
+  ostream    &os)                  /*!< The stream into which we stream     */
+const
+{
+  os << "container_trace: " << _events.size() << " events";
+  for (unsigned int op = 0; op < operation_count; op++)
+    os << ", " << operation_name((operation) op) << " = " << count((operation) op);
+
+  return os;
+}
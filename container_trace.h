@@ -0,0 +1,201 @@
+#ifndef container_trace_h_included
+#define container_trace_h_included 1
+
+/*!
+ * \file container_trace.h
+ *
+ * \brief Contains the definition of container_trace
+ *
+ * \author Stewart L. Palmer
+ */
+
+#include <iostream>
+#include <vector>
+#include <assert.h>
+#include <stdint.h>
+
+class juggler;
+class juggler_circuit;
+
+
+/*!
+ * \brief The operations a solve did on its rosters and on its set of orphans,
+ *        in the order it did them
+ *
+ * A scheduler given one with scheduler::set_container_trace() records every
+ * insertion into and removal from the roster of a circuit (the
+ * juggler_circuit_set of its assigned jugglers), every lookup of the lowest
+ * score of a full roster while placing a juggler, and every insertion into
+ * and removal from the set of orphans (a type_pointer_set by name).  At the end
+ * of assign() it adds one ordered walk of each roster, which is what writing
+ * the assignments does.  Replaying a trace against another container shows what
+ * it would have cost the same solve; containerbench does exactly that.
+ *
+ * The events point at the scheduler's jugglers and juggler_circuits, so a
+ * trace can only be replayed while the scheduler lives.  Recording is meant for
+ * a solve on one worker thread.
+ */
+class container_trace
+{
+public:
+
+  /*!
+   * \brief What an event did
+   */
+  enum operation
+  {
+    roster_insert,                 /*!< A juggler assigned to a circuit     */
+    roster_remove,                 /*!< A given juggler removed             */
+    roster_evict_min,              /*!< The lowest scoring juggler removed  */
+    roster_min,                    /*!< The lowest score looked up          */
+    roster_iterate,                /*!< The roster walked in order          */
+    orphan_insert,                 /*!< A juggler added to the orphans      */
+    orphan_remove,                 /*!< A given juggler taken from them     */
+    orphan_take,                   /*!< The first orphan taken from them    */
+    operation_count                /*!< Number of operations                */
+  };
+
+
+  /*!
+   * \brief One operation on one container
+   */
+  struct event
+  {
+    //! The operation
+    operation                 op;
+
+    //! Index of the circuit, for operations on a roster
+    unsigned int              circuit;
+
+    //! The juggler_circuit inserted or removed, for operations on a roster
+    const juggler_circuit    *jc;
+
+    //! The juggler inserted or removed, for operations on the orphans
+    const juggler            *jug;
+  };
+
+
+  /*!
+   * \brief Standard constructor
+   */
+  container_trace()
+  { }
+
+
+  /*!
+   * \brief Return the name of an operation, as used in reports
+   */
+  static const char *operation_name(
+    const operation      op        /*!< The operation                       */
+                                   );
+
+
+  /*!
+   * \brief Record an operation on the roster of a circuit
+   */
+  void record_roster(
+    const operation          op,   /*!< The operation                       */
+    const unsigned int       circuit,/*!< Index of the circuit              */
+    const juggler_circuit   *jc)   /*!< The juggler_circuit, if any         */
+  {
+    assert(op <= roster_iterate);
+    const event e = { op, circuit, jc, 0 };
+    _events.push_back(e);
+  }
+
+
+  /*!
+   * \brief Record an operation on the orphans
+   */
+  void record_orphan(
+    const operation          op,   /*!< The operation                       */
+    const juggler           *jug)  /*!< The juggler                         */
+  {
+    assert(op >= orphan_insert);
+    const event e = { op, 0, 0, jug };
+    _events.push_back(e);
+  }
+
+
+  /*!
+   * \brief Return the number of events
+   */
+  size_t size() const
+  { return _events.size(); }
+
+
+  /*!
+   * \brief Return an event
+   */
+  const event &operator[](
+    const size_t         i)        /*!< Index of the event                  */
+  const
+  {
+    assert(i < _events.size());
+    return _events[i];
+  }
+
+
+  /*!
+   * \brief Return the number of events of one operation
+   */
+  uint64_t count(
+    const operation      op        /*!< The operation                       */
+                ) const;
+
+
+  /*!
+   * \brief Forget every event
+   */
+  void clear()
+  { _events.clear(); }
+
+
+  /*!
+   *  \brief Stream object out to a stream
+   *
+   * \return The same stream as the input to allow for chained operators.
+   */
+  friend std::ostream &operator<<(
+    std::ostream            &os,   /*!< The stream into which we stream     */
+    const container_trace   &cn)   /*!< The object to be streamed           */
+  {
+    return cn.print_self(os);
+  }
+
+private:
+
+  /*!
+   * \brief The copy constructor is deliberately private and unimplemented.
+   *
+   * \param rhs the object from which we are to be constructed
+   */
+  container_trace(
+    const container_trace   &rhs);
+
+  /*!
+   * \brief operator=() is deliberately private and unimplemented.
+   *
+   * \param rhs the object from which we are to be assigned
+   *
+   * \return reference to self to allow for chained operators
+   */
+  container_trace &operator=(
+    const container_trace   &rhs);
+
+  /*!
+   * \brief This is the implementation function for operator<<()
+   *
+   * \return The same stream as the input to allow for chained operators.
+   */
+  std::ostream &print_self(
+    std::ostream    &os)           /*!< The stream into which we stream     */
+  const;
+
+
+  //! The events, oldest first
+  std::vector<event>   _events;
+
+};
+
+#endif                             /* container_trace_h_included            */
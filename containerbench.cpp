@@ -0,0 +1,652 @@
+
+/*!
+ * \file containerbench.cpp
+ *
+ * \brief Main program for timing the roster and name containers on the trace
+ *        of a solve, against candidates to replace them
+ *
+ * \author Stewart L. Palmer
+ */
+
+#include <algorithm>
+#include <iostream>
+#include <set>
+#include <sstream>
+#include <string>
+#include <utility>
+#include <vector>
+#include <sys/time.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include "container_trace.h"
+#include "festival_generator.h"
+#include "juggler.h"
+#include "juggler_circuit.h"
+#include "juggler_circuit_set.h"
+#include "juggler_circuit_set_const_iterator.h"
+#include "juggler_circuit_set_iterator.h"
+#include "line_scanner.h"
+#include "name_table.h"
+#include "scheduler.h"
+#include "type_pointer_set.h"
+#include "type_pointer_set_iterator.h"
+
+using namespace ::std;
+
+
+/*!
+ * \brief A juggler in a roster held by value, in the order of juggler_circuit
+ */
+struct roster_key
+{
+  //! Score of the juggler in the circuit
+  int            score;
+
+  //! Preference of the juggler for the circuit
+  int            preference;
+
+  //! Number of the juggler
+  int            juggler;
+
+  /*!
+   * \brief Compare as juggler_circuit::operator<() does
+   */
+  bool operator<(
+    const roster_key   &rhs)       /*!< Right hand side of comparison       */
+  const
+  {
+    if (score != rhs.score)
+      return (score < rhs.score);
+    if (preference != rhs.preference)
+      return (preference < rhs.preference);
+    return (juggler < rhs.juggler);
+  }
+};
+
+
+/*!
+ * \brief The time and the result of replaying a trace against one container
+ */
+struct replay_result
+{
+  //! Name of the container
+  const char    *container;
+
+  //! Seconds for all of the repeats
+  double         seconds;
+
+  //! Sum of everything the replay looked up, which every container must agree on
+  int64_t        checksum;
+};
+
+
+/*!
+ * \brief Print the command line usage
+ */
+static void usage(
+  const char   *program)           /*!< Name of the program                 */
+{
+  cerr << "usage: " << program << " [-c circuits] [-j jugglers] [-l preferences] [-m popularity]\n"
+          "       [-r seed] [-w repeats]\n"
+          "  -c circuits     number of circuits, 2000 by default\n"
+          "  -j jugglers     number of jugglers, 12000 by default\n"
+          "  -l preferences  preferences of each juggler, 10 by default\n"
+          "  -m popularity   as for generate, uniform by default\n"
+          "  -r seed         seed of the festival, 1 by default\n"
+          "  -w repeats      times each trace is replayed, 20 by default" << endl;
+}
+
+
+/*!
+ * \brief Return the time of day in seconds
+ */
+static double now()
+{
+  struct timeval tv;
+  gettimeofday(&tv, 0);
+
+  return (tv.tv_sec + tv.tv_usec / 1000000.0);
+}
+
+
+/*!
+ * \brief Replay the roster events against juggler_circuit_set, as the
+ *        circuits use it
+ */
+static replay_result replay_juggler_circuit_set(
+  const container_trace   &trace,  /*!< The recorded solve                  */
+  const unsigned int       circuits,/*!< Number of circuits                 */
+  const unsigned int       repeats)/*!< Number of replays                   */
+{
+  replay_result result = { "juggler_circuit_set", 0.0, 0 };
+  for (unsigned int r = 0; r < repeats; r++)
+    {
+      vector<juggler_circuit_set *> rosters(circuits);
+      for (unsigned int c = 0; c < circuits; c++)
+        rosters[c] = new juggler_circuit_set;
+
+      int64_t sum = 0;
+      const double start = now();
+      for (size_t i = 0; i < trace.size(); i++)
+        {
+          const container_trace::event &e = trace[i];
+          juggler_circuit_set &roster = *rosters[e.circuit];
+          switch (e.op)
+          {
+            case container_trace::roster_insert:
+              roster.add(*e.jc);
+              break;
+            case container_trace::roster_remove:
+              roster.remove(*e.jc);
+              break;
+            case container_trace::roster_evict_min:
+              {
+                juggler_circuit_set_iterator it(roster);
+                sum += it.first()->juggler_id();
+                it.remove_current();
+              }
+              break;
+            case container_trace::roster_min:
+              {
+                juggler_circuit_set_const_iterator it(roster);
+                const juggler_circuit *const jc = it.first();
+                sum += (jc == 0) ? 0 : jc->score();
+              }
+              break;
+            case container_trace::roster_iterate:
+              {
+                juggler_circuit_set_const_iterator it(roster);
+                for (const juggler_circuit *jc = it.last(); jc != 0; jc = it.previous())
+                  sum += jc->juggler_id();
+              }
+              break;
+            default:
+              break;
+          }
+        }
+      result.seconds += now() - start;
+      result.checksum = sum;
+
+      for (unsigned int c = 0; c < circuits; c++)
+        delete rosters[c];
+    }
+
+  return result;
+}
+
+
+/*!
+ * \brief Replay the roster events against a std::set of roster_key, which
+ *        keeps the order by value instead of through a juggler_circuit
+ */
+static replay_result replay_value_set(
+  const container_trace        &trace,/*!< The recorded solve               */
+  const vector<roster_key>     &keys,/*!< Key of each event                 */
+  const unsigned int            circuits,/*!< Number of circuits            */
+  const unsigned int            repeats)/*!< Number of replays              */
+{
+  replay_result result = { "std::set<roster_key>", 0.0, 0 };
+  for (unsigned int r = 0; r < repeats; r++)
+    {
+      vector< set<roster_key> > rosters(circuits);
+
+      int64_t sum = 0;
+      const double start = now();
+      for (size_t i = 0; i < trace.size(); i++)
+        {
+          const container_trace::event &e = trace[i];
+          set<roster_key> &roster = rosters[e.circuit];
+          switch (e.op)
+          {
+            case container_trace::roster_insert:
+              roster.insert(keys[i]);
+              break;
+            case container_trace::roster_remove:
+              roster.erase(keys[i]);
+              break;
+            case container_trace::roster_evict_min:
+              sum += roster.begin()->juggler;
+              roster.erase(roster.begin());
+              break;
+            case container_trace::roster_min:
+              sum += roster.empty() ? 0 : roster.begin()->score;
+              break;
+            case container_trace::roster_iterate:
+              for (set<roster_key>::const_reverse_iterator it = roster.rbegin(); it != roster.rend(); ++it)
+                sum += it->juggler;
+              break;
+            default:
+              break;
+          }
+        }
+      result.seconds += now() - start;
+      result.checksum = sum;
+    }
+
+  return result;
+}
+
+
+/*!
+ * \brief Replay the roster events against a sorted std::vector of roster_key,
+ *        which suits rosters of a few jugglers
+ */
+static replay_result replay_sorted_vector(
+  const container_trace        &trace,/*!< The recorded solve               */
+  const vector<roster_key>     &keys,/*!< Key of each event                 */
+  const unsigned int            circuits,/*!< Number of circuits            */
+  const unsigned int            repeats)/*!< Number of replays              */
+{
+  replay_result result = { "sorted std::vector<roster_key>", 0.0, 0 };
+  for (unsigned int r = 0; r < repeats; r++)
+    {
+      vector< vector<roster_key> > rosters(circuits);
+
+      int64_t sum = 0;
+      const double start = now();
+      for (size_t i = 0; i < trace.size(); i++)
+        {
+          const container_trace::event &e = trace[i];
+          vector<roster_key> &roster = rosters[e.circuit];
+          switch (e.op)
+          {
+            case container_trace::roster_insert:
+              roster.insert(upper_bound(roster.begin(), roster.end(), keys[i]), keys[i]);
+              break;
+            case container_trace::roster_remove:
+              roster.erase(lower_bound(roster.begin(), roster.end(), keys[i]));
+              break;
+            case container_trace::roster_evict_min:
+              sum += roster.front().juggler;
+              roster.erase(roster.begin());
+              break;
+            case container_trace::roster_min:
+              sum += roster.empty() ? 0 : roster.front().score;
+              break;
+            case container_trace::roster_iterate:
+              for (size_t k = roster.size(); k > 0; k--)
+                sum += roster[k - 1].juggler;
+              break;
+            default:
+              break;
+          }
+        }
+      result.seconds += now() - start;
+      result.checksum = sum;
+    }
+
+  return result;
+}
+
+
+/*!
+ * \brief Replay the orphan events against type_pointer_set, as the scheduler
+ *        uses it
+ */
+static replay_result replay_type_pointer_set(
+  const container_trace   &trace,  /*!< The recorded solve                  */
+  const unsigned int       repeats)/*!< Number of replays                   */
+{
+  replay_result result = { "type_pointer_set", 0.0, 0 };
+  for (unsigned int r = 0; r < repeats; r++)
+    {
+      type_pointer_set<string, const juggler *> orphans;
+
+      int64_t sum = 0;
+      const double start = now();
+      for (size_t i = 0; i < trace.size(); i++)
+        {
+          const container_trace::event &e = trace[i];
+          const juggler *jug = e.jug;
+          switch (e.op)
+          {
+            case container_trace::orphan_insert:
+              orphans.add(jug->name(), jug);
+              break;
+            case container_trace::orphan_remove:
+              orphans.remove(jug->name());
+              break;
+            case container_trace::orphan_take:
+              {
+                type_pointer_set_iterator<string, const juggler *> it(orphans);
+                sum += it.next()->id();
+                it.remove_current();
+              }
+              break;
+            default:
+              break;
+          }
+        }
+      result.seconds += now() - start;
+      result.checksum = sum;
+    }
+
+  return result;
+}
+
+
+/*!
+ * \brief Replay the orphan events against a sorted std::vector of names
+ */
+static replay_result replay_sorted_names(
+  const container_trace   &trace,  /*!< The recorded solve                  */
+  const unsigned int       repeats)/*!< Number of replays                   */
+{
+  typedef pair<string, const juggler *> named;
+  replay_result result = { "sorted std::vector<name>", 0.0, 0 };
+  for (unsigned int r = 0; r < repeats; r++)
+    {
+      vector<named> orphans;
+
+      int64_t sum = 0;
+      const double start = now();
+      for (size_t i = 0; i < trace.size(); i++)
+        {
+          const container_trace::event &e = trace[i];
+          const juggler *jug = e.jug;
+          switch (e.op)
+          {
+            case container_trace::orphan_insert:
+              {
+                const named n(jug->name(), jug);
+                orphans.insert(lower_bound(orphans.begin(), orphans.end(), n), n);
+              }
+              break;
+            case container_trace::orphan_remove:
+              orphans.erase(lower_bound(orphans.begin(), orphans.end(),
+                                        named(jug->name(), (const juggler *) 0)));
+              break;
+            case container_trace::orphan_take:
+              sum += orphans.front().second->id();
+              orphans.erase(orphans.begin());
+              break;
+            default:
+              break;
+          }
+        }
+      result.seconds += now() - start;
+      result.checksum = sum;
+    }
+
+  return result;
+}
+
+
+/*!
+ * \brief Look up every preference by circuit name in a type_pointer_set, as
+ *        reading input.txt does
+ */
+static replay_result find_type_pointer_set(
+  const vector<string>   &names,   /*!< Name of each circuit                */
+  const vector<string>   &lookups, /*!< Names looked up, in order           */
+  const unsigned int      repeats) /*!< Number of replays                   */
+{
+  replay_result result = { "type_pointer_set", 0.0, 0 };
+  type_pointer_set<string, unsigned int> table;
+  for (unsigned int c = 0; c < names.size(); c++)
+    table.add(names[c], c);
+
+  for (unsigned int r = 0; r < repeats; r++)
+    {
+      int64_t sum = 0;
+      const double start = now();
+      for (size_t i = 0; i < lookups.size(); i++)
+        {
+          unsigned int c = 0;
+          if (table.find(lookups[i], c) == 0)
+            sum += c;
+        }
+      result.seconds += now() - start;
+      result.checksum = sum;
+    }
+
+  return result;
+}
+
+
+/*!
+ * \brief Look up every preference by circuit name in a sorted std::vector
+ */
+static replay_result find_sorted_names(
+  const vector<string>   &names,   /*!< Name of each circuit                */
+  const vector<string>   &lookups, /*!< Names looked up, in order           */
+  const unsigned int      repeats) /*!< Number of replays                   */
+{
+  typedef pair<string, unsigned int> named;
+  replay_result result = { "sorted std::vector<name>", 0.0, 0 };
+  vector<named> table;
+  for (unsigned int c = 0; c < names.size(); c++)
+    table.push_back(named(names[c], c));
+  sort(table.begin(), table.end());
+
+  for (unsigned int r = 0; r < repeats; r++)
+    {
+      int64_t sum = 0;
+      const double start = now();
+      for (size_t i = 0; i < lookups.size(); i++)
+        {
+          const vector<named>::const_iterator it =
+            lower_bound(table.begin(), table.end(), named(lookups[i], 0));
+          if ( (it != table.end()) && (it->first == lookups[i]) )
+            sum += it->second;
+        }
+      result.seconds += now() - start;
+      result.checksum = sum;
+    }
+
+  return result;
+}
+
+
+/*!
+ * \brief Look up every preference by circuit name in a name_table, the hash
+ *        table that verify uses
+ */
+static replay_result find_name_table(
+  const vector<string>   &names,   /*!< Name of each circuit                */
+  const vector<string>   &lookups, /*!< Names looked up, in order           */
+  const unsigned int      repeats) /*!< Number of replays                   */
+{
+  replay_result result = { "name_table", 0.0, 0 };
+  vector<line_scanner::span> spans(names.size());
+  for (unsigned int c = 0; c < names.size(); c++)
+    {
+      spans[c].text = names[c].data();
+      spans[c].size = names[c].size();
+    }
+  name_table table(spans);
+  table.reset();
+  for (unsigned int c = 0; c < names.size(); c++)
+    table.insert(c);
+
+  for (unsigned int r = 0; r < repeats; r++)
+    {
+      int64_t sum = 0;
+      const double start = now();
+      for (size_t i = 0; i < lookups.size(); i++)
+        {
+          line_scanner::span s;
+          s.text = lookups[i].data();
+          s.size = lookups[i].size();
+          const int c = table.find(s);
+          if (c >= 0)
+            sum += c;
+        }
+      result.seconds += now() - start;
+      result.checksum = sum;
+    }
+
+  return result;
+}
+
+
+/*!
+ * \brief Write the results of one group of replays as a JSON array
+ *
+ * \return Zero if every container agreed, non-zero otherwise
+ */
+static int write_results(
+  ostream                         &os,/*!< The stream for the array         */
+  const vector<replay_result>     &results,/*!< The replays                 */
+  const uint64_t                   operations,/*!< Operations per replay    */
+  const unsigned int               repeats)/*!< Number of replays           */
+{
+  int rc = 0;
+  os << "[";
+  for (unsigned int r = 0; r < results.size(); r++)
+    {
+      const double per = (operations == 0) ? 0.0 :
+                         results[r].seconds * 1e9 / ((double) operations * repeats);
+      os << ((r == 0) ? "" : ",") << "\n  {\"container\":\"" << results[r].container <<
+            "\",\"seconds\":" << results[r].seconds << ",\"ns_per_operation\":" << per <<
+            ",\"checksum\":" << results[r].checksum << "}";
+      if (results[r].checksum != results[0].checksum)
+        {
+          cerr << results[r].container << " disagrees with " << results[0].container << endl;
+          rc = 1;
+        }
+    }
+  os << "]";
+
+  return rc;
+}
+
+
+int main(
+  int     argc,
+  char   *argv[])
+{
+  unsigned int circuits = 2000;
+  unsigned int jugglers = 12000;
+  unsigned int length = 10;
+  string popularity = "uniform";
+  unsigned long seed = 1;
+  unsigned int repeats = 20;
+
+  int opt = getopt(argc, argv, "c:j:l:m:r:w:");
+  while (opt != -1)
+  {
+    switch (opt)
+    {
+      case 'c':
+        circuits = atoi(optarg);
+        break;
+      case 'j':
+        jugglers = atoi(optarg);
+        break;
+      case 'l':
+        length = atoi(optarg);
+        break;
+      case 'm':
+        popularity = optarg;
+        break;
+      case 'r':
+        seed = strtoul(optarg, 0, 10);
+        break;
+      case 'w':
+        repeats = atoi(optarg);
+        if (repeats == 0)
+          {
+            usage(argv[0]);
+            return 1;
+          }
+        break;
+      default:
+        usage(argv[0]);
+        return 1;
+    }
+    opt = getopt(argc, argv, "c:j:l:m:r:w:");
+  }
+  if (optind != argc)
+    {
+      usage(argv[0]);
+      return 1;
+    }
+
+  festival_generator generator(circuits, jugglers, length, seed);
+  festival_definition definition;
+  if ( (generator.set_popularity(popularity) != 0) ||
+       (generator.generate(definition) != 0) )
+    {
+      cerr << "Cannot make " << jugglers << " jugglers with " << length <<
+              " preferences over " << circuits << " circuits with " <<
+              popularity << " popularity." << endl;
+      return 1;
+    }
+
+  // Record a solve
+  scheduler *created = 0;
+  if (scheduler::create(definition, cerr, created) != 0)
+    return 1;
+  scheduler &sched = *created;
+  sched.set_worker_count(1);
+  container_trace trace;
+  sched.set_container_trace(&trace);
+  sched.assign();
+  sched.set_container_trace(0);
+
+  // The candidates that hold rosters by value get their keys ahead of time
+  vector<roster_key> keys(trace.size());
+  for (size_t i = 0; i < trace.size(); i++)
+    if (trace[i].jc != 0)
+      {
+        keys[i].score = trace[i].jc->score();
+        keys[i].preference = trace[i].jc->preference();
+        keys[i].juggler = trace[i].jc->juggler_id();
+      }
+
+  // Reading input.txt looks up every preference by name, in file order
+  vector<string> names(circuits);
+  for (unsigned int c = 0; c < circuits; c++)
+    {
+      ostringstream name;
+      name << "C" << c;
+      names[c] = name.str();
+    }
+  vector<string> lookups(definition.preferences.size());
+  for (size_t p = 0; p < lookups.size(); p++)
+    lookups[p] = names[definition.preferences[p]];
+
+  uint64_t roster_operations = 0;
+  uint64_t orphan_operations = 0;
+  cout << "{\"festival\":{\"circuits\":" << circuits << ",\"jugglers\":" << jugglers <<
+          ",\"preferences\":" << length << ",\"popularity\":\"" << popularity <<
+          "\",\"seed\":" << seed << "},\"repeats\":" << repeats << ",\"trace\":{";
+  for (unsigned int op = 0; op < container_trace::operation_count; op++)
+    {
+      const uint64_t n = trace.count((container_trace::operation) op);
+      if (op <= container_trace::roster_iterate)
+        roster_operations += n;
+      else
+        orphan_operations += n;
+      cout << ((op == 0) ? "" : ",") << "\"" <<
+              container_trace::operation_name((container_trace::operation) op) << "\":" << n;
+    }
+  cout << ",\"find_by_name\":" << lookups.size() << "},\n\"rosters\":";
+
+  vector<replay_result> results;
+  results.push_back(replay_juggler_circuit_set(trace, circuits, repeats));
+  results.push_back(replay_value_set(trace, keys, circuits, repeats));
+  results.push_back(replay_sorted_vector(trace, keys, circuits, repeats));
+  int rc = write_results(cout, results, roster_operations, repeats);
+
+  cout << ",\n\"orphans\":";
+  results.clear();
+  results.push_back(replay_type_pointer_set(trace, repeats));
+  results.push_back(replay_sorted_names(trace, repeats));
+  if (write_results(cout, results, orphan_operations, repeats) != 0)
+    rc = 1;
+
+  cout << ",\n\"find_by_name\":";
+  results.clear();
+  results.push_back(find_type_pointer_set(names, lookups, repeats));
+  results.push_back(find_sorted_names(names, lookups, repeats));
+  results.push_back(find_name_table(names, lookups, repeats));
+  if (write_results(cout, results, lookups.size(), repeats) != 0)
+    rc = 1;
+  cout << "}" << endl;
+  delete created;
+
+  return rc;
+}
@@ -0,0 +1,120 @@
+
+/*!
+ * \file daemon_client.cpp
+ *
+ * \brief Contains the implementation of daemon_client
+ *
+ * \author Stewart L. Palmer
+ */
+
+#include <assert.h>
+#include <errno.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include "output_buffer.h"
+#include "daemon_client.h"
+
+using namespace ::std;
+
+
+/*                                                                          */
+/****************************************************************************/
+/*     D E S T R U C T O R                                                  */
+/****************************************************************************/
+/*                                                                          */
+daemon_client::~daemon_client()
+{
+  if (_fd >= 0)
+    close(_fd);
+}
+
+
+/*                                                                          */
+/****************************************************************************/
+/*     C O N N E C T                                                        */
+/****************************************************************************/
+/*                                                                          */
+int daemon_client::connect(
+  const string    &path)           /*!< Path of the socket                  */
+{
+  sockaddr_un address;
+  memset(&address, 0, sizeof(address));
+  address.sun_family = AF_UNIX;
+  if (path.size() >= sizeof(address.sun_path))
+    return 1;
+  memcpy(address.sun_path, path.c_str(), path.size());
+
+  _fd = socket(AF_UNIX, SOCK_STREAM, 0);
+  if (_fd < 0)
+    return 1;
+  if (::connect(_fd, reinterpret_cast<sockaddr *>(&address), sizeof(address)) != 0)
+    {
+      close(_fd);
+      _fd = -1;
+      return 1;
+    }
+
+  return 0;
+}
+
+
+/*                                                                          */
+/****************************************************************************/
+/*     C A L L                                                              */
+/****************************************************************************/
+/*                                                                          */
+int daemon_client::call(
+  const daemon_request          &request,/*!< The request                   */
+  const vector<uint32_t>        &preferences,/*!< Circuit numbers           */
+  daemon_reply                  &reply,/*!< The reply                       */
+  vector<daemon_entry>          &entries)/*!< The entries of the reply      */
+{
+  assert(request.preference_count == preferences.size());
+  output_buffer ob;
+  ob.append(reinterpret_cast<const char *>(&request), sizeof(request));
+  if ( !preferences.empty() )
+    ob.append(reinterpret_cast<const char *>(&preferences[0]),
+              preferences.size() * sizeof(uint32_t));
+  if (ob.write_to(_fd) != 0)
+    return 1;
+
+  if (read_fully(&reply, sizeof(reply)) != 0)
+    return 1;
+  entries.resize(reply.entry_count);
+  if ( (reply.entry_count != 0) &&
+       (read_fully(&entries[0], reply.entry_count * sizeof(daemon_entry)) != 0) )
+    return 1;
+
+  return 0;
+}
+
+
+/*                                                                          */
+/****************************************************************************/
+/*     R E A D _ F U L L Y                                                  */
+/****************************************************************************/
+/*                                                                          */
+int daemon_client::read_fully(
+  void            *data,           /*!< Where to put the bytes              */
+  const size_t     size)           /*!< Number of bytes                     */
+{
+  char *const bytes = static_cast<char *>(data);
+  size_t done = 0;
+  while (done < size)
+  {
+    const ssize_t n = read(_fd, bytes + done, size - done);
+    if (n < 0)
+      {
+        if (errno == EINTR)
+          continue;
+        return 1;
+      }
+    if (n == 0)
+      return 1;
+    done += n;
+  }
+
+  return 0;
+}
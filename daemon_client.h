@@ -0,0 +1,132 @@
+#ifndef daemon_client_h_included
+#define daemon_client_h_included 1
+
+/*!
+ * \file daemon_client.h
+ *
+ * \brief Contains the definition of daemon_client
+ *
+ * \author Stewart L. Palmer
+ */
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include "daemon_protocol.h"
+
+
+/*!
+ * \brief A connection to a solver_daemon
+ *
+ * Each call() sends one daemon_request and waits for its reply, so a client
+ * sees its own changes in every later call.
+ */
+class daemon_client
+{
+public:
+
+  /*!
+   * \brief Standard constructor
+   *
+   * The client is not connected until connect() is called.
+   */
+  explicit daemon_client()
+  :
+  _fd(-1)
+  { }
+
+
+  /*!
+   * \brief Destructor
+   */
+  ~daemon_client();
+
+
+  /*!
+   * \brief Connect to the daemon listening on a socket
+   *
+   * \return Zero if connected, non-zero otherwise
+   */
+  int connect(
+    const std::string    &path     /*!< Path of the socket                  */
+             );
+
+
+  /*!
+   * \brief Send a request and wait for the reply
+   *
+   * \return Zero if a reply came back, non-zero if the connection failed
+   */
+  int call(
+    const daemon_request          &request,/*!< The request                 */
+    const std::vector<uint32_t>   &preferences,/*!< Circuit numbers of an
+                                                    add_operation           */
+    daemon_reply                  &reply,/*!< The reply                     */
+    std::vector<daemon_entry>     &entries/*!< The entries of the reply     */
+          );
+
+
+  /*!
+   *  \brief Stream object out to a stream
+   *
+   * \return The same stream as the input to allow for chained operators.
+   */
+  friend std::ostream &operator<<(
+    std::ostream          &os,     /*!< The stream into which we stream     */
+    const daemon_client   &cn)     /*!< The object to be streamed           */
+  {
+    return cn.print_self(os);
+  }
+
+private:
+
+  /*!
+   * \brief The copy constructor is deliberately private and unimplemented.
+   *
+   * \param rhs the object from which we are to be constructed
+   */
+  daemon_client(
+    const daemon_client   &rhs);
+
+  /*!
+   * \brief operator=() is deliberately private and unimplemented.
+   *
+   * \param rhs the object from which we are to be assigned
+   *
+   * \return reference to self to allow for chained operators
+   */
+  daemon_client &operator=(
+    const daemon_client   &rhs);
+
+  /*!
+   * \brief This is the implementation function for operator<<()
+   *
+   * \return The same stream as the input to allow for chained operators.
+   */
+  std::ostream &print_self(
+    std::ostream    &os)           /*!< The stream into which we stream     */
+  const
+  {
+    os << "daemon_client: fd = " << _fd;
+
+    return os;
+  }
+
+
+  /*!
+   * \brief Read exactly size bytes
+   *
+   * \return Zero if they were read, non-zero otherwise
+   */
+  int read_fully(
+    void            *data,         /*!< Where to put the bytes              */
+    const size_t     size          /*!< Number of bytes                     */
+                );
+
+
+  //! The socket, or -1
+  int             _fd;
+
+};
+
+#endif                             /* daemon_client_h_included              */
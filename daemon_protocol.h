@@ -0,0 +1,124 @@
+#ifndef daemon_protocol_h_included
+#define daemon_protocol_h_included 1
+
+/*!
+ * \file daemon_protocol.h
+ *
+ * \brief Contains the messages exchanged with solver_daemon
+ *
+ * \author Stewart L. Palmer
+ */
+
+#include <stdint.h>
+
+
+/*!
+ * \brief What a daemon_request asks for
+ */
+enum daemon_operation
+{
+  locate_operation = 1,            //!< Where juggler J<id> is assigned
+  roster_operation = 2,            //!< The jugglers assigned to circuit C<id>
+  cutoff_operation = 3,            //!< The score needed to get into C<id>
+  add_operation = 4,               //!< Add juggler J<id>
+  withdraw_operation = 5,          //!< Withdraw juggler J<id>
+  shutdown_operation = 6           //!< Stop the daemon
+};
+
+
+/*!
+ * \brief How a request turned out
+ */
+enum daemon_status
+{
+  ok_status = 0,                   //!< Done
+  not_found_status = 1,            //!< No such juggler or circuit
+  rejected_status = 2,             //!< The change could not be made
+  malformed_status = 3             //!< The request makes no sense; the
+                                   //!< daemon closes the connection
+};
+
+
+/*!
+ * \brief A request to the daemon
+ *
+ * Jugglers and circuits are named by the number after the J or the C.  An
+ * add_operation request is followed by preference_count circuit numbers, each
+ * a uint32_t, most preferred first; every other request has a preference_count
+ * of zero.  An added juggler's number must be below twice the number of
+ * jugglers the daemon holds, plus solver_daemon::id_headroom, and its talents
+ * may not be negative; otherwise the add is rejected.  Everything is in the byte order of the machine, since the socket
+ * is local.
+ */
+struct daemon_request
+{
+  //! A daemon_operation
+  uint32_t       operation;
+
+  //! Number of the juggler or circuit
+  uint32_t       id;
+
+  //! Hand-eye coordination of a juggler being added
+  int32_t        hand;
+
+  //! Endurance of a juggler being added
+  int32_t        endurance;
+
+  //! Pizzazz of a juggler being added
+  int32_t        pizzazz;
+
+  //! Number of circuit numbers after the request
+  uint32_t       preference_count;
+};
+
+
+/*!
+ * \brief The reply to a daemon_request
+ *
+ * The reply is followed by entry_count daemon_entry records:
+ *
+ * <ul>
+ * <li> locate_operation and add_operation give one, for the juggler; its
+ *      circuit is -1 if the juggler is unassigned;
+ * <li> roster_operation gives one per assigned juggler, best score first, and
+ *      value is the sum of their numbers;
+ * <li> cutoff_operation gives none, and value is the score a juggler must
+ *      beat to get into the circuit, or INT32_MIN if it is not full.
+ * </ul>
+ */
+struct daemon_reply
+{
+  //! A daemon_status
+  int32_t        status;
+
+  //! Result of a roster_operation or cutoff_operation
+  int32_t        value;
+
+  //! Number of daemon_entry records after the reply
+  uint32_t       entry_count;
+};
+
+
+/*!
+ * \brief One assignment in a daemon_reply
+ */
+struct daemon_entry
+{
+  //! Number of the juggler
+  int32_t        juggler;
+
+  //! Number of its circuit, or -1 for none
+  int32_t        circuit;
+
+  //! Score of the juggler in that circuit
+  int32_t        score;
+
+  //! Preference of the juggler for that circuit, zero for its first choice
+  int32_t        preference;
+};
+
+
+//! Largest preference_count the daemon accepts
+const uint32_t daemon_max_preferences = 4096;
+
+#endif                             /* daemon_protocol_h_included            */
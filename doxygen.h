@@ -120,11 +120,13 @@
  * of their preferred circuits.
  *
  * If y orphaned jugglers exist, there are y open slots in the circuits.  At this
- * point we go through all the circuits.  We fill any open slot in a circuit with
- * the next orphaned juggler.  It matters not which jugglers are used to fill the
- * open slots.  It is still the case that none of these orphaned jugglers could be
- * moved to a circuit that they prefer more and be a better fit than any juggler in
- * that circuit.  If that were true they would already have been assigned there.
+ * point we go through the orphaned jugglers and place each one in the open circuit
+ * where it scores highest.  A circuit_index finds that circuit without scoring the
+ * juggler against every circuit.  As far as the problem statement goes it matters
+ * not which jugglers are used to fill the open slots.  It is still the case that
+ * none of these orphaned jugglers could be moved to a circuit that they prefer
+ * more and be a better fit than any juggler in that circuit.  If that were true
+ * they would already have been assigned there.
  *
  * In order to be certain that all of the assignments have been done correctly, we
  * make one more pass through the jugglers and circuits to validate that the
@@ -0,0 +1,190 @@
+
+/*!
+ * \file festival_checkpoint.cpp
+ *
+ * \brief Contains the implementation of festival_checkpoint
+ *
+ * \author Stewart L. Palmer
+ */
+
+#include <string>
+#include <vector>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <assert.h>
+#include "festival_instance.h"
+#include "festival_solution.h"
+#include "festival_checkpoint.h"
+
+using namespace ::std;
+
+
+namespace
+{
+
+//! Images start on multiples of this, which is at least the page size
+const uint64_t image_alignment = 65536;
+
+
+/*!
+ * \brief Return an offset rounded up to the next image boundary
+ */
+uint64_t align_image(
+  const uint64_t   offset)         /*!< The offset                          */
+{
+  return (offset + image_alignment - 1) / image_alignment * image_alignment;
+}
+
+
+/*!
+ * \brief Write all of a block of bytes to a file
+ *
+ * \return Zero if they were written, non-zero otherwise
+ */
+int write_fully(
+  const int        fd,             /*!< The file                            */
+  const char      *data,           /*!< The bytes                           */
+  const size_t     size)           /*!< Number of bytes                     */
+{
+  size_t done = 0;
+  while (done < size)
+  {
+    const ssize_t n = ::write(fd, data + done, size - done);
+    if (n < 0)
+      {
+        if (errno == EINTR)
+          continue;
+        return 1;
+      }
+    done += n;
+  }
+
+  return 0;
+}
+
+}
+
+
+/*                                                                          */
+/****************************************************************************/
+/*     D E S T R U C T O R                                                  */
+/****************************************************************************/
+/*                                                                          */
+festival_checkpoint::~festival_checkpoint()
+{
+  delete _solution;
+  delete _instance;
+  if (_data != 0)
+    munmap(_data, _size);
+}
+
+
+/*                                                                          */
+/****************************************************************************/
+/*     W R I T E                                                            */
+/****************************************************************************/
+/*                                                                          */
+int festival_checkpoint::write(
+  const festival_solution   &solution,/*!< The solution to save             */
+  const char                *file_name)/*!< Name of the file to write       */
+{
+  const festival_instance &inst = solution.instance();
+  checkpoint_header header;
+  memset(&header, 0, sizeof(header));
+  memcpy(header.magic, "JUGGLECK", sizeof(header.magic));
+  header.version = 1;
+  header.byte_order = 0x01020304;
+  header.instance_offset = align_image(sizeof(header));
+  header.instance_size = inst.image_size();
+  header.solution_offset = align_image(header.instance_offset + header.instance_size);
+  header.solution_size = solution.image_size();
+
+  const string temporary = string(file_name) + ".tmp";
+  const int fd = open(temporary.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+  if (fd < 0)
+    return 1;
+
+  const vector<char> padding(image_alignment, 0);
+  int rc = write_fully(fd, reinterpret_cast<const char *>(&header), sizeof(header));
+  if (rc == 0)
+    rc = write_fully(fd, &padding[0], header.instance_offset - sizeof(header));
+  if (rc == 0)
+    rc = write_fully(fd, inst.image(), header.instance_size);
+  if (rc == 0)
+    rc = write_fully(fd, &padding[0], header.solution_offset -
+                                      (header.instance_offset + header.instance_size));
+  if (rc == 0)
+    rc = write_fully(fd, solution.image(), header.solution_size);
+  if ( (rc == 0) && (fsync(fd) != 0) )
+    rc = 1;
+  if (close(fd) != 0)
+    rc = 1;
+
+  if ( (rc == 0) && (rename(temporary.c_str(), file_name) != 0) )
+    rc = 1;
+  if (rc != 0)
+    unlink(temporary.c_str());
+
+  return rc;
+}
+
+
+/*                                                                          */
+/****************************************************************************/
+/*     R E S T O R E                                                        */
+/****************************************************************************/
+/*                                                                          */
+int festival_checkpoint::restore(
+  const char    *file_name)        /*!< Name of the file to restore         */
+{
+  assert(_data == 0);
+  _name = file_name;
+  const int fd = open(file_name, O_RDONLY);
+  if (fd < 0)
+    return 1;
+
+  struct stat st;
+  int rc = 0;
+  if ( (fstat(fd, &st) != 0) || (st.st_size < (off_t) sizeof(checkpoint_header)) )
+    rc = 1;
+  else
+    {
+      // Private and writable, so the solution can go on in place
+      void *const p = mmap(0, st.st_size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+      if (p == MAP_FAILED)
+        rc = 1;
+      else
+        {
+          _data = static_cast<char *>(p);
+          _size = st.st_size;
+        }
+    }
+  close(fd);
+  if (rc != 0)
+    return rc;
+
+  const checkpoint_header &header = *reinterpret_cast<const checkpoint_header *>(_data);
+  if ( (memcmp(header.magic, "JUGGLECK", sizeof(header.magic)) != 0) ||
+       (header.version != 1) || (header.byte_order != 0x01020304) ||
+       ((header.instance_offset % image_alignment) != 0) ||
+       ((header.solution_offset % image_alignment) != 0) ||
+       (header.instance_offset > _size) || (header.instance_size > (_size - header.instance_offset)) ||
+       (header.solution_offset > _size) || (header.solution_size > (_size - header.solution_offset)) )
+    return 1;
+
+  const char *const instance_image = _data + header.instance_offset;
+  char *const solution_image = _data + header.solution_offset;
+  if (festival_instance::check_image(instance_image, header.instance_size) != 0)
+    return 1;
+  _instance = new festival_instance(instance_image);
+  if (festival_solution::check_image(*_instance, solution_image, header.solution_size) != 0)
+    return 1;
+  _solution = new festival_solution(*_instance, solution_image);
+
+  return 0;
+}
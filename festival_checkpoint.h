@@ -0,0 +1,201 @@
+#ifndef festival_checkpoint_h_included
+#define festival_checkpoint_h_included 1
+
+/*!
+ * \file festival_checkpoint.h
+ *
+ * \brief Contains the definition of festival_checkpoint
+ *
+ * \author Stewart L. Palmer
+ */
+
+#include <assert.h>
+#include <iostream>
+#include <string>
+#include <stddef.h>
+#include <stdint.h>
+
+class festival_instance;
+class festival_solution;
+
+
+/*!
+ * \brief The start of a checkpoint file
+ *
+ * The header is followed by the image of a festival_instance and the image of
+ * a festival_solution of it, each starting on a multiple of 64 KiB, which is a
+ * page boundary on any machine, so that both can be used where they are
+ * mapped.  Everything is in the byte order of the machine that wrote it.
+ */
+struct checkpoint_header
+{
+  //! "JUGGLECK", not terminated
+  char           magic[8];
+
+  //! Version of the layout, which is 1
+  uint32_t       version;
+
+  //! 0x01020304 as written, to catch a file from the other byte order
+  uint32_t       byte_order;
+
+  //! Offset of the image of the instance
+  uint64_t       instance_offset;
+
+  //! Size of the image of the instance
+  uint64_t       instance_size;
+
+  //! Offset of the image of the solution
+  uint64_t       solution_offset;
+
+  //! Size of the image of the solution
+  uint64_t       solution_size;
+};
+
+
+/*!
+ * \brief A festival and the state of a solve of it, saved to or restored from
+ *        a file
+ *
+ * Rebuilding a festival means parsing it and scoring every preference again,
+ * and a solve that is lost has to start over.  write() saves the images of a
+ * festival_solution and its festival_instance to one file, whether the solve is
+ * done or not.  restore() maps the file and builds the instance and solution
+ * on the mapped images, so nothing is copied or built per circuit or juggler,
+ * and only the pages that are used are ever read.  The mapping is private:
+ * advancing the restored solution changes memory, never the file.
+ */
+class festival_checkpoint
+{
+public:
+
+  /*!
+   * \brief Standard constructor
+   *
+   * Nothing is restored until restore() is called.
+   */
+  festival_checkpoint()
+  :
+  _data(0),
+  _size(0),
+  _instance(0),
+  _solution(0)
+  { }
+
+
+  /*!
+   * \brief Destructor, which unmaps the file
+   */
+  ~festival_checkpoint();
+
+
+  /*!
+   * \brief Save a solution and its instance to a file
+   *
+   * The file is written under a temporary name and renamed into place once it
+   * is complete, so a crash while writing leaves the last checkpoint intact.
+   *
+   * \return Zero if the file was written, non-zero otherwise
+   */
+  static int write(
+    const festival_solution   &solution,/*!< The solution to save           */
+    const char                *file_name/*!< Name of the file to write      */
+                  );
+
+
+  /*!
+   * \brief Map a checkpoint file and restore the instance and solution in it
+   *
+   * \return Zero if the file was restored, non-zero if it could not be mapped
+   *         or is not a whole checkpoint
+   */
+  int restore(
+    const char    *file_name       /*!< Name of the file to restore         */
+             );
+
+
+  /*!
+   * \brief Return the restored festival
+   */
+  const festival_instance &instance() const
+  {
+    assert(_instance != 0);
+    return *_instance;
+  }
+
+
+  /*!
+   * \brief Return the restored solution, which may be advanced or solved
+   *        again
+   */
+  festival_solution &solution()
+  {
+    assert(_solution != 0);
+    return *_solution;
+  }
+
+
+  /*!
+   *  \brief Stream object out to a stream
+   *
+   * \return The same stream as the input to allow for chained operators.
+   */
+  friend std::ostream &operator<<(
+    std::ostream                &os,/*!< The stream into which we stream    */
+    const festival_checkpoint   &cn)/*!< The object to be streamed          */
+  {
+    return cn.print_self(os);
+  }
+
+private:
+
+  /*!
+   * \brief The copy constructor is deliberately private and unimplemented.
+   *
+   * \param rhs the object from which we are to be constructed
+   */
+  festival_checkpoint(
+    const festival_checkpoint   &rhs);
+
+  /*!
+   * \brief operator=() is deliberately private and unimplemented.
+   *
+   * \param rhs the object from which we are to be assigned
+   *
+   * \return reference to self to allow for chained operators
+   */
+  festival_checkpoint &operator=(
+    const festival_checkpoint   &rhs);
+
+  /*!
+   * \brief This is the implementation function for operator<<()
+   *
+   * \return The same stream as the input to allow for chained operators.
+   */
+  std::ostream &print_self(
+    std::ostream    &os)           /*!< The stream into which we stream     */
+  const
+  {
+    os << "festival_checkpoint: " << _name << " (" << _size << " bytes)";
+
+    return os;
+  }
+
+
+  //! Name of the restored file
+  std::string          _name;
+
+  //! The mapped file, or zero if nothing is restored
+  char                *_data;
+
+  //! Number of mapped bytes
+  size_t               _size;
+
+  //! The restored festival, on the mapped image
+  festival_instance   *_instance;
+
+  //! The restored solution, on the mapped image
+  festival_solution   *_solution;
+
+};
+
+#endif                             /* festival_checkpoint_h_included        */
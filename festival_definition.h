@@ -0,0 +1,61 @@
+#ifndef festival_definition_h_included
+#define festival_definition_h_included 1
+
+/*!
+ * \file festival_definition.h
+ *
+ * \brief Contains the in-memory definition of a festival
+ *
+ * \author Stewart L. Palmer
+ */
+
+#include <vector>
+
+
+/*!
+ * \brief The talents of one circuit or juggler
+ */
+struct talent_definition
+{
+  //! Value for hand-eye coordination
+  int            hand;
+
+  //! Value for endurance
+  int            endurance;
+
+  //! Value for pizzazz
+  int            pizzazz;
+};
+
+
+/*!
+ * \brief A festival held in arrays rather than in an input file
+ *
+ * This is what a program that links with libjugglefest hands to the
+ * scheduler instead of writing an input file for it to read back.  Circuit i
+ * is named "C" followed by i, and juggler j is named "J" followed by j, just as
+ * in the input file, so the results read the same either way.
+ *
+ * The preferences of all of the jugglers are kept one after the other in
+ * preferences, each as the index of a circuit, most preferred first.  Juggler j
+ * has preference_counts[j] of them, following those of juggler j-1.  There must
+ * be a whole number of jugglers for each circuit, no talent may be negative,
+ * and no juggler may list a circuit twice; scheduler::check_definition()
+ * reports what is wrong with a definition that breaks these rules.
+ */
+struct festival_definition
+{
+  //! Talents of each circuit
+  std::vector<talent_definition>  circuits;
+
+  //! Talents of each juggler
+  std::vector<talent_definition>  jugglers;
+
+  //! Number of preferences of each juggler
+  std::vector<unsigned int>       preference_counts;
+
+  //! Circuit index of each preference, juggler by juggler
+  std::vector<unsigned int>       preferences;
+};
+
+#endif                             /* festival_definition_h_included        */
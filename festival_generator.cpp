@@ -0,0 +1,322 @@
+
+/*!
+ * \file festival_generator.cpp
+ *
+ * \brief Contains the implementation of festival_generator
+ *
+ * \author Stewart L. Palmer
+ */
+
+#include <algorithm>
+#include <math.h>
+#include <stdlib.h>
+#include "output_buffer.h"
+#include "festival_generator.h"
+
+using namespace ::std;
+
+
+/*                                                                          */
+/****************************************************************************/
+/*     C O N S T R U C T O R                                                */
+/****************************************************************************/
+/*                                                                          */
+festival_generator::festival_generator(
+  const unsigned int   circuits,   /*!< Number of circuits                  */
+  const unsigned int   jugglers,   /*!< Number of jugglers, a multiple of
+                                        the number of circuits              */
+  const unsigned int   length,     /*!< Preferences of each juggler, no
+                                        more than the number of circuits    */
+  const uint64_t       seed)       /*!< Seed of the festival                */
+  :
+  _circuits(circuits),
+  _jugglers(jugglers),
+  _length(length),
+  _state(seed * 2 + 1),
+  _popularity(uniform_popularity),
+  _exponent(1.0),
+  _hot_fraction(0.01),
+  _hot_share(0.5),
+  _skills(uniform_skills)
+{
+}
+
+
+/*                                                                          */
+/****************************************************************************/
+/*     S E T _ P O P U L A R I T Y                                          */
+/****************************************************************************/
+/*                                                                          */
+int festival_generator::set_popularity(
+  const string   &description)     /*!< The description                     */
+{
+  const string::size_type colon = description.find(':');
+  const string model = description.substr(0, colon);
+  vector<double> values;
+  for (string::size_type at = colon; at != string::npos; )
+  {
+    const char *const text = description.c_str() + at + 1;
+    char *end = 0;
+    values.push_back(strtod(text, &end));
+    if ( (end == text) || ((*end != ':') && (*end != '\0')) )
+      return 1;
+    at = (*end == ':') ? (string::size_type) (end - description.c_str()) : string::npos;
+  }
+
+  if ( (model == "uniform") && values.empty() )
+    set_uniform();
+  else if ( (model == "zipf") && (values.size() <= 1) )
+    set_zipf(values.empty() ? 1.0 : values[0]);
+  else if ( (model == "hotspot") && ((values.size() == 0) || (values.size() == 2)) )
+    set_hotspot(values.empty() ? 0.01 : values[0], values.empty() ? 0.5 : values[1]);
+  else
+    return 1;
+
+  return 0;
+}
+
+
+/*                                                                          */
+/****************************************************************************/
+/*     G E N E R A T E                                                      */
+/****************************************************************************/
+/*                                                                          */
+int festival_generator::generate(
+  festival_definition   &definition)/*!< Returned festival                  */
+{
+  if ( (_circuits == 0) || (_jugglers == 0) || ((_jugglers % _circuits) != 0) ||
+       (_length == 0) || (_length > _circuits) || !(_exponent > 0.0) ||
+       !(_hot_fraction > 0.0) || (_hot_fraction > 1.0) ||
+       (_hot_share < 0.0) || (_hot_share > 1.0) )
+    return 1;
+
+  // Deal the ranks of popularity to the circuits
+  _ranked.resize(_circuits);
+  for (unsigned int c = 0; c < _circuits; c++)
+    _ranked[c] = c;
+  for (unsigned int c = _circuits - 1; c > 0; c--)
+    swap(_ranked[c], _ranked[below(c + 1)]);
+
+  _cumulative.clear();
+  if (_popularity == zipf_popularity)
+    {
+      _cumulative.resize(_circuits);
+      double total = 0.0;
+      for (unsigned int r = 0; r < _circuits; r++)
+        {
+          total += 1.0 / pow(r + 1.0, _exponent);
+          _cumulative[r] = total;
+        }
+      for (unsigned int r = 0; r < _circuits; r++)
+        _cumulative[r] /= total;
+    }
+
+  definition.circuits.resize(_circuits);
+  for (unsigned int c = 0; c < _circuits; c++)
+    {
+      definition.circuits[c].hand = talent();
+      definition.circuits[c].endurance = talent();
+      definition.circuits[c].pizzazz = talent();
+    }
+
+  definition.jugglers.resize(_jugglers);
+  definition.preference_counts.assign(_jugglers, _length);
+  definition.preferences.clear();
+  definition.preferences.reserve((size_t) _jugglers * _length);
+  for (unsigned int j = 0; j < _jugglers; j++)
+    {
+      definition.jugglers[j].hand = talent();
+      definition.jugglers[j].endurance = talent();
+      definition.jugglers[j].pizzazz = talent();
+
+      // No circuit twice; when the popular ones are all taken, the next
+      // circuit not listed after a random one will do
+      const size_t first = definition.preferences.size();
+      for (unsigned int p = 0; p < _length; p++)
+        {
+          vector<unsigned int>::iterator listed = definition.preferences.begin() + first;
+          unsigned int c = 0;
+          bool found = false;
+          for (unsigned int tries = 0; !found && (tries < 64); tries++)
+            {
+              c = popular_circuit();
+              found = (find(listed, definition.preferences.end(), c) ==
+                       definition.preferences.end());
+            }
+          if ( !found )
+            for (c = below(_circuits);
+                 find(listed, definition.preferences.end(), c) != definition.preferences.end();
+                 c = (c + 1) % _circuits)
+              ;
+          definition.preferences.push_back(c);
+        }
+    }
+
+  return 0;
+}
+
+
+/*                                                                          */
+/****************************************************************************/
+/*     W R I T E _ T E X T                                                  */
+/****************************************************************************/
+/*                                                                          */
+int festival_generator::write_text(
+  const festival_definition   &definition,/*!< The festival                 */
+  const int                    fd) /*!< File descriptor to write to         */
+{
+  static const size_t flush_size = 1 << 20;
+  output_buffer buffer;
+  int rc = 0;
+
+  for (unsigned int c = 0; c < definition.circuits.size(); c++)
+    {
+      const talent_definition &t = definition.circuits[c];
+      buffer.append("C C");
+      buffer.append_int(c);
+      buffer.append(" H:");
+      buffer.append_int(t.hand);
+      buffer.append(" E:");
+      buffer.append_int(t.endurance);
+      buffer.append(" P:");
+      buffer.append_int(t.pizzazz);
+      buffer.append('\n');
+      if ( (buffer.size() >= flush_size) && (buffer.write_to(fd) != 0) )
+        rc = 1;
+    }
+  buffer.append('\n');
+
+  size_t next = 0;
+  for (unsigned int j = 0; j < definition.jugglers.size(); j++)
+    {
+      const talent_definition &t = definition.jugglers[j];
+      buffer.append("J J");
+      buffer.append_int(j);
+      buffer.append(" H:");
+      buffer.append_int(t.hand);
+      buffer.append(" E:");
+      buffer.append_int(t.endurance);
+      buffer.append(" P:");
+      buffer.append_int(t.pizzazz);
+      for (unsigned int p = 0; p < definition.preference_counts[j]; p++)
+        {
+          buffer.append((p == 0) ? " C" : ",C");
+          buffer.append_int(definition.preferences[next++]);
+        }
+      buffer.append('\n');
+      if ( (buffer.size() >= flush_size) && (buffer.write_to(fd) != 0) )
+        rc = 1;
+    }
+  if (buffer.write_to(fd) != 0)
+    rc = 1;
+
+  return rc;
+}
+
+
+/*                                                                          */
+/****************************************************************************/
+/*     N E X T                                                              */
+/****************************************************************************/
+/*                                                                          */
+uint64_t festival_generator::next()
+{
+  // Knuth's MMIX multiplier and increment, built from halves for C++98
+  static const uint64_t multiplier = ((uint64_t) 0x5851f42d << 32) | 0x4c957f2d;
+  static const uint64_t increment = ((uint64_t) 0x14057b7e << 32) | 0xf767814f;
+  _state = _state * multiplier + increment;
+
+  // The low bits of a power of two generator are weak, so mix the high ones in
+  uint64_t x = _state;
+  x ^= x >> 29;
+  x *= ((uint64_t) 0xbf58476d << 32) | 0x1ce4e5b9;
+  x ^= x >> 32;
+
+  return x;
+}
+
+
+/*                                                                          */
+/****************************************************************************/
+/*     B E L O W                                                            */
+/****************************************************************************/
+/*                                                                          */
+unsigned int festival_generator::below(
+  const unsigned int   limit)      /*!< One more than the largest result    */
+{
+  return (unsigned int) (next() % limit);
+}
+
+
+/*                                                                          */
+/****************************************************************************/
+/*     F R A C T I O N                                                      */
+/****************************************************************************/
+/*                                                                          */
+double festival_generator::fraction()
+{
+  return (next() >> 11) * (1.0 / 9007199254740992.0);
+}
+
+
+/*                                                                          */
+/****************************************************************************/
+/*     T A L E N T                                                          */
+/****************************************************************************/
+/*                                                                          */
+int festival_generator::talent()
+{
+  if (_skills == uniform_skills)
+    return below(11);
+
+  // Ten coin tosses from one draw
+  uint64_t bits = next();
+  int heads = 0;
+  for (unsigned int toss = 0; toss < 10; toss++, bits >>= 1)
+    heads += (int) (bits & 1);
+
+  return heads;
+}
+
+
+/*                                                                          */
+/****************************************************************************/
+/*     P O P U L A R _ C I R C U I T                                        */
+/****************************************************************************/
+/*                                                                          */
+unsigned int festival_generator::popular_circuit()
+{
+  if (_popularity == zipf_popularity)
+    {
+      const unsigned int r = upper_bound(_cumulative.begin(), _cumulative.end(), fraction()) -
+                             _cumulative.begin();
+      return _ranked[min(r, _circuits - 1)];
+    }
+
+  if (_popularity == hotspot_popularity)
+    {
+      const unsigned int hot = max(1u, (unsigned int) (_hot_fraction * _circuits));
+      if ( (hot == _circuits) || (fraction() < _hot_share) )
+        return _ranked[below(hot)];
+      return _ranked[hot + below(_circuits - hot)];
+    }
+
+  return below(_circuits);
+}
+
+
+/*                                                                          */
+/****************************************************************************/
+/*     P R I N T _ S E L F                                                  */
+/****************************************************************************/
+/*                                                                          */
+ostream &festival_generator::print_self(
+  ostream    &os)                  /*!< The stream into which we stream     */
+const
+{
+  static const char *const names[] = { "uniform", "zipf", "hotspot" };
+  os << "festival_generator: " << _circuits << " circuits, " << _jugglers <<
+        " jugglers, " << _length << " preferences, " << names[_popularity];
+
+  return os;
+}
@@ -0,0 +1,268 @@
+#ifndef festival_generator_h_included
+#define festival_generator_h_included 1
+
+/*!
+ * \file festival_generator.h
+ *
+ * \brief Contains the definition of festival_generator
+ *
+ * \author Stewart L. Palmer
+ */
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <stdint.h>
+#include "festival_definition.h"
+
+
+/*!
+ * \brief Makes up festivals of any size, with as much or as little agreement
+ *        among the jugglers about which circuits they want
+ *
+ * The festival given in input.txt spreads the preferences evenly over the
+ * circuits, so few circuits are ever fought over and the chains of evictions
+ * stay short.  Real festivals have favourites.  The popularity of a circuit is
+ * the chance that a juggler lists it:
+ *
+ * <ul>
+ * <li> uniform: every circuit is as popular as any other, as in input.txt;
+ * <li> zipf: the circuit of rank r is chosen in proportion to 1 / r^s, where s
+ *      is the exponent;
+ * <li> hotspot: a few hot circuits get a set share of all of the preferences,
+ *      and the rest is spread evenly.
+ * </ul>
+ *
+ * The ranks are dealt to the circuits at random, so the popular circuits are
+ * not simply the first ones.  Talents are either uniform from 0 to 10 or bell
+ * shaped around 5, the sum of ten coin tosses.  Everything comes from one
+ * pseudo-random sequence of 64 bits, so the same settings and seed always give
+ * the same festival on any machine.
+ */
+class festival_generator
+{
+public:
+
+  /*!
+   * \brief How the preferences are spread over the circuits
+   */
+  enum popularity
+  {
+    uniform_popularity,            /*!< Every circuit alike                 */
+    zipf_popularity,               /*!< In proportion to 1 / rank^exponent  */
+    hotspot_popularity             /*!< A share of them to a few circuits   */
+  };
+
+
+  /*!
+   * \brief How the talents are spread
+   */
+  enum skills
+  {
+    uniform_skills,                /*!< 0 to 10, each as likely             */
+    bell_skills                    /*!< 0 to 10, most often 5               */
+  };
+
+
+  /*!
+   * \brief Standard constructor
+   *
+   * The festival is uniform with uniform talents until set otherwise.
+   */
+  festival_generator(
+    const unsigned int   circuits, /*!< Number of circuits                  */
+    const unsigned int   jugglers, /*!< Number of jugglers, a multiple of
+                                        the number of circuits              */
+    const unsigned int   length,   /*!< Preferences of each juggler, no
+                                        more than the number of circuits    */
+    const uint64_t       seed      /*!< Seed of the festival                */
+                    );
+
+
+  /*!
+   * \brief Spread the preferences uniformly
+   */
+  void set_uniform()
+  { _popularity = uniform_popularity; }
+
+
+  /*!
+   * \brief Spread the preferences in proportion to 1 / rank^exponent
+   */
+  void set_zipf(
+    const double   exponent)       /*!< The exponent, 1 for classic Zipf    */
+  {
+    _popularity = zipf_popularity;
+    _exponent = exponent;
+  }
+
+
+  /*!
+   * \brief Give a share of the preferences to a few hot circuits
+   */
+  void set_hotspot(
+    const double   hot_fraction,   /*!< Fraction of the circuits that are
+                                        hot, such as 0.01                   */
+    const double   hot_share)      /*!< Fraction of the preferences that go
+                                        to them, such as 0.5                */
+  {
+    _popularity = hotspot_popularity;
+    _hot_fraction = hot_fraction;
+    _hot_share = hot_share;
+  }
+
+
+  /*!
+   * \brief Set the popularity from a description on a command line
+   *
+   * The description is "uniform", "zipf" or "zipf:exponent", or "hotspot" or
+   * "hotspot:hot_fraction:hot_share", such as "zipf:1.2" or
+   * "hotspot:0.01:0.8".  Zipf has an exponent of 1 and a hotspot 1% of the
+   * circuits and half of the preferences unless given.
+   *
+   * \return Zero if the description was understood, non-zero otherwise
+   */
+  int set_popularity(
+    const std::string   &description/*!< The description                    */
+                    );
+
+
+  /*!
+   * \brief Set how the talents are spread
+   */
+  void set_skills(
+    const skills   s)              /*!< The spread                          */
+  { _skills = s; }
+
+
+  /*!
+   * \brief Make up the festival
+   *
+   * \return Zero if it was made, non-zero if the settings are impossible
+   */
+  int generate(
+    festival_definition   &definition/*!< Returned festival                 */
+              );
+
+
+  /*!
+   * \brief Write a festival in the format of input.txt
+   *
+   * \return Zero if everything was written, non-zero otherwise
+   */
+  static int write_text(
+    const festival_definition   &definition,/*!< The festival               */
+    const int                    fd/*!< File descriptor to write to         */
+                       );
+
+
+  /*!
+   *  \brief Stream object out to a stream
+   *
+   * \return The same stream as the input to allow for chained operators.
+   */
+  friend std::ostream &operator<<(
+    std::ostream               &os,/*!< The stream into which we stream     */
+    const festival_generator   &cn)/*!< The object to be streamed           */
+  {
+    return cn.print_self(os);
+  }
+
+private:
+
+  /*!
+   * \brief The copy constructor is deliberately private and unimplemented.
+   *
+   * \param rhs the object from which we are to be constructed
+   */
+  festival_generator(
+    const festival_generator   &rhs);
+
+  /*!
+   * \brief operator=() is deliberately private and unimplemented.
+   *
+   * \param rhs the object from which we are to be assigned
+   *
+   * \return reference to self to allow for chained operators
+   */
+  festival_generator &operator=(
+    const festival_generator   &rhs);
+
+  /*!
+   * \brief This is the implementation function for operator<<()
+   *
+   * \return The same stream as the input to allow for chained operators.
+   */
+  std::ostream &print_self(
+    std::ostream    &os)           /*!< The stream into which we stream     */
+  const;
+
+
+  /*!
+   * \brief Return the next 64 pseudo-random bits
+   */
+  uint64_t next();
+
+
+  /*!
+   * \brief Return a number from zero up to but not including limit
+   */
+  unsigned int below(
+    const unsigned int   limit     /*!< One more than the largest result    */
+                    );
+
+
+  /*!
+   * \brief Return a number at least zero and less than one
+   */
+  double fraction();
+
+
+  /*!
+   * \brief Return a talent
+   */
+  int talent();
+
+
+  /*!
+   * \brief Return the index of a circuit, chosen by popularity
+   */
+  unsigned int popular_circuit();
+
+
+  //! Number of circuits
+  const unsigned int      _circuits;
+
+  //! Number of jugglers
+  const unsigned int      _jugglers;
+
+  //! Preferences of each juggler
+  const unsigned int      _length;
+
+  //! State of the pseudo-random sequence
+  uint64_t                _state;
+
+  //! How the preferences are spread
+  popularity              _popularity;
+
+  //! Exponent of the Zipf spread
+  double                  _exponent;
+
+  //! Fraction of the circuits that are hot
+  double                  _hot_fraction;
+
+  //! Fraction of the preferences that go to the hot circuits
+  double                  _hot_share;
+
+  //! How the talents are spread
+  skills                  _skills;
+
+  //! Circuit index of each rank, most popular first
+  std::vector<unsigned int> _ranked;
+
+  //! Chance of choosing each rank or one before it, for the Zipf spread
+  std::vector<double>     _cumulative;
+
+};
+
+#endif                             /* festival_generator_h_included         */
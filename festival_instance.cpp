@@ -0,0 +1,229 @@
+
+/*!
+ * \file festival_instance.cpp
+ *
+ * \brief Contains the implementation of festival_instance
+ *
+ * \author Stewart L. Palmer
+ */
+
+#include <algorithm>
+#include <utility>
+#include <assert.h>
+#include <stdint.h>
+#include "scheduler.h"
+#include "festival_instance.h"
+
+using namespace ::std;
+
+
+namespace
+{
+
+/*!
+ * \brief Return a key that orders numbers as their decimal text is ordered
+ *
+ * The digits are left aligned in ten places, so "12" sorts between "1" and
+ * "2", and the number of digits breaks ties, so "1" sorts before "10".
+ */
+uint64_t name_key(
+  const unsigned int   number)     /*!< The number in the name              */
+{
+  unsigned int digits = 1;
+  uint64_t scaled = number;
+  for (unsigned int n = number; n >= 10; n /= 10)
+    digits++;
+  for (unsigned int d = digits; d < 10; d++)
+    scaled *= 10;
+
+  return (scaled << 4) | digits;
+}
+
+
+/*!
+ * \brief Return true if any of the talents is negative
+ */
+bool negative(
+  const talent_definition   &talents)/*!< The talents                      */
+{
+  return (talents.hand < 0) || (talents.endurance < 0) || (talents.pizzazz < 0);
+}
+
+}
+
+
+/*                                                                          */
+/****************************************************************************/
+/*     C O N S T R U C T O R                                                */
+/****************************************************************************/
+/*                                                                          */
+festival_instance::festival_instance(
+  const festival_definition  &definition)/*!< The festival                 */
+  :
+  _storage(image_size(definition.circuits.size(), definition.jugglers.size(),
+                      definition.preferences.size()) / sizeof(uint32_t), 0),
+  _image(reinterpret_cast<const char *>(&_storage[0]))
+{
+  image_header *const header = reinterpret_cast<image_header *>(&_storage[0]);
+  header->circuit_count = definition.circuits.size();
+  header->juggler_count = definition.jugglers.size();
+  header->preference_count = definition.preferences.size();
+  header->reserved = 0;
+  locate_arrays();
+
+  // The arrays are only read once built, so they are filled in through casts
+  talent_definition *const circuit_talents = const_cast<talent_definition *>(_circuit_talents);
+  talent_definition *const juggler_talents = const_cast<talent_definition *>(_juggler_talents);
+  uint32_t *const first = const_cast<uint32_t *>(_first);
+  uint32_t *const circuit = const_cast<uint32_t *>(_circuit);
+  int32_t *const scores = const_cast<int32_t *>(_score);
+  uint32_t *const name_order = const_cast<uint32_t *>(_name_order);
+
+  copy(definition.circuits.begin(), definition.circuits.end(), circuit_talents);
+  copy(definition.jugglers.begin(), definition.jugglers.end(), juggler_talents);
+  copy(definition.preferences.begin(), definition.preferences.end(), circuit);
+  first[0] = 0;
+  for (unsigned int j = 0; j < juggler_count(); j++)
+    first[j + 1] = first[j] + definition.preference_counts[j];
+  for (unsigned int j = 0; j < juggler_count(); j++)
+    for (unsigned int e = first[j]; e < first[j + 1]; e++)
+      scores[e] = score(j, circuit[e]);
+
+  vector< pair<uint64_t, unsigned int> > keys(juggler_count());
+  for (unsigned int j = 0; j < juggler_count(); j++)
+    keys[j] = make_pair(name_key(j), j);
+  sort(keys.begin(), keys.end());
+  for (unsigned int p = 0; p < juggler_count(); p++)
+    name_order[p] = keys[p].second;
+}
+
+
+/*                                                                          */
+/****************************************************************************/
+/*     C O N S T R U C T O R                                                */
+/****************************************************************************/
+/*                                                                          */
+festival_instance::festival_instance(
+  const char      *image)          /*!< The image, four byte aligned        */
+  :
+  _image(image)
+{
+  locate_arrays();
+}
+
+
+/*                                                                          */
+/****************************************************************************/
+/*     C R E A T E                                                          */
+/****************************************************************************/
+/*                                                                          */
+int festival_instance::create(
+  const festival_definition  &definition,/*!< The festival                 */
+  ostream                    &os,  /*!< Stream for error reporting          */
+  festival_instance         *&instance)/*!< Returned instance, or zero      */
+{
+  instance = 0;
+  const int rc = scheduler::check_definition(definition, os);
+  if (rc != 0)
+    return rc;
+  instance = new festival_instance(definition);
+
+  return 0;
+}
+
+
+/*                                                                          */
+/****************************************************************************/
+/*     C H E C K _ I M A G E                                                */
+/****************************************************************************/
+/*                                                                          */
+int festival_instance::check_image(
+  const char      *image,          /*!< The image, four byte aligned        */
+  const size_t     size)           /*!< Number of bytes available           */
+{
+  if ( (size < sizeof(image_header)) || ((reinterpret_cast<uintptr_t>(image) % 4) != 0) )
+    return 1;
+  const image_header &header = *reinterpret_cast<const image_header *>(image);
+  if ( (header.circuit_count == 0) || (header.reserved != 0) ||
+       (size < image_size(header.circuit_count, header.juggler_count, header.preference_count)) )
+    return 1;
+
+  // The preferences must lead to circuits that exist, so that nothing built
+  // on the image reads outside of it
+  festival_instance inst(image);
+  if ( (inst._first[0] != 0) || (inst._first[inst.juggler_count()] != header.preference_count) )
+    return 1;
+  for (unsigned int j = 0; j < inst.juggler_count(); j++)
+    if ( (inst._first[j] > inst._first[j + 1]) || (inst._name_order[j] >= inst.juggler_count()) )
+      return 1;
+  for (unsigned int e = 0; e < header.preference_count; e++)
+    if (inst._circuit[e] >= header.circuit_count)
+      return 1;
+
+  // Nor may a talent be negative, as a definition's may not be
+  for (unsigned int c = 0; c < header.circuit_count; c++)
+    if (negative(inst._circuit_talents[c]))
+      return 1;
+  for (unsigned int j = 0; j < header.juggler_count; j++)
+    if (negative(inst._juggler_talents[j]))
+      return 1;
+
+  return 0;
+}
+
+
+/*                                                                          */
+/****************************************************************************/
+/*     I M A G E _ S I Z E                                                  */
+/****************************************************************************/
+/*                                                                          */
+size_t festival_instance::image_size(
+  const size_t     circuits,       /*!< Number of circuits                  */
+  const size_t     jugglers,       /*!< Number of jugglers                  */
+  const size_t     preferences)    /*!< Number of preference entries        */
+{
+  return sizeof(image_header) +
+         (circuits + jugglers) * sizeof(talent_definition) +
+         (jugglers + 1) * sizeof(uint32_t) +
+         preferences * (sizeof(uint32_t) + sizeof(int32_t)) +
+         jugglers * sizeof(uint32_t);
+}
+
+
+/*                                                                          */
+/****************************************************************************/
+/*     L O C A T E _ A R R A Y S                                            */
+/****************************************************************************/
+/*                                                                          */
+void festival_instance::locate_arrays()
+{
+  _header = reinterpret_cast<const image_header *>(_image);
+  const char *next = _image + sizeof(image_header);
+  _circuit_talents = reinterpret_cast<const talent_definition *>(next);
+  next += _header->circuit_count * sizeof(talent_definition);
+  _juggler_talents = reinterpret_cast<const talent_definition *>(next);
+  next += _header->juggler_count * sizeof(talent_definition);
+  _first = reinterpret_cast<const uint32_t *>(next);
+  next += (_header->juggler_count + 1) * sizeof(uint32_t);
+  _circuit = reinterpret_cast<const uint32_t *>(next);
+  next += _header->preference_count * sizeof(uint32_t);
+  _score = reinterpret_cast<const int32_t *>(next);
+  next += _header->preference_count * sizeof(int32_t);
+  _name_order = reinterpret_cast<const uint32_t *>(next);
+}
+
+
+/*                                                                          */
+/****************************************************************************/
+/*     P R I N T _ S E L F                                                  */
+/****************************************************************************/
+/*                                                                          */
+ostream &festival_instance::print_self(
+  ostream    &os)                  /*!< The stream into which we stream     */
+const
+{
+  os << "festival_instance: " << circuit_count() << " circuits, " <<
+        juggler_count() << " jugglers, " << _header->preference_count << " preferences";
+
+  return os;
+}
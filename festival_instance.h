@@ -0,0 +1,312 @@
+#ifndef festival_instance_h_included
+#define festival_instance_h_included 1
+
+/*!
+ * \file festival_instance.h
+ *
+ * \brief Contains the definition of festival_instance
+ *
+ * \author Stewart L. Palmer
+ */
+
+#include <iostream>
+#include <vector>
+#include <stddef.h>
+#include <stdint.h>
+#include "festival_definition.h"
+
+
+/*!
+ * \brief The read-only part of a festival: talents, preferences and scores
+ *
+ * The circuits and jugglers of scheduler carry their assignments with them, so
+ * a festival read into a scheduler can be solved only once.  A festival_instance
+ * holds everything that does not change while solving, in flat arrays indexed
+ * by circuit, juggler and preference, and nothing that does.  Once constructed
+ * it is never modified, so any number of festival_solution objects on any
+ * number of threads can share it without locks.
+ *
+ * The preferences of juggler j are the entries [first_preference(j),
+ * first_preference(j+1)), most preferred first.  Each entry gives the circuit
+ * and the score of the juggler in it, computed once here.
+ *
+ * All of the arrays are kept one after the other in a single block of memory,
+ * the image, with nothing in it but four byte fields.  A festival_checkpoint
+ * writes the image to a file as it is, and an instance restored from the file
+ * uses the mapped image in place instead of building anything.
+ */
+class festival_instance
+{
+public:
+
+  /*!
+   * \brief Make an instance from a festival held in memory
+   *
+   * \return Zero if the definition passes scheduler::check_definition(), with
+   *         the new instance, which the caller deletes; non-zero otherwise,
+   *         with each problem written to the stream and no instance
+   */
+  static int create(
+    const festival_definition  &definition,/*!< The festival               */
+    std::ostream               &os,/*!< Stream for error reporting          */
+    festival_instance         *&instance/*!< Returned instance, or zero     */
+                   );
+
+
+  /*!
+   * \brief Construct an instance that uses an image in place
+   *
+   * The image must pass check_image() and must outlive the instance.
+   */
+  explicit festival_instance(
+    const char      *image         /*!< The image, four byte aligned        */
+                            );
+
+
+  /*!
+   * \brief Check that a block of memory holds a whole image
+   *
+   * \return Zero if it does, non-zero otherwise
+   */
+  static int check_image(
+    const char      *image,        /*!< The image, four byte aligned        */
+    const size_t     size          /*!< Number of bytes available           */
+                        );
+
+
+  /*!
+   * \brief Return the image, which is image_size() bytes long
+   */
+  const char *image() const
+  { return _image; }
+
+
+  /*!
+   * \brief Return the size of the image in bytes
+   */
+  size_t image_size() const
+  { return image_size(_header->circuit_count, _header->juggler_count,
+                      _header->preference_count); }
+
+
+  /*!
+   * \brief Return the number of circuits
+   */
+  unsigned int circuit_count() const
+  { return _header->circuit_count; }
+
+
+  /*!
+   * \brief Return the number of jugglers
+   */
+  unsigned int juggler_count() const
+  { return _header->juggler_count; }
+
+
+  /*!
+   * \brief Return the number of jugglers per circuit
+   */
+  unsigned int jugglers_per_circuit() const
+  { return juggler_count() / circuit_count(); }
+
+
+  /*!
+   * \brief Return the first preference entry of a juggler
+   *
+   * first_preference(juggler_count()) is the total number of entries.
+   */
+  unsigned int first_preference(
+    const unsigned int   juggler)  /*!< Index of the juggler                */
+  const
+  { return _first[juggler]; }
+
+
+  /*!
+   * \brief Return the number of preferences of a juggler
+   */
+  unsigned int preference_count(
+    const unsigned int   juggler)  /*!< Index of the juggler                */
+  const
+  { return _first[juggler + 1] - _first[juggler]; }
+
+
+  /*!
+   * \brief Return the circuit of a preference entry
+   */
+  unsigned int preferred_circuit(
+    const unsigned int   entry)    /*!< Index of the preference entry       */
+  const
+  { return _circuit[entry]; }
+
+
+  /*!
+   * \brief Return the score of the juggler in the circuit of a preference entry
+   */
+  int preferred_score(
+    const unsigned int   entry)    /*!< Index of the preference entry       */
+  const
+  { return _score[entry]; }
+
+
+  /*!
+   * \brief Return the talents of a circuit
+   */
+  const talent_definition &circuit_talents(
+    const unsigned int   circuit)  /*!< Index of the circuit                */
+  const
+  { return _circuit_talents[circuit]; }
+
+
+  /*!
+   * \brief Return the talents of a juggler
+   */
+  const talent_definition &juggler_talents(
+    const unsigned int   juggler)  /*!< Index of the juggler                */
+  const
+  { return _juggler_talents[juggler]; }
+
+
+  /*!
+   * \brief Return the score of a juggler in any circuit
+   */
+  int score(
+    const unsigned int   juggler,  /*!< Index of the juggler                */
+    const unsigned int   circuit)  /*!< Index of the circuit                */
+  const
+  {
+    const talent_definition &j = _juggler_talents[juggler];
+    const talent_definition &c = _circuit_talents[circuit];
+
+    return j.hand * c.hand + j.endurance * c.endurance + j.pizzazz * c.pizzazz;
+  }
+
+
+  /*!
+   * \brief Return the juggler that comes at a position in name order
+   *
+   * scheduler keeps its jugglers ordered by name, so "J10" comes before "J2",
+   * and places them in that order.  Solving in the same order gives the same
+   * answer when scores tie.
+   */
+  unsigned int juggler_in_name_order(
+    const unsigned int   position) /*!< Position in name order              */
+  const
+  { return _name_order[position]; }
+
+
+  /*!
+   *  \brief Stream object out to a stream
+   *
+   * \return The same stream as the input to allow for chained operators.
+   */
+  friend std::ostream &operator<<(
+    std::ostream              &os, /*!< The stream into which we stream     */
+    const festival_instance   &cn) /*!< The object to be streamed           */
+  {
+    return cn.print_self(os);
+  }
+
+private:
+
+  /*!
+   * \brief The start of an image, followed by its arrays in the order of the
+   *        members that point to them
+   */
+  struct image_header
+  {
+    //! Number of circuits
+    uint32_t   circuit_count;
+
+    //! Number of jugglers
+    uint32_t   juggler_count;
+
+    //! Number of preference entries of all of the jugglers
+    uint32_t   preference_count;
+
+    //! Zero
+    uint32_t   reserved;
+  };
+
+
+  /*!
+   * \brief Constructor from a festival held in memory, which create() has
+   *        checked
+   */
+  explicit festival_instance(
+    const festival_definition  &definition/*!< The festival                */
+                            );
+
+  /*!
+   * \brief The copy constructor is deliberately private and unimplemented.
+   *
+   * \param rhs the object from which we are to be constructed
+   */
+  festival_instance(
+    const festival_instance   &rhs);
+
+  /*!
+   * \brief operator=() is deliberately private and unimplemented.
+   *
+   * \param rhs the object from which we are to be assigned
+   *
+   * \return reference to self to allow for chained operators
+   */
+  festival_instance &operator=(
+    const festival_instance   &rhs);
+
+  /*!
+   * \brief This is the implementation function for operator<<()
+   *
+   * \return The same stream as the input to allow for chained operators.
+   */
+  std::ostream &print_self(
+    std::ostream    &os)           /*!< The stream into which we stream     */
+  const;
+
+
+  /*!
+   * \brief Return the size of the image of a festival
+   */
+  static size_t image_size(
+    const size_t     circuits,     /*!< Number of circuits                  */
+    const size_t     jugglers,     /*!< Number of jugglers                  */
+    const size_t     preferences   /*!< Number of preference entries        */
+                          );
+
+
+  /*!
+   * \brief Point the members at the arrays of the image
+   */
+  void locate_arrays();
+
+
+  //! Image built by this instance, if it was not given one
+  std::vector<uint32_t>           _storage;
+
+  //! The image
+  const char                     *_image;
+
+  //! Counts at the start of the image
+  const image_header             *_header;
+
+  //! Talents of each circuit
+  const talent_definition        *_circuit_talents;
+
+  //! Talents of each juggler
+  const talent_definition        *_juggler_talents;
+
+  //! First preference entry of each juggler, and one past the last
+  const uint32_t                 *_first;
+
+  //! Circuit of each preference entry
+  const uint32_t                 *_circuit;
+
+  //! Score of each preference entry
+  const int32_t                  *_score;
+
+  //! Jugglers in the order of their names
+  const uint32_t                 *_name_order;
+
+};
+
+#endif                             /* festival_instance_h_included          */
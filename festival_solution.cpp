@@ -0,0 +1,386 @@
+
+/*!
+ * \file festival_solution.cpp
+ *
+ * \brief Contains the implementation of festival_solution
+ *
+ * \author Stewart L. Palmer
+ */
+
+#include <algorithm>
+#include <functional>
+#include "circuit_index.h"
+#include "parallel_task.h"
+#include "festival_solution.h"
+
+using namespace ::std;
+
+
+namespace
+{
+
+/*!
+ * \brief Solves a range of solutions, each on the thread of its worker
+ */
+class solution_sweep : public parallel_task
+{
+public:
+
+  /*!
+   * \brief Standard constructor
+   */
+  explicit solution_sweep(
+    const vector<festival_solution *> &solutions)/*!< To solve              */
+  :
+  _solutions(solutions)
+  { }
+
+protected:
+
+  /*!
+   * \brief Solve the solutions [first, last)
+   */
+  virtual void do_range(
+    const unsigned int   worker,
+    const unsigned int   first,
+    const unsigned int   last)
+  {
+    (void) worker;
+    for (unsigned int s = first; s < last; s++)
+      _solutions[s]->solve();
+  }
+
+private:
+
+  //! Solutions to solve
+  const vector<festival_solution *>  &_solutions;
+
+};
+
+}
+
+
+/*                                                                          */
+/****************************************************************************/
+/*     C O N S T R U C T O R                                                */
+/****************************************************************************/
+/*                                                                          */
+festival_solution::festival_solution(
+  const festival_instance  &instance)/*!< The festival to solve             */
+  :
+  _instance(instance),
+  _capacity(instance.jugglers_per_circuit()),
+  _image(0)
+{
+  start();
+}
+
+
+/*                                                                          */
+/****************************************************************************/
+/*     C O N S T R U C T O R                                                */
+/****************************************************************************/
+/*                                                                          */
+festival_solution::festival_solution(
+  const festival_instance  &instance,/*!< The festival being solved         */
+  char                     *image) /*!< The image, eight byte aligned       */
+  :
+  _instance(instance),
+  _capacity(reinterpret_cast<const image_header *>(image)->capacity),
+  _image(image)
+{
+  locate_arrays();
+}
+
+
+/*                                                                          */
+/****************************************************************************/
+/*     C H E C K _ I M A G E                                                */
+/****************************************************************************/
+/*                                                                          */
+int festival_solution::check_image(
+  const festival_instance  &instance,/*!< The festival being solved         */
+  const char               *image, /*!< The image, eight byte aligned       */
+  const size_t              size)  /*!< Number of bytes available           */
+{
+  if ( (size < sizeof(image_header)) || ((reinterpret_cast<uintptr_t>(image) % 8) != 0) )
+    return 1;
+  const image_header &header = *reinterpret_cast<const image_header *>(image);
+  if ( (header.circuit_count != instance.circuit_count()) ||
+       (header.juggler_count != instance.juggler_count()) ||
+       (header.capacity == 0) || (header.next_position > header.juggler_count) ||
+       (size < image_size(header.circuit_count, header.juggler_count, header.capacity)) )
+    return 1;
+
+  // Everything that indexes an array must stay inside it
+  festival_solution sol(instance, const_cast<char *>(image));
+  for (unsigned int j = 0; j < header.juggler_count; j++)
+    {
+      const int32_t c = sol._assignments[j].circuit;
+      if ( (c < -1) || (c >= (int32_t) header.circuit_count) )
+        return 1;
+    }
+  for (unsigned int c = 0; c < header.circuit_count; c++)
+    {
+      if (sol._roster_sizes[c] > header.capacity)
+        return 1;
+      for (const roster_entry *e = sol.roster_begin(c); e != sol.roster_end(c); e++)
+        if (e->juggler >= header.juggler_count)
+          return 1;
+    }
+
+  return 0;
+}
+
+
+/*                                                                          */
+/****************************************************************************/
+/*     S T A R T                                                            */
+/****************************************************************************/
+/*                                                                          */
+void festival_solution::start()
+{
+  const festival_instance &inst = instance();
+  const size_t size = image_size(inst.circuit_count(), inst.juggler_count(), _capacity);
+  _storage.assign((size + sizeof(uint64_t) - 1) / sizeof(uint64_t), 0);
+  _image = reinterpret_cast<char *>(&_storage[0]);
+  _header = reinterpret_cast<image_header *>(_image);
+  _header->capacity = _capacity;
+  _header->circuit_count = inst.circuit_count();
+  _header->juggler_count = inst.juggler_count();
+  locate_arrays();
+
+  assignment_record none;
+  none.circuit = -1;
+  none.score = 0;
+  none.preference = 0;
+  fill(_assignments, _assignments + inst.juggler_count(), none);
+}
+
+
+/*                                                                          */
+/****************************************************************************/
+/*     A D V A N C E                                                        */
+/****************************************************************************/
+/*                                                                          */
+bool festival_solution::advance(
+  const unsigned int   jugglers)   /*!< Most jugglers to place              */
+{
+  const festival_instance &inst = instance();
+  for (unsigned int n = 0; (n < jugglers) && (_header->next_position < inst.juggler_count()); n++)
+    place(inst.juggler_in_name_order(_header->next_position++));
+  if ( (_header->next_position == inst.juggler_count()) && !is_solved() )
+    {
+      distribute_orphans();
+      _header->solved = 1;
+    }
+
+  return is_solved();
+}
+
+
+/*                                                                          */
+/****************************************************************************/
+/*     S O L V E _ A L L                                                    */
+/****************************************************************************/
+/*                                                                          */
+void festival_solution::solve_all(
+  const vector<festival_solution *> &solutions,/*!< To solve                */
+  const unsigned int   workers)    /*!< Maximum number of worker threads    */
+{
+  solution_sweep   sweep(solutions);
+  sweep.run(solutions.size(), workers);
+}
+
+
+/*                                                                          */
+/****************************************************************************/
+/*     J U G G L E R _ S U M                                                */
+/****************************************************************************/
+/*                                                                          */
+int festival_solution::juggler_sum(
+  const unsigned int   circuit)    /*!< Index of the circuit                */
+const
+{
+  const roster_entry *const roster = _roster_entries + (size_t) circuit * _header->capacity;
+  int sum = 0;
+  for (unsigned int r = 0; r < _roster_sizes[circuit]; r++)
+    sum += roster[r].juggler;
+
+  return sum;
+}
+
+
+/*                                                                          */
+/****************************************************************************/
+/*     T O T A L _ S C O R E                                                */
+/****************************************************************************/
+/*                                                                          */
+int64_t festival_solution::total_score() const
+{
+  int64_t total = 0;
+  for (unsigned int j = 0; j < _header->juggler_count; j++)
+    if (_assignments[j].circuit >= 0)
+      total += _assignments[j].score;
+
+  return total;
+}
+
+
+/*                                                                          */
+/****************************************************************************/
+/*     P L A C E                                                            */
+/****************************************************************************/
+/*                                                                          */
+void festival_solution::place(
+  const unsigned int   juggler)    /*!< Index of the juggler                */
+{
+  const festival_instance &inst = instance();
+  unsigned int jug = juggler;
+  unsigned int preference = 0;
+  while (preference < inst.preference_count(jug))
+  {
+    const unsigned int entry = inst.first_preference(jug) + preference;
+    const unsigned int circuit = inst.preferred_circuit(entry);
+    const int score = inst.preferred_score(entry);
+    _header->proposal_count++;
+    if (_roster_sizes[circuit] < _header->capacity)
+      {                            /* Room for one more                     */
+        add_to_roster(jug, circuit, score, preference);
+        return;
+      }
+    roster_entry *const roster = roster_begin(circuit);
+    if (score > roster->score)
+      {                            /* Better than the lowest, who moves on  */
+        const roster_entry evicted = *roster;
+        pop_heap(roster, roster_end(circuit), greater<roster_entry>());
+        _roster_sizes[circuit]--;
+        _assignments[evicted.juggler].circuit = -1;
+        add_to_roster(jug, circuit, score, preference);
+        jug = evicted.juggler;
+        preference = evicted.preference;
+      }
+    preference++;
+  }
+  _header->orphan_count++;         /* Left for distribute_orphans()         */
+}
+
+
+/*                                                                          */
+/****************************************************************************/
+/*     A D D _ T O _ R O S T E R                                            */
+/****************************************************************************/
+/*                                                                          */
+void festival_solution::add_to_roster(
+  const unsigned int   juggler,    /*!< Index of the juggler                */
+  const unsigned int   circuit,    /*!< Index of the circuit                */
+  const int            score,      /*!< Score of the juggler in the circuit */
+  const unsigned int   preference) /*!< Preference for the circuit          */
+{
+  roster_entry e;
+  e.score = score;
+  e.preference = preference;
+  e.juggler = juggler;
+  assert(_roster_sizes[circuit] < _header->capacity);
+  *roster_end(circuit) = e;
+  _roster_sizes[circuit]++;
+  push_heap(roster_begin(circuit), roster_end(circuit), greater<roster_entry>());
+
+  assignment_record &r = _assignments[juggler];
+  r.circuit = circuit;
+  r.score = score;
+  r.preference = preference;
+}
+
+
+/*                                                                          */
+/****************************************************************************/
+/*     D I S T R I B U T E _ O R P H A N S                                  */
+/****************************************************************************/
+/*                                                                          */
+void festival_solution::distribute_orphans()
+{
+  if (orphan_count() == 0)
+    return;
+
+  // As scheduler::distribute_orphans(), in name order, with the lowest circuit
+  // winning a tie.  The index finds the best open circuit without scoring the
+  // orphan against every circuit.
+  const festival_instance &inst = instance();
+  circuit_index  open;
+  open.build(inst);
+  for (unsigned int c = 0; c < inst.circuit_count(); c++)
+    if (_roster_sizes[c] >= _header->capacity)
+      open.close(c);
+  for (unsigned int p = 0; p < inst.juggler_count(); p++)
+    {
+      const unsigned int jug = inst.juggler_in_name_order(p);
+      if (_assignments[jug].circuit >= 0)
+        continue;
+      const int best = open.best_id(inst.juggler_talents(jug), true);
+      if (best < 0)                /* Every circuit is full                 */
+        break;
+
+      // A circuit it did not list ranks after all those it did
+      unsigned int preference = inst.preference_count(jug) + 1;
+      const unsigned int first = inst.first_preference(jug);
+      for (unsigned int e = first; e < inst.first_preference(jug + 1); e++)
+        if (inst.preferred_circuit(e) == (unsigned int) best)
+          preference = e - first;
+      add_to_roster(jug, best, inst.score(jug, best), preference);
+      if (_roster_sizes[best] >= _header->capacity)
+        open.close(best);
+    }
+}
+
+
+/*                                                                          */
+/****************************************************************************/
+/*     I M A G E _ S I Z E                                                  */
+/****************************************************************************/
+/*                                                                          */
+size_t festival_solution::image_size(
+  const size_t         circuits,   /*!< Number of circuits                  */
+  const size_t         jugglers,   /*!< Number of jugglers                  */
+  const size_t         capacity)   /*!< Jugglers per circuit                */
+{
+  return sizeof(image_header) +
+         jugglers * sizeof(assignment_record) +
+         circuits * sizeof(uint32_t) +
+         circuits * capacity * sizeof(roster_entry);
+}
+
+
+/*                                                                          */
+/****************************************************************************/
+/*     L O C A T E _ A R R A Y S                                            */
+/****************************************************************************/
+/*                                                                          */
+void festival_solution::locate_arrays()
+{
+  _header = reinterpret_cast<image_header *>(_image);
+  char *next = _image + sizeof(image_header);
+  _assignments = reinterpret_cast<assignment_record *>(next);
+  next += _header->juggler_count * sizeof(assignment_record);
+  _roster_sizes = reinterpret_cast<uint32_t *>(next);
+  next += _header->circuit_count * sizeof(uint32_t);
+  _roster_entries = reinterpret_cast<roster_entry *>(next);
+}
+
+
+/*                                                                          */
+/****************************************************************************/
+/*     P R I N T _ S E L F                                                  */
+/****************************************************************************/
+/*                                                                          */
+ostream &festival_solution::print_self(
+  ostream    &os)                  /*!< The stream into which we stream     */
+const
+{
+  os << "festival_solution: capacity = " << _header->capacity <<
+        ", placed = " << placed_count() <<
+        ", proposals = " << proposal_count() <<
+        ", orphans = " << orphan_count();
+
+  return os;
+}
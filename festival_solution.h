@@ -0,0 +1,424 @@
+#ifndef festival_solution_h_included
+#define festival_solution_h_included 1
+
+/*!
+ * \file festival_solution.h
+ *
+ * \brief Contains the definition of festival_solution
+ *
+ * \author Stewart L. Palmer
+ */
+
+#include <iostream>
+#include <vector>
+#include <assert.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "assignment_record.h"
+#include "festival_instance.h"
+
+
+/*!
+ * \brief One assignment of the jugglers of a shared festival_instance
+ *
+ * All of the state of a solve lives here: the assignment of each juggler and
+ * the roster of each circuit.  The instance is only read,
+ * so many solutions of one instance can be solved at the same time on
+ * different threads, for instance to sweep the circuit capacity, without
+ * reading or copying the festival again.  solve_all() does exactly that.
+ *
+ * solve() finds the same stable assignment as scheduler::assign() without a
+ * time budget: jugglers propose in name order, a full circuit takes a proposer
+ * only for a strictly higher score than its lowest, and the jugglers left over
+ * go to the open circuit where they score highest.  A capacity other than
+ * jugglers_per_circuit() may leave jugglers unassigned or circuits short.
+ *
+ * A solve can also be taken a few jugglers at a time with start() and
+ * advance().  Between calls, the whole state, down to the proposal count, is
+ * in one block of memory, the image, with nothing in it that points anywhere.
+ * A festival_checkpoint writes the image to a file as it is, and a solution
+ * restored from the file works on the mapped image in place, so a long solve
+ * that is interrupted can carry on from its last checkpoint.
+ */
+class festival_solution
+{
+public:
+
+  /*!
+   * \brief Standard constructor
+   *
+   * The capacity of every circuit starts as the instance's jugglers per
+   * circuit.
+   */
+  explicit festival_solution(
+    const festival_instance  &instance/*!< The festival to solve            */
+                            );
+
+
+  /*!
+   * \brief Construct a solution that works on an image in place
+   *
+   * The image must pass check_image() for the instance and must outlive the
+   * solution; it is changed by advance().  The capacity is that of the image.
+   */
+  explicit festival_solution(
+    const festival_instance  &instance,/*!< The festival being solved       */
+    char                     *image/*!< The image, eight byte aligned       */
+                            );
+
+
+  /*!
+   * \brief Check that a block of memory holds a whole image of a solution of
+   *        an instance
+   *
+   * \return Zero if it does, non-zero otherwise
+   */
+  static int check_image(
+    const festival_instance  &instance,/*!< The festival being solved       */
+    const char               *image,/*!< The image, eight byte aligned      */
+    const size_t              size /*!< Number of bytes available           */
+                        );
+
+
+  /*!
+   * \brief Return the image
+   */
+  const char *image() const
+  { return _image; }
+
+
+  /*!
+   * \brief Return the size of the image in bytes
+   */
+  size_t image_size() const
+  { return image_size(_header->circuit_count, _header->juggler_count, _header->capacity); }
+
+
+  /*!
+   * \brief Return the festival being solved
+   */
+  const festival_instance &instance() const
+  { return _instance; }
+
+
+  /*!
+   * \brief Return the number of jugglers each circuit takes
+   */
+  unsigned int capacity() const
+  { return _capacity; }
+
+
+  /*!
+   * \brief Set the number of jugglers each circuit takes
+   *
+   * Takes effect at the next start() or solve().
+   */
+  void set_capacity(
+    const unsigned int   capacity) /*!< Jugglers per circuit                */
+  {
+    assert(capacity > 0);
+    _capacity = capacity;
+  }
+
+
+  /*!
+   * \brief Find the stable assignment, replacing any earlier one
+   */
+  void solve()
+  {
+    start();
+    advance(instance().juggler_count());
+  }
+
+
+  /*!
+   * \brief Forget any earlier assignment and start a new solve
+   */
+  void start();
+
+
+  /*!
+   * \brief Place up to a number of jugglers more, in name order, and
+   *        distribute the orphans once every juggler has been placed
+   *
+   * \return True if the solve is done, false if jugglers remain to be placed
+   */
+  bool advance(
+    const unsigned int   jugglers  /*!< Most jugglers to place              */
+              );
+
+
+  /*!
+   * \brief Return the number of jugglers placed so far, in name order
+   */
+  unsigned int placed_count() const
+  { return _header->next_position; }
+
+
+  /*!
+   * \brief Return true once the solve is done
+   */
+  bool is_solved() const
+  { return (_header->solved != 0); }
+
+
+  /*!
+   * \brief Solve several solutions at once, one per worker thread at a time
+   *
+   * The solutions may share instances.  Each is solved with its own capacity.
+   */
+  static void solve_all(
+    const std::vector<festival_solution *> &solutions,/*!< To solve         */
+    const unsigned int   workers   /*!< Maximum number of worker threads    */
+                       );
+
+
+  /*!
+   * \brief Return the assignment of a juggler
+   *
+   * The circuit is -1 if the juggler is unassigned.
+   */
+  const assignment_record &assignment(
+    const unsigned int   juggler)  /*!< Index of the juggler                */
+  const
+  { return _assignments[juggler]; }
+
+
+  /*!
+   * \brief Return the assignment of every juggler, by juggler index
+   *
+   * There are instance().juggler_count() of them.
+   */
+  const assignment_record *assignments() const
+  { return _assignments; }
+
+
+  /*!
+   * \brief Return the number of jugglers assigned to a circuit
+   */
+  unsigned int assigned_count(
+    const unsigned int   circuit)  /*!< Index of the circuit                */
+  const
+  { return _roster_sizes[circuit]; }
+
+
+  /*!
+   * \brief Return the sum of the IDs of the jugglers assigned to a circuit
+   */
+  int juggler_sum(
+    const unsigned int   circuit)  /*!< Index of the circuit                */
+  const;
+
+
+  /*!
+   * \brief Return the total score of all assigned jugglers
+   */
+  int64_t total_score() const;
+
+
+  /*!
+   * \brief Return the number of proposals made since start()
+   */
+  uint64_t proposal_count() const
+  { return _header->proposal_count; }
+
+
+  /*!
+   * \brief Return the number of jugglers that ran out of preferences since
+   *        start()
+   */
+  unsigned int orphan_count() const
+  { return _header->orphan_count; }
+
+
+  /*!
+   *  \brief Stream object out to a stream
+   *
+   * \return The same stream as the input to allow for chained operators.
+   */
+  friend std::ostream &operator<<(
+    std::ostream              &os, /*!< The stream into which we stream     */
+    const festival_solution   &cn) /*!< The object to be streamed           */
+  {
+    return cn.print_self(os);
+  }
+
+private:
+
+  /*!
+   * \brief A juggler on the roster of a circuit
+   *
+   * Rosters are heaps with the juggler to evict first on top.  That is the one
+   * with the lowest score, then the one that listed the circuit earliest, then
+   * the one with the lowest ID, as juggler_circuit::operator<() orders them.
+   */
+  struct roster_entry
+  {
+    //! Score of the juggler in the circuit
+    int32_t        score;
+
+    //! Preference of the juggler for the circuit
+    uint32_t       preference;
+
+    //! Index of the juggler
+    uint32_t       juggler;
+
+    /*!
+     * \brief Return true if this entry should be evicted after rhs
+     */
+    bool operator>(
+      const roster_entry   &rhs)   /*!< Right hand side of comparison       */
+    const
+    {
+      if (score != rhs.score)
+        return score > rhs.score;
+      if (preference != rhs.preference)
+        return preference > rhs.preference;
+      return juggler > rhs.juggler;
+    }
+  };
+
+
+  /*!
+   * \brief The start of an image, followed by the assignment of each juggler,
+   *        the size of each roster, and capacity roster entries per circuit
+   */
+  struct image_header
+  {
+    //! Number of proposals made so far
+    uint64_t       proposal_count;
+
+    //! Number of jugglers each circuit takes
+    uint32_t       capacity;
+
+    //! Number of circuits
+    uint32_t       circuit_count;
+
+    //! Number of jugglers
+    uint32_t       juggler_count;
+
+    //! Position in name order of the next juggler to place
+    uint32_t       next_position;
+
+    //! Number of jugglers that ran out of preferences so far
+    uint32_t       orphan_count;
+
+    //! Non-zero once the orphans have been distributed
+    uint32_t       solved;
+  };
+
+
+  /*!
+   * \brief The copy constructor is deliberately private and unimplemented.
+   *
+   * \param rhs the object from which we are to be constructed
+   */
+  festival_solution(
+    const festival_solution   &rhs);
+
+  /*!
+   * \brief operator=() is deliberately private and unimplemented.
+   *
+   * \param rhs the object from which we are to be assigned
+   *
+   * \return reference to self to allow for chained operators
+   */
+  festival_solution &operator=(
+    const festival_solution   &rhs);
+
+  /*!
+   * \brief This is the implementation function for operator<<()
+   *
+   * \return The same stream as the input to allow for chained operators.
+   */
+  std::ostream &print_self(
+    std::ostream    &os)           /*!< The stream into which we stream     */
+  const;
+
+
+  /*!
+   * \brief Return the size of the image of a solution
+   */
+  static size_t image_size(
+    const size_t         circuits, /*!< Number of circuits                  */
+    const size_t         jugglers, /*!< Number of jugglers                  */
+    const size_t         capacity  /*!< Jugglers per circuit                */
+                          );
+
+
+  /*!
+   * \brief Point the members at the arrays of the image
+   */
+  void locate_arrays();
+
+
+  /*!
+   * \brief Return the first entry of the roster of a circuit
+   */
+  roster_entry *roster_begin(
+    const unsigned int   circuit)  /*!< Index of the circuit                */
+  { return _roster_entries + (size_t) circuit * _header->capacity; }
+
+
+  /*!
+   * \brief Return the entry just past the roster of a circuit
+   */
+  roster_entry *roster_end(
+    const unsigned int   circuit)  /*!< Index of the circuit                */
+  { return roster_begin(circuit) + _roster_sizes[circuit]; }
+
+
+  /*!
+   * \brief Propose a juggler to its preferences in turn, following the chain
+   *        of evictions, until someone is placed or runs out of preferences
+   */
+  void place(
+    const unsigned int   juggler   /*!< Index of the juggler                */
+            );
+
+
+  /*!
+   * \brief Put a juggler on the roster of a circuit
+   */
+  void add_to_roster(
+    const unsigned int   juggler,  /*!< Index of the juggler                */
+    const unsigned int   circuit,  /*!< Index of the circuit                */
+    const int            score,    /*!< Score of the juggler in the circuit */
+    const unsigned int   preference/*!< Preference for the circuit          */
+                    );
+
+
+  /*!
+   * \brief Place the jugglers left without a circuit in the open circuits
+   *        where they score highest
+   */
+  void distribute_orphans();
+
+
+  //! The festival being solved
+  const festival_instance               &_instance;
+
+  //! Number of jugglers each circuit takes from the next start()
+  unsigned int                           _capacity;
+
+  //! Image built by this solution, if it was not given one
+  std::vector<uint64_t>                  _storage;
+
+  //! The image
+  char                                  *_image;
+
+  //! Counts and progress at the start of the image
+  image_header                          *_header;
+
+  //! Assignment of each juggler
+  assignment_record                     *_assignments;
+
+  //! Number of jugglers assigned to each circuit
+  uint32_t                              *_roster_sizes;
+
+  //! Jugglers assigned to each circuit, as heaps of capacity entries each
+  roster_entry                          *_roster_entries;
+
+};
+
+#endif                             /* festival_solution_h_included          */
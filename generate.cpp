@@ -0,0 +1,145 @@
+
+/*!
+ * \file generate.cpp
+ *
+ * \brief Main program for making up a festival
+ *
+ * \author Stewart L. Palmer
+ */
+
+#include <iostream>
+#include <string>
+#include <fcntl.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "festival_checkpoint.h"
+#include "festival_generator.h"
+#include "festival_instance.h"
+#include "festival_solution.h"
+
+using namespace ::std;
+
+/*!
+ * \brief Print the command line usage
+ */
+static void usage(
+  const char   *program)           /*!< Name of the program                 */
+{
+  cerr << "usage: " << program << " [-c circuits] [-j jugglers] [-l preferences] [-m popularity]\n"
+          "       [-k uniform | bell] [-r seed] [-o file] [-b file]\n"
+          "  -c circuits     number of circuits, 2000 by default\n"
+          "  -j jugglers     number of jugglers, a multiple of the circuits, 12000 by default\n"
+          "  -l preferences  preferences of each juggler, 10 by default\n"
+          "  -m popularity   uniform (the default), zipf[:exponent] or\n"
+          "                  hotspot[:hot_fraction:hot_share]\n"
+          "  -k skills       talents uniform from 0 to 10 (the default) or bell shaped\n"
+          "  -r seed         seed, 1 by default; the same seed gives the same festival\n"
+          "  -o file         write the festival as text to file instead of stdout\n"
+          "  -b file         also write it as a checkpoint, which loads without parsing" << endl;
+}
+
+
+int main(
+  int     argc,
+  char   *argv[])
+{
+  unsigned int circuits = 2000;
+  unsigned int jugglers = 12000;
+  unsigned int length = 10;
+  string popularity = "uniform";
+  festival_generator::skills skills = festival_generator::uniform_skills;
+  unsigned long seed = 1;
+  const char *text_file = 0;
+  const char *checkpoint_file = 0;
+
+  int opt = getopt(argc, argv, "c:j:l:m:k:r:o:b:");
+  while (opt != -1)
+  {
+    switch (opt)
+    {
+      case 'c':
+        circuits = atoi(optarg);
+        break;
+      case 'j':
+        jugglers = atoi(optarg);
+        break;
+      case 'l':
+        length = atoi(optarg);
+        break;
+      case 'm':
+        popularity = optarg;
+        break;
+      case 'k':
+        if (strcmp(optarg, "uniform") == 0)
+          skills = festival_generator::uniform_skills;
+        else if (strcmp(optarg, "bell") == 0)
+          skills = festival_generator::bell_skills;
+        else
+          {
+            usage(argv[0]);
+            return 1;
+          }
+        break;
+      case 'r':
+        seed = strtoul(optarg, 0, 10);
+        break;
+      case 'o':
+        text_file = optarg;
+        break;
+      case 'b':
+        checkpoint_file = optarg;
+        break;
+      default:
+        usage(argv[0]);
+        return 1;
+    }
+    opt = getopt(argc, argv, "c:j:l:m:k:r:o:b:");
+  }
+  if (optind != argc)
+    {
+      usage(argv[0]);
+      return 1;
+    }
+
+  festival_generator generator(circuits, jugglers, length, seed);
+  generator.set_skills(skills);
+  festival_definition definition;
+  if ( (generator.set_popularity(popularity) != 0) ||
+       (generator.generate(definition) != 0) )
+    {
+      cerr << "Cannot make " << jugglers << " jugglers with " << length <<
+              " preferences over " << circuits << " circuits with " <<
+              popularity << " popularity." << endl;
+      return 1;
+    }
+
+  const int fd = (text_file == 0) ? STDOUT_FILENO
+                                  : open(text_file, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+  if ( (fd < 0) || (festival_generator::write_text(definition, fd) != 0) )
+    {
+      cerr << "Cannot write " << ((text_file == 0) ? "stdout" : text_file) << endl;
+      return 1;
+    }
+  if (fd != STDOUT_FILENO)
+    close(fd);
+
+  // The checkpoint holds the scored festival and a solution not yet started
+  if (checkpoint_file != 0)
+    {
+      festival_instance *instance = 0;
+      if (festival_instance::create(definition, cerr, instance) != 0)
+        return 1;
+      festival_solution *const solution = new festival_solution(*instance);
+      const int crc = festival_checkpoint::write(*solution, checkpoint_file);
+      delete solution;
+      delete instance;
+      if (crc != 0)
+        {
+          cerr << "Cannot write " << checkpoint_file << endl;
+          return 1;
+        }
+    }
+
+  return 0;
+}
@@ -10,13 +10,32 @@
 #include <regex>
 #include <sstream>
 #include <assert.h>
+#include <limits.h>
 #include "juggler_circuit.h"
+#include "memory_usage.h"
 #include "circuit_set.h"
+#include "output_buffer.h"
+#include "scheduler.h"
 #include "juggler.h"
 
 using namespace ::std;
 
 
+/*!
+ * \brief Write the score needed to get into a circuit, or "open" if it has a
+ *        vacancy
+ */
+static void show_low(
+  ostream            &os,          /*!< Stream for the score                */
+  const int           low)         /*!< The score, or INT_MIN               */
+{
+  if (low == INT_MIN)
+    os << "open";
+  else
+    os << low;
+}
+
+
 // Regular expression to scan a juggler string and extract the name of the juggler, its talent
 // (hand-eye coordination, endurance, and pizzazz), and comma separated string of preferred circuits.
 const string juggler::_scan_exp =
@@ -38,7 +57,9 @@ juggler::juggler(
   circuit_set         &circuits)   /*!< The set of all circuits             */
   :
   talent(sched),
-  _assignment(0)
+  _assignment(0),
+  _preference_count(0),
+  _withdrawn(false)
 {
   smatch    matches;
   regex scan_rx(_scan_exp);
@@ -51,6 +72,7 @@ juggler::juggler(
   const int talent_rc = set_talents(matches, 2);
   assert(talent_rc == 0);
 
+  scheduler_stats::phase_scope scope(sched.stats(), scheduler_stats::score_phase);
   const string circuits_list = matches[8];
   istringstream is(circuits_list);
   string   single_circuit;
@@ -65,6 +87,53 @@ juggler::juggler(
     add_circuit(circ, preference);
     preference++;
   }
+  _preference_count = preference;
+}
+
+
+/*                                                                          */
+/****************************************************************************/
+/*     C O N S T R U C T O R                                                */
+/****************************************************************************/
+/*                                                                          */
+juggler::juggler(
+  scheduler           &sched,      /*!< Reference to the scheduler          */
+  const string        &name,       /*!< Name of the juggler                 */
+  const int            hand,       /*!< Value for hand-eye coordination     */
+  const int            endurance,  /*!< Value for endurance                 */
+  const int            pizzazz,    /*!< Value for pizzazz                   */
+  const vector<circuit *> &preferences)/*!< Preferred circuits              */
+  :
+  talent(sched),
+  _assignment(0),
+  _preference_count(0),
+  _withdrawn(false)
+{
+  // Used to detect a juggler with duplicate circuit preferences
+  circuit_set   local_circuits;
+
+  set_name(name);
+  set_talents(hand, endurance, pizzazz);
+  scheduler_stats::phase_scope scope(sched.stats(), scheduler_stats::score_phase);
+  for (unsigned int p = 0; p < preferences.size(); p++)
+    {
+      circuit &circ = *preferences[p];
+      local_circuits.add(circ);    /* Check for duplicates in pref list     */
+      add_circuit(circ, p);
+    }
+  _preference_count = preferences.size();
+}
+
+
+/*                                                                          */
+/****************************************************************************/
+/*     D E S T R U C T O R                                                  */
+/****************************************************************************/
+/*                                                                          */
+juggler::~juggler()
+{
+  for (unsigned int i = 0; i < _requested.size(); i++)
+    delete _requested[i];
 }
 
 
@@ -82,11 +151,35 @@ const juggler_circuit *juggler::add_circuit(
   const juggler_circuit  *j = new juggler_circuit(self, circ, score, preference);
   const juggler_circuit  &jc = *j;
   self.add_request(jc);
+  circ.add_interest(jc);
 
   return j;
 }
 
 
+/*                                                                          */
+/****************************************************************************/
+/*     F I N D _ R E Q U E S T                                              */
+/****************************************************************************/
+/*                                                                          */
+const juggler_circuit *juggler::find_request(
+  const circuit        &circ)      /*!< The circuit to look for             */
+const
+{
+  const juggler_circuit *found = 0;
+  for (unsigned int i = 0; i < _requested.size(); i++)
+    {
+      if (&_requested[i]->circ() == &circ)
+        {
+          found = _requested[i];
+          break;
+        }
+    }
+
+  return found;
+}
+
+
 /*                                                                          */
 /****************************************************************************/
 /*     A D D _ R E Q U E S T                                                */
@@ -133,13 +226,36 @@ const
 }
 
 
+/*                                                                          */
+/****************************************************************************/
+/*     S H O W _ R E Q U E S T S                                            */
+/****************************************************************************/
+/*                                                                          */
+void juggler::show_requests(
+  output_buffer   &ob)             /*!< Buffer for requests                 */
+const
+{
+  for (unsigned int i = 0; i < _requested.size(); i++)
+    {
+      const juggler_circuit &jc = *_requested[i];
+      if (i != 0)
+        ob.append(' ');
+      ob.append(jc.circuit_name());
+      ob.append(':');
+      ob.append_int(jc.score());
+    }
+}
+
+
 /*                                                                          */
 /****************************************************************************/
 /*     V A L I D A T E _ A S S I G N M E N T                                */
 /****************************************************************************/
 /*                                                                          */
 int juggler::validate_assignment(
-  ostream     &os)
+  ostream            &os,
+  const vector<int>  &lowest)
+const
 {
   int rc = 0;
   if ( !is_assigned() )
@@ -159,14 +275,17 @@ int juggler::validate_assignment(
           break;
         }
 
-      if (jc.score() > this_circuit.lowest_score())
+      const int low = lowest[this_circuit.index()];
+      if (jc.score() > low)
         {
           os << name() << " is assigned to " << assigned_circuit.name() <<
             " (Pref " << assigned.preference() << ", Score " << assigned.score() <<
-            ", Low = " << assigned_circuit.lowest_score() <<
-            ").  Better fit in " << this_circuit.name() << " (Pref " <<
-            jc.preference() << ", Score " << jc.score() << ", Low = " << this_circuit.lowest_score() <<
-            ")." << endl;
+            ", Low = ";
+          show_low(os, lowest[assigned_circuit.index()]);
+          os << ").  Better fit in " << this_circuit.name() << " (Pref " <<
+            jc.preference() << ", Score " << jc.score() << ", Low = ";
+          show_low(os, low);
+          os << ")." << endl;
           rc = 1;
         }
     }
@@ -175,6 +294,47 @@ int juggler::validate_assignment(
 }
 
 
+/*                                                                          */
+/****************************************************************************/
+/*     B L O C K I N G _ P A I R _ C O U N T                                */
+/****************************************************************************/
+/*                                                                          */
+unsigned int juggler::blocking_pair_count() const
+{
+  unsigned int count = 0;
+  for (unsigned int i = 0; i < _requested.size(); i++)
+    {
+      const juggler_circuit *j = _requested[i];
+      const juggler_circuit &jc = *j;
+      if (_assignment == j)
+        break;
+
+      const circuit &this_circuit = jc.circ();
+      if ( this_circuit.is_not_full() ||
+           (jc.score() > this_circuit.lowest_score()) )
+        count++;
+    }
+
+  return count;
+}
+
+
+/*                                                                          */
+/****************************************************************************/
+/*     A C C O U N T _ M E M O R Y                                          */
+/****************************************************************************/
+/*                                                                          */
+void juggler::account_memory(
+  memory_usage   &usage)           /*!< Where to charge them                */
+const
+{
+  usage.add_object(memory_usage::juggler_objects, sizeof(juggler));
+  usage.add_vector(memory_usage::preference_vectors, _requested);
+  for (unsigned int i = 0; i < _requested.size(); i++)
+    usage.add_object(memory_usage::juggler_circuit_objects, sizeof(juggler_circuit));
+  usage.add_string(memory_usage::talent_names, name());
+}
+
 /*                                                                          */
 /****************************************************************************/
 /*     P R I N T _ S E L F                                                  */
@@ -187,7 +347,9 @@ const
   os << "J:";
   talent::print_self(os);
   os << ": ";
-  if ( !is_assigned() )
+  if (is_withdrawn())
+    os << "Withdrawn.";
+  else if ( !is_assigned() )
     os << "Not assigned to a circuit.";
   else
     os << "Assigned to circuit " << assignment().circuit_name();
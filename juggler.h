@@ -19,6 +19,8 @@ class circuit_set;
 class juggler_assignment;
 class juggler_circuit;
 class juggler_circuit_set;
+class memory_usage;
+class output_buffer;
 
 
 /*!
@@ -47,6 +49,31 @@ public:
     circuit_set        &circuits);
 
 
+  /*!
+   * \brief Constructor from values rather than from an input record
+   *
+   * A juggler_circuit is constructed for each preferred circuit, as the other
+   * constructor does.
+   */
+  explicit juggler(
+    scheduler          &sched,     /*!< Reference to the scheduler          */
+    const std::string  &name,      /*!< Name of the juggler                 */
+    const int           hand,      /*!< Value for hand-eye coordination     */
+    const int           endurance, /*!< Value for endurance                 */
+    const int           pizzazz,   /*!< Value for pizzazz                   */
+    const std::vector<circuit *> &preferences/*!< Preferred circuits, most
+                                                  preferred first           */
+                  );
+
+
+  /*!
+   * \brief Destructor
+   *
+   * Deletes the juggler_circuit of each preference.
+   */
+  virtual ~juggler();
+
+
 
   /*!
    * \brief Return a reference to the current juggler assignment
@@ -89,6 +116,24 @@ public:
   }
 
 
+  /*!
+   * \brief Return true if the juggler has withdrawn from the festival
+   */
+  bool is_withdrawn() const
+  {
+    return _withdrawn;
+  }
+
+
+  /*!
+   * \brief Mark the juggler as withdrawn from the festival
+   *
+   * A withdrawn juggler is never again taken from a waitlist.
+   */
+  void set_withdrawn()
+  { _withdrawn = true; }
+
+
   /*!
    * \brief Add this juggler to its first preferred circuit
    *
@@ -108,6 +153,16 @@ public:
   const;
 
 
+  /*!
+   * \brief Show all circuits, and their scores, that this juggler prefers
+   *
+   * The same text as show_requests(std::ostream &), appended to a buffer.
+   */
+  void show_requests(
+    output_buffer    &ob)          /*!< Buffer for requests                 */
+  const;
+
+
   /*!
    * \brief Set the assignment for the juggler
    */
@@ -136,6 +191,41 @@ public:
   }
 
 
+  /*!
+   * \brief Return the number of circuits this juggler has asked for
+   *
+   * An orphaned juggler that was placed in a circuit it did not ask for has that
+   * circuit added at the end of its requests.
+   */
+  unsigned int request_count() const
+  { return _requested.size(); }
+
+
+  /*!
+   * \brief Return the number of circuits listed in this juggler's definition
+   *
+   * Unlike request_count(), this never includes a circuit added for an
+   * orphaned juggler.
+   */
+  unsigned int preference_count() const
+  { return _preference_count; }
+
+
+  /*!
+   * \brief Return one of the circuits this juggler has asked for
+   *
+   * \return The juggler_circuit for the request, in order of preference
+   */
+  const juggler_circuit &request(
+    const unsigned int    i)       /*!< Index of the request                */
+  const
+  {
+    assert(i < _requested.size());
+
+    return *_requested[i];
+  }
+
+
   /*!
    * \brief Get the next preference for this juggler
    *
@@ -159,6 +249,26 @@ public:
   }
 
 
+  /*!
+   * \brief Return this juggler's request for a circuit
+   *
+   * \return The juggler_circuit for the circuit, or zero if the juggler has not
+   *         asked for it
+   */
+  const juggler_circuit *find_request(
+    const circuit        &circ)    /*!< The circuit to look for             */
+  const;
+
+
+  /*!
+   * \brief Charge the juggler, its requests, their list and its name to
+   *        their subsystems
+   */
+  void account_memory(
+    memory_usage   &usage          /*!< Where to charge them                */
+                     ) const;
+
+
   /*!
    * \brief Validate the juggler assignment
    *
@@ -166,11 +276,28 @@ public:
    * that it is not a better fit in any circuit that it prefers more than the
    * circuit to which it is assigned.
    *
+   * The lowest score of every circuit is passed in, indexed by circuit index, so
+   * that it is found only once for all jugglers.  Nothing is changed, so many
+   * jugglers can be validated at once.
+   *
    * \return zero if the assignment is correct, non-zero if a problem was detected
    */
   int validate_assignment(
-    std::ostream     &os           /*!< Output stream for error messages    */
-                        );
+    std::ostream     &os,          /*!< Output stream for error messages    */
+    const std::vector<int> &lowest /*!< Lowest score of each circuit        */
+                        )
+  const;
+
+
+  /*!
+   * \brief Count the circuits this juggler prefers to its assignment and that
+   *        would rather have it than their lowest scoring juggler
+   *
+   * These are the blocking pairs that validate_assignment() reports.  An
+   * unassigned juggler is counted against every preferred circuit that would
+   * take it.
+   */
+  unsigned int blocking_pair_count() const;
 
 
   /*!
@@ -262,6 +389,12 @@ private:
     */
   std::vector<const juggler_circuit *>   _requested;
 
+  //! Number of circuits listed in the juggler's definition
+  unsigned int                           _preference_count;
+
+  //! True if the juggler has withdrawn from the festival
+  bool                                   _withdrawn;
+
 
 };
 
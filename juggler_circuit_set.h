@@ -13,6 +13,7 @@
 #include <set>
 #include <assert.h>
 #include "juggler_circuit_reference.h"
+#include "memory_usage.h"
 
 class juggler_circuit_set_iterator;
 class juggler_circuit_set_const_iterator;
@@ -53,6 +54,15 @@ public:
   { return _jcs_set.size(); }
 
 
+  /*!
+   * \brief Charge the nodes of the set to the rosters
+   */
+  void account_memory(
+    memory_usage   &usage)         /*!< Where to charge them                */
+  const
+  { usage.add_tree(memory_usage::roster_sets, _jcs_set); }
+
+
   /*!
    * \brief Delete a juggler_curcuit by value
    */
@@ -104,12 +104,19 @@ public:
 
   /*!
    * \brief Delete the juggeler_circuit on which the iterator is positioned
+   *
+   * Iteration may continue in either direction after the removal.  When we are
+   * walking backwards, _it is still positioned on the item being deleted, so it
+   * is first moved to the following item where previous() will pick up again.
    */
   void remove_current()
   {
     assert( !(_last == 0) );
     std::set<juggler_circuit_reference>::iterator  iter = _last_it;
+    if (_it == _last_it)
+      _it++;
     _jcs._jcs_set.erase(iter);
+    _last = 0;
   }
 
 
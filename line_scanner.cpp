@@ -0,0 +1,71 @@
+
+/*!
+ * \file line_scanner.cpp
+ *
+ * \brief Contains the implementation of line_scanner
+ *
+ * \author Stewart L. Palmer
+ */
+
+#include <string.h>
+#include "line_scanner.h"
+
+using namespace ::std;
+
+
+/*                                                                          */
+/****************************************************************************/
+/*     S P L I T                                                            */
+/****************************************************************************/
+/*                                                                          */
+void line_scanner::split(
+  const char             *data,    /*!< The text                            */
+  const size_t            size,    /*!< Number of characters                */
+  const unsigned int      wanted,  /*!< Number of pieces wanted             */
+  vector<const char *>   &starts)  /*!< Returned starts of the pieces       */
+{
+  const char *const end = data + size;
+  starts.clear();
+  starts.push_back(data);
+  const char *first = data;
+  for (unsigned int i = 1; (i <= wanted) && (first != end); i++)
+    {
+      const char *last = end;
+      if (i != wanted)
+        {
+          last = data + (size / wanted) * i;
+          if (last < first)
+            last = first;
+          const char *const nl = static_cast<const char *>(memchr(last, '\n', end - last));
+          last = (nl == 0) ? end : (nl + 1);
+        }
+      if (last == first)
+        continue;
+      starts.push_back(last);
+      first = last;
+    }
+}
+
+
+/*                                                                          */
+/****************************************************************************/
+/*     C O U N T _ L I N E S                                                */
+/****************************************************************************/
+/*                                                                          */
+unsigned int line_scanner::count_lines(
+  const char             *first,   /*!< First character                     */
+  const char             *last)    /*!< Just past the last character        */
+{
+  unsigned int lines = 0;
+  const char *p = first;
+  while (p != last)
+  {
+    const char *const nl = static_cast<const char *>(memchr(p, '\n', last - p));
+    if (nl == 0)
+      break;
+    lines++;
+    p = nl + 1;
+  }
+
+  return lines;
+}
@@ -0,0 +1,148 @@
+#ifndef line_scanner_h_included
+#define line_scanner_h_included 1
+
+/*!
+ * \file line_scanner.h
+ *
+ * \brief Contains the definition of line_scanner
+ *
+ * \author Stewart L. Palmer
+ */
+
+#include <vector>
+#include <stddef.h>
+#include <stdint.h>
+#include <ctype.h>
+
+
+/*!
+ * \brief Small helpers for scanning the lines of a file held in memory
+ *
+ * The programs that read whole instances or assignment files do not use
+ * regular expressions.  They cut the text into pieces that start at the
+ * beginning of a line, scan the pieces on several threads, and refer to names
+ * by pointing into the text rather than copying them.
+ */
+class line_scanner
+{
+public:
+
+  /*!
+   * \brief A piece of text, usually a name, in a file held in memory
+   */
+  struct span
+  {
+    //! First character
+    const char    *text;
+
+    //! Number of characters
+    unsigned int   size;
+  };
+
+
+  /*!
+   * \brief Split text into pieces that start at the beginning of a line
+   *
+   * On return, piece i is [starts[i], starts[i+1]); there are starts.size()-1
+   * pieces, and no piece is empty.
+   */
+  static void split(
+    const char             *data,  /*!< The text                            */
+    const size_t            size,  /*!< Number of characters                */
+    const unsigned int      wanted,/*!< Number of pieces wanted             */
+    std::vector<const char *> &starts/*!< Returned starts of the pieces      */
+                   );
+
+
+  /*!
+   * \brief Return the number of newlines in [first, last)
+   */
+  static unsigned int count_lines(
+    const char             *first, /*!< First character                     */
+    const char             *last   /*!< Just past the last character        */
+                                 );
+
+
+  /*!
+   * \brief Return true for the characters that separate tokens
+   */
+  static bool is_blank(
+    const char     c)              /*!< Character to test                   */
+  {
+    return ( (c == ' ') || (c == '\t') || (c == '\r') );
+  }
+
+
+  /*!
+   * \brief Return the next token of a line and move past it
+   *
+   * \return The length of the token, which is zero at the end of the line
+   */
+  static unsigned int next_token(
+    const char    *&p,             /*!< Current position, moved past token  */
+    const char    *const end,      /*!< End of the line                     */
+    const char    *&token)         /*!< Returned start of the token         */
+  {
+    while ( (p != end) && is_blank(*p) )
+      p++;
+    token = p;
+    while ( (p != end) && !is_blank(*p) )
+      p++;
+
+    return (p - token);
+  }
+
+
+  /*!
+   * \brief Parse a number that makes up all of the text
+   *
+   * \return Zero if the text is a number, non-zero otherwise
+   */
+  static int parse_number(
+    const char    *p,              /*!< First character                     */
+    const char    *const end,      /*!< Just past the last character        */
+    int           &value)          /*!< Returned number                     */
+  {
+    if (p == end)
+      return 1;
+    int n = 0;
+    while (p != end)
+    {
+      if ( !isdigit((unsigned char) *p) )
+        return 1;
+      n = 10 * n + (*p - '0');
+      p++;
+    }
+    value = n;
+
+    return 0;
+  }
+
+
+  /*!
+   * \brief Hash a name
+   */
+  static uint32_t hash(
+    const char          *text,     /*!< First character                     */
+    const unsigned int   size)     /*!< Number of characters                */
+  {
+    uint32_t h = 2166136261U;
+    for (unsigned int i = 0; i < size; i++)
+      {
+        h ^= (unsigned char) text[i];
+        h *= 16777619U;
+      }
+
+    return h;
+  }
+
+private:
+
+  /*!
+   * \brief There are no line_scanner objects, only its static functions
+   */
+  line_scanner();
+
+};
+
+#endif                             /* line_scanner_h_included               */
@@ -0,0 +1,65 @@
+
+/*!
+ * \file mapped_file.cpp
+ *
+ * \brief Contains the implementation of mapped_file
+ *
+ * \author Stewart L. Palmer
+ */
+
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <assert.h>
+#include "mapped_file.h"
+
+using namespace ::std;
+
+
+/*                                                                          */
+/****************************************************************************/
+/*     D E S T R U C T O R                                                  */
+/****************************************************************************/
+/*                                                                          */
+mapped_file::~mapped_file()
+{
+  if (_data != 0)
+    munmap(const_cast<char *>(_data), _size);
+}
+
+
+/*                                                                          */
+/****************************************************************************/
+/*     M A P                                                                */
+/****************************************************************************/
+/*                                                                          */
+int mapped_file::map(
+  const char    *file_name)        /*!< Name of file to map                 */
+{
+  assert(_data == 0);
+  _name = file_name;
+  const int fd = open(file_name, O_RDONLY);
+  if (fd < 0)
+    return 1;
+
+  int rc = 0;
+  struct stat st;
+  if (fstat(fd, &st) != 0)
+    rc = 1;
+  else if (st.st_size != 0)        /* An empty file maps to nothing         */
+    {
+      void *const p = mmap(0, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+      if (p == MAP_FAILED)
+        rc = 1;
+      else
+        {
+          madvise(p, st.st_size, MADV_SEQUENTIAL);
+          _data = static_cast<const char *>(p);
+          _size = st.st_size;
+        }
+    }
+  close(fd);
+
+  return rc;
+}
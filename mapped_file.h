@@ -0,0 +1,134 @@
+#ifndef mapped_file_h_included
+#define mapped_file_h_included 1
+
+/*!
+ * \file mapped_file.h
+ *
+ * \brief Contains the definition of mapped_file
+ *
+ * \author Stewart L. Palmer
+ */
+
+#include <iostream>
+#include <string>
+#include <stddef.h>
+
+
+/*!
+ * \brief A file mapped read only into memory
+ *
+ * Large input files are read much faster by mapping them than through a
+ * stream, and the mapped bytes can be parsed by many threads at once.  The file
+ * is unmapped when the object is destroyed.
+ */
+class mapped_file
+{
+public:
+
+  /*!
+   * \brief Standard constructor
+   */
+  mapped_file()
+  :
+  _data(0),
+  _size(0)
+  { }
+
+
+  /*!
+   * \brief Destructor, which unmaps the file
+   */
+  ~mapped_file();
+
+
+  /*!
+   * \brief Map a file into memory
+   *
+   * \return Zero if the file was mapped, non-zero if it could not be opened or
+   *         mapped
+   */
+  int map(
+    const char    *file_name       /*!< Name of file to map                 */
+         );
+
+
+  /*!
+   * \brief Return the first byte of the file
+   */
+  const char *data() const
+  { return _data; }
+
+
+  /*!
+   * \brief Return the size of the file in bytes
+   */
+  size_t size() const
+  { return _size; }
+
+
+  /*!
+   * \brief Return the name of the file
+   */
+  const std::string &name() const
+  { return _name; }
+
+
+  /*!
+   *  \brief Stream object out to a stream
+   *
+   * \return The same stream as the input to allow for chained operators.
+   */
+  friend std::ostream &operator<<(
+    std::ostream        &os,       /*!< The stream into which we stream     */
+    const mapped_file   &cn)       /*!< The object to be streamed           */
+  {
+    return cn.print_self(os);
+  }
+
+private:
+
+  /*!
+   * \brief The copy constructor is deliberately private and unimplemented.
+   *
+   * \param rhs the object from which we are to be constructed
+   */
+  mapped_file(
+    const mapped_file   &rhs);
+
+  /*!
+   * \brief operator=() is deliberately private and unimplemented.
+   *
+   * \param rhs the object from which we are to be assigned
+   *
+   * \return reference to self to allow for chained operators
+   */
+  mapped_file &operator=(
+    const mapped_file   &rhs);
+
+  /*!
+   * \brief This is the implementation function for operator<<()
+   *
+   * \return The same stream as the input to allow for chained operators.
+   */
+  std::ostream &print_self(
+    std::ostream    &os)           /*!< The stream into which we stream     */
+  const
+  {
+    os << _name << " (" << _size << " bytes)";
+
+    return os;
+  }
+
+
+  //! Name of the mapped file
+  std::string    _name;
+
+  //! The mapped bytes, or zero if nothing is mapped
+  const char    *_data;
+
+  //! Number of mapped bytes
+  size_t         _size;
+
+};
+
+#endif                             /* mapped_file_h_included                */
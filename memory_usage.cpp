@@ -0,0 +1,161 @@
+
+/*!
+ * \file memory_usage.cpp
+ *
+ * \brief Contains the implementation of memory_usage
+ *
+ * \author Stewart L. Palmer
+ */
+
+#include <algorithm>
+#include <stdio.h>
+#include <unistd.h>
+#include <sys/resource.h>
+#include "memory_usage.h"
+
+using namespace ::std;
+
+
+/*                                                                          */
+/****************************************************************************/
+/*     C O N S T R U C T O R                                                */
+/****************************************************************************/
+/*                                                                          */
+memory_usage::memory_usage()
+{
+  fill(_allocations, _allocations + subsystem_count, 0);
+  fill(_bytes, _bytes + subsystem_count, 0);
+}
+
+
+/*                                                                          */
+/****************************************************************************/
+/*     S U B S Y S T E M _ N A M E                                          */
+/****************************************************************************/
+/*                                                                          */
+const char *memory_usage::subsystem_name(
+  const subsystem      s)          /*!< The subsystem                       */
+{
+  static const char *const names[subsystem_count] =
+  {
+    "jugglers", "circuits", "juggler_circuits", "preferences", "names",
+    "name_maps", "rosters", "circuit_index", "scheduler_tables"
+  };
+
+  return names[s];
+}
+
+
+/*                                                                          */
+/****************************************************************************/
+/*     A D D _ S T R I N G                                                  */
+/****************************************************************************/
+/*                                                                          */
+void memory_usage::add_string(
+  const subsystem          s,      /*!< The subsystem                       */
+  const string            &str)    /*!< The string                          */
+{
+  // A string with the short string optimisation holds this many characters
+  // itself; a reference counted one holds none and adds a header to each
+  static const size_t inside = string().capacity();
+  if (str.capacity() <= inside)
+    return;
+
+  const size_t header = (inside == 0) ? 3 * sizeof(size_t) : 0;
+  add(s, 1, block_size(header + str.capacity() + 1));
+}
+
+
+/*                                                                          */
+/****************************************************************************/
+/*     T O T A L _ B Y T E S                                                */
+/****************************************************************************/
+/*                                                                          */
+uint64_t memory_usage::total_bytes() const
+{
+  uint64_t total = 0;
+  for (unsigned int s = 0; s < subsystem_count; s++)
+    total += _bytes[s];
+
+  return total;
+}
+
+
+/*                                                                          */
+/****************************************************************************/
+/*     P E A K _ R S S _ K B                                                */
+/****************************************************************************/
+/*                                                                          */
+uint64_t memory_usage::peak_rss_kb()
+{
+  struct rusage usage;
+  getrusage(RUSAGE_SELF, &usage);
+
+  // Linux gives kilobytes and Mac OS X bytes
+#ifdef __APPLE__
+  return usage.ru_maxrss / 1024;
+#else
+  return usage.ru_maxrss;
+#endif
+}
+
+
+/*                                                                          */
+/****************************************************************************/
+/*     C U R R E N T _ R S S _ K B                                          */
+/****************************************************************************/
+/*                                                                          */
+uint64_t memory_usage::current_rss_kb()
+{
+  uint64_t kb = 0;
+  FILE *const f = fopen("/proc/self/statm", "r");
+  if (f != 0)
+    {
+      unsigned long size = 0;
+      unsigned long resident = 0;
+      if (fscanf(f, "%lu %lu", &size, &resident) == 2)
+        kb = (uint64_t) resident * (sysconf(_SC_PAGESIZE) / 1024);
+      fclose(f);
+    }
+
+  return kb;
+}
+
+
+/*                                                                          */
+/****************************************************************************/
+/*     W R I T E _ R E P O R T                                              */
+/****************************************************************************/
+/*                                                                          */
+void memory_usage::write_report(
+  ostream              &os,        /*!< The stream for the report           */
+  const uint64_t        jugglers)  /*!< Number of jugglers                  */
+const
+{
+  const uint64_t total = total_bytes();
+  os << "{\"subsystems\":{";
+  for (unsigned int s = 0; s < subsystem_count; s++)
+    os << (s == 0 ? "" : ",") << "\"" << subsystem_name((subsystem) s) <<
+          "\":{\"allocations\":" << _allocations[s] << ",\"bytes\":" << _bytes[s] << "}";
+  os << "},\"total_bytes\":" << total <<
+        ",\"bytes_per_juggler\":" << ((jugglers != 0) ? (double) total / jugglers : 0.0) <<
+        ",\"current_rss_kb\":" << current_rss_kb() <<
+        ",\"peak_rss_kb\":" << peak_rss_kb() << "}";
+}
+
+
+/*                                                                          */
+/****************************************************************************/
+/*     P R I N T _ S E L F                                                  */
+/****************************************************************************/
+/*                                                                          */
+ostream &memory_usage::print_self(
+  ostream    &os)                  /*!< The stream into which we stream     */
+const
+{
+  os << "memory_usage: " << total_bytes() << " bytes";
+  for (unsigned int s = 0; s < subsystem_count; s++)
+    os << ", " << subsystem_name((subsystem) s) << " = " << _bytes[s];
+
+  return os;
+}
@@ -0,0 +1,277 @@
+#ifndef memory_usage_h_included
+#define memory_usage_h_included 1
+
+/*!
+ * \file memory_usage.h
+ *
+ * \brief Contains the definition of memory_usage
+ *
+ * \author Stewart L. Palmer
+ */
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <assert.h>
+#include <stddef.h>
+#include <stdint.h>
+
+
+/*!
+ * \brief The heap allocations of a scheduler, counted by subsystem
+ *
+ * scheduler::account_memory() walks every juggler, circuit and container and
+ * adds what each holds on the heap to the subsystem it belongs to.  Nothing is
+ * counted while solving, so there is no cost until a report is asked for.
+ * The bytes are what the allocator hands out: a red-black tree node is its
+ * value plus a colour and three links, a vector is its capacity, and a string
+ * allocates only when it is longer than fits inside it; each allocation is
+ * then rounded as glibc's malloc does, with its 8 byte header, to a multiple
+ * of 16 of at least 32.  Objects held by value inside another are part of it,
+ * not counted again.
+ *
+ * Comparing total_bytes() with the growth of the resident set shows what the
+ * accounting misses: allocator slack, freed memory not returned, and anything
+ * outside the scheduler.
+ */
+class memory_usage
+{
+public:
+
+  /*!
+   * \brief The subsystems to which allocations are charged
+   */
+  enum subsystem
+  {
+    juggler_objects,               /*!< The jugglers themselves             */
+    circuit_objects,               /*!< The circuits themselves             */
+    juggler_circuit_objects,       /*!< One per preference of each juggler  */
+    preference_vectors,            /*!< Each juggler's list of preferences  */
+    talent_names,                  /*!< Names of jugglers and circuits      */
+    name_maps,                     /*!< type_pointer_set maps by name       */
+    roster_sets,                   /*!< juggler_circuit_set rosters and
+                                        waitlists                           */
+    index_tables,                  /*!< The circuit_index                   */
+    scheduler_tables,              /*!< The scheduler's other vectors       */
+    subsystem_count                /*!< Number of subsystems                */
+  };
+
+
+  /*!
+   * \brief Standard constructor
+   */
+  memory_usage();
+
+
+  /*!
+   * \brief Return the name of a subsystem, as used in the report
+   */
+  static const char *subsystem_name(
+    const subsystem      s         /*!< The subsystem                       */
+                                   );
+
+
+  /*!
+   * \brief Return the bytes malloc hands out for a request
+   */
+  static size_t block_size(
+    const size_t         requested)/*!< Bytes requested                     */
+  {
+    const size_t block = (requested + 8 + 15) & ~((size_t) 15);
+
+    return (block < 32) ? 32 : block;
+  }
+
+
+  /*!
+   * \brief Charge allocations to a subsystem
+   */
+  void add(
+    const subsystem      s,        /*!< The subsystem                       */
+    const uint64_t       allocations,/*!< Number of allocations             */
+    const uint64_t       bytes)    /*!< Bytes they take                     */
+  {
+    assert(s < subsystem_count);
+    _allocations[s] += allocations;
+    _bytes[s] += bytes;
+  }
+
+
+  /*!
+   * \brief Charge one object allocated with new
+   */
+  void add_object(
+    const subsystem      s,        /*!< The subsystem                       */
+    const size_t         size)     /*!< sizeof the object                   */
+  { add(s, 1, block_size(size)); }
+
+
+  /*!
+   * \brief Charge the nodes of a std::map or std::set
+   */
+  template<typename Tree>
+  void add_tree(
+    const subsystem      s,        /*!< The subsystem                       */
+    const Tree          &tree)     /*!< The map or set                      */
+  {
+    const size_t node = sizeof(typename Tree::value_type) + tree_node_links;
+    add(s, tree.size(), (uint64_t) tree.size() * block_size(node));
+  }
+
+
+  /*!
+   * \brief Charge the buffer of a std::vector
+   */
+  template<typename T>
+  void add_vector(
+    const subsystem          s,    /*!< The subsystem                       */
+    const std::vector<T>    &v)    /*!< The vector                          */
+  {
+    if (v.capacity() != 0)
+      add(s, 1, block_size(v.capacity() * sizeof(T)));
+  }
+
+
+  /*!
+   * \brief Charge the buffer of a std::vector<bool>, a bit per element
+   */
+  void add_vector(
+    const subsystem            s,  /*!< The subsystem                       */
+    const std::vector<bool>   &v)  /*!< The vector                          */
+  {
+    if (v.capacity() != 0)
+      add(s, 1, block_size(v.capacity() / 8));
+  }
+
+
+  /*!
+   * \brief Charge the characters of a string, if they are not held inside it
+   */
+  void add_string(
+    const subsystem          s,    /*!< The subsystem                       */
+    const std::string       &str); /*!< The string                          */
+
+
+  /*!
+   * \brief Charge the key of a map, which only allocates if it is a string
+   */
+  template<typename K>
+  void add_key(
+    const subsystem,               /*!< The subsystem                       */
+    const K             &)         /*!< The key                             */
+  { }
+
+
+  /*!
+   * \brief Charge the characters of a string key
+   */
+  void add_key(
+    const subsystem          s,    /*!< The subsystem                       */
+    const std::string       &key)  /*!< The key                             */
+  { add_string(s, key); }
+
+
+  /*!
+   * \brief Return the number of allocations charged to a subsystem
+   */
+  uint64_t allocations(
+    const subsystem      s)        /*!< The subsystem                       */
+  const
+  { return _allocations[s]; }
+
+
+  /*!
+   * \brief Return the bytes charged to a subsystem
+   */
+  uint64_t bytes(
+    const subsystem      s)        /*!< The subsystem                       */
+  const
+  { return _bytes[s]; }
+
+
+  /*!
+   * \brief Return the bytes charged to every subsystem
+   */
+  uint64_t total_bytes() const;
+
+
+  /*!
+   * \brief Return the peak resident set of the process, in kilobytes
+   */
+  static uint64_t peak_rss_kb();
+
+
+  /*!
+   * \brief Return the resident set of the process now, in kilobytes, or zero
+   *        where it cannot be read
+   */
+  static uint64_t current_rss_kb();
+
+
+  /*!
+   * \brief Write everything as one JSON object
+   *
+   * It has the allocations and bytes of each subsystem, their total, the
+   * bytes per juggler, and the current and peak resident set.
+   */
+  void write_report(
+    std::ostream         &os,      /*!< The stream for the report           */
+    const uint64_t        jugglers /*!< Number of jugglers                  */
+                   )
+  const;
+
+
+  /*!
+   *  \brief Stream object out to a stream
+   *
+   * \return The same stream as the input to allow for chained operators.
+   */
+  friend std::ostream &operator<<(
+    std::ostream          &os,     /*!< The stream into which we stream     */
+    const memory_usage    &cn)     /*!< The object to be streamed           */
+  {
+    return cn.print_self(os);
+  }
+
+private:
+
+  /*!
+   * \brief The copy constructor is deliberately private and unimplemented.
+   *
+   * \param rhs the object from which we are to be constructed
+   */
+  memory_usage(
+    const memory_usage   &rhs);
+
+  /*!
+   * \brief operator=() is deliberately private and unimplemented.
+   *
+   * \param rhs the object from which we are to be assigned
+   *
+   * \return reference to self to allow for chained operators
+   */
+  memory_usage &operator=(
+    const memory_usage   &rhs);
+
+  /*!
+   * \brief This is the implementation function for operator<<()
+   *
+   * \return The same stream as the input to allow for chained operators.
+   */
+  std::ostream &print_self(
+    std::ostream    &os)           /*!< The stream into which we stream     */
+  const;
+
+
+  //! Bytes a red-black tree node takes besides its value: colour and links
+  static const size_t   tree_node_links = 4 * sizeof(void *);
+
+  //! Number of allocations charged to each subsystem
+  uint64_t              _allocations[subsystem_count];
+
+  //! Bytes charged to each subsystem
+  uint64_t              _bytes[subsystem_count];
+
+};
+
+#endif                             /* memory_usage_h_included               */
@@ -0,0 +1,83 @@
+
+/*!
+ * \file name_table.cpp
+ *
+ * \brief Contains the implementation of name_table
+ *
+ * \author Stewart L. Palmer
+ */
+
+#include <string.h>
+#include "name_table.h"
+
+using namespace ::std;
+
+
+/*                                                                          */
+/****************************************************************************/
+/*     R E S E T                                                            */
+/****************************************************************************/
+/*                                                                          */
+void name_table::reset()
+{
+  slot empty;
+  empty.hash = 0;
+  empty.index = -1;
+  _slots.assign(2 * _names.size() + 2, empty);
+}
+
+
+/*                                                                          */
+/****************************************************************************/
+/*     I N S E R T                                                          */
+/****************************************************************************/
+/*                                                                          */
+int name_table::insert(
+  const int              index)    /*!< Index of the name to add            */
+{
+  const span &name = _names[index];
+  const uint32_t hash = line_scanner::hash(name.text, name.size);
+  const unsigned int size = _slots.size();
+  unsigned int h = hash % size;
+  while (_slots[h].index >= 0)
+  {
+    const span &other = _names[_slots[h].index];
+    if ( (_slots[h].hash == hash) && (other.size == name.size) &&
+         (memcmp(other.text, name.text, name.size) == 0) )
+      return _slots[h].index;
+    h = (h + 1) % size;
+  }
+  _slots[h].hash = hash;
+  _slots[h].index = index;
+
+  return -1;
+}
+
+
+/*                                                                          */
+/****************************************************************************/
+/*     F I N D                                                              */
+/****************************************************************************/
+/*                                                                          */
+int name_table::find(
+  const span            &name)     /*!< The name to find                    */
+const
+{
+  const uint32_t hash = line_scanner::hash(name.text, name.size);
+  const unsigned int size = _slots.size();
+  if (size == 0)
+    return -1;
+  unsigned int h = hash % size;
+  while (_slots[h].index >= 0)
+  {
+    if (_slots[h].hash == hash)
+      {
+        const span &other = _names[_slots[h].index];
+        if ( (other.size == name.size) && (memcmp(other.text, name.text, name.size) == 0) )
+          return _slots[h].index;
+      }
+    h = (h + 1) % size;
+  }
+
+  return -1;
+}
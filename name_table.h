@@ -0,0 +1,139 @@
+#ifndef name_table_h_included
+#define name_table_h_included 1
+
+/*!
+ * \file name_table.h
+ *
+ * \brief Contains the definition of name_table
+ *
+ * \author Stewart L. Palmer
+ */
+
+#include <iostream>
+#include <vector>
+#include <stdint.h>
+#include "line_scanner.h"
+
+
+/*!
+ * \brief A hash table from names to their indexes in a vector of names
+ *
+ * The names themselves stay in the vector, which points into the text they came
+ * from, so the table holds only a hash and an index per slot.  It uses open
+ * addressing with linear probing and is sized for at most half full.  Once
+ * filled it is only read, so any number of threads may call find() at once.
+ */
+class name_table
+{
+public:
+
+  typedef line_scanner::span span;
+
+  /*!
+   * \brief Standard constructor
+   */
+  explicit name_table(
+    const std::vector<span>  &names)/*!< Names of the indexes               */
+  :
+  _names(names)
+  { }
+
+
+  /*!
+   * \brief Empty the table and size it for the names now in the vector
+   */
+  void reset();
+
+
+  /*!
+   * \brief Add a name to the table
+   *
+   * \return The index already in the table under that name, or -1 if the name
+   *         was added
+   */
+  int insert(
+    const int                 index/*!< Index of the name to add            */
+            );
+
+
+  /*!
+   * \brief Find a name in the table
+   *
+   * \return The index of the name, or -1 if it is not there
+   */
+  int find(
+    const span               &name /*!< The name to find                    */
+          )
+  const;
+
+
+  /*!
+   *  \brief Stream object out to a stream
+   *
+   * \return The same stream as the input to allow for chained operators.
+   */
+  friend std::ostream &operator<<(
+    std::ostream        &os,       /*!< The stream into which we stream     */
+    const name_table    &cn)       /*!< The object to be streamed           */
+  {
+    return cn.print_self(os);
+  }
+
+private:
+
+  /*!
+   * \brief One slot of the table
+   */
+  struct slot
+  {
+    //! Hash of the name, kept to skip most comparisons of the names
+    uint32_t       hash;
+
+    //! Index of the name, or -1 if the slot is empty
+    int            index;
+  };
+
+
+  /*!
+   * \brief The copy constructor is deliberately private and unimplemented.
+   *
+   * \param rhs the object from which we are to be constructed
+   */
+  name_table(
+    const name_table    &rhs);
+
+  /*!
+   * \brief operator=() is deliberately private and unimplemented.
+   *
+   * \param rhs the object from which we are to be assigned
+   *
+   * \return reference to self to allow for chained operators
+   */
+  name_table &operator=(
+    const name_table    &rhs);
+
+  /*!
+   * \brief This is the implementation function for operator<<()
+   *
+   * \return The same stream as the input to allow for chained operators.
+   */
+  std::ostream &print_self(
+    std::ostream    &os)           /*!< The stream into which we stream     */
+  const
+  {
+    os << "name_table: " << _slots.size() << " slots for " << _names.size() <<
+          " names";
+
+    return os;
+  }
+
+
+  //! Names of the indexes
+  const std::vector<span>    &_names;
+
+  //! The slots
+  std::vector<slot>           _slots;
+
+};
+
+#endif                             /* name_table_h_included                 */
@@ -0,0 +1,108 @@
+
+/*!
+ * \file output_buffer.cpp
+ *
+ * \brief Contains the implementation of output_buffer
+ *
+ * \author Stewart L. Palmer
+ */
+
+#include <errno.h>
+#include <unistd.h>
+#include "output_buffer.h"
+
+using namespace ::std;
+
+
+namespace
+{
+
+//! The two digit numbers 00 to 99, one after the other
+const char digit_pairs[] =
+  "00010203040506070809"
+  "10111213141516171819"
+  "20212223242526272829"
+  "30313233343536373839"
+  "40414243444546474849"
+  "50515253545556575859"
+  "60616263646566676869"
+  "70717273747576777879"
+  "80818283848586878889"
+  "90919293949596979899";
+
+}
+
+
+/*                                                                          */
+/****************************************************************************/
+/*     A P P E N D _ I N T                                                  */
+/****************************************************************************/
+/*                                                                          */
+void output_buffer::append_int(
+  const int       value)           /*!< The integer                         */
+{
+  // Fill a small buffer from the right, two digits at a time
+  char text[12];
+  char *p = text + sizeof(text);
+  unsigned int n = (value < 0) ? (0U - (unsigned int) value) : (unsigned int) value;
+  while (n >= 100)
+  {
+    const unsigned int pair = 2 * (n % 100);
+    n /= 100;
+    *--p = digit_pairs[pair + 1];
+    *--p = digit_pairs[pair];
+  }
+  if (n >= 10)
+    {
+      *--p = digit_pairs[2 * n + 1];
+      *--p = digit_pairs[2 * n];
+    }
+  else
+    *--p = '0' + n;
+  if (value < 0)
+    *--p = '-';
+  append(p, text + sizeof(text) - p);
+}
+
+
+/*                                                                          */
+/****************************************************************************/
+/*     W R I T E _ T O                                                      */
+/****************************************************************************/
+/*                                                                          */
+int output_buffer::write_to(
+  const int       fd)              /*!< File descriptor to write            */
+{
+  size_t done = 0;
+  while (done < _used)
+  {
+    const ssize_t n = write(fd, &_bytes[done], _used - done);
+    if (n < 0)
+      {
+        if (errno == EINTR)
+          continue;
+        return 1;
+      }
+    done += n;
+  }
+  _used = 0;
+
+  return 0;
+}
+
+
+/*                                                                          */
+/****************************************************************************/
+/*     G R O W                                                              */
+/****************************************************************************/
+/*                                                                          */
+void output_buffer::grow(
+  const size_t    size)            /*!< Number of bytes needed              */
+{
+  size_t wanted = 2 * _bytes.size();
+  if (wanted < 65536)
+    wanted = 65536;
+  if (wanted < (_used + size))
+    wanted = _used + size;
+  _bytes.resize(wanted);
+}
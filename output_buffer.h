@@ -0,0 +1,185 @@
+#ifndef output_buffer_h_included
+#define output_buffer_h_included 1
+
+/*!
+ * \file output_buffer.h
+ *
+ * \brief Contains the definition of output_buffer
+ *
+ * \author Stewart L. Palmer
+ */
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <stddef.h>
+#include <string.h>
+
+
+/*!
+ * \brief A growing buffer of bytes that is written to a file descriptor
+ *
+ * Writing the assignments through an ostream costs a formatted insertion for
+ * every name, colon and score, and there are millions of them.  This formats
+ * straight into memory instead, converting integers two digits at a time, and
+ * hands the bytes to the operating system in a few large writes.  Several
+ * buffers can be filled at once by different threads and then written in
+ * order.
+ */
+class output_buffer
+{
+public:
+
+  /*!
+   * \brief Standard constructor
+   */
+  explicit output_buffer()
+  :
+  _used(0)
+  { }
+
+
+  /*!
+   * \brief Append characters
+   */
+  void append(
+    const char     *text,          /*!< First character                     */
+    const size_t    size)          /*!< Number of characters                */
+  {
+    if ((_used + size) > _bytes.size())
+      grow(size);
+    memcpy(&_bytes[_used], text, size);
+    _used += size;
+  }
+
+
+  /*!
+   * \brief Append a null terminated string
+   */
+  void append(
+    const char     *text)          /*!< The string                          */
+  { append(text, strlen(text)); }
+
+
+  /*!
+   * \brief Append a string
+   */
+  void append(
+    const std::string  &text)      /*!< The string                          */
+  { append(text.data(), text.size()); }
+
+
+  /*!
+   * \brief Append one character
+   */
+  void append(
+    const char      c)             /*!< The character                       */
+  {
+    if (_used == _bytes.size())
+      grow(1);
+    _bytes[_used++] = c;
+  }
+
+
+  /*!
+   * \brief Append an integer in decimal
+   */
+  void append_int(
+    const int       value          /*!< The integer                         */
+                 );
+
+
+  /*!
+   * \brief Return the number of bytes in the buffer
+   */
+  size_t size() const
+  { return _used; }
+
+
+  /*!
+   * \brief Return the bytes in the buffer as a string
+   */
+  std::string str() const
+  { return std::string(_bytes.empty() ? "" : &_bytes[0], _used); }
+
+
+  /*!
+   * \brief Empty the buffer, keeping its memory
+   */
+  void clear()
+  { _used = 0; }
+
+
+  /*!
+   * \brief Write the buffer to a file descriptor and empty it
+   *
+   * \return Zero if every byte was written, non-zero otherwise
+   */
+  int write_to(
+    const int       fd             /*!< File descriptor to write            */
+              );
+
+
+  /*!
+   *  \brief Stream object out to a stream
+   *
+   * \return The same stream as the input to allow for chained operators.
+   */
+  friend std::ostream &operator<<(
+    std::ostream          &os,     /*!< The stream into which we stream     */
+    const output_buffer   &cn)     /*!< The object to be streamed           */
+  {
+    return cn.print_self(os);
+  }
+
+private:
+
+  /*!
+   * \brief The copy constructor is deliberately private and unimplemented.
+   *
+   * \param rhs the object from which we are to be constructed
+   */
+  output_buffer(
+    const output_buffer   &rhs);
+
+  /*!
+   * \brief operator=() is deliberately private and unimplemented.
+   *
+   * \param rhs the object from which we are to be assigned
+   *
+   * \return reference to self to allow for chained operators
+   */
+  output_buffer &operator=(
+    const output_buffer   &rhs);
+
+  /*!
+   * \brief This is the implementation function for operator<<()
+   *
+   * \return The same stream as the input to allow for chained operators.
+   */
+  std::ostream &print_self(
+    std::ostream    &os)           /*!< The stream into which we stream     */
+  const
+  {
+    os << "output_buffer: " << _used << " of " << _bytes.size() << " bytes used";
+
+    return os;
+  }
+
+
+  /*!
+   * \brief Make room for at least size more bytes
+   */
+  void grow(
+    const size_t    size);         /*!< Number of bytes needed              */
+
+
+  //! The memory of the buffer
+  std::vector<char>    _bytes;
+
+  //! Number of bytes in use
+  size_t               _used;
+
+};
+
+#endif                             /* output_buffer_h_included              */
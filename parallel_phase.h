@@ -0,0 +1,106 @@
+#ifndef parallel_phase_h_included
+#define parallel_phase_h_included 1
+
+/*!
+ * \file parallel_phase.h
+ *
+ * \brief Contains the definition of parallel_phase
+ *
+ * \author Stewart L. Palmer
+ */
+
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <stdint.h>
+#include "parallel_task.h"
+
+
+/*!
+ * \brief Runs a member function of an object over a range of items
+ *
+ * The member function is called once per worker with its range of the items
+ * and a stream of its own for diagnostics, and returns the number of problems
+ * it found.  The ranges are in order, so the reports joined in worker order
+ * read as if one thread had done all of the work.
+ */
+template <class T>
+class parallel_phase : public parallel_task
+{
+public:
+
+  //! Function run over a range of items by one worker
+  typedef uint64_t (T::*function)(
+    std::ostream          &os,
+    const unsigned int     first,
+    const unsigned int     last);
+
+
+  /*!
+   * \brief Standard constructor
+   */
+  explicit parallel_phase(
+    T                    &object,  /*!< Object whose function is run        */
+    const function        work)    /*!< The work of the phase               */
+  :
+  _object(object),
+  _work(work)
+  { }
+
+
+  /*!
+   * \brief Run the phase over count items and write the reports in order
+   *
+   * \return The number of problems found
+   */
+  uint64_t run_in_order(
+    const unsigned int    count,   /*!< Number of items                     */
+    const unsigned int    workers, /*!< Maximum number of worker threads    */
+    std::ostream         &os)      /*!< Stream for the reports              */
+  {
+    _reports.assign(workers, std::string());
+    _problems.assign(workers, 0);
+    const unsigned int used = run(count, workers);
+    uint64_t problems = 0;
+    for (unsigned int w = 0; w < used; w++)
+      {
+        os << _reports[w];
+        problems += _problems[w];
+      }
+
+    return problems;
+  }
+
+protected:
+
+  /*!
+   * \brief Run the phase over the items [first, last)
+   */
+  virtual void do_range(
+    const unsigned int   worker,
+    const unsigned int   first,
+    const unsigned int   last)
+  {
+    std::ostringstream  os;
+    _problems[worker] = (_object.*_work)(os, first, last);
+    _reports[worker] = os.str();
+  }
+
+private:
+
+  //! Object whose function is run
+  T                          &_object;
+
+  //! The work of the phase
+  const function              _work;
+
+  //! Diagnostics of each worker
+  std::vector<std::string>    _reports;
+
+  //! Number of problems found by each worker
+  std::vector<uint64_t>       _problems;
+
+};
+
+#endif                             /* parallel_phase_h_included             */
@@ -0,0 +1,141 @@
+
+/*!
+ * \file parallel_task.cpp
+ *
+ * \brief Contains the implementation of parallel_task
+ *
+ * \author Stewart L. Palmer
+ */
+
+#include <vector>
+#include <stdint.h>
+#include <unistd.h>
+#include "worker_pool.h"
+#include "parallel_task.h"
+
+using namespace ::std;
+
+
+namespace
+{
+
+/*!
+ * \brief One worker's share of a parallel_task
+ */
+struct task_range
+{
+  //! The task being run
+  parallel_task   *task;
+
+  //! Worker number
+  unsigned int     worker;
+
+  //! First item of the range
+  unsigned int     first;
+
+  //! Just past the last item of the range
+  unsigned int     last;
+};
+
+}
+
+
+/*                                                                          */
+/****************************************************************************/
+/*     R U N                                                                */
+/****************************************************************************/
+/*                                                                          */
+unsigned int parallel_task::run(
+  const unsigned int   count,      /*!< Number of items                     */
+  const unsigned int   workers)    /*!< Maximum number of worker threads    */
+{
+  unsigned int used = workers;
+  if (used > count)
+    used = count;
+  if (used <= 1)
+    {
+      if (count != 0)
+        {
+          if (_observer != 0)
+            _observer->run_starting(1);
+          run_range(0, 0, count);
+        }
+      return 1;
+    }
+
+  vector<task_range>   ranges(used);
+  for (unsigned int w = 0; w < used; w++)
+    {
+      task_range &r = ranges[w];
+      r.task = this;
+      r.worker = w;
+      r.first = (unsigned int) (((uint64_t) count * w) / used);
+      r.last  = (unsigned int) (((uint64_t) count * (w + 1)) / used);
+    }
+
+  // Worker zero runs on the calling thread, and so does any range the pool
+  // has no thread for
+  if (_observer != 0)
+    _observer->run_starting(used);
+  worker_pool   own_pool;
+  worker_pool  &pool = (_pool != 0) ? *_pool : own_pool;
+  vector<void *>  args(used - 1);
+  for (unsigned int w = 1; w < used; w++)
+    args[w - 1] = &ranges[w];
+  const unsigned int started = pool.start(thread_main, &args[0], used - 1);
+  run_range(0, ranges[0].first, ranges[0].last);
+  for (unsigned int w = 1 + started; w < used; w++)
+    run_range(w, ranges[w].first, ranges[w].last);
+  pool.wait();
+
+  return used;
+}
+
+
+/*                                                                          */
+/****************************************************************************/
+/*     A V A I L A B L E _ W O R K E R S                                    */
+/****************************************************************************/
+/*                                                                          */
+unsigned int parallel_task::available_workers()
+{
+  const long n = sysconf(_SC_NPROCESSORS_ONLN);
+  unsigned int workers = 1;
+  if (n > 1)
+    workers = n;
+
+  return workers;
+}
+
+
+/*                                                                          */
+/****************************************************************************/
+/*     R U N _ R A N G E                                                    */
+/****************************************************************************/
+/*                                                                          */
+void parallel_task::run_range(
+  const unsigned int   worker,     /*!< Worker number, from zero            */
+  const unsigned int   first,      /*!< First item of the range             */
+  const unsigned int   last)       /*!< Just past the last item             */
+{
+  if (_observer != 0)
+    _observer->worker_starting(worker);
+  do_range(worker, first, last);
+  if (_observer != 0)
+    _observer->worker_finished(worker);
+}
+
+
+/*                                                                          */
+/****************************************************************************/
+/*     T H R E A D _ M A I N                                                */
+/****************************************************************************/
+/*                                                                          */
+void *parallel_task::thread_main(
+  void    *arg)                    /*!< The range to run                    */
+{
+  task_range &r = *static_cast<task_range *>(arg);
+  r.task->run_range(r.worker, r.first, r.last);
+
+  return 0;
+}
@@ -0,0 +1,220 @@
+#ifndef parallel_task_h_included
+#define parallel_task_h_included 1
+
+/*!
+ * \file parallel_task.h
+ *
+ * \brief Contains the definition of parallel_task
+ *
+ * \author Stewart L. Palmer
+ */
+
+#include <iostream>
+
+class worker_pool;
+
+/*!
+ * \brief Told when the workers of a parallel_task start and finish
+ *
+ * worker_starting() and worker_finished() are called on the worker's own
+ * thread, around its do_range(), so an observer can measure that thread; the
+ * run_ calls are on the thread that called run().  Workers only ever touch the
+ * state of their own worker number.
+ */
+class parallel_observer
+{
+public:
+
+  /*!
+   * \brief Standard destructor
+   */
+  virtual ~parallel_observer()
+  { }
+
+
+  /*!
+   * \brief Called before any worker starts
+   */
+  virtual void run_starting(
+    const unsigned int   workers   /*!< Number of workers that will run     */
+                           ) = 0;
+
+
+  /*!
+   * \brief Called on a worker's thread before its range
+   */
+  virtual void worker_starting(
+    const unsigned int   worker    /*!< Worker number, from zero            */
+                              ) = 0;
+
+
+  /*!
+   * \brief Called on a worker's thread after its range
+   */
+  virtual void worker_finished(
+    const unsigned int   worker    /*!< Worker number, from zero            */
+                              ) = 0;
+
+};
+
+
+/*!
+ * \brief A loop over a range of items that is split among worker threads
+ *
+ * A child class supplies do_range(), which processes a contiguous range of the
+ * items.  run() cuts the items into one contiguous range per worker, runs each
+ * range on its own POSIX thread, and returns when they are all done.  The
+ * threads come from the worker_pool given to set_pool(), or else are created
+ * for the run and joined at its end; a range that gets no thread runs on the
+ * calling thread.  The
+ * ranges are assigned in order, so worker w always gets items before those of
+ * worker w+1.  That lets a child class keep per worker results and combine them
+ * in the original item order.
+ *
+ * With one worker, or fewer items than workers, everything runs on the calling
+ * thread.
+ */
+class parallel_task
+{
+public:
+
+  /*!
+   * \brief Standard constructor
+   */
+  explicit parallel_task()
+    :
+    _observer(0),
+    _pool(0)
+  { }
+
+
+  /*!
+   * \brief Standard destructor
+   */
+  virtual ~parallel_task()
+  { }
+
+
+  /*!
+   * \brief Process items [0, count) using up to the given number of workers
+   *
+   * \return The number of workers actually used
+   */
+  unsigned int run(
+    const unsigned int   count,    /*!< Number of items                     */
+    const unsigned int   workers   /*!< Maximum number of worker threads    */
+                  );
+
+
+  /*!
+   * \brief Set the observer told about each worker of later runs, or zero
+   *        for none
+   */
+  void set_observer(
+    parallel_observer   *observer) /*!< The observer, or zero               */
+  { _observer = observer; }
+
+
+  /*!
+   * \brief Set the pool whose threads run the workers of later runs, or zero
+   *        to create threads for each run
+   *
+   * The pool must outlive the runs.
+   */
+  void set_pool(
+    worker_pool         *pool)     /*!< The pool, or zero                   */
+  { _pool = pool; }
+
+
+  /*!
+   * \brief Return the number of processors available for worker threads
+   */
+  static unsigned int available_workers();
+
+
+  /*!
+   *  \brief Stream object out to a stream
+   *
+   * \return The same stream as the input to allow for chained operators.
+   */
+  friend std::ostream &operator<<(
+    std::ostream          &os,     /*!< The stream into which we stream     */
+    const parallel_task   &cn)     /*!< The object to be streamed           */
+  {
+    return cn.print_self(os);
+  }
+
+protected:
+
+  /*!
+   * \brief Process the items [first, last)
+   *
+   * This is called concurrently from several threads, each with a different
+   * worker number and a disjoint range.
+   */
+  virtual void do_range(
+    const unsigned int   worker,   /*!< Worker number, from zero            */
+    const unsigned int   first,    /*!< First item of the range             */
+    const unsigned int   last      /*!< Just past the last item             */
+                       ) = 0;
+
+  /*!
+   * \brief This is the implementation function for operator<<()
+   *
+   * \return The same stream as the input to allow for chained operators.
+   */
+  virtual std::ostream &print_self(
+    std::ostream    &os)           /*!< The stream into which we stream     */
+  const
+  {
+    os << "parallel_task";
+
+    return os;
+  }
+
+private:
+
+  /*!
+   * \brief The copy constructor is deliberately private and unimplemented.
+   *
+   * \param rhs the object from which we are to be constructed
+   */
+  parallel_task(
+    const parallel_task   &rhs);
+
+  /*!
+   * \brief operator=() is deliberately private and unimplemented.
+   *
+   * \param rhs the object from which we are to be assigned
+   *
+   * \return reference to self to allow for chained operators
+   */
+  parallel_task &operator=(
+    const parallel_task   &rhs);
+
+
+  /*!
+   * \brief Run one range, telling the observer
+   */
+  void run_range(
+    const unsigned int   worker,   /*!< Worker number, from zero            */
+    const unsigned int   first,    /*!< First item of the range             */
+    const unsigned int   last      /*!< Just past the last item             */
+                );
+
+  /*!
+   * \brief Thread entry point; runs one range of a parallel_task
+   */
+  static void *thread_main(
+    void    *arg);                 /*!< The range to run                    */
+
+
+  //! Told about each worker, or zero
+  parallel_observer   *_observer;
+
+  //! Threads for the workers, or zero
+  worker_pool         *_pool;
+
+};
+
+#endif                             /* parallel_task_h_included              */
@@ -0,0 +1,185 @@
+
+/*!
+ * \file perf_counters.cpp
+ *
+ * \brief Contains the implementation of perf_counters
+ *
+ * \author Stewart L. Palmer
+ */
+
+#include <errno.h>
+#include <string.h>
+#include <unistd.h>
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#endif
+#include "perf_counters.h"
+
+using namespace ::std;
+
+
+#ifdef __linux__
+namespace
+{
+
+/*!
+ * \brief Open one counter of the calling thread
+ *
+ * \return The file descriptor, or -1 with errno set
+ */
+int open_counter(
+  const uint32_t   type,           /*!< Type of the event                   */
+  const uint64_t   config,         /*!< The event                           */
+  const int        group)          /*!< Leader of the group, or -1          */
+{
+  struct perf_event_attr attr;
+  memset(&attr, 0, sizeof(attr));
+  attr.size = sizeof(attr);
+  attr.type = type;
+  attr.config = config;
+  attr.disabled = (group == -1) ? 1 : 0;
+  attr.exclude_kernel = 1;
+  attr.exclude_hv = 1;
+  attr.read_format = PERF_FORMAT_GROUP;
+
+  return (int) syscall(__NR_perf_event_open, &attr, 0, -1, group, 0);
+}
+
+}
+#endif
+
+
+/*                                                                          */
+/****************************************************************************/
+/*     C O N S T R U C T O R                                                */
+/****************************************************************************/
+/*                                                                          */
+perf_counters::perf_counters()
+  :
+  _leader(-1),
+  _opened(0)
+{
+  for (unsigned int c = 0; c < counter_count; c++)
+    {
+      _fd[c] = -1;
+      _slot[c] = -1;
+    }
+
+#ifdef __linux__
+  static const uint32_t types[counter_count] =
+  {
+    PERF_TYPE_HARDWARE, PERF_TYPE_HARDWARE, PERF_TYPE_HARDWARE,
+    PERF_TYPE_HARDWARE, PERF_TYPE_HW_CACHE, PERF_TYPE_SOFTWARE
+  };
+  static const uint64_t configs[counter_count] =
+  {
+    PERF_COUNT_HW_CPU_CYCLES, PERF_COUNT_HW_INSTRUCTIONS, PERF_COUNT_HW_CACHE_MISSES,
+    PERF_COUNT_HW_BRANCH_MISSES,
+    PERF_COUNT_HW_CACHE_DTLB | (PERF_COUNT_HW_CACHE_OP_READ << 8) |
+                               (PERF_COUNT_HW_CACHE_RESULT_MISS << 16),
+    PERF_COUNT_SW_TASK_CLOCK
+  };
+
+  for (unsigned int c = 0; c < counter_count; c++)
+    {
+      const int fd = open_counter(types[c], configs[c], _leader);
+      if (fd < 0)
+        {
+          if (_reason.empty())
+            _reason = string(counter_name((counter) c)) + ": " + strerror(errno);
+          continue;
+        }
+      if (_leader < 0)
+        _leader = fd;
+      _fd[c] = fd;
+      _slot[c] = _opened++;
+    }
+
+  if (_leader >= 0)
+    {
+      ioctl(_leader, PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+      ioctl(_leader, PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+    }
+#else
+  _reason = "perf_event_open is only on Linux";
+#endif
+}
+
+
+/*                                                                          */
+/****************************************************************************/
+/*     D E S T R U C T O R                                                  */
+/****************************************************************************/
+/*                                                                          */
+perf_counters::~perf_counters()
+{
+  // Members first, then the leader
+  for (unsigned int c = counter_count; c > 0; c--)
+    if (_fd[c - 1] >= 0)
+      close(_fd[c - 1]);
+}
+
+
+/*                                                                          */
+/****************************************************************************/
+/*     C O U N T E R _ N A M E                                              */
+/****************************************************************************/
+/*                                                                          */
+const char *perf_counters::counter_name(
+  const counter        c)          /*!< The counter                         */
+{
+  static const char *const names[counter_count] =
+  {
+    "cycles", "instructions", "llc_misses", "branch_misses", "dtlb_misses",
+    "task_clock_ns"
+  };
+
+  return names[c];
+}
+
+
+/*                                                                          */
+/****************************************************************************/
+/*     R E A D                                                              */
+/****************************************************************************/
+/*                                                                          */
+void perf_counters::read(
+  uint64_t             values[counter_count])/*!< Returned counts           */
+const
+{
+  for (unsigned int c = 0; c < counter_count; c++)
+    values[c] = 0;
+  if (_leader < 0)
+    return;
+
+  // The number of counters, then each count in the order they were opened
+  uint64_t group[1 + counter_count];
+  const ssize_t n = ::read(_leader, group, sizeof(group));
+  if ( (n < (ssize_t) sizeof(uint64_t)) || (group[0] != _opened) )
+    return;
+  for (unsigned int c = 0; c < counter_count; c++)
+    if (_slot[c] >= 0)
+      values[c] = group[1 + _slot[c]];
+}
+
+
+/*                                                                          */
+/****************************************************************************/
+/*     P R I N T _ S E L F                                                  */
+/****************************************************************************/
+/*                                                                          */
+ostream &perf_counters::print_self(
+  ostream    &os)                  /*!< The stream into which we stream     */
+const
+{
+  os << "perf_counters:";
+  for (unsigned int c = 0; c < counter_count; c++)
+    if (available((counter) c))
+      os << " " << counter_name((counter) c);
+  if ( !_reason.empty() )
+    os << " (" << _reason << ")";
+
+  return os;
+}
@@ -0,0 +1,164 @@
+#ifndef perf_counters_h_included
+#define perf_counters_h_included 1
+
+/*!
+ * \file perf_counters.h
+ *
+ * \brief Contains the definition of perf_counters
+ *
+ * \author Stewart L. Palmer
+ */
+
+#include <iostream>
+#include <string>
+#include <stdint.h>
+
+
+/*!
+ * \brief The hardware counters of the calling thread, read together
+ *
+ * On Linux these come from perf_event_open(2), opened as one group on the
+ * thread that constructs the object, counting only that thread in user mode.
+ * Any counter the processor, the kernel or perf_event_paranoid does not allow
+ * is left out, and on other systems they all are; read() gives zero for a
+ * counter that is left out, and available() tells which those are, so callers
+ * never have to treat a missing counter as an error.  The task clock is a
+ * software counter, so it is there on a virtual machine that hides the
+ * hardware ones.
+ *
+ * Each read() is one system call, so the counters should be read at the start
+ * and end of a phase, not around every small piece of work.
+ */
+class perf_counters
+{
+public:
+
+  /*!
+   * \brief The counters
+   */
+  enum counter
+  {
+    cycles,                        /*!< Processor cycles                    */
+    instructions,                  /*!< Instructions retired                */
+    llc_misses,                    /*!< Last level cache misses             */
+    branch_misses,                 /*!< Mispredicted branches               */
+    dtlb_misses,                   /*!< Data TLB read misses                */
+    task_clock,                    /*!< Nanoseconds on a processor          */
+    counter_count                  /*!< Number of counters                  */
+  };
+
+
+  /*!
+   * \brief Open the counters of the calling thread and start them
+   */
+  perf_counters();
+
+
+  /*!
+   * \brief Destructor, which closes the counters
+   */
+  ~perf_counters();
+
+
+  /*!
+   * \brief Return the name of a counter, as used in reports
+   */
+  static const char *counter_name(
+    const counter        c         /*!< The counter                         */
+                                 );
+
+
+  /*!
+   * \brief Return true if a counter could be opened
+   */
+  bool available(
+    const counter        c)        /*!< The counter                         */
+  const
+  { return (_slot[c] >= 0); }
+
+
+  /*!
+   * \brief Return true if any counter could be opened
+   */
+  bool any_available() const
+  { return (_leader >= 0); }
+
+
+  /*!
+   * \brief Return why the first counter that is left out could not be opened,
+   *        or an empty string if none is left out
+   */
+  const std::string &unavailable_reason() const
+  { return _reason; }
+
+
+  /*!
+   * \brief Read every counter, zero for those left out
+   *
+   * This must be called on the thread that constructed the object.
+   */
+  void read(
+    uint64_t             values[counter_count]/*!< Returned counts          */
+           ) const;
+
+
+  /*!
+   *  \brief Stream object out to a stream
+   *
+   * \return The same stream as the input to allow for chained operators.
+   */
+  friend std::ostream &operator<<(
+    std::ostream          &os,     /*!< The stream into which we stream     */
+    const perf_counters   &cn)     /*!< The object to be streamed           */
+  {
+    return cn.print_self(os);
+  }
+
+private:
+
+  /*!
+   * \brief The copy constructor is deliberately private and unimplemented.
+   *
+   * \param rhs the object from which we are to be constructed
+   */
+  perf_counters(
+    const perf_counters   &rhs);
+
+  /*!
+   * \brief operator=() is deliberately private and unimplemented.
+   *
+   * \param rhs the object from which we are to be assigned
+   *
+   * \return reference to self to allow for chained operators
+   */
+  perf_counters &operator=(
+    const perf_counters   &rhs);
+
+  /*!
+   * \brief This is the implementation function for operator<<()
+   *
+   * \return The same stream as the input to allow for chained operators.
+   */
+  std::ostream &print_self(
+    std::ostream    &os)           /*!< The stream into which we stream     */
+  const;
+
+
+  //! File descriptor of the group leader, or -1 if nothing could be opened
+  int                 _leader;
+
+  //! File descriptor of each counter, or -1 if it is left out
+  int                 _fd[counter_count];
+
+  //! Position of each counter in a read of the group, or -1
+  int                 _slot[counter_count];
+
+  //! Number of counters in the group
+  unsigned int        _opened;
+
+  //! Why the first counter left out could not be opened
+  std::string         _reason;
+
+};
+
+#endif                             /* perf_counters_h_included              */
@@ -7,117 +7,1180 @@
  * \author Stewart L. Palmer
  */
 
+#include <algorithm>
+#include <climits>
 #include <fstream>
+#include <sstream>
+#include <string.h>
+#include <sys/time.h>
 #include "juggler_circuit.h"
 #include "circuit_set_iterator.h"
 #include "juggler_set_iterator.h"
 #include "juggler_circuit_set_iterator.h"
+#include "auction_engine.h"
+#include "parallel_task.h"
+#include "output_buffer.h"
+#include "assignment_record.h"
 #include "scheduler.h"
 
 using namespace ::std;
 
+
+/*!
+ * \brief Return the time of day in seconds
+ */
+static double now()
+{
+  struct timeval tv;
+  gettimeofday(&tv, 0);
+
+  return (tv.tv_sec + tv.tv_usec / 1000000.0);
+}
+
+
+/*!
+ * \brief Orders talents by name, as the juggler and circuit sets do
+ */
+template <class T>
+static bool by_name(
+  T     *lhs,                      /*!< Left hand side of comparison        */
+  T     *rhs)                      /*!< Right hand side of comparison       */
+{
+  return (lhs->name() < rhs->name());
+}
+
+
+/*!
+ * \brief Return the score a juggler must beat to get into a circuit
+ *
+ * Any juggler that prefers a circuit with a vacancy is a better fit there.
+ */
+static int cutoff(
+  const circuit   &circ)           /*!< The circuit                         */
+{
+  return circ.is_full() ? circ.lowest_score() : INT_MIN;
+}
+
+
+/*!
+ * \brief Return true if any of the talents is negative
+ *
+ * The circuit index bounds its search on talents of zero or more.
+ */
+static bool has_negative(
+  const talent_definition   &talents)/*!< The talents                      */
+{
+  return (talents.hand < 0) || (talents.endurance < 0) || (talents.pizzazz < 0);
+}
+
+
+/*!
+ * \brief Validates the assignments of a range of jugglers
+ *
+ * Each worker writes its diagnostics into its own report.  The ranges are in
+ * order, so the reports joined in worker order read the same as a validation
+ * done on one thread.
+ */
+class assignment_validator : public parallel_task
+{
+public:
+
+  /*!
+   * \brief Standard constructor
+   */
+  explicit assignment_validator(
+    const vector<const juggler *>  &jugglers,/*!< Jugglers to validate      */
+    const vector<int>              &lowest,/*!< Lowest score of each circuit*/
+    const unsigned int              workers)/*!< Maximum number of workers  */
+  :
+  _jugglers(jugglers),
+  _lowest(lowest),
+  _reports(workers),
+  _failed(workers, 0)
+  { }
+
+
+  /*!
+   * \brief Return the diagnostics written by one worker
+   */
+  const string &report(
+    const unsigned int   worker)   /*!< Worker number                       */
+  const
+  { return _reports[worker]; }
+
+
+  /*!
+   * \brief Return true if one worker found a problem
+   */
+  bool failed(
+    const unsigned int   worker)   /*!< Worker number                       */
+  const
+  { return (_failed[worker] != 0); }
+
+protected:
+
+  /*!
+   * \brief Validate the jugglers [first, last)
+   */
+  virtual void do_range(
+    const unsigned int   worker,
+    const unsigned int   first,
+    const unsigned int   last)
+  {
+    ostringstream  os;
+    for (unsigned int i = first; i < last; i++)
+      {
+        const int lrc = _jugglers[i]->validate_assignment(os, _lowest);
+        if (lrc != 0)
+          _failed[worker] = 1;
+      }
+    _reports[worker] = os.str();
+  }
+
+private:
+
+  //! Jugglers to validate, in the order their diagnostics are wanted
+  const vector<const juggler *>   &_jugglers;
+
+  //! Lowest score of each circuit, by circuit index
+  const vector<int>               &_lowest;
+
+  //! Diagnostics of each worker
+  vector<string>                   _reports;
+
+  //! True for each worker that found a problem
+  vector<int>                      _failed;
+
+};
+
+
+/*!
+ * \brief Append a CSV field, quoted only if it has to be
+ */
+static void append_csv_field(
+  output_buffer   &ob,             /*!< Buffer for the field                */
+  const string    &field)          /*!< Text of the field                   */
+{
+  if (field.find_first_of(",\"\n") == string::npos)
+    {
+      ob.append(field);
+      return;
+    }
+  ob.append('"');
+  for (unsigned int i = 0; i < field.size(); i++)
+    {
+      if (field[i] == '"')
+        ob.append('"');
+      ob.append(field[i]);
+    }
+  ob.append('"');
+}
+
+
+/*!
+ * \brief Append a JSON string
+ */
+static void append_json_string(
+  output_buffer   &ob,             /*!< Buffer for the string               */
+  const string    &text)           /*!< Text of the string                  */
+{
+  static const char hex[] = "0123456789abcdef";
+  ob.append('"');
+  for (unsigned int i = 0; i < text.size(); i++)
+    {
+      const unsigned char c = text[i];
+      if ( (c == '"') || (c == '\\') )
+        {
+          ob.append('\\');
+          ob.append((char) c);
+        }
+      else if (c < 0x20)
+        {
+          ob.append("\\u00");
+          ob.append(hex[c >> 4]);
+          ob.append(hex[c & 0xf]);
+        }
+      else
+        ob.append((char) c);
+    }
+  ob.append('"');
+}
+
+
+/*!
+ * \brief Formats the assignments of a range of circuits
+ *
+ * Each worker formats into its own buffer for each format.  The ranges are in
+ * order, so the buffers written in worker order read the same as if one thread
+ * had formatted everything.  A writer is run once per batch of circuits,
+ * starting at the circuit given by set_first().  Binary records go straight
+ * into one array indexed by juggler, since no two workers share a juggler.
+ */
+class assignment_writer : public parallel_task
+{
+public:
+
+  /*!
+   * \brief Standard constructor
+   */
+  explicit assignment_writer(
+    const vector<const circuit *>  &circuits,/*!< Circuits, in output order */
+    const vector<scheduler::output_format> &formats,/*!< Formats to write   */
+    vector<assignment_record>      &records,/*!< Binary record per juggler  */
+    const unsigned int              workers)/*!< Maximum number of workers  */
+  :
+  _circuits(circuits),
+  _formats(formats),
+  _records(records),
+  _first(0),
+  _workers(workers),
+  _by_juggler(false),
+  _buffers(formats.size() * workers, (output_buffer *) 0)
+  {
+    for (unsigned int b = 0; b < _buffers.size(); b++)
+      _buffers[b] = new output_buffer();
+    for (unsigned int f = 0; f < formats.size(); f++)
+      if (formats[f] != scheduler::text_output)
+        _by_juggler = true;
+  }
+
+
+  /*!
+   * \brief Destructor
+   */
+  virtual ~assignment_writer()
+  {
+    for (unsigned int b = 0; b < _buffers.size(); b++)
+      delete _buffers[b];
+  }
+
+
+  /*!
+   * \brief Set the circuit that item zero of the next run stands for
+   */
+  void set_first(
+    const unsigned int   first)    /*!< Index of the first circuit          */
+  { _first = first; }
+
+
+  /*!
+   * \brief Return the text formatted by one worker in one format
+   */
+  output_buffer &buffer(
+    const unsigned int   format,   /*!< Index into the formats              */
+    const unsigned int   worker)   /*!< Worker number                       */
+  { return *_buffers[format * _workers + worker]; }
+
+protected:
+
+  /*!
+   * \brief Format the circuits [_first+first, _first+last)
+   */
+  virtual void do_range(
+    const unsigned int   worker,
+    const unsigned int   first,
+    const unsigned int   last)
+  {
+    vector<const juggler_circuit *> assigned;
+    for (unsigned int i = first; i < last; i++)
+      {
+        const circuit &circ = *_circuits[_first + i];
+        for (unsigned int f = 0; f < _formats.size(); f++)
+          if (_formats[f] == scheduler::text_output)
+            {
+              output_buffer &ob = buffer(f, worker);
+              circ.show_assignments(ob);
+              ob.append('\n');
+            }
+        if ( !_by_juggler )
+          continue;
+
+        assigned.clear();
+        circ.assigned_jugglers(assigned);
+        for (unsigned int a = 0; a < assigned.size(); a++)
+          for (unsigned int f = 0; f < _formats.size(); f++)
+            write_juggler(*assigned[a], _formats[f], buffer(f, worker));
+      }
+  }
+
+private:
+
+  /*!
+   * \brief Format the assignment of one juggler in one of the formats that
+   *        are written by juggler
+   */
+  void write_juggler(
+    const juggler_circuit           &jc,/*!< The assignment                 */
+    const scheduler::output_format   format,/*!< Format to write            */
+    output_buffer                   &ob)/*!< Buffer for the format          */
+  {
+    switch (format)
+    {
+      case scheduler::csv_output:
+        append_csv_field(ob, jc.juggler_name());
+        ob.append(',');
+        append_csv_field(ob, jc.circuit_name());
+        ob.append(',');
+        ob.append_int(jc.score());
+        ob.append(',');
+        ob.append_int(jc.preference());
+        ob.append('\n');
+        break;
+      case scheduler::json_lines_output:
+        ob.append("{\"juggler\":");
+        append_json_string(ob, jc.juggler_name());
+        ob.append(",\"circuit\":");
+        append_json_string(ob, jc.circuit_name());
+        ob.append(",\"score\":");
+        ob.append_int(jc.score());
+        ob.append(",\"preference\":");
+        ob.append_int(jc.preference());
+        ob.append("}\n");
+        break;
+      case scheduler::binary_output:
+        {
+          assignment_record &r = _records[jc.jug().index()];
+          r.circuit = jc.circ().index();
+          r.score = jc.score();
+          r.preference = jc.preference();
+        }
+        break;
+      default:
+        break;
+    }
+  }
+
+
+  //! Circuits, in the order they are written
+  const vector<const circuit *>           &_circuits;
+
+  //! Formats to write
+  const vector<scheduler::output_format>  &_formats;
+
+  //! Binary record of each juggler, by juggler index
+  vector<assignment_record>               &_records;
+
+  //! Index of the first circuit of the batch
+  unsigned int                             _first;
+
+  //! Maximum number of workers
+  unsigned int                             _workers;
+
+  //! True if any format is written juggler by juggler
+  bool                                     _by_juggler;
+
+  //! Text formatted by each worker in each format, format major
+  vector<output_buffer *>                  _buffers;
+
+};
+
+
+/*                                                                          */
+/****************************************************************************/
+/*     C O N S T R U C T O R                                                */
+/****************************************************************************/
+/*                                                                          */
+scheduler::scheduler(
+  const char  *file_name)          /*!< Name of input file                  */
+  :
+  _file_name(file_name),
+  _capacity(0),
+  _withdrawn_count(0),
+  _waitlist_size(0),
+  _worker_count(parallel_task::available_workers()),
+  _time_budget(0.0),
+  _progress(0),
+  _progress_interval(1.0),
+  _start_time(0.0),
+  _next_sample(0.0),
+  _trace(0),
+  _pending_count(0),
+  _out_of_time(false),
+  _clock_running(false),
+  _validation_round(0)
+{
+  scheduler_stats::phase_scope scope(_stats, scheduler_stats::parse_phase);
+  double span_start = (_stats.spans() != 0) ? _stats.spans()->now() : 0.0;
+  double scored = 0.0;
+  unsigned int definitions = 0;
+  {
+    ifstream inp(file_name);
+    char   line[4096];
+    int line_no = 1;
+
+    inp.getline(line, sizeof(line));
+    while (inp.good())
+    {
+      const char type = toupper(line[0]);
+      const string definition(line);
+      if (type == 'C')
+        {
+          circuit *const c = new circuit(*this, definition);
+          circuit &crs = *c;
+          crs.set_index(_circuits.size());
+          _circuits.add(crs);
+        }
+      else if (type == 'J')
+        {
+          juggler *const j = new juggler(*this, definition, _circuits);
+          juggler &jug = *j;
+          jug.set_index(_jugglers.size());
+          _jugglers.add(jug);
+        }
+      else
+        {
+          if (definition.size() != 0)
+            {
+              cout << __FILE__ << ":" << __LINE__ << ": " <<
+                      "Do not understand line " << line_no << ": <" << definition << ">" << endl;
+            }
+        }
+      if ( (_stats.spans() != 0) && (++definitions == span_batch) )
+        end_parse_span(span_start, scored, definitions);
+      inp.getline(line, sizeof(line));
+      line_no++;
+    }
+    assert((juggler_count() % circuit_count()) == 0);
+  }
+  _capacity = juggler_count() / circuit_count();
+  _circuit_index.build(_circuits);
+  end_parse_span(span_start, scored, definitions);
+}
+
+
+/*                                                                          */
+/****************************************************************************/
+/*     C O N S T R U C T O R                                                */
+/****************************************************************************/
+/*                                                                          */
+scheduler::scheduler(
+  const festival_definition  &definition)/*!< The festival                 */
+  :
+  _file_name(),
+  _capacity(0),
+  _withdrawn_count(0),
+  _waitlist_size(0),
+  _worker_count(parallel_task::available_workers()),
+  _time_budget(0.0),
+  _progress(0),
+  _progress_interval(1.0),
+  _start_time(0.0),
+  _next_sample(0.0),
+  _trace(0),
+  _pending_count(0),
+  _out_of_time(false),
+  _clock_running(false),
+  _validation_round(0)
+{
+  scheduler_stats::phase_scope scope(_stats, scheduler_stats::parse_phase);
+  double span_start = (_stats.spans() != 0) ? _stats.spans()->now() : 0.0;
+  double scored = 0.0;
+  unsigned int definitions = 0;
+
+  vector<circuit *> circuits(definition.circuits.size(), (circuit *) 0);
+  for (unsigned int i = 0; i < circuits.size(); i++)
+    {
+      const talent_definition &t = definition.circuits[i];
+      ostringstream name;
+      name << "C" << i;
+      circuit *const c = new circuit(*this, name.str(), t.hand, t.endurance, t.pizzazz);
+      circuit &crs = *c;
+      crs.set_index(i);
+      _circuits.add(crs);
+      circuits[i] = c;
+    }
+
+  vector<circuit *> preferred;
+  unsigned int next = 0;
+  for (unsigned int i = 0; i < definition.jugglers.size(); i++)
+    {
+      const talent_definition &t = definition.jugglers[i];
+      preferred.clear();
+      for (unsigned int p = 0; p < definition.preference_counts[i]; p++)
+        preferred.push_back(circuits[definition.preferences[next++]]);
+      ostringstream name;
+      name << "J" << i;
+      juggler *const j = new juggler(*this, name.str(), t.hand, t.endurance, t.pizzazz, preferred);
+      juggler &jug = *j;
+      jug.set_index(i);
+      _jugglers.add(jug);
+      if ( (_stats.spans() != 0) && (++definitions == span_batch) )
+        end_parse_span(span_start, scored, definitions);
+    }
+  _capacity = juggler_count() / circuit_count();
+  _circuit_index.build(_circuits);
+  end_parse_span(span_start, scored, definitions);
+}
+
+
+/*                                                                          */
+/****************************************************************************/
+/*     D E S T R U C T O R                                                  */
+/****************************************************************************/
+/*                                                                          */
+scheduler::~scheduler()
+{
+  juggler_set_iterator   jit(_jugglers);
+  for (juggler *j = jit.next(); j != 0; j = jit.next())
+    delete j;
+  circuit_set_iterator   cit(_circuits);
+  for (circuit *c = cit.next(); c != 0; c = cit.next())
+    delete c;
+}
+
+
+/*                                                                          */
+/****************************************************************************/
+/*     C R E A T E                                                          */
+/****************************************************************************/
+/*                                                                          */
+int scheduler::create(
+  const festival_definition  &definition,/*!< The festival                 */
+  ostream                    &os,  /*!< Stream for error reporting          */
+  scheduler                 *&sched)/*!< Returned scheduler, or zero        */
+{
+  sched = 0;
+  const int rc = check_definition(definition, os);
+  if (rc != 0)
+    return rc;
+  sched = new scheduler(definition);
+
+  return 0;
+}
+
+
+/*                                                                          */
+/****************************************************************************/
+/*     C H E C K _ D E F I N I T I O N                                      */
+/****************************************************************************/
+/*                                                                          */
+int scheduler::check_definition(
+  const festival_definition  &definition,/*!< The festival                 */
+  ostream                    &os)  /*!< Stream for error reporting          */
+{
+  const unsigned int circuits = definition.circuits.size();
+  const unsigned int jugglers = definition.jugglers.size();
+  if (circuits == 0)
+    {
+      os << "The festival has no circuits." << endl;
+      return 1;
+    }
+  if ((jugglers % circuits) != 0)
+    {
+      os << jugglers << " jugglers cannot be shared among " << circuits <<
+            " circuits." << endl;
+      return 1;
+    }
+  if (definition.preference_counts.size() != jugglers)
+    {
+      os << "There are " << definition.preference_counts.size() <<
+            " preference counts for " << jugglers << " jugglers." << endl;
+      return 1;
+    }
+
+  int rc = 0;
+  for (unsigned int c = 0; c < circuits; c++)
+    if (has_negative(definition.circuits[c]))
+      {
+        os << "Circuit C" << c << " has a negative talent." << endl;
+        rc = 1;
+      }
+  for (unsigned int j = 0; j < jugglers; j++)
+    if (has_negative(definition.jugglers[j]))
+      {
+        os << "Juggler J" << j << " has a negative talent." << endl;
+        rc = 1;
+      }
+
+  unsigned int next = 0;
+  vector<unsigned int> listed_by(circuits, jugglers);
+  for (unsigned int j = 0; j < jugglers; j++)
+    {
+      const unsigned int count = definition.preference_counts[j];
+      if (count > (definition.preferences.size() - next))
+        {
+          os << "Juggler J" << j << " has preferences beyond the end." << endl;
+          return 1;
+        }
+      for (unsigned int p = 0; p < count; p++)
+        {
+          const unsigned int c = definition.preferences[next++];
+          if (c >= circuits)
+            {
+              os << "Juggler J" << j << " prefers circuit " << c <<
+                    ", which does not exist." << endl;
+              rc = 1;
+            }
+          else if (listed_by[c] == j)
+            {
+              os << "Juggler J" << j << " lists C" << c << " twice." << endl;
+              rc = 1;
+            }
+          else
+            listed_by[c] = j;
+        }
+    }
+  if (next != definition.preferences.size())
+    {
+      os << (definition.preferences.size() - next) <<
+            " preferences belong to no juggler." << endl;
+      rc = 1;
+    }
+
+  return rc;
+}
+
+
+/*                                                                          */
+/****************************************************************************/
+/*     A S S I G N                                                          */
+/****************************************************************************/
+/*                                                                          */
+void scheduler::assign()
+{
+  _start_time = now();
+  _next_sample = _progress_interval;
+  {
+    scheduler_stats::phase_scope scope(_stats, scheduler_stats::propose_phase);
+    _clock_running = true;
+    do_assignments();
+    _clock_running = false;
+  }
+  if (_progress != 0)
+    show_progress(now() - _start_time);
+  if (orphan_juggler_count() != 0)
+    distribute_orphans();
+
+  // Writing the assignments walks every roster once, in order
+  if (_trace != 0)
+    for (unsigned int c = 0; c < circuit_count(); c++)
+      _trace->record_roster(container_trace::roster_iterate, c, 0);
+}
+
+
+/*                                                                          */
+/****************************************************************************/
+/*     A S S I G N _ M A X _ S C O R E                                      */
+/****************************************************************************/
+/*                                                                          */
+void scheduler::assign_max_score()
+{
+  scheduler_stats::phase_scope scope(_stats, scheduler_stats::propose_phase);
+  vector<juggler *>   jugglers;
+  vector<circuit *>   circuits;
+  jugglers_by_index(jugglers);
+  circuits_by_index(circuits);
+
+  auction_engine   engine(jugglers, circuits, jugglers_per_circuit());
+  engine.solve(worker_count());
+
+  for (unsigned int j = 0; j < jugglers.size(); j++)
+    {
+      juggler &jug = *jugglers[j];
+      assert( !jug.is_assigned() );
+      const juggler_circuit *const jcp = engine.assignment(j);
+      if (jcp == 0)
+        add_orphaned_juggler(jug);
+      else
+        {
+          const juggler_circuit &jc = *jcp;
+          jc.circ().assign_juggler(jc);
+        }
+    }
+  _circuit_index.refresh();        /* Circuits filled in bulk               */
+  if (orphan_juggler_count() != 0)
+    distribute_orphans();
+}
+
+
+/*                                                                          */
+/****************************************************************************/
+/*     A S S I G N _ S T A B L E                                            */
+/****************************************************************************/
+/*                                                                          */
+void scheduler::assign_stable(
+  const stable_lattice::choice   which,/*!< The stable assignment wanted    */
+  ostream                       &os)/*!< Stream for the summary             */
+{
+  scheduler_stats::phase_scope scope(_stats, scheduler_stats::propose_phase);
+  vector<juggler *>   jugglers;
+  vector<circuit *>   circuits;
+  jugglers_by_index(jugglers);
+  circuits_by_index(circuits);
+
+  stable_lattice   lattice(jugglers, circuits, jugglers_per_circuit());
+  vector<int>      preference;
+  lattice.matching(which, preference);
+  os << lattice << ", sum of ranks = " << lattice.cost(preference) <<
+        ", regret = " << lattice.regret(preference) << endl;
+
+  for (unsigned int j = 0; j < jugglers.size(); j++)
+    {
+      juggler &jug = *jugglers[j];
+      assert( !jug.is_assigned() );
+      if (preference[j] < 0)
+        add_orphaned_juggler(jug);
+      else
+        {
+          const juggler_circuit &jc = jug.request(preference[j]);
+          jc.circ().assign_juggler(jc);
+        }
+    }
+  _circuit_index.refresh();        /* Circuits filled in bulk               */
+  if (orphan_juggler_count() != 0)
+    distribute_orphans();
+}
+
+
+/*                                                                          */
+/****************************************************************************/
+/*     A S S I G N M E N T _ R E C O R D S                                  */
+/****************************************************************************/
+/*                                                                          */
+void scheduler::assignment_records(
+  vector<assignment_record> &records)
+{
+  assignment_record none;
+  none.circuit = -1;
+  none.score = 0;
+  none.preference = 0;
+  records.assign(juggler_count(), none);
+
+  juggler_set_iterator   jit(_jugglers);
+  const juggler *j = jit.next();
+  while (j != 0)
+  {
+    const juggler &jug = *j;
+    if (jug.is_assigned())
+      {
+        const juggler_circuit &jc = jug.assignment();
+        assignment_record &r = records[jug.index()];
+        r.circuit = jc.circ().index();
+        r.score = jc.score();
+        r.preference = jc.preference();
+      }
+    j = jit.next();
+  }
+}
+
+
+/*                                                                          */
+/****************************************************************************/
+/*     T O T A L _ S C O R E                                                */
+/****************************************************************************/
+/*                                                                          */
+int64_t scheduler::total_score()
+{
+  int64_t total = 0;
+  juggler_set_iterator   jit(_jugglers);
+  const juggler *j = jit.next();
+  while (j != 0)
+  {
+    const juggler &jug = *j;
+    if (jug.is_assigned())
+      total += jug.assignment().score();
+    j = jit.next();
+  }
+
+  return total;
+}
+
+
+/*                                                                          */
+/****************************************************************************/
+/*     J U G G L E R S _ B Y _ I N D E X                                    */
+/****************************************************************************/
+/*                                                                          */
+void scheduler::jugglers_by_index(
+  vector<juggler *>    &jugglers)
+{
+  jugglers.assign(juggler_count(), (juggler *) 0);
+  juggler_set_iterator   jit(_jugglers);
+  juggler *j = jit.next();
+  while (j != 0)
+  {
+    jugglers[j->index()] = j;
+    j = jit.next();
+  }
+}
+
+
+/*                                                                          */
+/****************************************************************************/
+/*     C I R C U I T S _ B Y _ I N D E X                                    */
+/****************************************************************************/
+/*                                                                          */
+void scheduler::circuits_by_index(
+  vector<circuit *>    &circuits)
+{
+  circuits.assign(circuit_count(), (circuit *) 0);
+  circuit_set_iterator   cit(_circuits);
+  circuit *c = cit.next();
+  while (c != 0)
+  {
+    circuits[c->index()] = c;
+    c = cit.next();
+  }
+}
+
+
+/*                                                                          */
+/****************************************************************************/
+/*     D O _ A S S I G N M E N T S                                          */
+/****************************************************************************/
+/*                                                                          */
+void scheduler::do_assignments()
+{
+  span_trace *const spans = _stats.spans();
+  double span_start = (spans != 0) ? spans->now() : 0.0;
+  uint64_t span_proposals = _stats.proposal_count();
+  unsigned int placed = 0;
+
+  _pending_count = juggler_count();
+  juggler_set_iterator   jit(_jugglers);
+  const juggler *j = jit.next();
+  while (j != 0)
+  {
+    const juggler &jug = *j;
+    _pending_count--;
+    const uint64_t evictions = _stats.eviction_count();
+    jug.add_to_first_preferred_circuit();
+    _stats.count_chain(_stats.eviction_count() - evictions);
+    j = jit.next();
+
+    // One span per batch of jugglers placed, with the proposals they took
+    if ( (spans != 0) && ((++placed == span_batch) || (j == 0)) )
+      {
+        const double t = spans->now();
+        spans->record(0, "propose", span_start, t, "jugglers", placed,
+                      "proposals", _stats.proposal_count() - span_proposals);
+        span_start = t;
+        span_proposals = _stats.proposal_count();
+        placed = 0;
+      }
+  }
+}
+
+
+/*                                                                          */
+/****************************************************************************/
+/*     E N D _ P A R S E _ S P A N                                          */
+/****************************************************************************/
+/*                                                                          */
+void scheduler::end_parse_span(
+  double          &start,          /*!< When the span started, updated      */
+  double          &scored,         /*!< Seconds of scoring before it, updated */
+  unsigned int    &definitions)    /*!< Definitions in it, reset            */
+{
+  span_trace *const spans = _stats.spans();
+  if ( (spans == 0) || (definitions == 0) )
+    return;
+
+  const double end = spans->now();
+  const double score = _stats.phase_seconds(scheduler_stats::score_phase);
+  spans->record(0, "parse", start, end, "definitions", definitions,
+                "score_us", (uint64_t) ((score - scored) * 1000000.0));
+  start = end;
+  scored = score;
+  definitions = 0;
+}
+
+/*                                                                          */
+/****************************************************************************/
+/*     C H E C K _ C L O C K                                                */
+/****************************************************************************/
+/*                                                                          */
+void scheduler::check_clock()
+{
+  const double elapsed = now() - _start_time;
+  if ( (_progress != 0) && (elapsed >= _next_sample) )
+    {
+      show_progress(elapsed);
+      while (_next_sample <= elapsed)
+        _next_sample += _progress_interval;
+    }
+  if ( (_time_budget > 0.0) && (elapsed >= _time_budget) )
+    _out_of_time = true;
+}
+
+
 /*                                                                          */
 /****************************************************************************/
-/*     C O N S T R U C T O R                                                */
+/*     S H O W _ P R O G R E S S                                            */
 /****************************************************************************/
 /*                                                                          */
-scheduler::scheduler(
-  const char  *file_name)          /*!< Name of input file                  */
-  :
-  _file_name(file_name)
+void scheduler::show_progress(
+  const double         elapsed)    /*!< Seconds since assign() started      */
+const
+{
+  ostream &os = *_progress;
+  os << "proposals = "  << proposal_count() <<
+        ", pending = "  << _pending_count <<
+        ", orphans = "  << orphan_juggler_count() <<
+        ", seconds = "  << elapsed << endl;
+}
+
+
+/*                                                                          */
+/****************************************************************************/
+/*     D I S T R I B U T E _ O R P H A N S                                  */
+/****************************************************************************/
+/*                                                                          */
+void scheduler::distribute_orphans()
 {
+  scheduler_stats::phase_scope scope(_stats, scheduler_stats::orphan_phase);
+  const double span_start = (_stats.spans() != 0) ? _stats.spans()->now() : 0.0;
+  const unsigned int orphans = orphan_juggler_count();
+  juggler *j = next_orphan();
+  while (j != 0)
   {
-    ifstream inp(file_name);
-    char   line[4096];
-    int line_no = 1;
+    juggler &jug = *j;
+    circuit *c = _circuit_index.best(jug, true);
+    if (c == 0)                    /* Every circuit is full, as happens     */
+      {                            /*  when jugglers are added              */
+        add_orphaned_juggler(jug);
+        break;
+      }
+    circuit &circ = *c;
+    const juggler_circuit *jcp = jug.find_request(circ);
+    if (jcp == 0)                  /* Not one it asked for, so add it       */
+      {
+        const int new_preference = jug.highest_preference() + 1;
+        jcp = jug.add_circuit(circ, new_preference);
+      }
+    assert(jcp != 0);
+    const juggler_circuit &jc = *jcp;
+    circ.assign_juggler(jc);
+    _circuit_index.update(circ);
+    j = next_orphan();
+  }
+  if (_stats.spans() != 0)
+    _stats.spans()->record(0, "orphans", span_start, _stats.spans()->now(),
+                           "orphans", orphans);
+}
 
-    inp.getline(line, sizeof(line));
-    while (inp.good())
+
+/*                                                                          */
+/****************************************************************************/
+/*     R E C O M M E N D _ C I R C U I T S                                  */
+/****************************************************************************/
+/*                                                                          */
+void scheduler::recommend_circuits(
+  const juggler             &jug,
+  const unsigned int         k,
+  vector<const circuit *>   &recommended)
+const
+{
+  vector<circuit *>  found;
+  _circuit_index.top(jug, k, false, found);
+  recommended.assign(found.begin(), found.end());
+}
+
+
+/*                                                                          */
+/****************************************************************************/
+/*     G E T _ C I R C U I T                                                */
+/****************************************************************************/
+/*                                                                          */
+const circuit *scheduler::get_circuit(
+  const string    &circuit_name)
+{
+  circuit *c = 0;
+  const int rc = _circuits.find(circuit_name, c);
+  if (rc != 0)
+    c = 0;
+
+  return c;
+}
+
+
+/*                                                                          */
+/****************************************************************************/
+/*     G E T _ J U G G L E R                                                */
+/****************************************************************************/
+/*                                                                          */
+const juggler *scheduler::get_juggler(
+  const string    &juggler_name)
+{
+  juggler *j = 0;
+  const int rc = _jugglers.find(juggler_name, j);
+  if (rc != 0)
+    j = 0;
+
+  return j;
+}
+
+
+/*                                                                          */
+/****************************************************************************/
+/*     A N S W E R _ Q U E R Y                                              */
+/****************************************************************************/
+/*                                                                          */
+int scheduler::answer_query(
+  const string    &query,          /*!< The query                           */
+  ostream         &os)             /*!< Stream for the answer               */
+{
+  static const string sum_prefix("sum:");
+  if (query.compare(0, sum_prefix.size(), sum_prefix) == 0)
     {
-      const char type = toupper(line[0]);
-      const string definition(line);
-      if (type == 'C')
+      const string circuit_name(query, sum_prefix.size());
+      const circuit *const c = get_circuit(circuit_name);
+      if (c == 0)
         {
-          circuit *const c = new circuit(*this, definition);
-          circuit &crs = *c;
-          _circuits.add(crs);
+          os << "Circuit " << circuit_name << " does not exist." << endl;
+          return 1;
         }
-      else if (type == 'J')
+      os << "Juggler sum for " << circuit_name << " is " << c->juggler_sum() << endl;
+      return 0;
+    }
+
+  const circuit *const c = get_circuit(query);
+  if (c != 0)
+    {
+      c->show_assignments(os);
+      os << endl;
+      return 0;
+    }
+
+  const juggler *const j = get_juggler(query);
+  if (j != 0)
+    {
+      const juggler &jug = *j;
+      if (jug.is_assigned())
         {
-          juggler *const j = new juggler(*this, definition, _circuits);
-          juggler &jug = *j;
-          _jugglers.add(jug);
+          const juggler_circuit &jc = jug.assignment();
+          os << query << " is assigned to " << jc.circuit_name() <<
+                ", score " << jc.score() << ", preference " << jc.preference() << endl;
         }
       else
-        {
-          if (definition.size() != 0)
-            {
-              cout << __FILE__ << ":" << __LINE__ << ": " <<
-                      "Do not understand line " << line_no << ": <" << definition << ">" << endl;
-            }
-        }
-      inp.getline(line, sizeof(line));
-      line_no++;
+        os << query << " is not assigned." << endl;
+      return 0;
     }
-    assert((juggler_count() % circuit_count()) == 0);
-  }
+
+  os << "No circuit or juggler is named " << query << "." << endl;
+
+  return 1;
 }
 
 
 /*                                                                          */
 /****************************************************************************/
-/*     A S S I G N                                                          */
+/*     W I T H D R A W _ J U G G L E R                                      */
 /****************************************************************************/
 /*                                                                          */
-void scheduler::assign()
+int scheduler::withdraw_juggler(
+  const string    &juggler_name)
+{
+  juggler *j = 0;
+  const int find_rc = _jugglers.find(juggler_name, j);
+  if (find_rc != 0)
+    return 1;
+
+  juggler &jug = *j;
+  if (jug.is_withdrawn())
+    return 1;
+
+  jug.set_withdrawn();
+  _withdrawn_count++;
+  if (jug.is_assigned())
+    {
+      const juggler_circuit &jc = jug.assignment();
+      circuit &circ = jc.circ();
+      circ.remove_juggler(jc);
+      circ.refill_vacancy();
+      if (orphan_juggler_count() != 0)
+        distribute_orphans();      /* The vacancy the chain left            */
+    }
+  else
+    {
+      remove_orphaned_juggler(jug);
+    }
+
+  return 0;
+}
+
+
+/*                                                                          */
+/****************************************************************************/
+/*     A D D _ J U G G L E R                                                */
+/****************************************************************************/
+/*                                                                          */
+int scheduler::add_juggler(
+  const string               &juggler_name,
+  const talent_definition    &talents,
+  const vector<string>       &preferences)
 {
-  do_assignments();
+  if ( (juggler_name.size() < 2) || (juggler_name[0] != 'J') ||
+       (get_juggler(juggler_name) != 0) || preferences.empty() )
+    return 1;
+  if (has_negative(talents))
+    return 1;
+
+  circuit_set       listed;        /* To reject a circuit listed twice      */
+  vector<circuit *> circuits;
+  for (unsigned int p = 0; p < preferences.size(); p++)
+    {
+      circuit *c = 0;
+      if ( (_circuits.find(preferences[p], c) != 0) || (listed.find(preferences[p], c) == 0) )
+        return 1;
+      listed.add(*c);
+      circuits.push_back(c);
+    }
+
+  juggler *const j = new juggler(*this, juggler_name, talents.hand, talents.endurance,
+                                 talents.pizzazz, circuits);
+  juggler &jug = *j;
+  jug.set_index(_jugglers.size());
+  _jugglers.add(jug);
+  if (_validation_round != 0)      /* validate_changes() checks it by index */
+    _checked_round.push_back(0);
+  const uint64_t evictions = _stats.eviction_count();
+  jug.add_to_first_preferred_circuit();
+  _stats.count_chain(_stats.eviction_count() - evictions);
   if (orphan_juggler_count() != 0)
     distribute_orphans();
+
+  return 0;
 }
 
 
 /*                                                                          */
 /****************************************************************************/
-/*     D O _ A S S I G N M E N T S                                          */
+/*     B L O C K I N G _ P A I R _ C O U N T                                */
 /****************************************************************************/
 /*                                                                          */
-void scheduler::do_assignments()
+unsigned int scheduler::blocking_pair_count()
 {
+  unsigned int count = 0;
   juggler_set_iterator   jit(_jugglers);
   const juggler *j = jit.next();
   while (j != 0)
   {
     const juggler &jug = *j;
-    jug.add_to_first_preferred_circuit();
+    if ( !jug.is_withdrawn() )
+      count += jug.blocking_pair_count();
     j = jit.next();
   }
+
+  return count;
 }
 
 
 /*                                                                          */
 /****************************************************************************/
-/*     D I S T R I B U T E _ O R P H A N S                                  */
+/*     S H O W _ A S S I G N M E N T S                                      */
 /****************************************************************************/
 /*                                                                          */
-void scheduler::distribute_orphans()
+void scheduler::show_assignments(
+  ostream    &os)
 {
   circuit_set_iterator   cit(_circuits);
   circuit *c = cit.next();
   while (c != 0)
   {
     circuit &circ = *c;
-    while (circ.is_not_full())
-    {
-      juggler *j = next_orphan();
-      assert(j != 0);
-      juggler &jug = *j;
-      const int new_preference = jug.highest_preference() + 1;
-      const juggler_circuit *jcp = jug.add_circuit(circ, new_preference);
-      assert(jcp != 0);
-      const juggler_circuit &jc = *jcp;
-      circ.assign_juggler(jc);
-    }
+    circ.show_assignments(os);
+    os << "\n";
     c = cit.next();
   }
 }
@@ -125,38 +1188,108 @@ void scheduler::distribute_orphans()
 
 /*                                                                          */
 /****************************************************************************/
-/*     G E T _ C I R C U I T                                                */
+/*     W R I T E _ A S S I G N M E N T S                                    */
 /****************************************************************************/
 /*                                                                          */
-const circuit *scheduler::get_circuit(
-  const string    &circuit_name)
+int scheduler::write_assignments(
+  const int    fd)
 {
-  circuit *c = 0;
-  const int rc = _circuits.find(circuit_name, c);
-  if (rc != 0)
-    c = 0;
-
-  return c;
+  return write_assignments(vector<output_format>(1, text_output), vector<int>(1, fd));
 }
 
 
 /*                                                                          */
 /****************************************************************************/
-/*     S H O W _ A S S I G N M E N T S                                      */
+/*     W R I T E _ A S S I G N M E N T S                                    */
 /****************************************************************************/
 /*                                                                          */
-void scheduler::show_assignments(
-  ostream    &os)
+int scheduler::write_assignments(
+  const vector<output_format>  &formats,
+  const vector<int>            &fds)
 {
+  scheduler_stats::phase_scope scope(_stats, scheduler_stats::output_phase);
+  assert(formats.size() == fds.size());
+  vector<const circuit *>  circuits;
+  circuits.reserve(circuit_count());
   circuit_set_iterator   cit(_circuits);
-  circuit *c = cit.next();
+  const circuit *c = cit.next();
   while (c != 0)
   {
-    circuit &circ = *c;
-    circ.show_assignments(os);
-    os << "\n";
+    circuits.push_back(c);
     c = cit.next();
   }
+
+  bool binary = false;
+  for (unsigned int f = 0; f < formats.size(); f++)
+    {
+      if (formats[f] == binary_output)
+        binary = true;
+      else if (formats[f] == csv_output)
+        {
+          output_buffer  header;
+          header.append("juggler,circuit,score,preference\n");
+          if (header.write_to(fds[f]) != 0)
+            return 1;
+        }
+    }
+  vector<assignment_record>  records;
+  if (binary)
+    {
+      assignment_record none;
+      none.circuit = -1;
+      none.score = 0;
+      none.preference = 0;
+      records.assign(juggler_count(), none);
+    }
+
+  // A batch at a time keeps the buffers small however many circuits there are
+  const unsigned int batch = write_batch * worker_count();
+  assignment_writer   writer(circuits, formats, records, worker_count());
+  scheduler_stats::worker_counting counting(_stats, scheduler_stats::output_phase);
+  writer.set_observer(&counting);
+  writer.set_pool(&_pool);
+  for (unsigned int first = 0; first < circuits.size(); first += batch)
+    {
+      const unsigned int count = min(batch, (unsigned int) circuits.size() - first);
+      writer.set_first(first);
+      const unsigned int used = writer.run(count, worker_count());
+      const double span_start = (_stats.spans() != 0) ? _stats.spans()->now() : 0.0;
+      uint64_t bytes = 0;
+      for (unsigned int f = 0; f < formats.size(); f++)
+        for (unsigned int w = 0; w < used; w++)
+          {
+            bytes += writer.buffer(f, w).size();
+            if (writer.buffer(f, w).write_to(fds[f]) != 0)
+              return 1;
+          }
+      if (_stats.spans() != 0)
+        _stats.spans()->record(0, "write", span_start, _stats.spans()->now(),
+                               "circuits", count, "bytes", bytes);
+    }
+
+  if (binary)
+    {
+      assignment_header header;
+      memcpy(header.magic, "JUGGLEFA", sizeof(header.magic));
+      header.version = 1;
+      header.record_size = sizeof(assignment_record);
+      header.juggler_count = juggler_count();
+      header.circuit_count = circuit_count();
+      output_buffer  ob;
+      for (unsigned int f = 0; f < formats.size(); f++)
+        {
+          if (formats[f] != binary_output)
+            continue;
+          ob.append(reinterpret_cast<const char *>(&header), sizeof(header));
+          if ( !records.empty() )
+            ob.append(reinterpret_cast<const char *>(&records[0]),
+                      records.size() * sizeof(assignment_record));
+          if (ob.write_to(fds[f]) != 0)
+            return 1;
+        }
+    }
+
+  return 0;
 }
 
 
@@ -168,6 +1301,8 @@ void scheduler::show_assignments(
 int scheduler::validate_assignments(
   ostream    &os)
 {
+  scheduler_stats::phase_scope scope(_stats, scheduler_stats::validate_phase);
+  const double span_start = (_stats.spans() != 0) ? _stats.spans()->now() : 0.0;
   int rc = 0;
 
   {
@@ -182,19 +1317,203 @@ int scheduler::validate_assignments(
       c = cit.next();
     }
   }
+  if (_stats.spans() != 0)
+    _stats.spans()->record(0, "validate_circuits", span_start, _stats.spans()->now(),
+                           "circuits", circuit_count());
 
+  // Find the lowest score of each circuit once, then check the jugglers in
+  // parallel against those cutoffs
+  vector<circuit *>   circuits;
+  circuits_by_index(circuits);
+  _lowest.resize(circuits.size());
+  for (unsigned int i = 0; i < circuits.size(); i++)
+    _lowest[i] = cutoff(*circuits[i]);
+
+  vector<const juggler *>  jugglers;
+  jugglers.reserve(juggler_count());
   {
     juggler_set_iterator   jit(_jugglers);
-    juggler *j = jit.next();
+    const juggler *j = jit.next();
     while (j != 0)
     {
-      juggler &jug = *j;
-      const int lrc = jug.validate_assignment(os);
-      if (lrc != 0)
-        rc = 1;
+      if ( !j->is_withdrawn() )
+        jugglers.push_back(j);
       j = jit.next();
     }
   }
 
+  const int jrc = validate_jugglers(jugglers, os);
+  if (jrc != 0)
+    rc = 1;
+
+  clear_changed_circuits();
+  _checked_round.assign(juggler_count(), 0);
+  _validation_round++;
+
+  return rc;
+}
+
+
+/*                                                                          */
+/****************************************************************************/
+/*     V A L I D A T E _ C H A N G E S                                      */
+/****************************************************************************/
+/*                                                                          */
+int scheduler::validate_changes(
+  ostream    &os)
+{
+  if (_validation_round == 0)
+    return validate_assignments(os);
+
+  int rc = 0;
+  _validation_round++;
+
+  // Report in the same order as a full validation, circuits by name
+  vector<circuit *>   changed(_changed_circuits);
+  sort(changed.begin(), changed.end(), by_name<circuit>);
+  vector<const juggler *>  dependent;
+  for (unsigned int i = 0; i < changed.size(); i++)
+    {
+      circuit &circ = *changed[i];
+      const int lrc = circ.validate_assignments(os);
+      if (lrc != 0)
+        rc = 1;
+      _lowest[circ.index()] = cutoff(circ);
+      circ.dependent_jugglers(dependent);
+    }
+
+  vector<const juggler *>  jugglers;
+  for (unsigned int i = 0; i < dependent.size(); i++)
+    {
+      const juggler &jug = *dependent[i];
+      assert( (jug.index() >= 0) && (jug.index() < (int) _checked_round.size()) );
+      if ( !jug.is_withdrawn() && (_checked_round[jug.index()] != _validation_round) )
+        {
+          _checked_round[jug.index()] = _validation_round;
+          jugglers.push_back(&jug);
+        }
+    }
+  sort(jugglers.begin(), jugglers.end(), by_name<const juggler>);
+
+  const int jrc = validate_jugglers(jugglers, os);
+  if (jrc != 0)
+    rc = 1;
+  clear_changed_circuits();
+
+  return rc;
+}
+
+
+/*                                                                          */
+/****************************************************************************/
+/*     V A L I D A T E _ J U G G L E R S                                    */
+/****************************************************************************/
+/*                                                                          */
+int scheduler::validate_jugglers(
+  const vector<const juggler *>  &jugglers,
+  ostream                        &os)
+{
+  int rc = 0;
+  assignment_validator   validator(jugglers, _lowest, worker_count());
+  scheduler_stats::worker_counting counting(_stats, scheduler_stats::validate_phase);
+  validator.set_observer(&counting);
+  validator.set_pool(&_pool);
+  const unsigned int used = validator.run(jugglers.size(), worker_count());
+  for (unsigned int w = 0; w < used; w++)
+    {
+      os << validator.report(w);
+      if (validator.failed(w))
+        rc = 1;
+    }
+
   return rc;
 }
+
+
+/*                                                                          */
+/****************************************************************************/
+/*     C L E A R _ C H A N G E D _ C I R C U I T S                          */
+/****************************************************************************/
+/*                                                                          */
+void scheduler::clear_changed_circuits()
+{
+  for (unsigned int i = 0; i < _changed_circuits.size(); i++)
+    _changed_circuits[i]->clear_changed();
+  _changed_circuits.clear();
+}
+
+
+/*                                                                          */
+/****************************************************************************/
+/*     T A K E _ U N P U B L I S H E D _ C I R C U I T S                    */
+/****************************************************************************/
+/*                                                                          */
+void scheduler::take_unpublished_circuits(
+  vector<circuit *>    &circuits)
+{
+  circuits.swap(_unpublished_circuits);
+  _unpublished_circuits.clear();
+  for (unsigned int i = 0; i < circuits.size(); i++)
+    circuits[i]->clear_unpublished();
+}
+
+
+/*                                                                          */
+/****************************************************************************/
+/*     A C C O U N T _ M E M O R Y                                          */
+/****************************************************************************/
+/*                                                                          */
+void scheduler::account_memory(
+  memory_usage         &usage)     /*!< Where to charge it                  */
+{
+  _jugglers.account_memory(usage, memory_usage::name_maps);
+  _circuits.account_memory(usage, memory_usage::name_maps);
+  _orphan_jugglers.account_memory(usage, memory_usage::name_maps);
+  _circuit_index.account_memory(usage);
+
+  juggler_set_iterator   jit(_jugglers);
+  for (juggler *j = jit.next(); j != 0; j = jit.next())
+    j->account_memory(usage);
+  circuit_set_iterator   cit(_circuits);
+  for (circuit *c = cit.next(); c != 0; c = cit.next())
+    c->account_memory(usage);
+
+  usage.add_vector(memory_usage::scheduler_tables, _changed_circuits);
+  usage.add_vector(memory_usage::scheduler_tables, _unpublished_circuits);
+  usage.add_vector(memory_usage::scheduler_tables, _lowest);
+  usage.add_vector(memory_usage::scheduler_tables, _checked_round);
+}
+
+/*                                                                          */
+/****************************************************************************/
+/*     W R I T E _ S T A T S _ R E P O R T                                  */
+/****************************************************************************/
+/*                                                                          */
+void scheduler::write_stats_report(
+  ostream             &os,         /*!< The stream for the report           */
+  const unsigned int   hottest_count)/*!< Number of circuits to list        */
+{
+  vector< pair<uint64_t, unsigned int> > hottest;
+  _stats.hottest_circuits(hottest_count, hottest);
+  vector<circuit *> circuits;
+  circuits_by_index(circuits);
+  vector<string> names(hottest.size());
+  for (unsigned int h = 0; h < hottest.size(); h++)
+    names[h] = circuits[hottest[h].second]->name();
+  _stats.write_report(os, hottest_count, names);
+}
+
+
+/*                                                                          */
+/****************************************************************************/
+/*     W R I T E _ M E M O R Y _ R E P O R T                                */
+/****************************************************************************/
+/*                                                                          */
+void scheduler::write_memory_report(
+  ostream             &os)         /*!< The stream for the report           */
+{
+  memory_usage   usage;
+  account_memory(usage);
+  usage.write_report(os, juggler_count());
+  os << endl;
+}
@@ -10,9 +10,19 @@
  */
 
 #include <iostream>
+#include <vector>
+#include <stdint.h>
 #include "juggler_set.h"
 #include "circuit_set.h"
 #include "juggler_set_iterator.h"
+#include "circuit_index.h"
+#include "stable_lattice.h"
+#include "festival_definition.h"
+#include "scheduler_stats.h"
+#include "container_trace.h"
+#include "worker_pool.h"
+
+struct assignment_record;
 
 /*!
  * \brief This class reads the input file, creates the circuits and jugglers,
@@ -23,6 +33,18 @@ class scheduler
 {
 public:
 
+  /*!
+   * \brief Formats in which write_assignments() can write the assignments
+   */
+  enum output_format
+  {
+    text_output,                   //!< The text of show_assignments()
+    csv_output,                    //!< juggler,circuit,score,preference rows
+    json_lines_output,             //!< One JSON object per juggler per line
+    binary_output                  //!< assignment_header, then records
+  };
+
+
   /*!
    * \brief Standard constructor
    */
@@ -31,6 +53,43 @@ public:
                           );
 
 
+  /*!
+   * \brief Destructor
+   *
+   * Deletes the jugglers and circuits, and with them every juggler_circuit.
+   */
+  ~scheduler();
+
+
+  /*!
+   * \brief Make a scheduler from a festival held in memory
+   *
+   * This is for programs that link with libjugglefest and already have the
+   * festival in memory; nothing is formatted or parsed.
+   *
+   * \return Zero if the definition passes check_definition(), with the new
+   *         scheduler, which the caller deletes; non-zero otherwise, with each
+   *         problem written to the stream and no scheduler
+   */
+  static int create(
+    const festival_definition  &definition,/*!< The festival               */
+    std::ostream               &os,/*!< Stream for error reporting          */
+    scheduler                 *&sched/*!< Returned scheduler, or zero       */
+                   );
+
+
+  /*!
+   * \brief Check that a festival_definition can be scheduled
+   *
+   * \return Zero if it can, non-zero otherwise; each problem is written to the
+   *         stream
+   */
+  static int check_definition(
+    const festival_definition  &definition,/*!< The festival               */
+    std::ostream               &os /*!< Stream for error reporting          */
+                             );
+
+
   /*!
    * \brief Assign all of the jugglers to their best fit circuits
    *
@@ -49,15 +108,238 @@ public:
    * of their preferred circuits.
    *
    * If y orphaned jugglers exist, there are y open slots in the circuits.  At this
-   * point we go through all the circuits.  We fill any open clot in a circuit with
-   * the next orphaned juggler.  It matter not which jugglers are used to fill the
-   * open slots.  It is still the case that none of these orphaned jugglers could be
-   * moved to a circuit that they prefer more and be a better fit for any juggler in
-   * that circuit.
+   * point we put each orphaned juggler into the open circuit where it scores
+   * highest.  It matters not which jugglers are used to fill the open slots, but
+   * best fit makes for better circuits.  It is still the case that none of these
+   * orphaned jugglers could be moved to a circuit that they prefer more and be a
+   * better fit for any juggler in that circuit.
+   *
+   * If a time budget has been set with set_time_budget() and it runs out, no
+   * more proposals are made.  The juggler being placed and all jugglers not yet
+   * placed go to the orphaned jugglers and are distributed as above, so every
+   * juggler still ends up in a circuit.  out_of_time() then returns true and
+   * blocking_pair_count() tells how far from stable the assignment is.
    */
   void assign();
 
 
+  /*!
+   * \brief Assign the jugglers so that the total score is as high as possible
+   *
+   * This is an alternative to assign() for planners who care about the total
+   * score more than about stability.  It uses auction_engine to maximize the
+   * sum of the scores of the jugglers placed in one of their preferred circuits.
+   * Jugglers that end up outside their preferences are treated as orphans and
+   * distributed by best fit, as assign() does.  The assignments are shown in the
+   * same format by show_assignments(), so the two can be compared directly.
+   *
+   * Only one of the assign functions may be called, and only once.
+   */
+  void assign_max_score();
+
+
+  /*!
+   * \brief Assign the jugglers to another stable assignment
+   *
+   * assign() finds the stable assignment that is best for every juggler.  This
+   * uses stable_lattice to find one of the other stable assignments instead,
+   * such as the egalitarian or the minimum regret assignment, for planners who
+   * want to review how fair the assignment is to jugglers and circuits alike.
+   * Jugglers that no stable assignment places are treated as orphans and
+   * distributed by best fit, as assign() does.  The number of rotations and the
+   * sum of ranks and regret of the assignment are written to the stream.
+   *
+   * Only one of the assign functions may be called, and only once.
+   */
+  void assign_stable(
+    const stable_lattice::choice   which,/*!< The stable assignment wanted  */
+    std::ostream                  &os  /*!< Stream for the summary          */
+                    );
+
+
+  /*!
+   * \brief Return the assignment of every juggler, by juggler index
+   *
+   * These are the records write_assignments() writes in binary_output, so a
+   * program that links with libjugglefest can read the results without any
+   * text.  Unassigned jugglers have a circuit of -1.
+   */
+  void assignment_records(
+    std::vector<assignment_record> &records/*!< Returned assignments        */
+                         );
+
+
+  /*!
+   * \brief Return the total score of all assigned jugglers
+   */
+  int64_t total_score();
+
+
+  /*!
+   * \brief Return the number of worker threads used by parallel phases
+   */
+  unsigned int worker_count() const
+  { return _worker_count; }
+
+
+  /*!
+   * \brief Set the number of worker threads used by parallel phases
+   *
+   * This defaults to the number of processors available.
+   */
+  void set_worker_count(
+    const unsigned int   workers)  /*!< Number of worker threads            */
+  {
+    assert(workers > 0);
+    _worker_count = workers;
+  }
+
+
+  /*!
+   * \brief Set the time allowed for assign()
+   *
+   * Zero, the default, means that assign() runs until every juggler has been
+   * placed by preference.  Only the proposals of assign() are limited; those
+   * of add_juggler() and withdraw_juggler() afterwards never are.
+   */
+  void set_time_budget(
+    const double         seconds)  /*!< Seconds allowed for the proposals   */
+  {
+    assert(seconds >= 0.0);
+    _time_budget = seconds;
+  }
+
+
+  /*!
+   * \brief Ask for progress samples while assign() makes its proposals
+   *
+   * Each sample is one line giving the number of proposals made, the number of
+   * jugglers yet to propose, the number of orphans and the time taken so far.
+   */
+  void set_progress(
+    std::ostream        *os,       /*!< Stream for samples, or zero for none*/
+    const double         interval) /*!< Seconds between samples             */
+  {
+    assert(interval > 0.0);
+    _progress = os;
+    _progress_interval = interval;
+  }
+
+
+  /*!
+   * \brief Return true if assign() ran out of time before every juggler was
+   *        placed by preference
+   */
+  bool out_of_time() const
+  { return _out_of_time; }
+
+
+  /*!
+   * \brief Return the number of proposals made by assign()
+   */
+  uint64_t proposal_count() const
+  { return _stats.proposal_count(); }
+
+
+  /*!
+   * \brief Return the phase times and counters of this scheduler
+   */
+  const scheduler_stats &stats() const
+  { return _stats; }
+
+
+  /*!
+   * \brief Return the phase times and counters, for the circuits and jugglers
+   *        to record into
+   */
+  scheduler_stats &stats()
+  { return _stats; }
+
+
+  /*!
+   * \brief Record the operations on the rosters and the orphans into a trace,
+   *        or stop recording with zero
+   *
+   * The trace must outlive the recording.  Set it before assign(), with one
+   * worker thread.
+   */
+  void set_container_trace(
+    container_trace   *trace)      /*!< The trace, or zero                  */
+  { _trace = trace; }
+
+
+  /*!
+   * \brief Return the trace being recorded, or zero
+   */
+  container_trace *trace() const
+  { return _trace; }
+
+
+  /*!
+   * \brief Write the phase times and counters as one line of JSON
+   *
+   * See scheduler_stats::write_report().
+   */
+  void write_stats_report(
+    std::ostream         &os,      /*!< The stream for the report           */
+    const unsigned int    hottest_count/*!< Number of circuits to list      */
+                         );
+
+
+  /*!
+   * \brief Charge everything the scheduler holds on the heap to its
+   *        subsystem
+   *
+   * This walks every juggler and circuit, so it takes about as long as
+   * validating and is meant for reports, not for use while solving.
+   */
+  void account_memory(
+    memory_usage         &usage    /*!< Where to charge it                  */
+                     );
+
+
+  /*!
+   * \brief Write the memory of each subsystem, the bytes per juggler and the
+   *        resident set as one line of JSON
+   *
+   * See memory_usage::write_report().
+   */
+  void write_memory_report(
+    std::ostream         &os       /*!< The stream for the report           */
+                          );
+
+
+  /*!
+   * \brief Record a proposal of a juggler to a circuit
+   *
+   * circuit::reassign_juggler() calls this before every proposal.
+   *
+   * \return true if the proposal may go ahead, false if assign() is running
+   *         and its time budget has run out, so the juggler should be
+   *         orphaned instead
+   */
+  bool allow_proposal()
+  {
+    if (_out_of_time && _clock_running)
+      return false;
+    _stats.count_proposal();
+    if ( _clock_running && ((_stats.proposal_count() % clock_interval) == 0) )
+      check_clock();
+
+    return ( !_out_of_time || !_clock_running );
+  }
+
+
+  /*!
+   * \brief Return the number of blocking pairs in the assignment
+   *
+   * A blocking pair is a juggler and a circuit that it prefers to its own,
+   * where the circuit would rather have it than its lowest scoring juggler.
+   * There are none after assign() unless it ran out of time.
+   */
+  unsigned int blocking_pair_count();
+
+
   /*!
    * \brief Show the final assignments
    */
@@ -66,6 +348,40 @@ public:
                        );
 
 
+  /*!
+   * \brief Write the final assignments to a file descriptor
+   *
+   * The text is the same as show_assignments() writes, but the circuits are
+   * formatted in parallel into buffers, a batch at a time, and each buffer is
+   * written with one system call.  Anything buffered in a stream on the same
+   * descriptor must be flushed first.
+   *
+   * \return Zero if everything was written, non-zero otherwise
+   */
+  int write_assignments(
+    const int        fd           /*!< File descriptor for results         */
+                       );
+
+
+  /*!
+   * \brief Write the final assignments in several formats in one pass
+   *
+   * Each circuit is visited once and formatted into every format asked for,
+   * format i going to fds[i].  The text and the CSV and JSON Lines rows come
+   * in the order of show_assignments(): circuits by name, and the jugglers of
+   * each circuit from the highest score down.  The CSV starts with a header
+   * line.  The binary format is laid out in assignment_record.h, with the
+   * jugglers and circuits numbered in the order of the input file; it is
+   * written after everything else.
+   *
+   * \return Zero if everything was written, non-zero otherwise
+   */
+  int write_assignments(
+    const std::vector<output_format> &formats,/*!< Formats to write        */
+    const std::vector<int>           &fds/*!< File descriptor of each format */
+                       );
+
+
   /*!
    * \brief Return the count of the number of circuits
    */
@@ -82,9 +398,44 @@ public:
 
   /*!
    * \brief Return the number of jugglers per circuit
+   *
+   * This is the number of jugglers in the input over the number of circuits,
+   * fixed when the scheduler is built; jugglers added later do not change it.
    */
   unsigned int  jugglers_per_circuit() const
-  { return (juggler_count() / circuit_count()); }
+  { return _capacity; }
+
+
+  /*!
+   * \brief Return true if there are fewer jugglers than places in the circuits
+   *
+   * Only withdrawals leave places that there is nobody to fill, so a circuit
+   * short of jugglers is not an error then.
+   */
+  bool has_vacancies() const
+  { return ((juggler_count() - _withdrawn_count) < (_capacity * circuit_count())); }
+
+
+  /*!
+   * \brief Return the number of rejected jugglers each circuit keeps on its
+   *        waitlist
+   *
+   * Zero, the default, means that no waitlists are kept.
+   */
+  unsigned int waitlist_size() const
+  { return _waitlist_size; }
+
+
+  /*!
+   * \brief Set the number of rejected jugglers each circuit keeps on its
+   *        waitlist
+   *
+   * This must be set before assign() is called, since the waitlists are filled
+   * as the circuits turn jugglers away.
+   */
+  void set_waitlist_size(
+    const unsigned int   size)     /*!< Maximum size of each waitlist       */
+  { _waitlist_size = size; }
 
 
   /*!
@@ -105,6 +456,91 @@ public:
 
 
 
+  /*!
+   * \brief Recommend the circuits that best fit a juggler
+   *
+   * This is meant for a juggler building its list of preferred circuits.  The
+   * circuits are returned from the highest score to the lowest, whether or not
+   * they are full.
+   */
+  void recommend_circuits(
+    const juggler             &jug,/*!< The juggler                         */
+    const unsigned int         k,  /*!< Number of circuits wanted           */
+    std::vector<const circuit *> &recommended/*!< Returned circuits         */
+                         )
+  const;
+
+
+  /*!
+   * \brief Return a juggler by name
+   *
+   * \return A pointer to the juggler if it exists, otherwise zero
+   */
+  const juggler *get_juggler(
+    const std::string    &juggler_name/*!< Name of juggler to return        */
+                                      );
+
+
+  /*!
+   * \brief Withdraw a juggler from the festival after the assignment
+   *
+   * The juggler gives up its place and the vacancy is refilled from the circuit
+   * waitlists, so that only the jugglers along the vacancy chain move.  If the
+   * chain ends with a place open and there are orphans, they are distributed
+   * as after assign(); otherwise the place is simply left open.
+   *
+   * \return Zero if the juggler was withdrawn, non-zero if it does not exist or
+   *         has already withdrawn
+   */
+  int withdraw_juggler(
+    const std::string    &juggler_name/*!< Name of juggler to withdraw      */
+                      );
+
+
+  /*!
+   * \brief Add a juggler to the festival after the assignment
+   *
+   * The juggler proposes to its preferred circuits as if it had been in the
+   * input all along, so only the jugglers along its chain of evictions move.  A
+   * juggler left without a circuit goes to the open circuit where it scores
+   * highest; if every circuit is full it stays an orphan.  The number of
+   * jugglers per circuit does not change.
+   *
+   * \return Zero if the juggler was added, non-zero if the name is taken or
+   *         malformed, a talent is negative, there are no preferences, or a
+   *         preferred circuit does not exist or is listed twice
+   */
+  int add_juggler(
+    const std::string             &juggler_name,/*!< Name of the juggler    */
+    const talent_definition       &talents,/*!< Talents of the juggler      */
+    const std::vector<std::string> &preferences/*!< Names of the preferred
+                                                    circuits, most preferred
+                                                    first                   */
+                 );
+
+
+  /*!
+   * \brief Answer one query about the assignments
+   *
+   * This is for checking a few results without writing all of the assignments.
+   * Each query is a name lookup, so it costs the same however large the
+   * festival is.  A query is one of:
+   *
+   * <ul>
+   * <li> a circuit name, such as "C1970", for the line show_assignments()
+   *      writes for the circuit;
+   * <li> a juggler name, such as "J12", for its circuit, score and preference;
+   * <li> "sum:" and a circuit name, such as "sum:C1970", for juggler_sum().
+   * </ul>
+   *
+   * \return Zero if the query was answered, non-zero if it names nothing
+   */
+  int answer_query(
+    const std::string    &query,   /*!< The query                           */
+    std::ostream         &os       /*!< Stream for the answer               */
+                  );
+
+
   /*!
    * \brief Add a juggler to the set of jugglers that have no circuits
    *
@@ -113,7 +549,26 @@ public:
   void add_orphaned_juggler(
     juggler    &jug)               /*!< Juggler to add                      */
   {
+    _stats.count_orphan();
     _orphan_jugglers.add(jug);
+    if (_trace != 0)
+      _trace->record_orphan(container_trace::orphan_insert, &jug);
+  }
+
+
+  /*!
+   * \brief Remove a juggler from the set of jugglers that have no circuits
+   *
+   * This happens when a vacancy opens up in a circuit that had turned the
+   * juggler away.
+   */
+  void remove_orphaned_juggler(
+    juggler    &jug)               /*!< Juggler to remove                   */
+  {
+    const int rc = _orphan_jugglers.remove(jug.name());
+    assert(rc == 0);
+    if (_trace != 0)
+      _trace->record_orphan(container_trace::orphan_remove, &jug);
   }
 
 
@@ -131,6 +586,90 @@ public:
                        );
 
 
+  /*!
+   * \brief Validate only what has changed since the last validation
+   *
+   * The scheduler keeps track of the circuits whose assigned jugglers have
+   * changed, for instance by withdraw_juggler().  Only those circuits are
+   * checked, along with the jugglers assigned to them and the jugglers that list
+   * them ahead of their assignment, so the cost follows the size of the change.
+   * The diagnostics are those that validate_assignments() would give for the
+   * same circuits and jugglers.  If there has been no full validation yet, this
+   * does one.
+   *
+   * \return Zero if no errors are found in the assignments, non-zero otherwise
+   */
+  int validate_changes(
+    std::ostream    &os            /*!< Stream for error reporting          */
+                      );
+
+
+  /*!
+   * \brief Record that the jugglers assigned to a circuit have changed
+   *
+   * The circuit calls this the first time it changes after a validation.
+   */
+  void circuit_changed(
+    circuit         &circ)         /*!< The circuit that changed            */
+  {
+    _changed_circuits.push_back(&circ);
+  }
+
+
+  /*!
+   * \brief Tell the circuit index that a circuit may have filled or emptied
+   *
+   * The circuit calls this when a proposal or a refill changes it, so that
+   * placing an orphan never needs to look at every circuit.  This runs in
+   * O(log c), where c is the number of circuits.
+   */
+  void update_circuit_index(
+    const circuit   &circ)         /*!< The circuit that changed            */
+  {
+    _circuit_index.update(circ);
+  }
+
+
+  /*!
+   * \brief Record that the jugglers assigned to a circuit have changed since
+   *        the last snapshot was published
+   *
+   * The circuit calls this the first time it changes after a publication.
+   */
+  void circuit_unpublished(
+    circuit         &circ)         /*!< The circuit that changed            */
+  {
+    _unpublished_circuits.push_back(&circ);
+  }
+
+
+  /*!
+   * \brief Return the circuits that changed since the last call, and forget
+   *        their changes
+   *
+   * This is for snapshot_store, which publishes the changes.
+   */
+  void take_unpublished_circuits(
+    std::vector<circuit *>   &circuits/*!< Returned circuits                */
+                                );
+
+
+  /*!
+   * \brief Return all jugglers in a vector indexed by juggler index
+   */
+  void jugglers_by_index(
+    std::vector<juggler *>    &jugglers/*!< Returned jugglers               */
+                        );
+
+
+  /*!
+   * \brief Return all circuits in a vector indexed by circuit index
+   */
+  void circuits_by_index(
+    std::vector<circuit *>    &circuits/*!< Returned circuits               */
+                        );
+
+
 
   /*!
    *  \brief Stream object out to a stream
@@ -146,6 +685,14 @@ public:
 
 private:
 
+  /*!
+   * \brief Constructor from a festival held in memory, which create() has
+   *        checked
+   */
+  explicit scheduler(
+    const festival_definition  &definition/*!< The festival                */
+                    );
+
   /*!
    * \brief The copy constructor is deliberately private and unimplemented.
    *
@@ -196,20 +743,66 @@ private:
   void do_assignments();
 
 
+  /*!
+   * \brief Record a span for the definitions parsed since the last one, when
+   *        tracing, and start the next
+   *
+   * Scoring is done juggler by juggler in the middle of parsing, so the span
+   * carries the microseconds of scoring in it rather than having spans of its
+   * own.
+   */
+  void end_parse_span(
+    double          &start,        /*!< When the span started, updated      */
+    double          &scored,       /*!< Seconds of scoring before it,
+                                        updated                             */
+    unsigned int    &definitions   /*!< Definitions in it, reset            */
+                     );
+
+
   /*!
    * \brief Distribute orphaned jugglers to underfull circuits
    *
    * All of the possible assignments are done based on juggler preference.  But
    * it might not be possible to put a juggler into any of its preferred circuits.
    * Any juggler that could not be placed into any of its preferred circuits is in
-   * the orphaned juggler set.  Here we go through the circuits.  As we encounter
-   * an underfull circuit, we populate it from the orphaned juggler set.
-   *
-   * This is the only loop through the circuits.
+   * the orphaned juggler set.  Here we go through the orphaned jugglers and put
+   * each one into the open circuit where it scores highest, using the circuit
+   * index to find that circuit without scoring every circuit.
    */
   void distribute_orphans();
 
 
+  /*!
+   * \brief Validate a set of jugglers in parallel against _lowest
+   *
+   * \return Zero if no errors are found, non-zero otherwise
+   */
+  int validate_jugglers(
+    const std::vector<const juggler *> &jugglers,/*!< Jugglers in report order*/
+    std::ostream    &os            /*!< Stream for error reporting          */
+                       );
+
+
+  /*!
+   * \brief Forget the changed circuits once they have been validated
+   */
+  void clear_changed_circuits();
+
+
+  /*!
+   * \brief Check the time budget and write a progress sample when one is due
+   */
+  void check_clock();
+
+
+  /*!
+   * \brief Write one progress sample
+   */
+  void show_progress(
+    const double         elapsed)  /*!< Seconds since assign() started      */
+  const;
+
+
   /*!
    * \brief Fetch and delete the next orphan from the set of orphaned jugglers
    */
@@ -218,7 +811,11 @@ private:
     juggler_set_iterator   jsi(_orphan_jugglers);
     juggler *j = jsi.next();
     if (j != 0)
-      jsi.remove_current();
+      {
+        jsi.remove_current();
+        if (_trace != 0)
+          _trace->record_orphan(container_trace::orphan_take, j);
+      }
 
     return j;
   }
@@ -230,6 +827,9 @@ private:
   //! The set of all circuits ordered by circuit name
   circuit_set    _circuits;
 
+  //! Index for finding the best fitting circuit for a juggler
+  circuit_index  _circuit_index;
+
    /*!
     * \brief The set of all jugglers that have become orphans
     *
@@ -240,6 +840,75 @@ private:
   //! Name of input file
   const std::string  _file_name;
 
+  //! Number of jugglers each circuit takes, fixed once the input is read
+  unsigned int       _capacity;
+
+  //! Number of jugglers withdrawn by withdraw_juggler()
+  unsigned int       _withdrawn_count;
+
+  //! Number of rejected jugglers each circuit keeps on its waitlist
+  unsigned int       _waitlist_size;
+
+  //! Number of worker threads used by parallel phases
+  unsigned int       _worker_count;
+
+  //! Threads that run the parallel phases
+  worker_pool        _pool;
+
+  //! Number of proposals between looks at the clock
+  static const unsigned int clock_interval = 1024;
+
+  //! Circuits formatted per worker between writes by write_assignments()
+  static const unsigned int write_batch = 1024;
+
+  //! Definitions parsed, or jugglers placed, per span when tracing
+  static const unsigned int span_batch = 4096;
+
+  //! Seconds allowed for the proposals of assign(), or zero for no limit
+  double             _time_budget;
+
+  //! Stream for progress samples, or zero for none
+  std::ostream      *_progress;
+
+  //! Seconds between progress samples
+  double             _progress_interval;
+
+  //! Time assign() started, in seconds
+  double             _start_time;
+
+  //! Time of the next progress sample, in seconds since assign() started
+  double             _next_sample;
+
+  //! Phase times and counters, the number of proposals among them
+  scheduler_stats    _stats;
+
+  //! The trace being recorded, or zero
+  container_trace   *_trace;
+
+  //! Number of jugglers that have yet to make their first proposal
+  unsigned int       _pending_count;
+
+  //! True once the time budget has run out
+  bool               _out_of_time;
+
+  //! True while assign() makes its proposals, which the clock limits
+  bool               _clock_running;
+
+  //! Circuits whose assigned jugglers changed since the last validation
+  std::vector<circuit *>  _changed_circuits;
+
+  //! Circuits changed since the last snapshot was published
+  std::vector<circuit *>  _unpublished_circuits;
+
+  //! Lowest score of each circuit at the last validation, by circuit index
+  std::vector<int>   _lowest;
+
+  //! Last validation round in which each juggler was checked, by juggler index
+  std::vector<unsigned int> _checked_round;
+
+  //! Number of validations done; zero until the first full validation
+  unsigned int       _validation_round;
+
 };
 
 #endif                             /* scheduler_h_included                  */
@@ -0,0 +1,414 @@
+
+/*!
+ * \file scheduler_stats.cpp
+ *
+ * \brief Contains the implementation of scheduler_stats
+ *
+ * \author Stewart L. Palmer
+ */
+
+#include <algorithm>
+#include <functional>
+#include <sys/time.h>
+#include "scheduler_stats.h"
+
+using namespace ::std;
+
+
+/*!
+ * \brief Return the time of day in seconds
+ */
+static double now()
+{
+  struct timeval tv;
+  gettimeofday(&tv, 0);
+
+  return (tv.tv_sec + tv.tv_usec / 1000000.0);
+}
+
+
+//! True if scheduler_stats constructed from now on count hardware events
+static bool count_hardware = false;
+
+//! The span_trace of scheduler_stats constructed from now on, or zero
+static span_trace *default_spans = 0;
+
+
+/*!
+ * \brief Write counts as a JSON object, with the instructions per cycle if
+ *        both were counted
+ */
+static void write_counts(
+  ostream                 &os,     /*!< The stream for the report           */
+  const perf_counters     &counters,/*!< Which counters are available       */
+  const uint64_t          *counts) /*!< One count per counter               */
+{
+  os << "{";
+  const char *separator = "";
+  for (unsigned int c = 0; c < perf_counters::counter_count; c++)
+    if (counters.available((perf_counters::counter) c))
+      {
+        os << separator << "\"" << perf_counters::counter_name((perf_counters::counter) c) <<
+              "\":" << counts[c];
+        separator = ",";
+      }
+  if ( counters.available(perf_counters::cycles) &&
+       counters.available(perf_counters::instructions) &&
+       (counts[perf_counters::cycles] != 0) )
+    os << ",\"ipc\":" << ((double) counts[perf_counters::instructions] /
+                          counts[perf_counters::cycles]);
+  os << "}";
+}
+
+
+/*                                                                          */
+/****************************************************************************/
+/*     C O N S T R U C T O R                                                */
+/****************************************************************************/
+/*                                                                          */
+scheduler_stats::scheduler_stats()
+  :
+  _current(idle_phase),
+  _since(now()),
+  _counters(0),
+  _spans(default_spans),
+  _proposals(0),
+  _evictions(0),
+  _orphans(0),
+  _longest_chain(0)
+{
+  fill(_seconds, _seconds + phase_count, 0.0);
+  fill(_entries, _entries + phase_count, 0);
+  fill(_chains, _chains + chain_buckets, 0);
+  fill(_last, _last + perf_counters::counter_count, 0);
+  for (unsigned int p = 0; p < phase_count; p++)
+    fill(_counted[p], _counted[p] + perf_counters::counter_count, 0);
+  if (count_hardware)
+    {
+      _counters = new perf_counters();
+      _counters->read(_last);
+    }
+}
+
+
+/*                                                                          */
+/****************************************************************************/
+/*     D E S T R U C T O R                                                  */
+/****************************************************************************/
+/*                                                                          */
+scheduler_stats::~scheduler_stats()
+{
+  delete _counters;
+}
+
+
+/*                                                                          */
+/****************************************************************************/
+/*     S E T _ H A R D W A R E _ C O U N T I N G                            */
+/****************************************************************************/
+/*                                                                          */
+void scheduler_stats::set_hardware_counting(
+  const bool           on)         /*!< True to count                       */
+{
+  count_hardware = on;
+}
+
+
+/*                                                                          */
+/****************************************************************************/
+/*     S E T _ S P A N _ T R A C E                                          */
+/****************************************************************************/
+/*                                                                          */
+void scheduler_stats::set_span_trace(
+  span_trace          *spans)      /*!< The trace, or zero                  */
+{
+  default_spans = spans;
+}
+
+
+/*                                                                          */
+/****************************************************************************/
+/*     P H A S E _ N A M E                                                  */
+/****************************************************************************/
+/*                                                                          */
+const char *scheduler_stats::phase_name(
+  const phase          p)          /*!< The phase                           */
+{
+  static const char *const names[phase_count] =
+  {
+    "idle", "parse", "score", "propose", "orphans", "validate", "output"
+  };
+
+  return names[p];
+}
+
+
+/*                                                                          */
+/****************************************************************************/
+/*     E N T E R _ P H A S E                                                */
+/****************************************************************************/
+/*                                                                          */
+scheduler_stats::phase scheduler_stats::enter_phase(
+  const phase          p)          /*!< The phase entered                   */
+{
+  const phase outer = _current;
+  leave_phase(p);
+  _entries[p]++;
+
+  return outer;
+}
+
+
+/*                                                                          */
+/****************************************************************************/
+/*     L E A V E _ P H A S E                                                */
+/****************************************************************************/
+/*                                                                          */
+void scheduler_stats::leave_phase(
+  const phase          outer)      /*!< As returned by enter_phase()        */
+{
+  const double t = now();
+  _seconds[_current] += t - _since;
+  _since = t;
+  if (_counters != 0)
+    {
+      uint64_t counts[perf_counters::counter_count];
+      _counters->read(counts);
+      for (unsigned int c = 0; c < perf_counters::counter_count; c++)
+        {
+          _counted[_current][c] += counts[c] - _last[c];
+          _last[c] = counts[c];
+        }
+    }
+  _current = outer;
+}
+
+
+/*                                                                          */
+/****************************************************************************/
+/*     W O R K E R _ C O U N T I N G :: D E S T R U C T O R                 */
+/****************************************************************************/
+/*                                                                          */
+scheduler_stats::worker_counting::~worker_counting()
+{
+  for (unsigned int w = 0; w < _counters.size(); w++)
+    delete _counters[w];
+}
+
+
+/*                                                                          */
+/****************************************************************************/
+/*     W O R K E R _ C O U N T I N G :: R U N _ S T A R T I N G             */
+/****************************************************************************/
+/*                                                                          */
+void scheduler_stats::worker_counting::run_starting(
+  const unsigned int   workers)    /*!< Number of workers that will run     */
+{
+  if (_stats._spans != 0)
+    {
+      _stats._spans->add_tracks(workers);
+      if (_span_start.size() < workers)
+        _span_start.resize(workers, 0.0);
+    }
+  if ( !_stats.counting_hardware() )
+    return;
+
+  const size_t size = (size_t) workers * perf_counters::counter_count;
+  if (_counters.size() < workers)
+    _counters.resize(workers, 0);
+  if (_start.size() < size)
+    _start.resize(size, 0);
+  vector<uint64_t> &counted = _stats._worker_counted[_phase];
+  if (counted.size() < size)
+    counted.resize(size, 0);
+}
+
+
+/*                                                                          */
+/****************************************************************************/
+/*     W O R K E R _ C O U N T I N G :: W O R K E R _ S T A R T I N G       */
+/****************************************************************************/
+/*                                                                          */
+void scheduler_stats::worker_counting::worker_starting(
+  const unsigned int   worker)     /*!< Worker number, from zero            */
+{
+  if (_stats._spans != 0)
+    _span_start[worker] = _stats._spans->now();
+  if ( !_stats.counting_hardware() )
+    return;
+
+  assert(worker < _counters.size());
+  delete _counters[worker];
+  _counters[worker] = new perf_counters();
+  _counters[worker]->read(&_start[worker * perf_counters::counter_count]);
+}
+
+
+/*                                                                          */
+/****************************************************************************/
+/*     W O R K E R _ C O U N T I N G :: W O R K E R _ F I N I S H E D       */
+/****************************************************************************/
+/*                                                                          */
+void scheduler_stats::worker_counting::worker_finished(
+  const unsigned int   worker)     /*!< Worker number, from zero            */
+{
+  if (_stats._spans != 0)
+    _stats._spans->record(worker, phase_name(_phase), _span_start[worker], _stats._spans->now());
+  if ( !_stats.counting_hardware() )
+    return;
+
+  uint64_t counts[perf_counters::counter_count];
+  _counters[worker]->read(counts);
+  const uint64_t *start = &_start[worker * perf_counters::counter_count];
+  uint64_t *counted = &_stats._worker_counted[_phase][worker * perf_counters::counter_count];
+  for (unsigned int c = 0; c < perf_counters::counter_count; c++)
+    counted[c] += counts[c] - start[c];
+  delete _counters[worker];
+  _counters[worker] = 0;
+}
+
+
+/*                                                                          */
+/****************************************************************************/
+/*     H O T T E S T _ C I R C U I T S                                      */
+/****************************************************************************/
+/*                                                                          */
+void scheduler_stats::hottest_circuits(
+  const unsigned int   count,      /*!< Most circuits to return             */
+  vector< pair<uint64_t, unsigned int> > &hottest)/*!< Returned contention
+                                                       and index            */
+const
+{
+  hottest.clear();
+  for (unsigned int c = 0; c < _contention.size(); c++)
+    if (_contention[c] != 0)
+      hottest.push_back(make_pair(_contention[c], c));
+
+  // Most contention first, then the lowest index
+  for (unsigned int h = 0; h < hottest.size(); h++)
+    hottest[h].second = ~hottest[h].second;
+  const unsigned int kept = min(count, (unsigned int) hottest.size());
+  partial_sort(hottest.begin(), hottest.begin() + kept, hottest.end(),
+               greater< pair<uint64_t, unsigned int> >());
+  hottest.resize(kept);
+  for (unsigned int h = 0; h < hottest.size(); h++)
+    hottest[h].second = ~hottest[h].second;
+}
+
+
+/*                                                                          */
+/****************************************************************************/
+/*     W R I T E _ R E P O R T                                              */
+/****************************************************************************/
+/*                                                                          */
+void scheduler_stats::write_report(
+  ostream                     &os, /*!< The stream for the report           */
+  const unsigned int           hottest_count,/*!< Circuits to list          */
+  const vector<string>        &hottest_names)/*!< Their names               */
+const
+{
+  os << "{\"phases\":{";
+  for (unsigned int p = parse_phase; p < phase_count; p++)
+    os << (p == parse_phase ? "" : ",") << "\"" << phase_name((phase) p) <<
+          "\":{\"seconds\":" << _seconds[p] << ",\"entries\":" << _entries[p] << "}";
+  os << "}";
+  if (_counters != 0)
+    {
+      os << ",\"counters\":";
+      write_counters(os);
+    }
+  os << ",\"proposals\":" << _proposals <<
+        ",\"evictions\":" << _evictions <<
+        ",\"orphans\":" << _orphans <<
+        ",\"longest_chain\":" << _longest_chain <<
+        ",\"chains\":[";
+  for (unsigned int b = 0; b < chain_buckets; b++)
+    {
+      const uint64_t low = (b == 0) ? 0 : ((uint64_t) 1 << (b - 1));
+      os << (b == 0 ? "" : ",") << "{\"min\":" << low;
+      if (b != (chain_buckets - 1))
+        os << ",\"max\":" << ((b == 0) ? 0 : ((uint64_t) 1 << b) - 1);
+      os << ",\"count\":" << _chains[b] << "}";
+    }
+  os << "],\"hottest_circuits\":[";
+  vector< pair<uint64_t, unsigned int> > hottest;
+  hottest_circuits(hottest_count, hottest);
+  for (unsigned int h = 0; h < hottest.size(); h++)
+    {
+      os << (h == 0 ? "" : ",") << "{\"circuit\":\"";
+      if (h < hottest_names.size())
+        os << hottest_names[h];
+      os << "\",\"index\":" << hottest[h].second <<
+            ",\"contention\":" << hottest[h].first << "}";
+    }
+  os << "]}" << endl;
+}
+
+
+/*                                                                          */
+/****************************************************************************/
+/*     W R I T E _ C O U N T E R S                                          */
+/****************************************************************************/
+/*                                                                          */
+void scheduler_stats::write_counters(
+  ostream                     &os) /*!< The stream for the report           */
+const
+{
+  assert(_counters != 0);
+
+  // Counts per phase on this thread, then per worker of parallel phases
+  os << "{\"available\":[";
+  const char *separator = "";
+  for (unsigned int c = 0; c < perf_counters::counter_count; c++)
+    if (_counters->available((perf_counters::counter) c))
+      {
+        os << separator << "\"" << perf_counters::counter_name((perf_counters::counter) c) << "\"";
+        separator = ",";
+      }
+  os << "]";
+  if ( !_counters->unavailable_reason().empty() )
+    os << ",\"unavailable\":\"" << _counters->unavailable_reason() << "\"";
+  if (_counters->any_available())
+    {
+      os << ",\"phases\":{";
+      for (unsigned int p = parse_phase; p < phase_count; p++)
+        {
+          os << (p == parse_phase ? "" : ",") << "\"" << phase_name((phase) p) << "\":";
+          write_counts(os, *_counters, _counted[p]);
+        }
+      os << "},\"workers\":{";
+      separator = "";
+      for (unsigned int p = parse_phase; p < phase_count; p++)
+        if ( !_worker_counted[p].empty() )
+          {
+            os << separator << "\"" << phase_name((phase) p) << "\":[";
+            for (size_t w = 0; w < _worker_counted[p].size(); w += perf_counters::counter_count)
+              {
+                os << (w == 0 ? "" : ",");
+                write_counts(os, *_counters, &_worker_counted[p][w]);
+              }
+            os << "]";
+            separator = ",";
+          }
+      os << "}";
+    }
+  os << "}";
+}
+
+
+/*                                                                          */
+/****************************************************************************/
+/*     P R I N T _ S E L F                                                  */
+/****************************************************************************/
+/*                                                                          */
+ostream &scheduler_stats::print_self(
+  ostream    &os)                  /*!< The stream into which we stream     */
+const
+{
+  os << "scheduler_stats: proposals = " << _proposals <<
+        ", evictions = " << _evictions <<
+        ", orphans = " << _orphans <<
+        ", longest chain = " << _longest_chain;
+
+  return os;
+}
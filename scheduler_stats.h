@@ -0,0 +1,566 @@
+#ifndef scheduler_stats_h_included
+#define scheduler_stats_h_included 1
+
+/*!
+ * \file scheduler_stats.h
+ *
+ * \brief Contains the definition of scheduler_stats
+ *
+ * \author Stewart L. Palmer
+ */
+
+#include <iostream>
+#include <string>
+#include <utility>
+#include <vector>
+#include <assert.h>
+#include <stdint.h>
+#include "parallel_task.h"
+#include "perf_counters.h"
+#include "span_trace.h"
+
+
+/*!
+ * \brief Where a scheduler spends its time, and what its proposals did
+ *
+ * Every scheduler keeps one of these and it is always on, so nothing has to be
+ * rebuilt to see a profile.  The time is split into phases: the scheduler
+ * enters a phase through a phase_scope, and the time until it leaves, less the
+ * time spent in any phase entered inside, is charged to the phase.  Only the
+ * time of day is read at each change of phase, and the counters are plain
+ * increments, so the cost is a few nanoseconds per proposal.
+ *
+ * A chain is everything that follows from placing one juggler: the proposals
+ * it makes and those of the jugglers it evicts, and of the jugglers they
+ * evict, until someone finds room or runs out of preferences.  Its length is
+ * the number of evictions in it.  The contention of a circuit is the number of
+ * proposals it received while full, whether they evicted someone or were
+ * turned away.
+ *
+ * Hardware counting is off unless set_hardware_counting() turned it on before
+ * the scheduler_stats was constructed.  Each change of phase then also reads
+ * the perf_counters of the thread that constructed it, and the difference goes
+ * to the phase being left.  The workers of the validation and output phases
+ * run on their own threads, so a worker_counting given to the parallel_task
+ * opens counters on each of those threads and charges each worker its own
+ * counts; those show how evenly the work was shared.  A counter the machine
+ * will not give is left out of the report, which says why.
+ *
+ * In the same way, set_span_trace() gives every scheduler_stats constructed
+ * afterwards a span_trace; the scheduler records its spans there, and
+ * worker_counting adds one span per worker of each parallel phase.
+ */
+class scheduler_stats
+{
+public:
+
+  /*!
+   * \brief The phases to which time is charged
+   */
+  enum phase
+  {
+    idle_phase,                    /*!< Outside any phase                   */
+    parse_phase,                   /*!< Reading the circuits and jugglers   */
+    score_phase,                   /*!< Scoring the jugglers' preferences   */
+    propose_phase,                 /*!< Proposals and evictions             */
+    orphan_phase,                  /*!< Placing the orphans                 */
+    validate_phase,                /*!< Checking the assignments            */
+    output_phase,                  /*!< Writing the assignments             */
+    phase_count                    /*!< Number of phases                    */
+  };
+
+
+  /*!
+   * \brief Charges the time from its construction to its destruction to a
+   *        phase
+   */
+  class phase_scope
+  {
+  public:
+
+    /*!
+     * \brief Enter a phase
+     */
+    phase_scope(
+      scheduler_stats   &stats,    /*!< The statistics to charge            */
+      const phase        p)        /*!< The phase entered                   */
+    :
+    _stats(stats),
+    _outer(stats.enter_phase(p))
+    { }
+
+
+    /*!
+     * \brief Go back to the phase that was current before
+     */
+    ~phase_scope()
+    { _stats.leave_phase(_outer); }
+
+  private:
+
+    /*!
+     * \brief The copy constructor is deliberately private and unimplemented.
+     *
+     * \param rhs the object from which we are to be constructed
+     */
+    phase_scope(
+      const phase_scope   &rhs);
+
+    /*!
+     * \brief operator=() is deliberately private and unimplemented.
+     *
+     * \param rhs the object from which we are to be assigned
+     *
+     * \return reference to self to allow for chained operators
+     */
+    phase_scope &operator=(
+      const phase_scope   &rhs);
+
+
+    //! The statistics charged
+    scheduler_stats   &_stats;
+
+    //! The phase to go back to
+    const phase        _outer;
+
+  };
+
+
+  /*!
+   * \brief Charges the hardware counts of each worker of a parallel_task to
+   *        a phase, and records a span for each worker
+   *
+   * It does nothing unless the scheduler_stats counts hardware events or has
+   * a span_trace.
+   */
+  class worker_counting : public parallel_observer
+  {
+  public:
+
+    /*!
+     * \brief Standard constructor
+     */
+    worker_counting(
+      scheduler_stats   &stats,    /*!< The statistics to charge            */
+      const phase        p)        /*!< The phase the workers run in        */
+    :
+    _stats(stats),
+    _phase(p)
+    { }
+
+
+    /*!
+     * \brief Standard destructor
+     */
+    ~worker_counting();
+
+
+    /*!
+     * \brief Make room for every worker
+     */
+    void run_starting(
+      const unsigned int   workers /*!< Number of workers that will run     */
+                     );
+
+
+    /*!
+     * \brief Open and read the counters of the worker's thread
+     */
+    void worker_starting(
+      const unsigned int   worker  /*!< Worker number, from zero            */
+                        );
+
+
+    /*!
+     * \brief Charge the worker what its thread counted, and close them
+     */
+    void worker_finished(
+      const unsigned int   worker  /*!< Worker number, from zero            */
+                        );
+
+  private:
+
+    /*!
+     * \brief The copy constructor is deliberately private and unimplemented.
+     *
+     * \param rhs the object from which we are to be constructed
+     */
+    worker_counting(
+      const worker_counting   &rhs);
+
+    /*!
+     * \brief operator=() is deliberately private and unimplemented.
+     *
+     * \param rhs the object from which we are to be assigned
+     *
+     * \return reference to self to allow for chained operators
+     */
+    worker_counting &operator=(
+      const worker_counting   &rhs);
+
+
+    //! The statistics charged
+    scheduler_stats                &_stats;
+
+    //! The phase charged
+    const phase                     _phase;
+
+    //! Counters of each worker while it runs
+    std::vector<perf_counters *>    _counters;
+
+    //! Counts of each worker when it started, perf_counters::counter_count
+    //! per worker
+    std::vector<uint64_t>           _start;
+
+    //! Time each worker started, from span_trace::now()
+    std::vector<double>             _span_start;
+
+  };
+
+
+  //! Number of buckets of chain lengths: 0, 1, 2-3, 4-7, ..., and the rest
+  static const unsigned int chain_buckets = 16;
+
+
+  /*!
+   * \brief Standard constructor
+   */
+  scheduler_stats();
+
+
+  /*!
+   * \brief Destructor, which closes any hardware counters
+   */
+  ~scheduler_stats();
+
+
+  /*!
+   * \brief Turn hardware counting on or off for every scheduler_stats
+   *        constructed afterwards
+   *
+   * Set this before any threads that build schedulers start.
+   */
+  static void set_hardware_counting(
+    const bool           on        /*!< True to count                       */
+                                   );
+
+
+  /*!
+   * \brief Give a span_trace to every scheduler_stats constructed afterwards,
+   *        or zero for none
+   *
+   * Set this before any threads that build schedulers start.
+   */
+  static void set_span_trace(
+    span_trace          *spans     /*!< The trace, or zero                  */
+                            );
+
+
+  /*!
+   * \brief Return the span_trace to record in, or zero if not tracing
+   */
+  span_trace *spans() const
+  { return _spans; }
+
+
+  /*!
+   * \brief Return true if the hardware events of each phase are counted
+   */
+  bool counting_hardware() const
+  { return (_counters != 0); }
+
+
+  /*!
+   * \brief Return the hardware counters, or zero if not counting
+   */
+  const perf_counters *hardware_counters() const
+  { return _counters; }
+
+
+  /*!
+   * \brief Return a hardware count charged to a phase on the constructing
+   *        thread
+   */
+  uint64_t phase_count_of(
+    const phase                    p,/*!< The phase                         */
+    const perf_counters::counter   c)/*!< The counter                       */
+  const
+  { return _counted[p][c]; }
+
+
+  /*!
+   * \brief Return the name of a phase, as used in the report
+   */
+  static const char *phase_name(
+    const phase          p         /*!< The phase                           */
+                               );
+
+
+  /*!
+   * \brief Enter a phase, charging the time since the last change to the
+   *        phase that was current
+   *
+   * \return The phase that was current, to be given to leave_phase()
+   */
+  phase enter_phase(
+    const phase          p         /*!< The phase entered                   */
+                   );
+
+
+  /*!
+   * \brief Leave the current phase for the one it was entered from, charging
+   *        the time since the last change to the current phase
+   */
+  void leave_phase(
+    const phase          outer     /*!< As returned by enter_phase()        */
+                  );
+
+
+  /*!
+   * \brief Return the seconds charged to a phase
+   */
+  double phase_seconds(
+    const phase          p)        /*!< The phase                           */
+  const
+  { return _seconds[p]; }
+
+
+  /*!
+   * \brief Return the number of times a phase was entered
+   */
+  uint64_t phase_entries(
+    const phase          p)        /*!< The phase                           */
+  const
+  { return _entries[p]; }
+
+
+  /*!
+   * \brief Count a proposal
+   */
+  void count_proposal()
+  { _proposals++; }
+
+
+  /*!
+   * \brief Count a proposal to a full circuit, which evicted someone or was
+   *        turned away
+   */
+  void count_contention(
+    const unsigned int   circuit,  /*!< Index of the circuit                */
+    const bool           evicted)  /*!< True if someone was evicted         */
+  {
+    if (circuit >= _contention.size())
+      _contention.resize(circuit + 1, 0);
+    _contention[circuit]++;
+    if (evicted)
+      _evictions++;
+  }
+
+
+  /*!
+   * \brief Count a juggler left without a circuit
+   */
+  void count_orphan()
+  { _orphans++; }
+
+
+  /*!
+   * \brief Count a chain
+   */
+  void count_chain(
+    const uint64_t       length)   /*!< Number of evictions in the chain    */
+  {
+    unsigned int b = 0;
+    for (uint64_t n = length; (n != 0) && (b < (chain_buckets - 1)); n >>= 1)
+      b++;
+    _chains[b]++;
+    if (length > _longest_chain)
+      _longest_chain = length;
+  }
+
+
+  /*!
+   * \brief Return the number of proposals
+   */
+  uint64_t proposal_count() const
+  { return _proposals; }
+
+
+  /*!
+   * \brief Return the number of evictions
+   */
+  uint64_t eviction_count() const
+  { return _evictions; }
+
+
+  /*!
+   * \brief Return the number of times a juggler was left without a circuit
+   */
+  uint64_t orphan_count() const
+  { return _orphans; }
+
+
+  /*!
+   * \brief Return the number of chains whose length falls in a bucket
+   *
+   * Bucket zero holds chains with no evictions, and bucket b the chains of
+   * 2^(b-1) to 2^b - 1 evictions.  The last bucket also holds everything
+   * longer.
+   */
+  uint64_t chain_count(
+    const unsigned int   bucket)   /*!< The bucket                          */
+  const
+  {
+    assert(bucket < chain_buckets);
+    return _chains[bucket];
+  }
+
+
+  /*!
+   * \brief Return the number of evictions in the longest chain
+   */
+  uint64_t longest_chain() const
+  { return _longest_chain; }
+
+
+  /*!
+   * \brief Return the contention of a circuit
+   */
+  uint64_t contention(
+    const unsigned int   circuit)  /*!< Index of the circuit                */
+  const
+  { return (circuit < _contention.size()) ? _contention[circuit] : 0; }
+
+
+  /*!
+   * \brief Return the circuits with the most contention, most first
+   *
+   * Each is given as its contention and its index.  Circuits with none are
+   * left out.
+   */
+  void hottest_circuits(
+    const unsigned int   count,    /*!< Most circuits to return             */
+    std::vector< std::pair<uint64_t, unsigned int> > &hottest/*!< Returned
+                                                    contention and index    */
+                       )
+  const;
+
+
+  /*!
+   * \brief Write everything as one JSON object on one line
+   *
+   * The names are those of the hottest circuits, as from hottest_circuits().
+   */
+  void write_report(
+    std::ostream                     &os,/*!< The stream for the report     */
+    const unsigned int                hottest_count,/*!< Circuits to list   */
+    const std::vector<std::string>   &hottest_names/*!< Their names         */
+                   )
+  const;
+
+
+  /*!
+   * \brief Write the hardware counts as one JSON object, which write_report()
+   *        includes as "counters"
+   *
+   * It lists the counters available and why any are not, the counts of each
+   * phase, and the counts of each worker of the phases run by worker_counting.
+   * Call it only when counting_hardware().
+   */
+  void write_counters(
+    std::ostream                     &os/*!< The stream for the report      */
+                     )
+  const;
+
+
+  /*!
+   *  \brief Stream object out to a stream
+   *
+   * \return The same stream as the input to allow for chained operators.
+   */
+  friend std::ostream &operator<<(
+    std::ostream            &os,   /*!< The stream into which we stream     */
+    const scheduler_stats   &cn)   /*!< The object to be streamed           */
+  {
+    return cn.print_self(os);
+  }
+
+private:
+
+  /*!
+   * \brief The copy constructor is deliberately private and unimplemented.
+   *
+   * \param rhs the object from which we are to be constructed
+   */
+  scheduler_stats(
+    const scheduler_stats   &rhs);
+
+  /*!
+   * \brief operator=() is deliberately private and unimplemented.
+   *
+   * \param rhs the object from which we are to be assigned
+   *
+   * \return reference to self to allow for chained operators
+   */
+  scheduler_stats &operator=(
+    const scheduler_stats   &rhs);
+
+  /*!
+   * \brief This is the implementation function for operator<<()
+   *
+   * \return The same stream as the input to allow for chained operators.
+   */
+  std::ostream &print_self(
+    std::ostream    &os)           /*!< The stream into which we stream     */
+  const;
+
+
+  //! The phase being charged
+  phase                   _current;
+
+  //! Time of the last change of phase, in seconds
+  double                  _since;
+
+  //! Seconds charged to each phase
+  double                  _seconds[phase_count];
+
+  //! Number of times each phase was entered
+  uint64_t                _entries[phase_count];
+
+  //! Hardware counters of the constructing thread, or zero if not counting
+  perf_counters          *_counters;
+
+  //! Hardware counts at the last change of phase
+  uint64_t                _last[perf_counters::counter_count];
+
+  //! Hardware counts charged to each phase
+  uint64_t                _counted[phase_count][perf_counters::counter_count];
+
+  //! Hardware counts charged to each worker of each phase,
+  //! perf_counters::counter_count per worker
+  std::vector<uint64_t>   _worker_counted[phase_count];
+
+  //! Where the scheduler records its spans, or zero
+  span_trace             *_spans;
+
+  //! Number of proposals
+  uint64_t                _proposals;
+
+  //! Number of evictions
+  uint64_t                _evictions;
+
+  //! Number of times a juggler was left without a circuit
+  uint64_t                _orphans;
+
+  //! Number of chains in each bucket of lengths
+  uint64_t                _chains[chain_buckets];
+
+  //! Number of evictions in the longest chain
+  uint64_t                _longest_chain;
+
+  //! Contention of each circuit, by circuit index
+  std::vector<uint64_t>   _contention;
+
+};
+
+#endif                             /* scheduler_stats_h_included            */
@@ -0,0 +1,362 @@
+
+/*!
+ * \file snapshot_store.cpp
+ *
+ * \brief Contains the implementation of snapshot_store
+ *
+ * \author Stewart L. Palmer
+ */
+
+#include <limits.h>
+#include "juggler_circuit.h"
+#include "scheduler.h"
+#include "snapshot_store.h"
+
+using namespace ::std;
+
+
+namespace
+{
+
+/*!
+ * \brief Return the entry of a juggler as it is now
+ */
+daemon_entry make_entry(
+  const juggler   &jug)            /*!< The juggler                         */
+{
+  daemon_entry entry;
+  entry.juggler = jug.id();
+  entry.circuit = -1;
+  entry.score = 0;
+  entry.preference = 0;
+  if (jug.is_withdrawn())
+    entry.juggler = -1;
+  else if (jug.is_assigned())
+    {
+      const juggler_circuit &jc = jug.assignment();
+      entry.circuit = jc.circ().id();
+      entry.score = jc.score();
+      entry.preference = jc.preference();
+    }
+
+  return entry;
+}
+
+
+/*!
+ * \brief Return the block that holds a page or roster in a snapshot, copying
+ *        it the first time a publication changes it
+ */
+template <class T>
+assignment_snapshot::block<T> &writable_block(
+  vector<const assignment_snapshot::block<T> *>   &blocks,/*!< The table of
+                                                               blocks       */
+  map<uint32_t, assignment_snapshot::block<T> *>  &copied,/*!< Blocks the
+                                                               publication
+                                                               copied       */
+  vector< pair<const assignment_snapshot::block<T> *, uint64_t> > &retired,
+                                   /*!< Where a replaced block is retired   */
+  const uint64_t                  version,/*!< Version being published      */
+  const uint32_t                  number) /*!< Number of the page or roster */
+{
+  typedef assignment_snapshot::block<T>  block_type;
+  const uint32_t b = number / assignment_snapshot::block_size;
+  const typename map<uint32_t, block_type *>::iterator it = copied.find(b);
+  if (it != copied.end())
+    return *it->second;
+
+  if (blocks.size() <= b)
+    blocks.resize(b + 1, (const block_type *) 0);
+  block_type *const fresh = new block_type;
+  const block_type *const old = blocks[b];
+  if (old != 0)
+    {
+      *fresh = *old;
+      retired.push_back(make_pair(old, version));
+    }
+  else
+    for (unsigned int i = 0; i < assignment_snapshot::block_size; i++)
+      fresh->items[i] = 0;
+  blocks[b] = fresh;
+  copied.insert(make_pair(b, fresh));
+
+  return *fresh;
+}
+
+
+/*!
+ * \brief Free the retired parts replaced by version oldest or before
+ */
+template <class T>
+void free_retired(
+  vector< pair<const T *, uint64_t> >  &retired,/*!< Parts and the versions
+                                                     that replaced them     */
+  const uint64_t                        oldest)/*!< Oldest version a reader
+                                                    is inside at            */
+{
+  unsigned int kept = 0;
+  for (unsigned int i = 0; i < retired.size(); i++)
+    if (retired[i].second <= oldest)
+      delete retired[i].first;
+    else
+      retired[kept++] = retired[i];
+  retired.resize(kept);
+}
+
+}
+
+
+/*                                                                          */
+/****************************************************************************/
+/*     C O N S T R U C T O R                                                */
+/****************************************************************************/
+/*                                                                          */
+snapshot_store::snapshot_store(
+  scheduler            &sched,     /*!< The scheduler to publish            */
+  const unsigned int    readers)   /*!< Number of reader numbers            */
+  :
+  _sched(sched),
+  _reader_count(readers),
+  _readers(new reader_slot[readers]),
+  _current(0),
+  _version(0)
+{
+  for (unsigned int r = 0; r < _reader_count; r++)
+    _readers[r].version = 0;
+}
+
+
+/*                                                                          */
+/****************************************************************************/
+/*     D E S T R U C T O R                                                  */
+/****************************************************************************/
+/*                                                                          */
+snapshot_store::~snapshot_store()
+{
+  for (unsigned int r = 0; r < _reader_count; r++)
+    _readers[r].version = 0;
+  reclaim();
+  assert(retired_count() == 0);
+
+  if (_current != 0)
+    {
+      const assignment_snapshot &snap = *_current;
+      for (unsigned int b = 0; b < snap._page_blocks.size(); b++)
+        if (snap._page_blocks[b] != 0)
+          {
+            for (unsigned int i = 0; i < assignment_snapshot::block_size; i++)
+              delete snap._page_blocks[b]->items[i];
+            delete snap._page_blocks[b];
+          }
+      for (unsigned int b = 0; b < snap._roster_blocks.size(); b++)
+        if (snap._roster_blocks[b] != 0)
+          {
+            for (unsigned int i = 0; i < assignment_snapshot::block_size; i++)
+              delete snap._roster_blocks[b]->items[i];
+            delete snap._roster_blocks[b];
+          }
+      delete _current;
+    }
+  delete [] _readers;
+}
+
+
+/*                                                                          */
+/****************************************************************************/
+/*     P U B L I S H                                                        */
+/****************************************************************************/
+/*                                                                          */
+void snapshot_store::publish(
+  const vector<const juggler *> &jugglers)/*!< Jugglers added or withdrawn  */
+{
+  const uint64_t version = _version + 1;
+  assignment_snapshot *const next = new assignment_snapshot(version);
+  copies copied;
+
+  vector<circuit *> changed;
+  _sched.take_unpublished_circuits(changed);
+
+  if (_current == 0)
+    {
+      // Everything is new, so every circuit and juggler is copied
+      vector<circuit *> circuits;
+      _sched.circuits_by_index(circuits);
+      for (unsigned int c = 0; c < circuits.size(); c++)
+        set_roster(*next, copied, *circuits[c]);
+      vector<juggler *> all;
+      _sched.jugglers_by_index(all);
+      for (unsigned int j = 0; j < all.size(); j++)
+        set_entry(*next, copied, all[j]->id(), make_entry(*all[j]));
+    }
+  else
+    {
+      // Share what did not change, and retire what is replaced; only the
+      // tables of blocks are copied whole, and they are short
+      const assignment_snapshot &prev = *_current;
+      next->_page_blocks = prev._page_blocks;
+      next->_roster_blocks = prev._roster_blocks;
+      for (unsigned int c = 0; c < changed.size(); c++)
+        {
+          const circuit &circ = *changed[c];
+          const roster *const old = next->find_roster(circ.id());
+          if (old == 0)
+            continue;
+          for (unsigned int e = 0; e < old->entries.size(); e++)
+            {
+              daemon_entry left = old->entries[e];
+              left.circuit = -1;
+              left.score = 0;
+              left.preference = 0;
+              set_entry(*next, copied, left.juggler, left);
+            }
+          clear_roster(*next, copied, circ.id());
+        }
+      for (unsigned int c = 0; c < changed.size(); c++)
+        {
+          const circuit &circ = *changed[c];
+          set_roster(*next, copied, circ);
+          const roster &ros = *next->find_roster(circ.id());
+          for (unsigned int e = 0; e < ros.entries.size(); e++)
+            set_entry(*next, copied, ros.entries[e].juggler, ros.entries[e]);
+        }
+      _retired_snapshots.push_back(make_pair(&prev, version));
+    }
+
+  // The jugglers given last, since they may have left every roster
+  for (unsigned int j = 0; j < jugglers.size(); j++)
+    set_entry(*next, copied, jugglers[j]->id(), make_entry(*jugglers[j]));
+
+  _current = next;
+  __sync_synchronize();            /* The snapshot before its version       */
+  _version = version;
+  __sync_synchronize();            /* The version before looking at readers */
+
+  reclaim();
+}
+
+
+/*                                                                          */
+/****************************************************************************/
+/*     S E T _ R O S T E R                                                  */
+/****************************************************************************/
+/*                                                                          */
+void snapshot_store::set_roster(
+  assignment_snapshot   &snap,     /*!< The snapshot being built            */
+  copies                &copied,   /*!< What the publication has copied     */
+  const circuit         &circ)     /*!< The circuit                         */
+{
+  roster *const ros = new roster;
+  vector<const juggler_circuit *> assigned;
+  circ.assigned_jugglers(assigned);
+  ros->entries.resize(assigned.size());
+  ros->sum = 0;
+  for (unsigned int a = 0; a < assigned.size(); a++)
+    {
+      ros->entries[a] = make_entry(assigned[a]->jug());
+      ros->sum += assigned[a]->juggler_id();
+    }
+  ros->cutoff = circ.is_full() ? circ.lowest_score() : INT_MIN;
+
+  const uint32_t c = circ.id();
+  roster_block &blk = writable_block(snap._roster_blocks, copied.roster_blocks,
+                                     _retired_roster_blocks, _version + 1, c);
+  assert(blk.items[c % assignment_snapshot::block_size] == 0);
+  blk.items[c % assignment_snapshot::block_size] = ros;
+}
+
+
+/*                                                                          */
+/****************************************************************************/
+/*     C L E A R _ R O S T E R                                              */
+/****************************************************************************/
+/*                                                                          */
+void snapshot_store::clear_roster(
+  assignment_snapshot   &snap,     /*!< The snapshot being built            */
+  copies                &copied,   /*!< What the publication has copied     */
+  const uint32_t         circuit)  /*!< Number of the circuit               */
+{
+  roster_block &blk = writable_block(snap._roster_blocks, copied.roster_blocks,
+                                     _retired_roster_blocks, _version + 1, circuit);
+  const roster *&ros = blk.items[circuit % assignment_snapshot::block_size];
+  assert(ros != 0);
+  _retired_rosters.push_back(make_pair(ros, _version + 1));
+  ros = 0;
+}
+
+
+/*                                                                          */
+/****************************************************************************/
+/*     S E T _ E N T R Y                                                    */
+/****************************************************************************/
+/*                                                                          */
+void snapshot_store::set_entry(
+  assignment_snapshot   &snap,     /*!< The snapshot being built            */
+  copies                &copied,   /*!< What the publication has copied     */
+  const uint32_t         juggler,  /*!< Number of the juggler               */
+  const daemon_entry    &entry)    /*!< The entry, or juggler -1 for none   */
+{
+  const uint32_t p = juggler / assignment_snapshot::page_size;
+  page *pg = 0;
+  const map<uint32_t, page *>::iterator it = copied.pages.find(p);
+  if (it != copied.pages.end())
+    pg = it->second;
+  else
+    {
+      page_block &blk = writable_block(snap._page_blocks, copied.page_blocks,
+                                       _retired_page_blocks, _version + 1, p);
+      const page *&slot = blk.items[p % assignment_snapshot::block_size];
+      pg = new page;
+      if (slot != 0)
+        {
+          *pg = *slot;
+          _retired_pages.push_back(make_pair(slot, _version + 1));
+        }
+      else
+        for (unsigned int e = 0; e < assignment_snapshot::page_size; e++)
+          pg->entries[e].juggler = -1;
+      slot = pg;
+      copied.pages.insert(make_pair(p, pg));
+    }
+  pg->entries[juggler % assignment_snapshot::page_size] = entry;
+}
+
+
+/*                                                                          */
+/****************************************************************************/
+/*     R E C L A I M                                                        */
+/****************************************************************************/
+/*                                                                          */
+void snapshot_store::reclaim()
+{
+  // A reader inside at version v may hold anything still current at v, so
+  // what version r replaced is safe once every reader inside is at r or later
+  uint64_t oldest = _version;
+  for (unsigned int r = 0; r < _reader_count; r++)
+    {
+      const uint64_t v = _readers[r].version;
+      if ( (v != 0) && (v < oldest) )
+        oldest = v;
+    }
+
+  free_retired(_retired_snapshots, oldest);
+  free_retired(_retired_page_blocks, oldest);
+  free_retired(_retired_roster_blocks, oldest);
+  free_retired(_retired_pages, oldest);
+  free_retired(_retired_rosters, oldest);
+}
+
+
+/*                                                                          */
+/****************************************************************************/
+/*     P R I N T _ S E L F                                                  */
+/****************************************************************************/
+/*                                                                          */
+ostream &snapshot_store::print_self(
+  ostream    &os)                  /*!< The stream into which we stream     */
+const
+{
+  os << "snapshot_store: version " << _version << ", " << _reader_count <<
+        " readers, " << retired_count() << " retired";
+
+  return os;
+}
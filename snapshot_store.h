@@ -0,0 +1,284 @@
+#ifndef snapshot_store_h_included
+#define snapshot_store_h_included 1
+
+/*!
+ * \file snapshot_store.h
+ *
+ * \brief Contains the definition of snapshot_store
+ *
+ * \author Stewart L. Palmer
+ */
+
+#include <assert.h>
+#include <iostream>
+#include <map>
+#include <utility>
+#include <vector>
+#include <stdint.h>
+#include "assignment_snapshot.h"
+
+class circuit;
+class juggler;
+class scheduler;
+
+
+/*!
+ * \brief Publishes snapshots of a scheduler's assignments to lock-free readers
+ *
+ * One writer changes the scheduler and then calls publish(), which builds the
+ * next assignment_snapshot from the circuits that changed, sharing everything
+ * else with the snapshot before it, and makes it current with a single pointer
+ * store.  Any number of readers, each with its own reader number, call enter()
+ * to get the current snapshot and leave() when done with it.  Readers never
+ * wait for the writer or for each other.
+ *
+ * The parts a publication replaces cannot be freed while a reader may still be
+ * looking at them.  Each reader announces the version it entered at in a slot
+ * of its own, and the parts replaced by version v are freed by a later
+ * publish() once no reader is inside with a version below v.  A reader that
+ * stays inside for a long time only delays the freeing.
+ */
+class snapshot_store
+{
+public:
+
+  /*!
+   * \brief Standard constructor
+   *
+   * Nothing is published until publish() is called.
+   */
+  explicit snapshot_store(
+    scheduler            &sched,   /*!< The scheduler to publish            */
+    const unsigned int    readers  /*!< Number of reader numbers            */
+                         );
+
+
+  /*!
+   * \brief Destructor
+   *
+   * No reader may be inside.
+   */
+  ~snapshot_store();
+
+
+  /*!
+   * \brief Publish the assignments as they are now
+   *
+   * The first publication copies everything.  Later ones copy only the circuits
+   * that changed, the jugglers on their rosters before and after, and the
+   * jugglers given, which must include any juggler added or withdrawn since
+   * the last publication.  Only the writer may call this.
+   */
+  void publish(
+    const std::vector<const juggler *> &jugglers/*!< Jugglers added or
+                                                     withdrawn              */
+              );
+
+
+  /*!
+   * \brief Return the snapshot published last
+   *
+   * Only the writer may call this, since only the writer frees snapshots.
+   */
+  const assignment_snapshot &current() const
+  { return *_current; }
+
+
+  /*!
+   * \brief Start reading the current snapshot
+   *
+   * The snapshot stays valid until leave() is called with the same reader
+   * number.  Each reader number may be inside only once at a time.
+   */
+  const assignment_snapshot &enter(
+    const unsigned int    reader   /*!< Number of the reader                */
+                                  )
+  {
+    assert(reader < _reader_count);
+    _readers[reader].version = _version;
+    __sync_synchronize();          /* Announce before looking               */
+
+    return *_current;
+  }
+
+
+  /*!
+   * \brief Stop reading the snapshot returned by enter()
+   */
+  void leave(
+    const unsigned int    reader   /*!< Number of the reader                */
+            )
+  {
+    assert(reader < _reader_count);
+    __sync_synchronize();          /* Finish looking before going           */
+    _readers[reader].version = 0;
+  }
+
+
+  /*!
+   * \brief Return the number of reader numbers
+   */
+  unsigned int reader_count() const
+  { return _reader_count; }
+
+
+  /*!
+   * \brief Return the number of replaced parts not yet freed
+   */
+  unsigned int retired_count() const
+  {
+    return _retired_snapshots.size() + _retired_page_blocks.size() +
+           _retired_roster_blocks.size() + _retired_pages.size() + _retired_rosters.size();
+  }
+
+
+  /*!
+   *  \brief Stream object out to a stream
+   *
+   * \return The same stream as the input to allow for chained operators.
+   */
+  friend std::ostream &operator<<(
+    std::ostream           &os,    /*!< The stream into which we stream     */
+    const snapshot_store   &cn)    /*!< The object to be streamed           */
+  {
+    return cn.print_self(os);
+  }
+
+private:
+
+  typedef assignment_snapshot::page          page;
+  typedef assignment_snapshot::roster        roster;
+  typedef assignment_snapshot::page_block    page_block;
+  typedef assignment_snapshot::roster_block  roster_block;
+
+
+  /*!
+   * \brief The blocks and pages a publication has copied, which only it holds
+   *        and so may still change
+   */
+  struct copies
+  {
+    //! Copied blocks of pages, by block number
+    std::map<uint32_t, page_block *>     page_blocks;
+
+    //! Copied blocks of rosters, by block number
+    std::map<uint32_t, roster_block *>   roster_blocks;
+
+    //! Copied pages, by page number
+    std::map<uint32_t, page *>           pages;
+  };
+
+
+  /*!
+   * \brief The version a reader entered at, or zero, alone on a cache line
+   */
+  struct reader_slot
+  {
+    //! Version entered at, or zero when outside
+    volatile uint64_t   version;
+
+    //! Keeps the slots of different readers on different cache lines
+    char                padding[64 - sizeof(uint64_t)];
+  };
+
+
+  /*!
+   * \brief The copy constructor is deliberately private and unimplemented.
+   *
+   * \param rhs the object from which we are to be constructed
+   */
+  snapshot_store(
+    const snapshot_store   &rhs);
+
+  /*!
+   * \brief operator=() is deliberately private and unimplemented.
+   *
+   * \param rhs the object from which we are to be assigned
+   *
+   * \return reference to self to allow for chained operators
+   */
+  snapshot_store &operator=(
+    const snapshot_store   &rhs);
+
+  /*!
+   * \brief This is the implementation function for operator<<()
+   *
+   * \return The same stream as the input to allow for chained operators.
+   */
+  std::ostream &print_self(
+    std::ostream    &os)           /*!< The stream into which we stream     */
+  const;
+
+
+  /*!
+   * \brief Put a roster of a circuit as it is now into a snapshot
+   */
+  void set_roster(
+    assignment_snapshot   &snap,   /*!< The snapshot being built            */
+    copies                &copied, /*!< What the publication has copied     */
+    const circuit         &circ    /*!< The circuit                         */
+                 );
+
+
+  /*!
+   * \brief Take a roster of a circuit out of a snapshot, retiring it
+   */
+  void clear_roster(
+    assignment_snapshot   &snap,   /*!< The snapshot being built            */
+    copies                &copied, /*!< What the publication has copied     */
+    const uint32_t         circuit /*!< Number of the circuit               */
+                   );
+
+
+  /*!
+   * \brief Put the entry of a juggler into a snapshot, copying its page the
+   *        first time
+   */
+  void set_entry(
+    assignment_snapshot   &snap,   /*!< The snapshot being built            */
+    copies                &copied, /*!< What the publication has copied     */
+    const uint32_t         juggler,/*!< Number of the juggler               */
+    const daemon_entry    &entry   /*!< The entry, or juggler -1 for none   */
+                );
+
+
+
+  /*!
+   * \brief Free the retired parts that no reader can be looking at
+   */
+  void reclaim();
+
+
+  //! The scheduler being published
+  scheduler                     &_sched;
+
+  //! Number of reader numbers
+  const unsigned int             _reader_count;
+
+  //! Slot of each reader
+  reader_slot                   *_readers;
+
+  //! The snapshot published last, or zero
+  const assignment_snapshot *volatile _current;
+
+  //! Version of the snapshot published last
+  volatile uint64_t              _version;
+
+  //! Snapshots replaced, with the version that replaced them
+  std::vector< std::pair<const assignment_snapshot *, uint64_t> > _retired_snapshots;
+
+  //! Blocks of pages replaced, with the version that replaced them
+  std::vector< std::pair<const page_block *, uint64_t> >          _retired_page_blocks;
+
+  //! Blocks of rosters replaced, with the version that replaced them
+  std::vector< std::pair<const roster_block *, uint64_t> >        _retired_roster_blocks;
+
+  //! Pages replaced, with the version that replaced them
+  std::vector< std::pair<const page *, uint64_t> >                _retired_pages;
+
+  //! Rosters replaced, with the version that replaced them
+  std::vector< std::pair<const roster *, uint64_t> >              _retired_rosters;
+
+};
+
+#endif                             /* snapshot_store_h_included             */
@@ -0,0 +1,487 @@
+
+/*!
+ * \file solver_daemon.cpp
+ *
+ * \brief Contains the implementation of solver_daemon
+ *
+ * \author Stewart L. Palmer
+ */
+
+#include <errno.h>
+#include <limits.h>
+#include <signal.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include "juggler_circuit.h"
+#include "output_buffer.h"
+#include "scheduler.h"
+#include "solver_daemon.h"
+
+using namespace ::std;
+
+
+namespace
+{
+
+/*!
+ * \brief Append a reply with no entries
+ */
+void append_reply(
+  output_buffer        &ob,        /*!< Buffer for the reply                */
+  const daemon_status   status,    /*!< How the request turned out          */
+  const int32_t         value,     /*!< Result of the request               */
+  const uint32_t        entry_count)/*!< Number of entries to follow        */
+{
+  daemon_reply reply;
+  reply.status = status;
+  reply.value = value;
+  reply.entry_count = entry_count;
+  ob.append(reinterpret_cast<const char *>(&reply), sizeof(reply));
+}
+
+
+/*!
+ * \brief Append entries
+ */
+void append_entries(
+  output_buffer        &ob,        /*!< Buffer for the entries              */
+  const daemon_entry   *entries,   /*!< The entries                         */
+  const uint32_t        count)     /*!< Number of entries                   */
+{
+  if (count != 0)
+    ob.append(reinterpret_cast<const char *>(entries), count * sizeof(daemon_entry));
+}
+
+
+/*!
+ * \brief Return the name of a juggler or circuit from its number
+ */
+string make_name(
+  const char       letter,         /*!< J or C                              */
+  const uint32_t   id)             /*!< The number                          */
+{
+  char name[16];
+  sprintf(name, "%c%u", letter, (unsigned int) id);
+
+  return name;
+}
+
+}
+
+
+/*                                                                          */
+/****************************************************************************/
+/*     C O N S T R U C T O R                                                */
+/****************************************************************************/
+/*                                                                          */
+solver_daemon::solver_daemon(
+  scheduler            &sched,     /*!< The solved scheduler to serve       */
+  const string         &path)      /*!< Path of the socket                  */
+  :
+  _sched(sched),
+  _path(path),
+  _listener(-1),
+  _store(sched, connection_limit),
+  _validation(0),
+  _invalid_change_count(0),
+  _bound(false),
+  _stopping(false),
+  _request_count(0)
+{
+  pthread_mutex_init(&_writer, 0);
+  pthread_mutex_init(&_lock, 0);
+  for (unsigned int r = connection_limit; r > 0; r--)
+    _free_readers.push_back(r - 1);
+}
+
+
+/*                                                                          */
+/****************************************************************************/
+/*     D E S T R U C T O R                                                  */
+/****************************************************************************/
+/*                                                                          */
+solver_daemon::~solver_daemon()
+{
+  reap_connections(true);
+  if (_listener >= 0)
+    close(_listener);
+  if (_bound)
+    unlink(_path.c_str());
+  pthread_mutex_destroy(&_lock);
+  pthread_mutex_destroy(&_writer);
+}
+
+
+/*                                                                          */
+/****************************************************************************/
+/*     S E R V E                                                            */
+/****************************************************************************/
+/*                                                                          */
+int solver_daemon::serve(
+  ostream         &os)             /*!< Stream for error reporting          */
+{
+  // A client that goes away must not take the daemon with it
+  signal(SIGPIPE, SIG_IGN);
+
+  sockaddr_un address;
+  memset(&address, 0, sizeof(address));
+  address.sun_family = AF_UNIX;
+  if (_path.size() >= sizeof(address.sun_path))
+    {
+      os << "Socket path " << _path << " is too long." << endl;
+      return 1;
+    }
+  memcpy(address.sun_path, _path.c_str(), _path.size());
+
+  // Replace a socket left by an earlier daemon, but nothing else
+  struct stat st;
+  if ( (stat(_path.c_str(), &st) == 0) && S_ISSOCK(st.st_mode) )
+    unlink(_path.c_str());
+
+  _listener = socket(AF_UNIX, SOCK_STREAM, 0);
+  if (_listener < 0)
+    {
+      os << "Cannot create a socket: " << strerror(errno) << endl;
+      return 1;
+    }
+  if (bind(_listener, reinterpret_cast<sockaddr *>(&address), sizeof(address)) != 0)
+    {
+      os << "Cannot bind " << _path << ": " << strerror(errno) << endl;
+      return 1;
+    }
+  _bound = true;
+  if (listen(_listener, SOMAXCONN) != 0)
+    {
+      os << "Cannot listen on " << _path << ": " << strerror(errno) << endl;
+      return 1;
+    }
+
+  // Lookups are answered from snapshots, so there must be one to begin with
+  _store.publish(vector<const juggler *>());
+
+  while ( !_stopping )
+  {
+    const int fd = accept(_listener, 0, 0);
+    reap_connections(false);
+    if (fd < 0)
+      {
+        if ( (errno == EINTR) || (errno == ECONNABORTED) || _stopping )
+          continue;
+        os << "Cannot accept a connection: " << strerror(errno) << endl;
+        reap_connections(true);
+        return 1;
+      }
+
+    pthread_mutex_lock(&_lock);
+    connection *conn = 0;
+    if ( !_free_readers.empty() )
+      {
+        conn = new connection;
+        conn->daemon = this;
+        conn->fd = fd;
+        conn->reader = _free_readers.back();
+        conn->done = false;
+        _free_readers.pop_back();
+        if (pthread_create(&conn->thread, 0, connection_main, conn) == 0)
+          _connections.push_back(conn);
+        else
+          {
+            _free_readers.push_back(conn->reader);
+            delete conn;
+            conn = 0;
+          }
+      }
+    pthread_mutex_unlock(&_lock);
+    if (conn == 0)                 /* Too many connections already          */
+      close(fd);
+  }
+  reap_connections(true);
+
+  return 0;
+}
+
+
+/*                                                                          */
+/****************************************************************************/
+/*     C O N N E C T I O N _ M A I N                                        */
+/****************************************************************************/
+/*                                                                          */
+void *solver_daemon::connection_main(
+  void           *arg)             /*!< The connection                      */
+{
+  connection &conn = *static_cast<connection *>(arg);
+  solver_daemon &daemon = *conn.daemon;
+  while ( !daemon._stopping && (daemon.handle_input(conn) == 0) )
+  { }
+
+  // The fd stays open until the thread is joined, so it cannot be reused
+  // while serve() may still shut it down
+  pthread_mutex_lock(&daemon._lock);
+  conn.done = true;
+  pthread_mutex_unlock(&daemon._lock);
+
+  return 0;
+}
+
+
+/*                                                                          */
+/****************************************************************************/
+/*     R E A P _ C O N N E C T I O N S                                      */
+/****************************************************************************/
+/*                                                                          */
+void solver_daemon::reap_connections(
+  const bool      all)             /*!< True to wait for every connection   */
+{
+  pthread_mutex_lock(&_lock);
+  if (all)                         /* Wake the threads waiting in read()    */
+    for (unsigned int c = 0; c < _connections.size(); c++)
+      shutdown(_connections[c]->fd, SHUT_RDWR);
+  vector<connection *> finished;
+  unsigned int kept = 0;
+  for (unsigned int c = 0; c < _connections.size(); c++)
+    {
+      connection *const conn = _connections[c];
+      if (all || conn->done)
+        finished.push_back(conn);
+      else
+        _connections[kept++] = conn;
+    }
+  _connections.resize(kept);
+  pthread_mutex_unlock(&_lock);
+
+  for (unsigned int c = 0; c < finished.size(); c++)
+    {
+      connection *const conn = finished[c];
+      pthread_join(conn->thread, 0);
+      close(conn->fd);
+      pthread_mutex_lock(&_lock);
+      _free_readers.push_back(conn->reader);
+      pthread_mutex_unlock(&_lock);
+      delete conn;
+    }
+}
+
+
+/*                                                                          */
+/****************************************************************************/
+/*     H A N D L E _ I N P U T                                              */
+/****************************************************************************/
+/*                                                                          */
+int solver_daemon::handle_input(
+  connection     &conn)            /*!< The connection                      */
+{
+  char chunk[65536];
+  const ssize_t n = read(conn.fd, chunk, sizeof(chunk));
+  if (n < 0)
+    return (errno == EINTR) ? 0 : 1;
+  if (n == 0)                      /* The client has gone                   */
+    return 1;
+  conn.input.insert(conn.input.end(), chunk, chunk + n);
+
+  output_buffer ob;
+  vector<uint32_t> preferences;
+  size_t used = 0;
+  int rc = 0;
+  while ( (rc == 0) && ((conn.input.size() - used) >= sizeof(daemon_request)) )
+  {
+    daemon_request request;
+    memcpy(&request, &conn.input[used], sizeof(request));
+    if (request.preference_count > daemon_max_preferences)
+      {
+        append_reply(ob, malformed_status, 0, 0);
+        rc = 1;
+        break;
+      }
+    const size_t size = sizeof(request) + request.preference_count * sizeof(uint32_t);
+    if ((conn.input.size() - used) < size)
+      break;                       /* The rest has not arrived yet          */
+    preferences.resize(request.preference_count);
+    if (request.preference_count != 0)
+      memcpy(&preferences[0], &conn.input[used + sizeof(request)],
+             request.preference_count * sizeof(uint32_t));
+    used += size;
+    rc = answer(conn.reader, request, preferences, ob);
+    __sync_fetch_and_add(&_request_count, 1);
+  }
+  conn.input.erase(conn.input.begin(), conn.input.begin() + used);
+
+  if ( (ob.size() != 0) && (ob.write_to(conn.fd) != 0) )
+    rc = 1;
+
+  // Wake serve() from accept() once the shutdown has been answered
+  if (_stopping)
+    shutdown(_listener, SHUT_RDWR);
+
+  return rc;
+}
+
+
+/*                                                                          */
+/****************************************************************************/
+/*     A N S W E R                                                          */
+/****************************************************************************/
+/*                                                                          */
+int solver_daemon::answer(
+  const unsigned int             reader,/*!< Reader number of the connection*/
+  const daemon_request          &request,/*!< The request                   */
+  const vector<uint32_t>        &preferences,/*!< Its circuit numbers       */
+  output_buffer                 &ob)/*!< Buffer for the reply               */
+{
+  if ( (request.operation != add_operation) && (request.preference_count != 0) )
+    {
+      append_reply(ob, malformed_status, 0, 0);
+      return 1;
+    }
+
+  switch (request.operation)
+  {
+    case locate_operation:
+      {
+        const assignment_snapshot &snap = _store.enter(reader);
+        const daemon_entry *const e = snap.locate(request.id);
+        if (e == 0)
+          append_reply(ob, not_found_status, 0, 0);
+        else
+          {
+            append_reply(ob, ok_status, 0, 1);
+            append_entries(ob, e, 1);
+          }
+        _store.leave(reader);
+      }
+      break;
+    case roster_operation:
+      {
+        const assignment_snapshot &snap = _store.enter(reader);
+        const assignment_snapshot::roster *const r = snap.find_roster(request.id);
+        if (r == 0)
+          append_reply(ob, not_found_status, 0, 0);
+        else
+          {
+            append_reply(ob, ok_status, r->sum, r->entries.size());
+            if ( !r->entries.empty() )
+              append_entries(ob, &r->entries[0], r->entries.size());
+          }
+        _store.leave(reader);
+      }
+      break;
+    case cutoff_operation:
+      {
+        const assignment_snapshot &snap = _store.enter(reader);
+        const assignment_snapshot::roster *const r = snap.find_roster(request.id);
+        if (r == 0)
+          append_reply(ob, not_found_status, 0, 0);
+        else
+          append_reply(ob, ok_status, r->cutoff, 0);
+        _store.leave(reader);
+      }
+      break;
+    case add_operation:
+    case withdraw_operation:
+      change(request, preferences, ob);
+      break;
+    case shutdown_operation:
+      append_reply(ob, ok_status, 0, 0);
+      _stopping = true;
+      break;
+    default:
+      append_reply(ob, malformed_status, 0, 0);
+      return 1;
+  }
+
+  return 0;
+}
+
+
+/*                                                                          */
+/****************************************************************************/
+/*     C H A N G E                                                          */
+/****************************************************************************/
+/*                                                                          */
+void solver_daemon::change(
+  const daemon_request          &request,/*!< The request                   */
+  const vector<uint32_t>        &preferences,/*!< Its circuit numbers       */
+  output_buffer                 &ob)/*!< Buffer for the reply               */
+{
+  pthread_mutex_lock(&_writer);
+  vector<const juggler *> changed;
+  if (request.operation == add_operation)
+    {
+      talent_definition talents;
+      talents.hand = request.hand;
+      talents.endurance = request.endurance;
+      talents.pizzazz = request.pizzazz;
+      vector<string> names(preferences.size());
+      for (unsigned int p = 0; p < preferences.size(); p++)
+        names[p] = make_name('C', preferences[p]);
+      // The snapshots keep a place for every number up to the largest, so
+      // one far past the jugglers there are would cost memory for nothing
+      const uint32_t limit = 2 * _sched.juggler_count() + id_headroom;
+      const string name = make_name('J', request.id);
+      if ( (request.id >= limit) || (_sched.add_juggler(name, talents, names) != 0) )
+        append_reply(ob, rejected_status, 0, 0);
+      else
+        {
+          changed.push_back(_sched.get_juggler(name));
+          _store.publish(changed);
+          append_reply(ob, ok_status, 0, 1);
+          append_entries(ob, _store.current().locate(request.id), 1);
+        }
+    }
+  else
+    {
+      const juggler *const j = find_juggler(request.id);
+      if (j == 0)
+        append_reply(ob, not_found_status, 0, 0);
+      else if (_sched.withdraw_juggler(j->name()) != 0)
+        append_reply(ob, rejected_status, 0, 0);
+      else
+        {
+          changed.push_back(j);
+          _store.publish(changed);
+          append_reply(ob, ok_status, 0, 0);
+        }
+    }
+
+  // Check what the change moved before another change can move more
+  if ( (_validation != 0) && !changed.empty() &&
+       (_sched.validate_changes(*_validation) != 0) )
+    _invalid_change_count++;
+  pthread_mutex_unlock(&_writer);
+}
+
+
+/*                                                                          */
+/****************************************************************************/
+/*     F I N D _ J U G G L E R                                              */
+/****************************************************************************/
+/*                                                                          */
+const juggler *solver_daemon::find_juggler(
+  const uint32_t   id)             /*!< Number of the juggler               */
+{
+  const juggler *j = _sched.get_juggler(make_name('J', id));
+  if ( (j != 0) && j->is_withdrawn() )
+    j = 0;
+
+  return j;
+}
+
+
+/*                                                                          */
+/****************************************************************************/
+/*     P R I N T _ S E L F                                                  */
+/****************************************************************************/
+/*                                                                          */
+ostream &solver_daemon::print_self(
+  ostream    &os)                  /*!< The stream into which we stream     */
+const
+{
+  os << "solver_daemon: " << _path << ", " << _connections.size() <<
+        " connections, " << _request_count << " requests, " <<
+        _invalid_change_count << " invalid changes, " << _store;
+
+  return os;
+}
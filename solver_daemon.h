@@ -0,0 +1,281 @@
+#ifndef solver_daemon_h_included
+#define solver_daemon_h_included 1
+
+/*!
+ * \file solver_daemon.h
+ *
+ * \brief Contains the definition of solver_daemon
+ *
+ * \author Stewart L. Palmer
+ */
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <pthread.h>
+#include "daemon_protocol.h"
+#include "snapshot_store.h"
+
+class circuit;
+class juggler;
+class output_buffer;
+class scheduler;
+
+
+/*!
+ * \brief Serves lookups and changes of a solved scheduler over a Unix socket
+ *
+ * assign loads and solves the festival once; the daemon then keeps the
+ * scheduler in memory and answers daemon_request messages from any number of
+ * local connections until it is asked to shut down.  Changes go through
+ * scheduler::add_juggler() and scheduler::withdraw_juggler(), so only the
+ * jugglers along a chain move.
+ *
+ * Each connection has a thread of its own.  Lookups are answered from the
+ * snapshot the snapshot_store published last, without taking any lock, so a
+ * lookup sees every eviction chain either whole or not at all and is never
+ * held up by a change.  Changes are made one at a time under a writer lock,
+ * and each one publishes a new snapshot before it is answered, so a client
+ * sees its own changes in every later lookup.  All of the complete requests
+ * read from a connection are answered in one write, which lets a client
+ * pipeline its requests.
+ *
+ * Given a stream with set_validation(), the daemon checks each change with
+ * scheduler::validate_changes() while it still holds the writer lock, so the
+ * cost follows the circuits the change moved rather than the festival.
+ */
+class solver_daemon
+{
+public:
+
+  /*!
+   * \brief Standard constructor
+   */
+  explicit solver_daemon(
+    scheduler            &sched,   /*!< The solved scheduler to serve       */
+    const std::string    &path     /*!< Path of the socket                  */
+                        );
+
+
+  /*!
+   * \brief Destructor
+   *
+   * Closes the connections and removes the socket.
+   */
+  ~solver_daemon();
+
+
+  /*!
+   * \brief Serve requests until a shutdown_operation arrives
+   *
+   * \return Zero on a shutdown, non-zero if the socket cannot be served; the
+   *         reason is written to the stream
+   */
+  int serve(
+    std::ostream         &os       /*!< Stream for error reporting          */
+           );
+
+
+  /*!
+   * \brief Validate each change and write what is wrong to a stream
+   *
+   * The assignments must have validated before the daemon serves them.  Zero,
+   * the default, validates nothing.
+   */
+  void set_validation(
+    std::ostream         *os       /*!< Stream for diagnostics, or zero     */
+                     )
+  { _validation = os; }
+
+
+  /*!
+   * \brief Return the number of changes whose validation found a problem
+   */
+  unsigned long invalid_change_count() const
+  { return _invalid_change_count; }
+
+
+  /*!
+   * \brief Return the number of requests answered
+   */
+  unsigned long request_count() const
+  { return _request_count; }
+
+
+  //! Most connections served at once; more are closed as they arrive
+  static const unsigned int   connection_limit = 64;
+
+
+  //! Numbers an added juggler may have past twice the number of jugglers
+  static const unsigned int   id_headroom = 1024;
+
+
+  /*!
+   *  \brief Stream object out to a stream
+   *
+   * \return The same stream as the input to allow for chained operators.
+   */
+  friend std::ostream &operator<<(
+    std::ostream          &os,     /*!< The stream into which we stream     */
+    const solver_daemon   &cn)     /*!< The object to be streamed           */
+  {
+    return cn.print_self(os);
+  }
+
+private:
+
+  /*!
+   * \brief A connection and the thread that serves it
+   */
+  struct connection
+  {
+    //! The daemon serving the connection
+    solver_daemon      *daemon;
+
+    //! The socket of the connection
+    int                 fd;
+
+    //! Reader number in the snapshot_store
+    unsigned int        reader;
+
+    //! The thread serving the connection
+    pthread_t           thread;
+
+    //! True once the thread is done and may be joined
+    bool                done;
+
+    //! Bytes read but not yet handled
+    std::vector<char>   input;
+  };
+
+
+  /*!
+   * \brief The copy constructor is deliberately private and unimplemented.
+   *
+   * \param rhs the object from which we are to be constructed
+   */
+  solver_daemon(
+    const solver_daemon   &rhs);
+
+  /*!
+   * \brief operator=() is deliberately private and unimplemented.
+   *
+   * \param rhs the object from which we are to be assigned
+   *
+   * \return reference to self to allow for chained operators
+   */
+  solver_daemon &operator=(
+    const solver_daemon   &rhs);
+
+  /*!
+   * \brief This is the implementation function for operator<<()
+   *
+   * \return The same stream as the input to allow for chained operators.
+   */
+  std::ostream &print_self(
+    std::ostream    &os)           /*!< The stream into which we stream     */
+  const;
+
+
+  /*!
+   * \brief Serve one connection until it closes, on a thread of its own
+   */
+  static void *connection_main(
+    void           *arg            /*!< The connection                      */
+                              );
+
+
+  /*!
+   * \brief Join the threads of the connections that are done and close them
+   */
+  void reap_connections(
+    const bool      all            /*!< True to wait for every connection   */
+                       );
+
+
+  /*!
+   * \brief Read what a connection has sent and answer its complete requests
+   *
+   * \return Zero to keep the connection, non-zero to close it
+   */
+  int handle_input(
+    connection     &conn           /*!< The connection                      */
+                  );
+
+
+  /*!
+   * \brief Answer one request
+   *
+   * \return Zero to go on, non-zero if the request was malformed
+   */
+  int answer(
+    const unsigned int             reader,/*!< Reader number of the
+                                               connection                   */
+    const daemon_request          &request,/*!< The request                 */
+    const std::vector<uint32_t>   &preferences,/*!< Its circuit numbers     */
+    output_buffer                 &ob/*!< Buffer for the reply              */
+            );
+
+
+  /*!
+   * \brief Apply a change under the writer lock, publish it, and answer it
+   */
+  void change(
+    const daemon_request          &request,/*!< The request                 */
+    const std::vector<uint32_t>   &preferences,/*!< Its circuit numbers     */
+    output_buffer                 &ob/*!< Buffer for the reply              */
+             );
+
+
+  /*!
+   * \brief Return a juggler by number, or zero
+   *
+   * Only a holder of the writer lock may call this.
+   */
+  const juggler *find_juggler(
+    const uint32_t   id            /*!< Number of the juggler               */
+                             );
+
+
+  //! The scheduler being served
+  scheduler                  &_sched;
+
+  //! Path of the socket
+  const std::string           _path;
+
+  //! Listening socket, or -1
+  int                         _listener;
+
+  //! Snapshots of the assignments for the lookups
+  snapshot_store              _store;
+
+  //! Stream for the diagnostics of each change, or zero not to validate
+  std::ostream               *_validation;
+
+  //! Changes whose validation found a problem
+  unsigned long               _invalid_change_count;
+
+  //! Held while the scheduler is changed and a snapshot published
+  pthread_mutex_t             _writer;
+
+  //! Held while the connections or free reader numbers are changed
+  pthread_mutex_t             _lock;
+
+  //! Open connections
+  std::vector<connection *>   _connections;
+
+  //! Reader numbers not used by any connection
+  std::vector<unsigned int>   _free_readers;
+
+  //! True once the socket is bound, so the destructor removes it
+  bool                        _bound;
+
+  //! True once a shutdown_operation has been answered
+  volatile bool               _stopping;
+
+  //! Number of requests answered
+  volatile unsigned long      _request_count;
+
+};
+
+#endif                             /* solver_daemon_h_included              */
@@ -0,0 +1,145 @@
+
+/*!
+ * \file span_trace.cpp
+ *
+ * \brief Contains the implementation of span_trace
+ *
+ * \author Stewart L. Palmer
+ */
+
+#include <sys/time.h>
+#include "span_trace.h"
+
+using namespace ::std;
+
+
+/*!
+ * \brief Return the time of day in microseconds
+ */
+static double time_of_day()
+{
+  struct timeval tv;
+  gettimeofday(&tv, 0);
+
+  return (tv.tv_sec * 1000000.0 + tv.tv_usec);
+}
+
+
+/*                                                                          */
+/****************************************************************************/
+/*     C O N S T R U C T O R                                                */
+/****************************************************************************/
+/*                                                                          */
+span_trace::span_trace(
+  const unsigned int   capacity)   /*!< Spans kept per track                */
+  :
+  _capacity(capacity),
+  _origin(time_of_day())
+{
+  assert(capacity != 0);
+  add_tracks(1);
+}
+
+
+/*                                                                          */
+/****************************************************************************/
+/*     N O W                                                                */
+/****************************************************************************/
+/*                                                                          */
+double span_trace::now() const
+{
+  return time_of_day() - _origin;
+}
+
+
+/*                                                                          */
+/****************************************************************************/
+/*     A D D _ T R A C K S                                                  */
+/****************************************************************************/
+/*                                                                          */
+void span_trace::add_tracks(
+  const unsigned int   tracks)     /*!< Number of tracks wanted             */
+{
+  while (_tracks.size() < tracks)
+    {
+      _tracks.push_back(track_ring());
+      _tracks.back().ring.resize(_capacity);
+      _tracks.back().recorded = 0;
+    }
+}
+
+
+/*                                                                          */
+/****************************************************************************/
+/*     D R O P P E D                                                        */
+/****************************************************************************/
+/*                                                                          */
+uint64_t span_trace::dropped() const
+{
+  uint64_t n = 0;
+  for (unsigned int t = 0; t < _tracks.size(); t++)
+    if (_tracks[t].recorded > _capacity)
+      n += _tracks[t].recorded - _capacity;
+
+  return n;
+}
+
+
+/*                                                                          */
+/****************************************************************************/
+/*     W R I T E _ C H R O M E _ J S O N                                    */
+/****************************************************************************/
+/*                                                                          */
+void span_trace::write_chrome_json(
+  ostream              &os)        /*!< The stream for the trace            */
+const
+{
+  const streamsize precision = os.precision(15);
+  os << "{\"traceEvents\":[\n";
+  const char *separator = "";
+  for (unsigned int t = 0; t < _tracks.size(); t++)
+    {
+      const track_ring &track = _tracks[t];
+      if (track.recorded == 0)
+        continue;
+      os << separator << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << t <<
+            ",\"args\":{\"name\":\"worker " << t << "\"}}";
+      separator = ",\n";
+
+      // Oldest first; once the ring has wrapped, that is the next to overwrite
+      const uint64_t kept = (track.recorded < _capacity) ? track.recorded : _capacity;
+      for (uint64_t k = track.recorded - kept; k < track.recorded; k++)
+        {
+          const span &s = track.ring[k % _capacity];
+          os << separator << "{\"name\":\"" << s.name << "\",\"cat\":\"solver\",\"ph\":\"X\"" <<
+                ",\"ts\":" << s.start << ",\"dur\":" << (s.end - s.start) <<
+                ",\"pid\":1,\"tid\":" << t;
+          if (s.first_name != 0)
+            {
+              os << ",\"args\":{\"" << s.first_name << "\":" << s.first;
+              if (s.second_name != 0)
+                os << ",\"" << s.second_name << "\":" << s.second;
+              os << "}";
+            }
+          os << "}";
+        }
+    }
+  os << "\n],\"displayTimeUnit\":\"ms\",\"otherData\":{\"dropped\":" << dropped() << "}}" << endl;
+  os.precision(precision);
+}
+
+
+/*                                                                          */
+/****************************************************************************/
+/*     P R I N T _ S E L F                                                  */
+/****************************************************************************/
+/*                                                                          */
+ostream &span_trace::print_self(
+  ostream    &os)                  /*!< The stream into which we stream     */
+const
+{
+  os << "span_trace: " << _tracks.size() << " tracks of " << _capacity <<
+        " spans, " << dropped() << " dropped";
+
+  return os;
+}
@@ -0,0 +1,207 @@
+#ifndef span_trace_h_included
+#define span_trace_h_included 1
+
+/*!
+ * \file span_trace.h
+ *
+ * \brief Contains the definition of span_trace
+ *
+ * \author Stewart L. Palmer
+ */
+
+#include <iostream>
+#include <vector>
+#include <assert.h>
+#include <stdint.h>
+
+
+/*!
+ * \brief A timeline of what each thread of a solve did, for viewing in
+ *        about:tracing or Perfetto
+ *
+ * A span is a named stretch of time on a track, with up to two named counts.
+ * Track w belongs to worker w of a parallel_task, and the thread that calls
+ * run() is worker zero, so track zero is also the scheduler's own thread.
+ * Each track has its own ring buffer, written only by its own thread, so
+ * recording takes no lock; when a ring is full the oldest spans are
+ * overwritten and counted as dropped.  Tracks must be made with add_tracks()
+ * before the threads that use them start.
+ *
+ * A scheduler records spans only while scheduler_stats::set_span_trace() has
+ * given it one, and otherwise pays a test of a null pointer at each place it
+ * would record.  Span names and count names must be string literals, since
+ * only the pointers are kept.
+ */
+class span_trace
+{
+public:
+
+  /*!
+   * \brief Standard constructor
+   */
+  explicit span_trace(
+    const unsigned int   capacity  /*!< Spans kept per track                */
+                     );
+
+
+  /*!
+   * \brief Return the time in microseconds since the trace was constructed
+   */
+  double now() const;
+
+
+  /*!
+   * \brief Make sure there are at least this many tracks
+   */
+  void add_tracks(
+    const unsigned int   tracks    /*!< Number of tracks wanted             */
+                 );
+
+
+  /*!
+   * \brief Return the number of tracks
+   */
+  unsigned int track_count() const
+  { return _tracks.size(); }
+
+
+  /*!
+   * \brief Record a span on a track
+   */
+  void record(
+    const unsigned int   track,    /*!< The track, usually the worker       */
+    const char          *name,     /*!< Name of the span                    */
+    const double         start,    /*!< From now(), when it started         */
+    const double         end,      /*!< From now(), when it ended           */
+    const char          *first_name = 0,/*!< Name of the first count, or 0  */
+    const uint64_t       first = 0,/*!< The first count                     */
+    const char          *second_name = 0,/*!< Name of the second count, or 0*/
+    const uint64_t       second = 0/*!< The second count                    */
+             )
+  {
+    assert(track < _tracks.size());
+    track_ring &t = _tracks[track];
+    span &s = t.ring[t.recorded % _capacity];
+    s.name = name;
+    s.start = start;
+    s.end = end;
+    s.first_name = first_name;
+    s.first = first;
+    s.second_name = second_name;
+    s.second = second;
+    t.recorded++;
+  }
+
+
+  /*!
+   * \brief Return the number of spans overwritten on every track
+   */
+  uint64_t dropped() const;
+
+
+  /*!
+   * \brief Write the spans in the Chrome trace event format
+   *
+   * Each span becomes a complete ("X") event with its counts as args, and each
+   * track a thread named after its worker.
+   */
+  void write_chrome_json(
+    std::ostream         &os       /*!< The stream for the trace            */
+                        ) const;
+
+
+  /*!
+   *  \brief Stream object out to a stream
+   *
+   * \return The same stream as the input to allow for chained operators.
+   */
+  friend std::ostream &operator<<(
+    std::ostream          &os,     /*!< The stream into which we stream     */
+    const span_trace      &cn)     /*!< The object to be streamed           */
+  {
+    return cn.print_self(os);
+  }
+
+private:
+
+  /*!
+   * \brief One span
+   */
+  struct span
+  {
+    //! Name of the span
+    const char      *name;
+
+    //! Microseconds since the trace was constructed when it started
+    double           start;
+
+    //! Microseconds since the trace was constructed when it ended
+    double           end;
+
+    //! Name of the first count, or zero for none
+    const char      *first_name;
+
+    //! The first count
+    uint64_t         first;
+
+    //! Name of the second count, or zero for none
+    const char      *second_name;
+
+    //! The second count
+    uint64_t         second;
+  };
+
+
+  /*!
+   * \brief The ring buffer of one track
+   */
+  struct track_ring
+  {
+    //! The spans, the newest at (recorded - 1) % capacity
+    std::vector<span>   ring;
+
+    //! Number of spans ever recorded on the track
+    uint64_t            recorded;
+  };
+
+
+  /*!
+   * \brief The copy constructor is deliberately private and unimplemented.
+   *
+   * \param rhs the object from which we are to be constructed
+   */
+  span_trace(
+    const span_trace   &rhs);
+
+  /*!
+   * \brief operator=() is deliberately private and unimplemented.
+   *
+   * \param rhs the object from which we are to be assigned
+   *
+   * \return reference to self to allow for chained operators
+   */
+  span_trace &operator=(
+    const span_trace   &rhs);
+
+  /*!
+   * \brief This is the implementation function for operator<<()
+   *
+   * \return The same stream as the input to allow for chained operators.
+   */
+  std::ostream &print_self(
+    std::ostream    &os)           /*!< The stream into which we stream     */
+  const;
+
+
+  //! Spans kept per track
+  const unsigned int         _capacity;
+
+  //! Time of day the trace was constructed, in microseconds
+  double                     _origin;
+
+  //! The tracks, by worker number
+  std::vector<track_ring>    _tracks;
+
+};
+
+#endif                             /* span_trace_h_included                 */
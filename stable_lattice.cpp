@@ -0,0 +1,735 @@
+
+/*!
+ * \file stable_lattice.cpp
+ *
+ * \brief Contains the implementation of stable_lattice
+ *
+ * \author Stewart L. Palmer
+ */
+
+#include <algorithm>
+#include <climits>
+#include <assert.h>
+#include "juggler_circuit.h"
+#include "circuit.h"
+#include "stable_lattice.h"
+
+using namespace ::std;
+
+
+namespace
+{
+
+/*!
+ * \brief Orders the preference entries of a circuit's applicants, best fit first
+ */
+struct applicant_better
+{
+  //! The juggler_circuit of each preference entry
+  const vector<const juggler_circuit *>   *jcs;
+
+  bool operator()(
+    const int     a,
+    const int     b)
+  const
+  {
+    const juggler_circuit &left  = *(*jcs)[a];
+    const juggler_circuit &right = *(*jcs)[b];
+
+    return (right < left);
+  }
+};
+
+
+/*!
+ * \brief Maximum flow by Dinic's algorithm, used to find a minimum cut
+ */
+class flow_network
+{
+public:
+
+  explicit flow_network(
+    const int     nodes)
+  :
+  _first(nodes, -1),
+  _level(nodes),
+  _cursor(nodes)
+  { }
+
+
+  void add_edge(
+    const int       from,
+    const int       to,
+    const int64_t   cap)
+  {
+    _to.push_back(to);
+    _cap.push_back(cap);
+    _next.push_back(_first[from]);
+    _first[from] = _to.size() - 1;
+    _to.push_back(from);
+    _cap.push_back(0);
+    _next.push_back(_first[to]);
+    _first[to] = _to.size() - 1;
+  }
+
+
+  //! Push as much flow as possible; limit bounds the flow along any one path
+  void max_flow(
+    const int       source,
+    const int       sink,
+    const int64_t   limit)
+  {
+    while (levels(source, sink))
+    {
+      _cursor = _first;
+      while (push(source, sink, limit) != 0)
+        ;
+    }
+  }
+
+
+  //! After max_flow(), marks the nodes on the source side of a minimum cut
+  void source_side(
+    const int       source,
+    vector<bool>   &side)
+  {
+    levels(source, -1);
+    side.assign(_first.size(), false);
+    for (unsigned int n = 0; n < _first.size(); n++)
+      side[n] = (_level[n] >= 0);
+  }
+
+private:
+
+  bool levels(
+    const int     source,
+    const int     sink)
+  {
+    _level.assign(_first.size(), -1);
+    vector<int>  queue;
+    queue.push_back(source);
+    _level[source] = 0;
+    for (unsigned int q = 0; q < queue.size(); q++)
+      {
+        const int u = queue[q];
+        for (int e = _first[u]; e >= 0; e = _next[e])
+          if ( (_cap[e] > 0) && (_level[_to[e]] < 0) )
+            {
+              _level[_to[e]] = _level[u] + 1;
+              queue.push_back(_to[e]);
+            }
+      }
+
+    return ( (sink >= 0) && (_level[sink] >= 0) );
+  }
+
+
+  int64_t push(
+    const int       u,
+    const int       sink,
+    const int64_t   limit)
+  {
+    if (u == sink)
+      return limit;
+    for (int &e = _cursor[u]; e >= 0; e = _next[e])
+      {
+        const int v = _to[e];
+        if ( (_cap[e] > 0) && (_level[v] == _level[u] + 1) )
+          {
+            const int64_t pushed = push(v, sink, min(limit, _cap[e]));
+            if (pushed != 0)
+              {
+                _cap[e] -= pushed;
+                _cap[e ^ 1] += pushed;
+                return pushed;
+              }
+          }
+      }
+
+    return 0;
+  }
+
+  vector<int>       _first;
+  vector<int>       _to;
+  vector<int64_t>   _cap;
+  vector<int>       _next;
+  vector<int>       _level;
+  vector<int>       _cursor;
+};
+
+}
+
+
+/*                                                                          */
+/****************************************************************************/
+/*     C O N S T R U C T O R                                                */
+/****************************************************************************/
+/*                                                                          */
+stable_lattice::stable_lattice(
+  const vector<juggler *>  &jugglers,/*!< All jugglers by index             */
+  const vector<circuit *>  &circuits,/*!< All circuits by index             */
+  const unsigned int        capacity)/*!< Jugglers per circuit              */
+  :
+  _jugglers(jugglers),
+  _circuits(circuits),
+  _capacity(capacity)
+{
+  assert(_capacity > 0);
+  load();
+  propose();
+  find_rotations();
+  build_precedence();
+}
+
+
+/*                                                                          */
+/****************************************************************************/
+/*     L O A D                                                              */
+/****************************************************************************/
+/*                                                                          */
+void stable_lattice::load()
+{
+  const int n = _jugglers.size();
+  const int c_count = _circuits.size();
+  vector<const juggler_circuit *>  jcs;
+
+  for (int m = 0; m < n; m++)
+    {
+      _pref_first.push_back(_pref_circuit.size());
+      const juggler &jug = *_jugglers[m];
+      for (unsigned int i = 0; i < jug.preference_count(); i++)
+        {
+          const juggler_circuit &jc = jug.request(i);
+          _pref_circuit.push_back(jc.circ().index());
+          _pref_man.push_back(m);
+          jcs.push_back(&jc);
+        }
+    }
+  _pref_first.push_back(_pref_circuit.size());
+
+  // Gather the applicants of each circuit and rank them, best fit first
+  _app_first.assign(c_count + 1, 0);
+  for (unsigned int e = 0; e < _pref_circuit.size(); e++)
+    _app_first[_pref_circuit[e] + 1]++;
+  for (int c = 0; c < c_count; c++)
+    _app_first[c + 1] += _app_first[c];
+  _applicant.assign(_pref_circuit.size(), 0);
+  vector<int>  fill(_app_first.begin(), _app_first.end() - 1);
+  for (unsigned int e = 0; e < _pref_circuit.size(); e++)
+    _applicant[fill[_pref_circuit[e]]++] = e;
+
+  applicant_better  better;
+  better.jcs = &jcs;
+  _pref_rank.assign(_pref_circuit.size(), 0);
+  for (int c = 0; c < c_count; c++)
+    {
+      sort(_applicant.begin() + _app_first[c], _applicant.begin() + _app_first[c + 1], better);
+      for (int a = _app_first[c]; a < _app_first[c + 1]; a++)
+        _pref_rank[_applicant[a]] = a - _app_first[c];
+    }
+}
+
+
+/*                                                                          */
+/****************************************************************************/
+/*     P R O P O S E                                                        */
+/****************************************************************************/
+/*                                                                          */
+void stable_lattice::propose()
+{
+  const int n = _jugglers.size();
+  const int slots = _circuits.size() * _capacity;
+  _slot_partner.assign(slots, -1);
+  _slot_rank.assign(slots, INT_MAX);
+  _man_pos.assign(n, -1);
+  _man_next.assign(n, 0);
+
+  vector<int>  free_men;
+  for (int m = n - 1; m >= 0; m--)
+    free_men.push_back(m);
+  while (free_men.size() != 0)
+  {
+    const int m = free_men.back();
+    free_men.pop_back();
+    const int len = (_pref_first[m + 1] - _pref_first[m]) * _capacity;
+    while (_man_next[m] < len)
+    {
+      const int pos = _man_next[m]++;
+      const int s = slot_of(m, pos);
+      const int r = rank_at(m, pos);
+      if (r < _slot_rank[s])       /* The slot prefers us to its partner    */
+        {
+          const int previous = _slot_partner[s];
+          _slot_partner[s] = m;
+          _slot_rank[s] = r;
+          _man_pos[m] = pos;
+          if (previous >= 0)
+            {
+              _man_pos[previous] = -1;
+              free_men.push_back(previous);
+            }
+          break;
+        }
+    }
+  }
+
+  _optimal_pos = _man_pos;
+  _optimal_rank = _slot_rank;
+}
+
+
+/*                                                                          */
+/****************************************************************************/
+/*     N E X T _ S L O T                                                    */
+/****************************************************************************/
+/*                                                                          */
+int stable_lattice::next_slot(
+  const int             man)       /*!< The juggler                         */
+{
+  // Slots only ever get better partners, so a slot that would not take this
+  // juggler never will, and the search can resume where it left off
+  const int len = (_pref_first[man + 1] - _pref_first[man]) * _capacity;
+  while (_man_next[man] < len)
+  {
+    const int pos = _man_next[man];
+    const int s = slot_of(man, pos);
+    if ( (_slot_partner[s] < 0) || (rank_at(man, pos) < _slot_rank[s]) )
+      return s;
+    _man_next[man]++;
+  }
+
+  return -1;
+}
+
+
+/*                                                                          */
+/****************************************************************************/
+/*     F I N D _ R O T A T I O N S                                          */
+/****************************************************************************/
+/*                                                                          */
+void stable_lattice::find_rotations()
+{
+  const int n = _jugglers.size();
+  const int slots = _slot_partner.size();
+  const int positions = _pref_circuit.size() * _capacity;
+  _label_leave.assign(positions, -1);
+  _label_removed.assign(positions, -1);
+  _man_target.assign(n, -1);
+  _rot_first.push_back(0);
+
+  vector<int>          dirty;
+  for (int m = 0; m < n; m++)
+    {
+      if (_man_pos[m] >= 0)
+        {
+          _man_next[m] = _man_pos[m] + 1;
+          dirty.push_back(m);
+        }
+    }
+
+  vector<vector<int> > pointing(slots);/* Jugglers whose next slot it is    */
+  vector<int>          visited(n, 0);
+  vector<int>          walk_of(n, -1);
+  vector<int>          path_index(n, 0);
+  vector<int>          dirty_stamp(n, 0);
+  vector<vector<int> > cycles;
+  vector<int>          path;
+  int                  round = 0;
+  int                  walk = 0;
+
+  while (dirty.size() != 0)
+  {
+    round++;
+    for (unsigned int d = 0; d < dirty.size(); d++)
+      {
+        const int m = dirty[d];
+        const int t = next_slot(m);
+        _man_target[m] = t;
+        if (t >= 0)
+          pointing[t].push_back(m);
+      }
+
+    // Any new exposed rotation is a cycle through a juggler that changed
+    cycles.clear();
+    for (unsigned int d = 0; d < dirty.size(); d++)
+      {
+        walk++;
+        path.clear();
+        int m = dirty[d];
+        while ( (m >= 0) && (visited[m] != round) )
+        {
+          visited[m] = round;
+          walk_of[m] = walk;
+          path_index[m] = path.size();
+          path.push_back(m);
+          const int t = _man_target[m];
+          m = (t >= 0) ? _slot_partner[t] : -1;
+        }
+        if ( (m >= 0) && (walk_of[m] == walk) )
+          cycles.push_back(vector<int>(path.begin() + path_index[m], path.end()));
+      }
+
+    dirty.clear();
+    for (unsigned int c = 0; c < cycles.size(); c++)
+      {
+        const vector<int> &men = cycles[c];
+        for (unsigned int i = 0; i < men.size(); i++)
+          {
+            const int m = men[i];
+            if (dirty_stamp[m] != round)
+              {
+                dirty_stamp[m] = round;
+                dirty.push_back(m);
+              }
+            // Jugglers waiting on this slot must look again once it improves
+            vector<int> &waiting = pointing[_man_target[m]];
+            for (unsigned int w = 0; w < waiting.size(); w++)
+              {
+                const int wm = waiting[w];
+                if ( (_man_target[wm] == _man_target[m]) && (dirty_stamp[wm] != round) )
+                  {
+                    dirty_stamp[wm] = round;
+                    dirty.push_back(wm);
+                  }
+              }
+            waiting.clear();
+          }
+        eliminate(men);
+      }
+  }
+}
+
+
+/*                                                                          */
+/****************************************************************************/
+/*     E L I M I N A T E                                                    */
+/****************************************************************************/
+/*                                                                          */
+void stable_lattice::eliminate(
+  const vector<int>   &men)        /*!< Jugglers of the rotation in order   */
+{
+  const int r = _rot_first.size() - 1;
+  const int k = men.size();
+  int64_t weight = 0;
+
+  for (int i = 0; i < k; i++)
+    {
+      const int m = men[i];
+      const int from = _man_pos[m];
+      const int to = _man_next[m];
+      const int t = _man_target[m];
+      assert(t == slot_of(m, to));
+      _label_leave[_pref_first[m] * _capacity + from] = r;
+      weight += (to / _capacity) - (from / _capacity);
+
+      // Every applicant between the new and the old partner of the slot can no
+      // longer be matched to it in any stable assignment
+      const int c = t / _capacity;
+      const int new_rank = rank_at(m, to);
+      const int old_rank = _slot_rank[t];
+      assert(new_rank < old_rank);
+      weight += new_rank - old_rank;
+      for (int a = _app_first[c] + new_rank + 1; a < _app_first[c] + old_rank; a++)
+        {
+          const int e = _applicant[a];
+          const int mm = _pref_man[e];
+          const int pos = (e - _pref_first[mm]) * _capacity + (t % _capacity);
+          if ( (_optimal_pos[mm] >= 0) && (pos > _optimal_pos[mm]) )
+            _label_removed[_pref_first[mm] * _capacity + pos] = r;
+        }
+    }
+
+  for (int i = 0; i < k; i++)
+    {
+      const int m = men[i];
+      const int t = _man_target[m];
+      _man_pos[m] = _man_next[m];
+      _man_next[m]++;
+      _slot_partner[t] = m;
+      _slot_rank[t] = rank_at(m, _man_pos[m]);
+      _rot_man.push_back(m);
+      _rot_to.push_back(_man_pos[m]);
+    }
+  _rot_first.push_back(_rot_man.size());
+  _rot_weight.push_back(weight);
+}
+
+
+/*                                                                          */
+/****************************************************************************/
+/*     B U I L D _ P R E C E D E N C E                                      */
+/****************************************************************************/
+/*                                                                          */
+void stable_lattice::build_precedence()
+{
+  const int n = _jugglers.size();
+  for (int m = 0; m < n; m++)
+    {
+      if (_optimal_pos[m] < 0)
+        continue;
+      const int base = _pref_first[m] * _capacity;
+      int last = -1;               /* Rotation that moved us off last partner*/
+      for (int pos = _optimal_pos[m]; pos < _man_pos[m]; pos++)
+        {
+          const int leave = _label_leave[base + pos];
+          const int removed = _label_removed[base + pos];
+          if (leave >= 0)
+            {                      /* Our successive moves are ordered      */
+              if (last >= 0)
+                {
+                  _prec_from.push_back(last);
+                  _prec_to.push_back(leave);
+                }
+              last = leave;
+            }
+          else if ( (removed >= 0) && (removed != last) )
+            {                      /* We can only pass this slot after it   */
+              _prec_from.push_back(removed);/* has a better partner than us */
+              _prec_to.push_back(last);
+            }
+        }
+    }
+
+  const int rotations = rotation_count();
+  _pred_first.assign(rotations + 1, 0);
+  for (unsigned int e = 0; e < _prec_to.size(); e++)
+    _pred_first[_prec_to[e] + 1]++;
+  for (int r = 0; r < rotations; r++)
+    _pred_first[r + 1] += _pred_first[r];
+  _pred.assign(_prec_to.size(), 0);
+  vector<int>  fill(_pred_first.begin(), _pred_first.end() - 1);
+  for (unsigned int e = 0; e < _prec_to.size(); e++)
+    _pred[fill[_prec_to[e]]++] = _prec_from[e];
+}
+
+
+/*                                                                          */
+/****************************************************************************/
+/*     M A T C H I N G                                                      */
+/****************************************************************************/
+/*                                                                          */
+void stable_lattice::matching(
+  const choice          which,
+  vector<int>          &preference)
+const
+{
+  const int rotations = rotation_count();
+  vector<bool>  in_set(rotations, false);
+  switch (which)
+  {
+    case juggler_optimal:
+      break;
+    case circuit_optimal:
+      in_set.assign(rotations, true);
+      break;
+    case egalitarian:
+      egalitarian_set(in_set);
+      break;
+    case minimum_regret:
+      {
+        // Find the smallest regret that some stable assignment meets
+        unsigned int low = 0;
+        unsigned int high = 0;
+        for (unsigned int c = 0; (c + 1) < _app_first.size(); c++)
+          high = max(high, (unsigned int) (_app_first[c + 1] - _app_first[c]));
+        for (unsigned int m = 0; (m + 1) < _pref_first.size(); m++)
+          high = max(high, (unsigned int) (_pref_first[m + 1] - _pref_first[m]));
+        vector<bool>  trial;
+        vector<int>   trial_preference;
+        while (low < high)
+        {
+          const unsigned int middle = low + (high - low) / 2;
+          bool fits = circuit_limit_set(middle, trial);
+          if (fits)
+            {
+              apply(trial, trial_preference);
+              fits = (regret(trial_preference) <= middle);
+            }
+          if (fits)
+            high = middle;
+          else
+            low = middle + 1;
+        }
+        const bool found = circuit_limit_set(low, in_set);
+        assert(found);
+      }
+      break;
+  }
+  apply(in_set, preference);
+}
+
+
+/*                                                                          */
+/****************************************************************************/
+/*     A P P L Y                                                            */
+/****************************************************************************/
+/*                                                                          */
+void stable_lattice::apply(
+  const vector<bool>  &in_set,     /*!< Rotations eliminated                */
+  vector<int>         &preference) /*!< Returned assignment                 */
+const
+{
+  // Rotations are numbered in the order they were eliminated, so the last
+  // one applied to a juggler leaves it at its partner in this assignment
+  vector<int>  pos(_optimal_pos);
+  for (unsigned int r = 0; r < rotation_count(); r++)
+    {
+      if ( !in_set[r] )
+        continue;
+      for (int p = _rot_first[r]; p < _rot_first[r + 1]; p++)
+        pos[_rot_man[p]] = _rot_to[p];
+    }
+
+  preference.assign(pos.size(), -1);
+  for (unsigned int m = 0; m < pos.size(); m++)
+    if (pos[m] >= 0)
+      preference[m] = pos[m] / _capacity;
+}
+
+
+/*                                                                          */
+/****************************************************************************/
+/*     E G A L I T A R I A N _ S E T                                        */
+/****************************************************************************/
+/*                                                                          */
+void stable_lattice::egalitarian_set(
+  vector<bool>        &in_set)     /*!< Returned rotations                  */
+const
+{
+  // The closed set of least total weight is the source side of a minimum cut.
+  // Rotations that lower the total rank hang off the source, those that raise
+  // it feed the sink, and a rotation cannot be taken without its predecessors.
+  const int rotations = rotation_count();
+  const int source = rotations;
+  const int sink = rotations + 1;
+  flow_network  network(rotations + 2);
+  int64_t infinite = 1;
+  for (int r = 0; r < rotations; r++)
+    {
+      const int64_t w = _rot_weight[r];
+      infinite += (w < 0) ? -w : w;
+      if (w < 0)
+        network.add_edge(source, r, -w);
+      else if (w > 0)
+        network.add_edge(r, sink, w);
+    }
+  for (unsigned int e = 0; e < _prec_from.size(); e++)
+    network.add_edge(_prec_to[e], _prec_from[e], infinite);
+
+  network.max_flow(source, sink, infinite);
+  vector<bool>  side;
+  network.source_side(source, side);
+  in_set.assign(side.begin(), side.begin() + rotations);
+}
+
+
+/*                                                                          */
+/****************************************************************************/
+/*     C I R C U I T _ L I M I T _ S E T                                    */
+/****************************************************************************/
+/*                                                                          */
+bool stable_lattice::circuit_limit_set(
+  const unsigned int   limit,      /*!< Largest circuit rank allowed        */
+  vector<bool>        &in_set)     /*!< Returned rotations                  */
+const
+{
+  // Find the rotation that brings each slot within the limit
+  const int rotations = rotation_count();
+  vector<int>   rank(_optimal_rank);
+  vector<int>   required;
+  vector<int>   needed_by(rank.size(), -1);
+  for (int r = 0; r < rotations; r++)
+    {
+      for (int p = _rot_first[r]; p < _rot_first[r + 1]; p++)
+        {
+          const int m = _rot_man[p];
+          const int s = slot_of(m, _rot_to[p]);
+          if (rank[s] > (int) limit)
+            {
+              rank[s] = rank_at(m, _rot_to[p]);
+              needed_by[s] = r;
+            }
+        }
+    }
+  for (unsigned int s = 0; s < rank.size(); s++)
+    {
+      if ( (_slot_partner[s] >= 0) && (rank[s] > (int) limit) )
+        return false;
+      if (needed_by[s] >= 0)
+        required.push_back(needed_by[s]);
+    }
+
+  // Take every required rotation along with all of its predecessors
+  in_set.assign(rotations, false);
+  while (required.size() != 0)
+  {
+    const int r = required.back();
+    required.pop_back();
+    if (in_set[r])
+      continue;
+    in_set[r] = true;
+    for (int p = _pred_first[r]; p < _pred_first[r + 1]; p++)
+      if ( !in_set[_pred[p]] )
+        required.push_back(_pred[p]);
+  }
+
+  return true;
+}
+
+
+/*                                                                          */
+/****************************************************************************/
+/*     C O S T                                                              */
+/****************************************************************************/
+/*                                                                          */
+int64_t stable_lattice::cost(
+  const vector<int>   &preference) /*!< Assignment from matching()          */
+const
+{
+  int64_t total = 0;
+  for (unsigned int m = 0; m < preference.size(); m++)
+    {
+      const int p = preference[m];
+      if (p >= 0)
+        total += p + _pref_rank[_pref_first[m] + p];
+    }
+
+  return total;
+}
+
+
+/*                                                                          */
+/****************************************************************************/
+/*     R E G R E T                                                          */
+/****************************************************************************/
+/*                                                                          */
+unsigned int stable_lattice::regret(
+  const vector<int>   &preference) /*!< Assignment from matching()          */
+const
+{
+  int worst = 0;
+  for (unsigned int m = 0; m < preference.size(); m++)
+    {
+      const int p = preference[m];
+      if (p >= 0)
+        worst = max(worst, max(p, _pref_rank[_pref_first[m] + p]));
+    }
+
+  return worst;
+}
+
+
+/*                                                                          */
+/****************************************************************************/
+/*     P R I N T _ S E L F                                                  */
+/****************************************************************************/
+/*                                                                          */
+ostream &stable_lattice::print_self(
+  ostream    &os)                  /*!< The stream into which we stream     */
+const
+{
+  os << "stable_lattice: " << rotation_count() << " rotations, " <<
+        precedence_count() << " precedence edges";
+
+  return os;
+}
@@ -0,0 +1,350 @@
+#ifndef stable_lattice_h_included
+#define stable_lattice_h_included 1
+
+/*!
+ * \file stable_lattice.h
+ *
+ * \brief Contains the definition of stable_lattice
+ *
+ * \author Stewart L. Palmer
+ */
+
+#include <iostream>
+#include <vector>
+#include <stdint.h>
+
+class circuit;
+class juggler;
+class juggler_circuit;
+
+
+/*!
+ * \brief Explores the lattice of stable assignments through its rotations
+ *
+ * scheduler::assign() finds the stable assignment that is best for every
+ * juggler.  There are usually many other stable assignments, and together they
+ * form a lattice.  Every stable assignment can be reached from the juggler
+ * optimal one by eliminating a set of rotations that is closed under the
+ * rotation precedence order.  This class finds all the rotations and their
+ * precedence graph, and from them computes:
+ *
+ * <ul>
+ * <li> The egalitarian assignment, which minimizes the sum of the ranks of all
+ *      partners.  A juggler ranks its circuit by its preference, counting from
+ *      zero, and a circuit ranks a juggler by its position among all jugglers
+ *      that asked for the circuit, best fit first.  This is a minimum weight
+ *      closed set of rotations, found as a minimum cut.
+ * <li> The minimum regret assignment, which minimizes the largest rank of any
+ *      juggler or circuit.  Ranks on the circuit side only get better as
+ *      rotations are eliminated and ranks on the juggler side only get worse, so
+ *      a binary search on the regret finds it.
+ * </ul>
+ *
+ * A circuit is treated as jugglers_per_circuit() identical slots that every
+ * juggler ranks consecutively, which turns the problem into one to one stable
+ * marriage with incomplete lists.  Only the preferences in the juggler
+ * definitions are used.  Jugglers that cannot be placed in any stable
+ * assignment are unplaced in all of them, and are left to the caller.
+ *
+ * Finding the rotations takes O(L) time, where L is the total length of the
+ * preference lists times jugglers_per_circuit(), plus the cost of a maximum
+ * flow over the rotation graph for the egalitarian assignment.
+ */
+class stable_lattice
+{
+public:
+
+  /*!
+   * \brief Which stable assignment to compute
+   */
+  enum choice
+  {
+    juggler_optimal,               //!< Best for every juggler
+    circuit_optimal,               //!< Best for every circuit
+    egalitarian,                   //!< Lowest sum of all ranks
+    minimum_regret                 //!< Lowest largest rank
+  };
+
+
+  /*!
+   * \brief Standard constructor
+   *
+   * The vectors are indexed by the dense index of each juggler and circuit, and
+   * must outlive the lattice.  All the work is done here.
+   */
+  explicit stable_lattice(
+    const std::vector<juggler *>  &jugglers,/*!< All jugglers by index      */
+    const std::vector<circuit *>  &circuits,/*!< All circuits by index      */
+    const unsigned int             capacity /*!< Jugglers per circuit       */
+                          );
+
+
+  /*!
+   * \brief Return the number of rotations in the instance
+   */
+  unsigned int rotation_count() const
+  { return _rot_first.size() - 1; }
+
+
+  /*!
+   * \brief Return the number of edges in the rotation precedence graph
+   */
+  unsigned int precedence_count() const
+  { return _prec_from.size(); }
+
+
+  /*!
+   * \brief Compute one of the stable assignments
+   *
+   * \param which       The assignment wanted
+   * \param preference  Returned preference index of each juggler's circuit,
+   *                    indexed by juggler index, or -1 if the juggler is not
+   *                    placed in any stable assignment
+   */
+  void matching(
+    const choice          which,
+    std::vector<int>     &preference)
+  const;
+
+
+  /*!
+   * \brief Return the sum of all ranks of an assignment from matching()
+   */
+  int64_t cost(
+    const std::vector<int>   &preference/*!< Assignment from matching()     */
+              )
+  const;
+
+
+  /*!
+   * \brief Return the largest rank of an assignment from matching()
+   */
+  unsigned int regret(
+    const std::vector<int>   &preference/*!< Assignment from matching()     */
+                     )
+  const;
+
+
+  /*!
+   *  \brief Stream object out to a stream
+   *
+   * \return The same stream as the input to allow for chained operators.
+   */
+  friend std::ostream &operator<<(
+    std::ostream           &os,    /*!< The stream into which we stream     */
+    const stable_lattice   &cn)    /*!< The object to be streamed           */
+  {
+    return cn.print_self(os);
+  }
+
+private:
+
+  /*!
+   * \brief The copy constructor is deliberately private and unimplemented.
+   *
+   * \param rhs the object from which we are to be constructed
+   */
+  stable_lattice(
+    const stable_lattice   &rhs);
+
+  /*!
+   * \brief operator=() is deliberately private and unimplemented.
+   *
+   * \param rhs the object from which we are to be assigned
+   *
+   * \return reference to self to allow for chained operators
+   */
+  stable_lattice &operator=(
+    const stable_lattice   &rhs);
+
+  /*!
+   * \brief This is the implementation function for operator<<()
+   *
+   * \return The same stream as the input to allow for chained operators.
+   */
+  std::ostream &print_self(
+    std::ostream    &os)           /*!< The stream into which we stream     */
+  const;
+
+
+  /*!
+   * \brief Flatten the preferences and rank the applicants of each circuit
+   */
+  void load();
+
+
+  /*!
+   * \brief Find the juggler optimal assignment by deferred acceptance
+   */
+  void propose();
+
+
+  /*!
+   * \brief Find every rotation, eliminating them until the circuit optimal
+   *        assignment is reached
+   */
+  void find_rotations();
+
+
+  /*!
+   * \brief Eliminate one exposed rotation and label the pairs it removes
+   */
+  void eliminate(
+    const std::vector<int>   &men  /*!< Jugglers of the rotation in order   */
+                );
+
+
+  /*!
+   * \brief Build the rotation precedence graph from the pair labels
+   */
+  void build_precedence();
+
+
+  /*!
+   * \brief Return the first slot after a juggler's partner that would take it
+   *
+   * \return The slot, or -1 if no slot further down the list would take it
+   */
+  int next_slot(
+    const int             man      /*!< The juggler                         */
+               );
+
+
+  /*!
+   * \brief Compute the assignment of a closed set of rotations
+   */
+  void apply(
+    const std::vector<bool>  &in_set,   /*!< Rotations eliminated           */
+    std::vector<int>         &preference/*!< Returned assignment            */
+            )
+  const;
+
+
+  /*!
+   * \brief Compute the egalitarian closed set of rotations
+   */
+  void egalitarian_set(
+    std::vector<bool>        &in_set    /*!< Returned rotations             */
+                      )
+  const;
+
+
+  /*!
+   * \brief Compute the smallest closed set of rotations that leaves no circuit
+   *        rank above a limit
+   *
+   * \return false if no stable assignment meets the limit
+   */
+  bool circuit_limit_set(
+    const unsigned int        limit,    /*!< Largest circuit rank allowed   */
+    std::vector<bool>        &in_set    /*!< Returned rotations             */
+                        )
+  const;
+
+
+  /*!
+   * \brief Return the slot of a local list position of a juggler
+   */
+  int slot_of(
+    const int             man,     /*!< The juggler                         */
+    const int             pos)     /*!< Position in the juggler's slot list */
+  const
+  {
+    return (_pref_circuit[_pref_first[man] + pos / _capacity] * _capacity + pos % _capacity);
+  }
+
+
+  /*!
+   * \brief Return the rank of a juggler at a local list position in the
+   *        circuit of that position
+   */
+  int rank_at(
+    const int             man,     /*!< The juggler                         */
+    const int             pos)     /*!< Position in the juggler's slot list */
+  const
+  {
+    return _pref_rank[_pref_first[man] + pos / _capacity];
+  }
+
+
+  //! All jugglers by index
+  const std::vector<juggler *>    &_jugglers;
+
+  //! All circuits by index
+  const std::vector<circuit *>    &_circuits;
+
+  //! Number of slots in each circuit
+  const int                        _capacity;
+
+  //! Start of each juggler's preferences in the _pref arrays; one extra at end
+  std::vector<int>                 _pref_first;
+
+  //! Circuit index of each preference
+  std::vector<int>                 _pref_circuit;
+
+  //! Rank of the juggler among the applicants of the circuit, best first
+  std::vector<int>                 _pref_rank;
+
+  //! Start of each circuit's applicants in _applicant; one extra at end
+  std::vector<int>                 _app_first;
+
+  //! Preference entry of each applicant, ordered by rank within each circuit
+  std::vector<int>                 _applicant;
+
+  //! Juggler of each preference entry
+  std::vector<int>                 _pref_man;
+
+  //! Current partner of each slot, or -1
+  std::vector<int>                 _slot_partner;
+
+  //! Rank of the current partner of each slot, or INT_MAX
+  std::vector<int>                 _slot_rank;
+
+  //! Current list position of each juggler, or -1 if it has no partner
+  std::vector<int>                 _man_pos;
+
+  //! List position of each juggler in the juggler optimal assignment
+  std::vector<int>                 _optimal_pos;
+
+  //! Next list position each juggler will look at for another partner
+  std::vector<int>                 _man_next;
+
+  //! Slot each juggler would move to next, or -1
+  std::vector<int>                 _man_target;
+
+  //! Rotation in which each juggler leaves the slot at each list position
+  std::vector<int>                 _label_leave;
+
+  //! Rotation that removes the juggler and slot at each list position
+  std::vector<int>                 _label_removed;
+
+  //! Start of each rotation in the _rot arrays; one extra at end
+  std::vector<int>                 _rot_first;
+
+  //! Juggler of each rotation pair
+  std::vector<int>                 _rot_man;
+
+  //! List position the juggler moves to when the rotation is eliminated
+  std::vector<int>                 _rot_to;
+
+  //! Change in the sum of all ranks when each rotation is eliminated
+  std::vector<int64_t>             _rot_weight;
+
+  //! Rank of the partner of each slot in the juggler optimal assignment
+  std::vector<int>                 _optimal_rank;
+
+  //! Start of each rotation's predecessors in _pred; one extra at end
+  std::vector<int>                 _pred_first;
+
+  //! Immediate predecessors of each rotation
+  std::vector<int>                 _pred;
+
+  //! Rotations that must precede another rotation, by edge
+  std::vector<int>                 _prec_from;
+
+  //! Rotations that are preceded, by edge
+  std::vector<int>                 _prec_to;
+
+};
+
+#endif                             /* stable_lattice_h_included             */
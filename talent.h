@@ -37,12 +37,20 @@ public:
   :
   _sched(sched),
   _id(-1),
+  _index(-1),
   _hand(-1),
   _endurance(-1),
   _pizzazz(-1)
   { }
 
 
+  /*!
+   * \brief Standard destructor
+   */
+  virtual ~talent()
+  { }
+
+
   /*!
    * \brief Return a reference to the scheduler
    */
@@ -65,6 +73,25 @@ public:
 
 
 
+  /*!
+   * \brief Return the dense index of this instance
+   *
+   * Circuits and jugglers are each numbered from zero in the order in which
+   * they appear in the input.  This allows per circuit or per juggler data to
+   * be kept in plain arrays.
+   */
+  int index() const
+  { return _index; }
+
+
+  /*!
+   * \brief Set the dense index of this instance
+   */
+  void set_index(
+    const int    index)            /*!< Index within circuits or jugglers   */
+  { _index = index; }
+
+
   /*!
    * \brief Return a reference to the name
    */
@@ -142,6 +169,20 @@ protected:
     const std::string   &name);
 
 
+  /*!
+   * \brief Set the talents from their values
+   */
+  void set_talents(
+    const int           hand,      /*!< Value for hand-eye coordination     */
+    const int           endurance, /*!< Value for endurance                 */
+    const int           pizzazz)   /*!< Value for pizzazz                   */
+  {
+    _hand = hand;
+    _endurance = endurance;
+    _pizzazz = pizzazz;
+  }
+
+
   /*!
    * \brief Set the talents from the result of a regular expression scan
    *        done by a child class
@@ -209,6 +250,9 @@ private:
     */
   int                _id;
 
+  //! The dense index of this instance among the circuits or the jugglers
+  int                _index;
+
   //! Value for hand-eye coordination
   int                _hand;
 
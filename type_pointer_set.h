@@ -12,6 +12,7 @@
 #include <iostream>
 #include <assert.h>
 #include <map>
+#include "memory_usage.h"
 
 template<typename K, typename T>
 class type_pointer_set_iterator;
@@ -70,6 +71,21 @@ public:
   }
 
 
+  /*!
+   * \brief Remove the item with a given name from the set
+   *
+   * \return non-zero if the item is not found
+   */
+  int remove(
+    const K             &name)     /*!< Name of item to remove              */
+  {
+    const unsigned int delete_count = _tts_map.erase(name);
+    const int rc = (delete_count == 1) ? 0 : 1;
+
+    return rc;
+  }
+
+
   /*!
    * \brief Return the number of items in the set
    */
@@ -77,6 +93,21 @@ public:
   { return _tts_map.size(); }
 
 
+  /*!
+   * \brief Charge the nodes of the map and their keys to a subsystem
+   */
+  void account_memory(
+    memory_usage                     &usage,/*!< Where to charge them       */
+    const memory_usage::subsystem     s)    /*!< The subsystem              */
+  const
+  {
+    usage.add_tree(s, _tts_map);
+    typename std::map<K, T>::const_iterator it;
+    for (it = _tts_map.begin(); it != _tts_map.end(); ++it)
+      usage.add_key(s, it->first);
+  }
+
+
   /*!
    *  \brief Stream object out to a stream
    *
@@ -0,0 +1,88 @@
+
+/*!
+ * \file verify.cpp
+ *
+ * \brief Main program for verifying an assignment file
+ *
+ * \author Stewart L. Palmer
+ */
+
+#include <iostream>
+#include <stdlib.h>
+#include <unistd.h>
+#include "mapped_file.h"
+#include "parallel_task.h"
+#include "assignment_verifier.h"
+
+using namespace ::std;
+
+/*!
+ * \brief Print the command line usage
+ */
+static void usage(
+  const char   *program)           /*!< Name of the program                 */
+{
+  cerr << "usage: " << program << " [-t threads] [instance [assignments]]\n"
+          "  -t threads   number of worker threads\n"
+          "  instance     circuit and juggler definitions, input.txt by default\n"
+          "  assignments  assignments to verify, output.txt by default" << endl;
+}
+
+
+int main(
+  int     argc,
+  char   *argv[])
+{
+  int workers = parallel_task::available_workers();
+  int opt = getopt(argc, argv, "t:");
+  while (opt != -1)
+  {
+    switch (opt)
+    {
+      case 't':
+        workers = atoi(optarg);
+        if (workers <= 0)
+          {
+            usage(argv[0]);
+            return 1;
+          }
+        break;
+      default:
+        usage(argv[0]);
+        return 1;
+    }
+    opt = getopt(argc, argv, "t:");
+  }
+  if ((argc - optind) > 2)
+    {
+      usage(argv[0]);
+      return 1;
+    }
+  const char *const instance_name = (optind < argc) ? argv[optind] : "input.txt";
+  const char *const assignments_name = ((optind + 1) < argc) ? argv[optind + 1] : "output.txt";
+
+  mapped_file instance;
+  if (instance.map(instance_name) != 0)
+    {
+      cerr << "Cannot read " << instance_name << endl;
+      return 1;
+    }
+  mapped_file assignments;
+  if (assignments.map(assignments_name) != 0)
+    {
+      cerr << "Cannot read " << assignments_name << endl;
+      return 1;
+    }
+
+  // Report every problem, then sum them up
+  assignment_verifier verifier(instance, assignments);
+  const int rc = verifier.verify(workers, cerr);
+  cerr << "circuit count = "      << verifier.circuit_count() <<
+          ", juggler count = "    << verifier.juggler_count() <<
+          ", problems = "         << verifier.problem_count() <<
+          ", blocking pairs = "   << verifier.blocking_pair_count() << endl;
+  if (rc == 0)
+    cerr << "Assignments verified." << endl;
+
+  return rc;
+}
@@ -0,0 +1,164 @@
+
+/*!
+ * \file worker_pool.cpp
+ *
+ * \brief Contains the implementation of worker_pool
+ *
+ * \author Stewart L. Palmer
+ */
+
+#include <assert.h>
+#include "worker_pool.h"
+
+using namespace ::std;
+
+
+/*                                                                          */
+/****************************************************************************/
+/*     C O N S T R U C T O R                                                */
+/****************************************************************************/
+/*                                                                          */
+worker_pool::worker_pool()
+  :
+  _function(0),
+  _generation(0),
+  _pending(0),
+  _stopping(false)
+{
+  pthread_mutex_init(&_lock, 0);
+  pthread_cond_init(&_started, 0);
+  pthread_cond_init(&_finished, 0);
+}
+
+
+/*                                                                          */
+/****************************************************************************/
+/*     D E S T R U C T O R                                                  */
+/****************************************************************************/
+/*                                                                          */
+worker_pool::~worker_pool()
+{
+  wait();
+  pthread_mutex_lock(&_lock);
+  _stopping = true;
+  pthread_cond_broadcast(&_started);
+  pthread_mutex_unlock(&_lock);
+  for (unsigned int t = 0; t < _threads.size(); t++)
+    {
+      pthread_join(_threads[t]->thread, 0);
+      delete _threads[t];
+    }
+  pthread_cond_destroy(&_finished);
+  pthread_cond_destroy(&_started);
+  pthread_mutex_destroy(&_lock);
+}
+
+
+/*                                                                          */
+/****************************************************************************/
+/*     S T A R T                                                            */
+/****************************************************************************/
+/*                                                                          */
+unsigned int worker_pool::start(
+  const job            function,   /*!< The job                             */
+  void *const         *args,       /*!< Argument of each job                */
+  const unsigned int   count)      /*!< Number of jobs                      */
+{
+  // A new thread waits for the generation after the one it was created in,
+  // which is the one set up below
+  while (_threads.size() < count)
+    {
+      pool_thread *const t = new pool_thread;
+      t->pool = this;
+      t->slot = _threads.size();
+      t->created = _generation;
+      if (pthread_create(&t->thread, 0, thread_main, t) != 0)
+        {
+          delete t;
+          break;
+        }
+      _threads.push_back(t);
+    }
+
+  const unsigned int started = (count < _threads.size()) ? count : _threads.size();
+  if (started == 0)
+    return 0;
+
+  pthread_mutex_lock(&_lock);
+  assert(_pending == 0);
+  _function = function;
+  _args.assign(args, args + started);
+  _pending = started;
+  _generation++;
+  pthread_cond_broadcast(&_started);
+  pthread_mutex_unlock(&_lock);
+
+  return started;
+}
+
+
+/*                                                                          */
+/****************************************************************************/
+/*     W A I T                                                              */
+/****************************************************************************/
+/*                                                                          */
+void worker_pool::wait()
+{
+  pthread_mutex_lock(&_lock);
+  while (_pending != 0)
+    pthread_cond_wait(&_finished, &_lock);
+  pthread_mutex_unlock(&_lock);
+}
+
+
+/*                                                                          */
+/****************************************************************************/
+/*     T H R E A D _ M A I N                                                */
+/****************************************************************************/
+/*                                                                          */
+void *worker_pool::thread_main(
+  void    *arg)                    /*!< The pool_thread                     */
+{
+  const pool_thread &t = *static_cast<pool_thread *>(arg);
+  worker_pool &pool = *t.pool;
+  pthread_mutex_lock(&pool._lock);
+  unsigned long seen = t.created;
+  for (;;)
+  {
+    while ( !pool._stopping && (pool._generation == seen) )
+      pthread_cond_wait(&pool._started, &pool._lock);
+    if (pool._stopping)
+      break;
+
+    // A start() with fewer jobs than threads leaves the last ones idle
+    seen = pool._generation;
+    if (t.slot < pool._args.size())
+      {
+        const job function = pool._function;
+        void *const job_arg = pool._args[t.slot];
+        pthread_mutex_unlock(&pool._lock);
+        function(job_arg);
+        pthread_mutex_lock(&pool._lock);
+        if (--pool._pending == 0)
+          pthread_cond_signal(&pool._finished);
+      }
+  }
+  pthread_mutex_unlock(&pool._lock);
+
+  return 0;
+}
+
+
+/*                                                                          */
+/****************************************************************************/
+/*     P R I N T _ S E L F                                                  */
+/****************************************************************************/
+/*                                                                          */
+ostream &worker_pool::print_self(
+  ostream    &os)                  /*!< The stream into which we stream     */
+const
+{
+  os << "worker_pool: " << _threads.size() << " threads";
+
+  return os;
+}
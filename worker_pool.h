@@ -0,0 +1,182 @@
+#ifndef worker_pool_h_included
+#define worker_pool_h_included 1
+
+/*!
+ * \file worker_pool.h
+ *
+ * \brief Contains the definition of worker_pool
+ *
+ * \author Stewart L. Palmer
+ */
+
+#include <iostream>
+#include <vector>
+#include <pthread.h>
+
+
+/*!
+ * \brief Threads that are kept waiting between the runs of parallel_tasks
+ *
+ * Creating and joining a thread for every run costs more than a short run
+ * does; the auction runs a parallel_task for every round of bids.  An object
+ * that runs many parallel_tasks keeps a pool and gives it to each of them with
+ * parallel_task::set_pool(), so the threads are created once, on the first run
+ * that needs them, and joined when the pool is destroyed.
+ *
+ * A pool runs the jobs of one start() at a time, from one calling thread.  If
+ * the system will not make another thread, start() runs on the threads it has
+ * and leaves the rest of the jobs to the caller.
+ */
+class worker_pool
+{
+public:
+
+  //! A job run on one of the threads
+  typedef void *(*job)(
+    void     *arg);
+
+
+  /*!
+   * \brief Standard constructor
+   *
+   * No thread is created until a start() needs one.
+   */
+  worker_pool();
+
+
+  /*!
+   * \brief Destructor
+   *
+   * Waits for the jobs started, then stops and joins the threads.
+   */
+  ~worker_pool();
+
+
+  /*!
+   * \brief Start a job on each of count threads, one for each argument
+   *
+   * The caller may go on with other work, and must call wait() before the
+   * next start().
+   *
+   * \return The number of jobs started, the first ones of args; the caller
+   *         must run the others itself
+   */
+  unsigned int start(
+    const job            function, /*!< The job                             */
+    void *const         *args,     /*!< Argument of each job                */
+    const unsigned int   count     /*!< Number of jobs                      */
+                    );
+
+
+  /*!
+   * \brief Wait until every job of the last start() is done
+   */
+  void wait();
+
+
+  /*!
+   * \brief Return the number of threads in the pool
+   */
+  unsigned int thread_count() const
+  { return _threads.size(); }
+
+
+  /*!
+   *  \brief Stream object out to a stream
+   *
+   * \return The same stream as the input to allow for chained operators.
+   */
+  friend std::ostream &operator<<(
+    std::ostream          &os,     /*!< The stream into which we stream     */
+    const worker_pool     &cn)     /*!< The object to be streamed           */
+  {
+    return cn.print_self(os);
+  }
+
+private:
+
+  /*!
+   * \brief One thread of the pool
+   */
+  struct pool_thread
+  {
+    //! The pool
+    worker_pool   *pool;
+
+    //! Which of the arguments of a start() it runs
+    unsigned int   slot;
+
+    //! The generation when it was created, whose jobs it does not run
+    unsigned long  created;
+
+    //! The thread
+    pthread_t      thread;
+  };
+
+
+  /*!
+   * \brief The copy constructor is deliberately private and unimplemented.
+   *
+   * \param rhs the object from which we are to be constructed
+   */
+  worker_pool(
+    const worker_pool   &rhs);
+
+  /*!
+   * \brief operator=() is deliberately private and unimplemented.
+   *
+   * \param rhs the object from which we are to be assigned
+   *
+   * \return reference to self to allow for chained operators
+   */
+  worker_pool &operator=(
+    const worker_pool   &rhs);
+
+  /*!
+   * \brief This is the implementation function for operator<<()
+   *
+   * \return The same stream as the input to allow for chained operators.
+   */
+  std::ostream &print_self(
+    std::ostream    &os)           /*!< The stream into which we stream     */
+  const;
+
+
+  /*!
+   * \brief Thread entry point; runs a job each time one is started for its
+   *        slot
+   */
+  static void *thread_main(
+    void    *arg);                 /*!< The pool_thread                     */
+
+
+  //! Guards everything below
+  pthread_mutex_t               _lock;
+
+  //! Signalled when jobs are started or the pool stops
+  pthread_cond_t                _started;
+
+  //! Signalled when the last job of a start() is done
+  pthread_cond_t                _finished;
+
+  //! The threads, by slot
+  std::vector<pool_thread *>    _threads;
+
+  //! The job of the last start()
+  job                           _function;
+
+  //! Arguments of the last start(), by slot
+  std::vector<void *>           _args;
+
+  //! Number of times start() has been called
+  unsigned long                 _generation;
+
+  //! Jobs of the last start() not yet done
+  unsigned int                  _pending;
+
+  //! True once the threads are to stop
+  bool                          _stopping;
+
+};
+
+#endif                             /* worker_pool_h_included                */